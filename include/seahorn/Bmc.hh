@@ -8,10 +8,13 @@
 
 #include "seahorn/Expr/Expr.hh"
 #include "seahorn/Expr/Smt/EZ3.hh"
+#include "seahorn/Expr/Smt/SmtLibWriter.hh"
 
 #include "seahorn/Analysis/CutPointGraph.hh"
 #include "seahorn/OperationalSemantics.hh"
 
+#include <functional>
+
 namespace seahorn {
 using namespace expr;
 
@@ -28,6 +31,26 @@ void unsat_core(ZSolver<EZ3> &solver, const ExprVector &f,
 } // namespace bmc_impl
 
 class BmcTrace;
+
+/// \brief A property checked by the multi-property mode of BmcEngine
+///
+/// A property is violated by an execution that takes the edge from \p src
+/// into the failure block \p dst, i.e., a block that calls verifier.error
+/// or seahorn.fail.
+struct BmcProperty {
+  /// source of the failing edge, null if \p dst is the entry block
+  const llvm::BasicBlock *src;
+  /// failure block
+  const llvm::BasicBlock *dst;
+  /// true iff the failing edge is taken. Set by the encoding
+  Expr guard;
+  /// true if violated, false if it holds, indeterminate if unknown
+  boost::tribool result;
+
+  BmcProperty(const llvm::BasicBlock *s, const llvm::BasicBlock *d)
+      : src(s), dst(d), result(boost::indeterminate) {}
+};
+
 class BmcEngine {
 protected:
   /// symbolic operational semantics
@@ -58,6 +81,12 @@ protected:
   /// path-condition for m_cps
   ExprVector m_side;
 
+  /// properties for solveProperties()
+  std::vector<BmcProperty> m_props;
+
+  /// computes the guard of every property in the final state
+  void encodeProperties();
+
 public:
   BmcEngine(OperationalSemantics &sem, EZ3 &zctx)
       : m_sem(sem), m_efac(sem.efac()), m_result(boost::indeterminate),
@@ -81,6 +110,24 @@ public:
   /// checks satisfiability of the path condition
   virtual boost::tribool solve();
 
+  /// \brief Collects one property per edge into a failure block of the
+  /// function under analysis, ordered by the source of the edge
+  void addProperties();
+
+  /// \brief Checks every property in one incremental session
+  ///
+  /// The formula is encoded and asserted once. Each property is then
+  /// checked under an assumption that enables its guard, so that lemmas
+  /// learned by the solver are shared between properties. A violated
+  /// property is reported to \p onFail with its counterexample and is
+  /// blocked before the next property is checked. Returns true if some
+  /// property is violated, false if all hold, and indeterminate otherwise.
+  virtual boost::tribool
+  solveProperties(std::function<void(const BmcProperty &, BmcTrace &)> onFail);
+
+  /// properties and their verdicts
+  const std::vector<BmcProperty> &getProperties() const { return m_props; }
+
   /// get model if side condition evaluated to sat.
   virtual ZModel<EZ3> getModel() {
     assert((bool)result());
@@ -104,7 +151,9 @@ public:
   /// output current path condition in SMT-LIB2 format
   virtual raw_ostream &toSmtLib(raw_ostream &out) {
     encode();
-    return m_smt_solver.toSmtLib(out);
+    SmtLibWriter w(out);
+    w.assertAll(m_side);
+    return out << "(check-sat)\n";
   }
 
   /// returns the latest result from solve()
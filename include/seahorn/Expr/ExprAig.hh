@@ -11,14 +11,27 @@ namespace expr
     namespace boolop
     {
       /// aig-fy an expression and simplify it
+      ///
+      /// The Boolean structure of e (AND, OR, NEG, IMPL, IFF, XOR, ITE
+      /// and equalities between Boolean terms) is converted to an
+      /// And-Inverter Graph with structural hashing, constant
+      /// propagation and two-level minimization. Nodes that random
+      /// simulation suggests are equivalent are merged if a SAT check
+      /// proves them equivalent (fraiging). Any other term is an input.
+      /// If gather is true, the result is in NNF with n-ary AND/OR.
       Expr aig (Expr e, bool gather = false);
-      
+
+      /// aig-fy a vector of expressions using a single AIG, so that
+      /// equivalent sub-formulas are shared between them
+      void aig (const ExprVector &in, ExprVector &out, bool gather = false);
+
       /// same as aig(e, true)
       inline Expr flat_aig (Expr e) { return aig (e, true); }
 
       /// size as number of gates + number of inputs
       unsigned aigSize (Expr e);
-    }  
+      unsigned aigSize (const ExprVector &vec);
+    }
   }
 }
 
@@ -81,43 +81,62 @@ inline std::ostream &operator<<(std::ostream &OS, const Operator &V) {
   return OS;
 }
 
-struct EFADeleter {
-  ExprFactoryAllocator *m_efa;
-  EFADeleter(ExprFactoryAllocator &efa) : m_efa(&efa) {}
-  EFADeleter(const EFADeleter &) = default;
-  EFADeleter &operator=(const EFADeleter &o) = default;
-  void operator()(void *p);
-};
-
 /// \brief An expression tree node
+///
+/// A node is allocated as a single block: the node header is immediately
+/// followed by an array of \c arity() pointers to its arguments. The operator
+/// is interned by the ExprFactory and shared by all nodes labeled by it.
 class ENode {
 protected:
   /** unique identifier of this expression node */
   unsigned int id;
-  /** reference counter */
+  /** reference counter. Updated atomically only in a concurrent factory
+      (using the __atomic builtins, so that a sequential factory pays
+      nothing for it) */
   unsigned int count;
 
+  /// \brief Number of arguments stored right after the node
+  unsigned int m_arity;
+
+  /// \brief True if the parent factory is concurrent. Kept next to the
+  /// counter to avoid loading the factory on every reference count update
+  bool m_concurrent;
+
+  /** structural hash of the node, computed once by ExprFactory */
+  size_t m_hash;
+
   /// \brief Parent factory that created this node
   ExprFactory *fac;
 
-  /// \brief Pointer to children / arguments of this node
-  std::vector<ENode *> args;
+  /// \brief Operator labeling the node. Owned by the factory
+  const Operator *m_oper;
 
-  /// \brief Operator labeling the node
-  std::unique_ptr<Operator, EFADeleter> m_oper;
+  ENode **trailingArgs() { return reinterpret_cast<ENode **>(this + 1); }
+  ENode *const *trailingArgs() const {
+    return reinterpret_cast<ENode *const *>(this + 1);
+  }
 
-  void Deref() {
-    if (count > 0)
-      count--;
+  /// \brief Size of the memory block of a node with \p arity arguments
+  static size_t allocSize(unsigned arity) {
+    return sizeof(ENode) + arity * sizeof(ENode *);
   }
 
+  /// \brief Decrements the reference counter and returns its new value
+  unsigned int Deref();
+  /// \brief Increments the reference counter unless it is zero (i.e., the
+  /// node is being removed). Returns true on success
+  bool tryRef();
+
   /// \brief Set id of the node
   void setId(unsigned int v) { id = v; }
 
-public:
-  ENode(ExprFactory &f, const Operator &o);
-  ~ENode();
+  /// \brief Nodes are created and destroyed only by ExprFactory
+  ENode(ExprFactory &f, const Operator &o, unsigned arity, bool concurrent)
+      : id(0), count(0), m_arity(arity), m_concurrent(concurrent), m_hash(0),
+        fac(&f), m_oper(&o) {}
+  ~ENode() = default;
 
+public:
   ENode() = delete;
   ENode(const ENode &) = delete;
 
@@ -126,40 +145,59 @@ public:
 
   /** returns the unique id of this expression */
   unsigned int getId() const { return id; }
+  /** returns the structural hash (operator and argument identity) */
+  size_t hash() const { return m_hash; }
 
-  void Ref() { count++; }
-  bool isGarbage() const { return count == 0; }
+  void Ref();
+  bool isGarbage() const { return use_count() == 0; }
   bool isMutable() const { return m_oper->isMutable(); }
 
-  unsigned int use_count() { return count; }
+  unsigned int use_count() const {
+    return m_concurrent ? __atomic_load_n(&count, __ATOMIC_RELAXED) : count;
+  }
 
   ENode *operator[](size_t p) { return arg(p); }
-  ENode *arg(size_t p) { return args[p]; }
+  ENode *arg(size_t p) {
+    assert(p < m_arity);
+    return trailingArgs()[p];
+  }
 
-  ENode *left() { return (args.size() > 0) ? args[0] : nullptr; }
+  ENode *left() { return (m_arity > 0) ? trailingArgs()[0] : nullptr; }
 
-  ENode *right() { return (args.size() > 1) ? args[1] : nullptr; }
+  ENode *right() { return (m_arity > 1) ? trailingArgs()[1] : nullptr; }
 
   ENode *first() { return left(); }
-  ENode *last() { return args.size() > 0 ? args[args.size() - 1] : nullptr; }
-
-  using args_const_iterator = std::vector<ENode *>::const_iterator;
-
-  bool args_empty() const { return args.empty(); }
-  args_const_iterator args_begin() const { return args.begin(); }
-  args_const_iterator args_end() const { return args.end(); }
+  ENode *last() { return m_arity > 0 ? trailingArgs()[m_arity - 1] : nullptr; }
+
+  /// \brief Iterator over the arguments of a node
+  ///
+  /// A class type rather than a raw pointer so that an rvalue iterator can be
+  /// advanced, as in ++e->args_begin()
+  class args_const_iterator
+      : public llvm::iterator_adaptor_base<args_const_iterator,
+                                           ENode *const *> {
+  public:
+    args_const_iterator() = default;
+    explicit args_const_iterator(ENode *const *p) : iterator_adaptor_base(p) {}
+  };
+
+  bool args_empty() const { return m_arity == 0; }
+  args_const_iterator args_begin() const {
+    return args_const_iterator(trailingArgs());
+  }
+  args_const_iterator args_end() const {
+    return args_const_iterator(trailingArgs() + m_arity);
+  }
 
+  /// \brief Replaces the arguments of a mutable node
+  /// The new range must have the same number of elements as the old one
   template <typename iterator> void renew_args(iterator b, iterator e);
 
-  void push_back(ENode *a) {
-    args.push_back(a);
-    a->Ref();
-  }
-
-  size_t arity() const { return args.size(); }
+  size_t arity() const { return m_arity; }
 
   const Operator &op() const { return *m_oper; }
   void Print(std::ostream &OS, int depth = 0, bool brkt = true) const {
+    std::vector<ENode *> args(args_begin(), args_end());
     m_oper->Print(OS, args, depth, brkt);
   }
   void dump() const {
@@ -168,9 +206,14 @@ public:
   }
 
   friend class ExprFactory;
+  friend struct ENodeUniqueHash;
+  friend struct ENodeUniqueEqual;
   friend struct std::less<expr::ENode *>;
 };
 
+static_assert(sizeof(ENode) % alignof(ENode *) == 0,
+              "trailing arguments of ENode must be aligned");
+
 inline std::ostream &operator<<(std::ostream &OS, const ENode &V) {
   V.Print(OS);
   return OS;
@@ -184,33 +227,146 @@ inline std::ostream &operator<<(std::ostream &OS, const ENode *v) {
 }
 
 /// \brief Hash function used by ExprFactory
+///
+/// Combines the identity of the (interned) operator with the identity of the
+/// arguments. Since arguments are already hash-consed, pointer identity is
+/// structural identity.
 struct ENodeUniqueHash {
+  static size_t hash(const Operator *op, ENode *const *args, unsigned arity) {
+    size_t res = std::hash<const Operator *>()(op);
+    for (unsigned i = 0; i < arity; ++i)
+      boost::hash_combine(res, args[i]);
+    return res;
+  }
+
   std::size_t operator()(const ENode *e) const {
-    size_t res = e->op().hash();
+    return hash(e->m_oper, e->trailingArgs(), e->arity());
+  }
+};
 
-    size_t a = e->arity();
-    if (a == 0)
-      return res;
+/// \brief Equality function used by ExprFactory
+struct ENodeUniqueEqual {
+  static bool equal(const ENode *e, const Operator *op, ENode *const *args,
+                    unsigned arity) {
+    // same operator, same arity, identical children
+    return e->m_oper == op && e->arity() == arity &&
+           std::equal(args, args + arity, e->trailingArgs());
+  }
 
-    auto it = e->args_begin();
-    if (a >= 1)
-      boost::hash_combine(res, *it);
+  bool operator()(ENode *const &e1, ENode *const &e2) const {
+    return e1->hash() == e2->hash() &&
+           equal(e1, e2->m_oper, e2->trailingArgs(), e2->arity());
+  }
+};
 
-    if (a >= 2)
-      boost::hash_combine(res, boost::hash_range(it, e->args_end()));
+/// \brief Spreads the bits of hash \p h
+///
+/// Node hashes are built from pointers and have poor low bits
+inline size_t mixHash(size_t h) {
+  h ^= h >> 31;
+  h *= 0x9e3779b97f4a7c15ULL;
+  return h ^ (h >> 29);
+}
 
-    return res;
+/// \brief Unique table of ExprFactory
+///
+/// A flat open-addressing hash table with linear probing. The table stores
+/// node pointers only, and relies on the structural hash cached in every
+/// node. Erased slots are marked with a tombstone that is reclaimed on the
+/// next rehash.
+class ENodeUniqueTable {
+  std::vector<ENode *> m_slots;
+  /// \brief number of live entries
+  size_t m_size;
+  /// \brief number of live entries and tombstones
+  size_t m_used;
+
+  static ENode *tombstone() {
+    return reinterpret_cast<ENode *>(static_cast<uintptr_t>(1));
+  }
+  size_t mask() const { return m_slots.size() - 1; }
+  /// \brief First slot to probe for hash \p h
+  size_t slot(size_t h) const { return mixHash(h) & mask(); }
+
+  void rehash(size_t capacity) {
+    std::vector<ENode *> old(capacity, nullptr);
+    old.swap(m_slots);
+    m_used = m_size;
+    for (ENode *n : old) {
+      if (n == nullptr || n == tombstone())
+        continue;
+      size_t i = slot(n->hash());
+      while (m_slots[i] != nullptr)
+        i = (i + 1) & mask();
+      m_slots[i] = n;
+    }
+  }
+
+public:
+  ENodeUniqueTable() : m_slots(1024, nullptr), m_size(0), m_used(0) {}
+  ENodeUniqueTable(const ENodeUniqueTable &) = delete;
+
+  size_t size() const { return m_size; }
+  size_t capacity() const { return m_slots.size(); }
+
+  /// \brief Returns a node with hash \p h, operator \p op and arguments \p
+  /// args that is accepted by \p accept, or nullptr if there is none
+  ///
+  /// In a concurrent factory, \p accept rejects nodes that are being removed
+  template <typename Accept>
+  ENode *find(size_t h, const Operator *op, ENode *const *args, unsigned arity,
+              Accept accept) const {
+    size_t i = slot(h);
+    for (ENode *n = m_slots[i]; n != nullptr; n = m_slots[i]) {
+      if (n != tombstone() && n->hash() == h &&
+          ENodeUniqueEqual::equal(n, op, args, arity) && accept(n))
+        return n;
+      i = (i + 1) & mask();
+    }
+    return nullptr;
+  }
+
+  /// \brief Inserts node \p v. No equal node may be in the table
+  void insert(ENode *v) {
+    // -- keep load (including tombstones) under 3/4, and grow unless most
+    // -- of the used slots are tombstones
+    size_t cap = m_slots.size();
+    if (4 * (m_used + 1) > 3 * cap)
+      rehash(4 * (m_size + 1) > cap ? 2 * cap : cap);
+
+    size_t i = slot(v->hash());
+    while (m_slots[i] != nullptr && m_slots[i] != tombstone())
+      i = (i + 1) & mask();
+    if (m_slots[i] == nullptr)
+      ++m_used;
+    m_slots[i] = v;
+    ++m_size;
+  }
+
+  /// \brief Removes node \p v (by identity) from the table
+  void erase(ENode *v) {
+    size_t i = slot(v->hash());
+    for (ENode *n = m_slots[i]; n != nullptr; n = m_slots[i]) {
+      if (n == v) {
+        m_slots[i] = tombstone();
+        --m_size;
+        return;
+      }
+      i = (i + 1) & mask();
+    }
+    assert(false && "removing a node that is not in the unique table");
   }
 };
 
-/// \brief Equality function used by ExprFactory
-struct ENodeUniqueEqual {
-  bool operator()(ENode *const &e1, ENode *const &e2) const {
-    // same arity, same operator, identical children
-    if (e1->arity() == e2->arity() && e1->op() == e2->op())
-      return std::equal(e1->args_begin(), e1->args_end(), e2->args_begin());
+/// \brief Hash of an Operator by value
+struct OperatorHash {
+  size_t operator()(const Operator *op) const { return op->hash(); }
+};
 
-    return false;
+/// \brief Equality of Operators by value
+struct OperatorEqual {
+  bool operator()(const Operator *op1, const Operator *op2) const {
+    return op1->getFamilyId() == op2->getFamilyId() && *op1 == *op2;
   }
 };
 
@@ -237,6 +393,15 @@ template <typename C> struct CacheStubImpl : CacheStub {
   virtual void erase(ENode *val) { m_cache.erase(val); }
 };
 
+/// \brief Returns a process-wide unique, non-zero identifier
+///
+/// Used to tag thread-local caches with the factory (or allocator) they
+/// belong to. Unlike an address, an identifier is never reused.
+inline uint64_t freshOwnerId() {
+  static std::atomic<uint64_t> counter(0);
+  return ++counter;
+}
+
 class ExprFactoryAllocator {
 private:
   /** pool for tiny objects */
@@ -244,111 +409,303 @@ private:
   /** pool for small objects */
   boost::pool<> small;
 
+  /// \brief True if the allocator may be used by several threads
+  bool m_concurrent;
+  /// \brief Guards the pools in concurrent mode
+  std::mutex m_mutex;
+  /// \brief Identifies the allocator in thread-local free lists
+  uint64_t m_uid;
+
+  /// \brief Free list of small blocks of the current thread
+  ///
+  /// In concurrent mode small blocks are recycled through a per-thread free
+  /// list and move to and from the shared pool in batches. A free list
+  /// belongs to one allocator at a time; blocks of another allocator are
+  /// dropped (they are reclaimed with their pool)
+  struct ThreadFreeList {
+    uint64_t owner = 0;
+    std::vector<void *> blocks;
+  };
+  static ThreadFreeList &threadFreeList() {
+    static thread_local ThreadFreeList freeList;
+    return freeList;
+  }
+  ThreadFreeList &ownFreeList() {
+    ThreadFreeList &fl = threadFreeList();
+    if (fl.owner != m_uid) {
+      fl.owner = m_uid;
+      fl.blocks.clear();
+    }
+    return fl;
+  }
+  static constexpr size_t FREE_LIST_BATCH = 64;
+  static constexpr size_t FREE_LIST_MAX_SIZE = 4096;
+
 public:
-  ExprFactoryAllocator() : tiny(8, 65536), small(64, 65536){};
+  ExprFactoryAllocator(bool concurrent = false)
+      : tiny(8, 65536), small(64, 65536), m_concurrent(concurrent),
+        m_uid(freshOwnerId()){};
   ExprFactoryAllocator(const ExprFactoryAllocator &) = delete;
 
   void *allocate(size_t n);
+  /// \brief Frees a block of unknown size
   void free(void *block);
-
-  EFADeleter get_deleter();
+  /// \brief Frees a block that was allocated with size \p n
+  void free(void *block, size_t n);
 };
 
 class ExprFactory : boost::noncopyable {
 protected:
-  using unique_entry_type =
-      std::unordered_set<ENode *, ENodeUniqueHash, ENodeUniqueEqual>;
-
-  using unique_key_type = std::string;
   // -- type of the unique table
-  using unique_type = std::map<unique_key_type, unique_entry_type>;
+  using unique_type = ENodeUniqueTable;
+
+  /// \brief A lock-striped part of the unique table
+  struct UniqueShard {
+    std::mutex mutex;
+    unique_type table;
+  };
+
+  // -- interned operators, with the number of nodes labeled by each
+  using op_table_type =
+      std::unordered_map<const Operator *, unsigned, OperatorHash,
+                         OperatorEqual>;
 
   using caches_type = boost::ptr_vector<CacheStub>;
 
+  /// \brief True if the factory may be used by several threads
+  const bool m_concurrent;
+
   /** pool allocator */
   ExprFactoryAllocator allocator;
 
   /** list of registered caches */
   caches_type caches;
+  /// \brief Guards registered caches in concurrent mode
+  std::mutex m_cachesMutex;
 
   // -- unique table
   unique_type unique;
+  // -- lock-striped unique table, used instead of unique when concurrent
+  static constexpr unsigned SHARD_BITS = 6;
+  std::unique_ptr<UniqueShard[]> m_shards;
+
+  // -- operator table
+  op_table_type m_ops;
+  /// \brief Guards the operator table in concurrent mode
+  std::mutex m_opsMutex;
+
+  /// \brief Identifies the factory in thread-local operator caches
+  const uint64_t m_uid;
 
   /** counter for assigning unique ids*/
-  unsigned int idCount;
+  std::atomic<unsigned int> idCount;
 
   /** returns a unique id > 0 */
-  unsigned int uniqueId() { return ++idCount; }
+  unsigned int uniqueId() {
+    if (m_concurrent)
+      return idCount.fetch_add(1, std::memory_order_relaxed) + 1;
+    unsigned int res = idCount.load(std::memory_order_relaxed) + 1;
+    idCount.store(res, std::memory_order_relaxed);
+    return res;
+  }
+
+  /// \brief Returns a lock for \p m that is only taken in concurrent mode
+  std::unique_lock<std::mutex> lockIfConcurrent(std::mutex &m) {
+    return m_concurrent ? std::unique_lock<std::mutex>(m)
+                        : std::unique_lock<std::mutex>();
+  }
+
+  UniqueShard &shardFor(size_t h) {
+    return m_shards[mixHash(h) >> (64 - SHARD_BITS)];
+  }
 
   /**
    * Remove value from unique table
    */
   void Remove(ENode *val) {
-    clearCaches(val);
-    if (!val->isMutable()) {
-      unique_type::iterator it = unique.find(val->op().name());
-      // -- can only remove things that have been inserted before
-      assert(it != unique.end());
-      it->second.erase(val);
-      if (it->second.empty())
-        unique.erase(it);
+    // -- freeing a node releases its kids, which may free them in turn. Use
+    // -- an explicit worklist so that releasing a deep DAG does not overflow
+    // -- the call stack
+    llvm::SmallVector<ENode *, 16> dead;
+    dead.push_back(val);
+    while (!dead.empty()) {
+      ENode *n = dead.pop_back_val();
+      unlink(n);
+      freeNode(n, dead);
     }
-    freeNode(val);
+  }
+
+  /// \brief Removes a dead node from all caches and the unique table
+  void unlink(ENode *val) {
+    clearCaches(val);
+    // -- can only remove things that have been inserted before
+    if (val->isMutable())
+      ;
+    else if (m_concurrent) {
+      UniqueShard &shard = shardFor(val->hash());
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      shard.table.erase(val);
+    } else
+      unique.erase(val);
   }
 
   /**
    * Clear val from all registered caches
    */
   void clearCaches(ENode *val) {
+    if (caches.empty())
+      return;
+    auto lock = lockIfConcurrent(m_cachesMutex);
     for (CacheStub &c : caches)
       c.erase(val);
   }
 
+  /// \brief Interned operators already seen by the current thread
+  struct ThreadOpCache {
+    uint64_t owner = 0;
+    std::unordered_set<const Operator *, OperatorHash, OperatorEqual> ops;
+  };
+  static ThreadOpCache &threadOpCache() {
+    static thread_local ThreadOpCache cache;
+    return cache;
+  }
+
   /**
-   * Return the canonical (unique) representetive of the given ENode \p v
-   * The node \p v should not be used after the call
+   * Return the interned copy of operator \p op
+   * A newly interned operator has no nodes and must be used by the caller
    */
-  ENode *canonize(ENode *v) {
-    if (v->isMutable()) {
-      v->setId(uniqueId());
-      return v;
+  op_table_type::value_type &internOp(const Operator &op) {
+    auto it = m_ops.find(&op);
+    if (it != m_ops.end())
+      return *it;
+    return *m_ops.emplace(op.clone(allocator), 0).first;
+  }
+
+  /**
+   * Return the interned copy of operator \p op in a concurrent factory
+   *
+   * Lookups go through a thread-local cache so that threads do not contend
+   * on common operators. Operators of a concurrent factory are only
+   * released when the factory is destroyed, so cached pointers stay valid
+   * for the life of the factory
+   */
+  const Operator *internOpConcurrent(const Operator &op) {
+    ThreadOpCache &cache = threadOpCache();
+    if (cache.owner != m_uid) {
+      cache.owner = m_uid;
+      cache.ops.clear();
     }
+    auto it = cache.ops.find(&op);
+    if (it != cache.ops.end())
+      return *it;
+
+    const Operator *res;
+    {
+      std::lock_guard<std::mutex> lock(m_opsMutex);
+      res = internOp(op).first;
+    }
+    cache.ops.insert(res);
+    return res;
+  }
 
-    auto x = unique[v->op().name()].insert(v);
-    if (x.second) {
-      v->setId(uniqueId());
-      return v;
-    } else {
-      freeNode(v);
-      return *x.first;
+  /**
+   * Release an interned operator after a node labeled by it is freed
+   */
+  void releaseOp(const Operator *op) {
+    // -- operators of a concurrent factory are released by ~ExprFactory
+    if (m_concurrent)
+      return;
+    auto it = m_ops.find(op);
+    assert(it != m_ops.end() && it->first == op);
+    if (--it->second > 0)
+      return;
+    m_ops.erase(it);
+    op->~Operator();
+    allocator.free(const_cast<Operator *>(op));
+  }
+
+  /**
+   * Return the canonical (unique) node with operator \p op and arguments \p
+   * args. A node is allocated only if there is no such node yet.
+   * The returned node is referenced on behalf of the caller
+   */
+  ENode *mkExpr(const Operator &op, ENode *const *args, unsigned arity) {
+    if (LLVM_UNLIKELY(m_concurrent))
+      return mkExprConcurrent(op, args, arity);
+
+    auto &opEntry = internOp(op);
+    const Operator *iop = opEntry.first;
+    size_t h = ENodeUniqueHash::hash(iop, args, arity);
+
+    if (!iop->isMutable())
+      if (ENode *res = unique.find(h, iop, args, arity,
+                                   [](ENode *) { return true; })) {
+        res->Ref();
+        return res;
+      }
+
+    ENode *res = allocNode(*iop, args, arity);
+    ++opEntry.second;
+    res->m_hash = h;
+    res->setId(uniqueId());
+    res->Ref();
+    if (!iop->isMutable())
+      unique.insert(res);
+    return res;
+  }
+
+  /// \brief mkExpr for a concurrent factory
+  ///
+  /// The shard of the unique table is locked during lookup and insertion. A
+  /// node whose counter already dropped to zero is being removed by another
+  /// thread and is skipped; a fresh equal node is created instead. Argument
+  /// counters are only incremented, so no other lock is taken meanwhile
+  ENode *mkExprConcurrent(const Operator &op, ENode *const *args,
+                          unsigned arity) {
+    const Operator *iop = internOpConcurrent(op);
+    size_t h = ENodeUniqueHash::hash(iop, args, arity);
+
+    if (iop->isMutable()) {
+      ENode *res = allocNode(*iop, args, arity);
+      res->m_hash = h;
+      res->setId(uniqueId());
+      res->Ref();
+      return res;
     }
+
+    UniqueShard &shard = shardFor(h);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (ENode *res = shard.table.find(h, iop, args, arity,
+                                      [](ENode *n) { return n->tryRef(); }))
+      return res;
+
+    ENode *res = allocNode(*iop, args, arity);
+    res->m_hash = h;
+    res->setId(uniqueId());
+    res->Ref();
+    shard.table.insert(res);
+    return res;
   }
 
-  ENode *mkExpr(const Operator &op) { return canonize(allocNode(op)); }
+  ENode *mkExpr(const Operator &op) { return mkExpr(op, nullptr, 0); }
 
   template <typename etype> ENode *mkExpr(const Operator &op, etype e) {
-    ENode *eVal = allocNode(op);
-    eVal->push_back(eptr(e));
-    return canonize(eVal);
+    ENode *args[] = {eptr(e)};
+    return mkExpr(op, args, 1);
   }
 
   /** binary */
   template <typename etype>
   ENode *mkExpr(const Operator &op, etype e1, etype e2) {
-    ENode *eVal = allocNode(op);
-    eVal->push_back(eptr(e1));
-    eVal->push_back(eptr(e2));
-    return canonize(eVal);
+    ENode *args[] = {eptr(e1), eptr(e2)};
+    return mkExpr(op, args, 2);
   }
 
   /** ternary */
   template <typename etype>
   ENode *mkExpr(const Operator &op, etype e1, etype e2, etype e3) {
-    ENode *eVal = allocNode(op);
-    eVal->push_back(eptr(e1));
-    eVal->push_back(eptr(e2));
-    eVal->push_back(eptr(e3));
-    return canonize(eVal);
+    ENode *args[] = {eptr(e1), eptr(e2), eptr(e3)};
+    return mkExpr(op, args, 3);
   }
 
   /** n-ary
@@ -356,41 +713,70 @@ protected:
   */
   template <typename iterator>
   ENode *mkNExpr(const Operator &op, iterator begin, iterator end) {
-    ENode *eVal = allocNode(op);
+    llvm::SmallVector<ENode *, 8> args;
     for (; begin != end; ++begin)
-      eVal->push_back(eptr(*begin));
-    return canonize(eVal);
+      args.push_back(eptr(*begin));
+    return mkExpr(op, args.data(), args.size());
   }
 
 private:
-#define FREE_LIST_MAX_SIZE 1024 * 4
-  std::vector<ENode *> freeList;
-  void freeNode(ENode *n);
-  ENode *allocNode(const Operator &op);
+  void freeNode(ENode *n, llvm::SmallVectorImpl<ENode *> &dead);
+  ENode *allocNode(const Operator &op, ENode *const *args, unsigned arity);
 
 public:
-  ExprFactory() : idCount(0) {}
+  /// \brief Creates a factory
+  ///
+  /// A \p concurrent factory can be used to create and release expressions
+  /// from several threads at once. It uses a lock-striped unique table,
+  /// atomic reference counters and per-thread free lists, and keeps
+  /// operators until it is destroyed. Node ids remain unique and never
+  /// change, but in concurrent mode their order reflects the interleaving of
+  /// threads. Caches must be registered before threads are started.
+  explicit ExprFactory(bool concurrent = false)
+      : m_concurrent(concurrent), allocator(concurrent),
+        m_uid(freshOwnerId()), idCount(0) {
+    if (m_concurrent)
+      m_shards.reset(new UniqueShard[size_t(1) << SHARD_BITS]);
+  }
+
+  /// \brief Releases the operators kept by a concurrent factory
+  ///
+  /// Stale entries in thread-local operator caches are never dereferenced:
+  /// they are keyed by the uid of this factory, which is not reused
+  ~ExprFactory() {
+    if (!m_concurrent)
+      return;
+    for (auto &kv : m_ops) {
+      kv.first->~Operator();
+      allocator.free(const_cast<Operator *>(kv.first));
+    }
+    m_ops.clear();
+  }
+
+  /// \brief True if the factory can be used by several threads at once
+  bool isConcurrent() const { return m_concurrent; }
 
   /** Derefernce a value */
   void Deref(ENode *val) {
-    val->Deref();
-    if (val->isGarbage())
+    if (val->Deref() == 0)
       Remove(val);
   }
 
   /*===================== PUBLIC API ========================================*/
 
-  Expr mkTerm(const Operator &o) { return Expr(mkExpr(o)); }
-  Expr mkUnary(const Operator &o, Expr e) { return Expr(mkExpr(o, e.get())); }
+  Expr mkTerm(const Operator &o) { return Expr(mkExpr(o), false); }
+  Expr mkUnary(const Operator &o, Expr e) {
+    return Expr(mkExpr(o, e.get()), false);
+  }
   Expr mkBin(const Operator &o, Expr e1, Expr e2) {
-    return Expr(mkExpr(o, e1.get(), e2.get()));
+    return Expr(mkExpr(o, e1.get(), e2.get()), false);
   }
   Expr mkTern(const Operator &o, Expr e1, Expr e2, Expr e3) {
-    return Expr(mkExpr(o, e1.get(), e2.get(), e3.get()));
+    return Expr(mkExpr(o, e1.get(), e2.get(), e3.get()), false);
   }
   template <typename iterator>
   Expr mkNary(const Operator &o, iterator b, iterator e) {
-    return Expr(mkNExpr(o, b, e));
+    return Expr(mkNExpr(o, b, e), false);
   }
 
   template <typename Range> Expr mkNary(const Operator &o, const Range &r) {
@@ -400,12 +786,14 @@ public:
   template <typename Cache> void registerCache(Cache &cache) {
     // -- to avoid double registration
     unregisterCache(cache);
+    auto lock = lockIfConcurrent(m_cachesMutex);
     caches.push_back(static_cast<CacheStub *>(new CacheStubImpl<Cache>(cache)));
   }
 
   template <typename Cache> bool unregisterCache(const Cache &cache) {
     const void *ptr = static_cast<const void *>(&cache);
 
+    auto lock = lockIfConcurrent(m_cachesMutex);
     for (caches_type::iterator it = caches.begin(), end = caches.end();
          it != end; ++it)
       if (it->owns(ptr)) {
@@ -418,10 +806,6 @@ public:
   friend class ENode;
 };
 
-inline ENode::ENode(ExprFactory &f, const Operator &o)
-    : count(0), fac(&f),
-      m_oper(o.clone(f.allocator), f.allocator.get_deleter()) {}
-
 } // namespace expr
 
 inline void *operator new(size_t n, expr::ExprFactoryAllocator &alloc) {
@@ -434,36 +818,71 @@ inline void operator delete(void *p, expr::ExprFactoryAllocator &alloc) {
 
 namespace expr {
 
-inline void ExprFactory::freeNode(ENode *n) {
-  if (freeList.size() < FREE_LIST_MAX_SIZE) {
-    for (ENode *a : n->args)
-      Deref(a);
-    n->args.clear();
-    n->m_oper.reset();
+inline void ENode::Ref() {
+  if (m_concurrent)
+    __atomic_add_fetch(&count, 1, __ATOMIC_RELAXED);
+  else
+    ++count;
+}
 
-    if (freeList.size() < FREE_LIST_MAX_SIZE) {
-      assert(n->count == 0);
-      freeList.push_back(n);
-      return;
-    }
-  }
+inline unsigned int ENode::Deref() {
+  assert(use_count() > 0);
+  if (m_concurrent)
+    return __atomic_sub_fetch(&count, 1, __ATOMIC_ACQ_REL);
+  return --count;
+}
 
-  operator delete(static_cast<void *>(n), allocator);
+inline bool ENode::tryRef() {
+  unsigned int c = __atomic_load_n(&count, __ATOMIC_RELAXED);
+  while (c > 0)
+    if (__atomic_compare_exchange_n(&count, &c, c + 1, true, __ATOMIC_ACQ_REL,
+                                    __ATOMIC_RELAXED))
+      return true;
+  return false;
 }
 
-inline ENode *ExprFactory::allocNode(const Operator &op) {
-  if (freeList.empty())
-    return new (allocator) ENode(*this, op);
+/// Kids whose reference count drops to zero are added to \p dead
+inline void ExprFactory::freeNode(ENode *n,
+                                  llvm::SmallVectorImpl<ENode *> &dead) {
+  ENode **kids = n->trailingArgs();
+  for (unsigned i = 0, sz = n->arity(); i < sz; ++i)
+    if (kids[i]->Deref() == 0)
+      dead.push_back(kids[i]);
+  releaseOp(n->m_oper);
+  size_t sz = ENode::allocSize(n->arity());
+  n->~ENode();
+  allocator.free(static_cast<void *>(n), sz);
+}
 
-  ENode *res = freeList.back();
-  freeList.pop_back();
-  res->m_oper = std::unique_ptr<Operator, EFADeleter>(op.clone(allocator),
-                                                      allocator.get_deleter());
-  assert(res->count == 0);
+inline ENode *ExprFactory::allocNode(const Operator &op, ENode *const *args,
+                                     unsigned arity) {
+  void *mem = allocator.allocate(ENode::allocSize(arity));
+  ENode *res = new (mem) ENode(*this, op, arity, m_concurrent);
+  ENode **kids = res->trailingArgs();
+  for (unsigned i = 0; i < arity; ++i) {
+    kids[i] = args[i];
+    kids[i]->Ref();
+  }
   return res;
 }
 
 inline void *ExprFactoryAllocator::allocate(size_t n) {
+  if (m_concurrent && n > tiny.get_requested_size() &&
+      n <= small.get_requested_size()) {
+    ThreadFreeList &fl = ownFreeList();
+    if (fl.blocks.empty()) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      for (size_t i = 0; i < FREE_LIST_BATCH; ++i)
+        fl.blocks.push_back(small.malloc());
+    }
+    void *res = fl.blocks.back();
+    fl.blocks.pop_back();
+    return res;
+  }
+
+  std::unique_lock<std::mutex> lock(m_mutex, std::defer_lock);
+  if (m_concurrent)
+    lock.lock();
   if (n <= tiny.get_requested_size())
     return tiny.malloc();
   else if (n <= small.get_requested_size())
@@ -473,6 +892,9 @@ inline void *ExprFactoryAllocator::allocate(size_t n) {
 }
 
 inline void ExprFactoryAllocator::free(void *block) {
+  std::unique_lock<std::mutex> lock(m_mutex, std::defer_lock);
+  if (m_concurrent)
+    lock.lock();
   if (tiny.is_from(block))
     tiny.free(block);
   else if (small.is_from(block))
@@ -481,28 +903,47 @@ inline void ExprFactoryAllocator::free(void *block) {
     delete[] static_cast<char *const>(block);
 }
 
-inline EFADeleter ExprFactoryAllocator::get_deleter() {
-  return EFADeleter(*this);
+inline void ExprFactoryAllocator::free(void *block, size_t n) {
+  if (n <= tiny.get_requested_size()) {
+    std::unique_lock<std::mutex> lock(m_mutex, std::defer_lock);
+    if (m_concurrent)
+      lock.lock();
+    tiny.free(block);
+  } else if (n <= small.get_requested_size()) {
+    if (!m_concurrent) {
+      small.free(block);
+      return;
+    }
+    ThreadFreeList &fl = ownFreeList();
+    fl.blocks.push_back(block);
+    if (fl.blocks.size() > FREE_LIST_MAX_SIZE) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      while (fl.blocks.size() > FREE_LIST_MAX_SIZE / 2) {
+        small.free(fl.blocks.back());
+        fl.blocks.pop_back();
+      }
+    }
+  } else
+    delete[] static_cast<char *const>(block);
 }
 
-inline void EFADeleter::operator()(void *p) { operator delete(p, *m_efa); }
-
 template <typename iterator> void ENode::renew_args(iterator b, iterator e) {
-  std::vector<ENode *> old = args;
-  args = std::vector<ENode *>();
+  assert(isMutable());
+  llvm::SmallVector<ENode *, 8> old(args_begin(), args_end());
 
   // -- increment reference count of all new arguments
-  for (; b != e; ++b)
-    this->push_back(eptr(*b));
+  ENode **kids = trailingArgs();
+  unsigned i = 0;
+  for (; b != e; ++b, ++i) {
+    assert(i < m_arity);
+    kids[i] = eptr(*b);
+    kids[i]->Ref();
+  }
+  assert(i == m_arity);
 
   // -- decrement reference count of all old arguments
-  for (auto b = old.begin(), e = old.end(); b != e; ++b)
-    efac().Deref(*b);
-}
-
-inline ENode::~ENode() {
-  for (auto b = args.begin(), e = args.end(); b != e; ++b)
-    efac().Deref(*b);
+  for (ENode *a : old)
+    efac().Deref(a);
 }
 
 /** Required by boost::intrusive_ptr */
@@ -512,7 +953,6 @@ inline void intrusive_ptr_release(ENode *v) { v->efac().Deref(v); }
 
 } // namespace expr
 
-
 // ========================== HASHING ======================================
 namespace expr {
 inline size_t hash_value(Expr e) {
@@ -0,0 +1,948 @@
+#pragma once
+/**
+   Native, memoizing term rewriter for Expr
+
+   Simplifies terms without a round-trip through an SMT solver. The rules are
+   local and cheap: Boolean simplifications, bit-vector constant folding,
+   extract/concat fusion, lifting of operators over ITE terms with constant
+   branches, and read-over-write on arrays and lambda memories.
+ */
+#include "seahorn/Expr/Expr.hh"
+#include "seahorn/Expr/ExprOpBinder.hh"
+#include "seahorn/Expr/ExprSimplifier.hh"
+
+#include "llvm/ADT/DenseMap.h"
+
+namespace expr {
+namespace rewrite_detail {
+/// \brief \p v modulo 2^w, i.e., in [0, 2^w)
+inline mpz_class wrap(const mpz_class &v, unsigned w) {
+  mpz_class r;
+  mpz_fdiv_r_2exp(r.get_mpz_t(), v.get_mpz_t(), w);
+  return r;
+}
+
+/// \brief Value of the w-bit two's complement number \p v
+inline mpz_class toSigned(const mpz_class &v, unsigned w) {
+  mpz_class r = wrap(v, w);
+  if (w > 0 && mpz_tstbit(r.get_mpz_t(), w - 1)) {
+    mpz_class m;
+    mpz_setbit(m.get_mpz_t(), w);
+    mpz_sub(r.get_mpz_t(), r.get_mpz_t(), m.get_mpz_t());
+  }
+  return r;
+}
+
+/// \brief 2^w - 1
+inline mpz_class ones(unsigned w) {
+  mpz_class r;
+  mpz_setbit(r.get_mpz_t(), w);
+  mpz_sub_ui(r.get_mpz_t(), r.get_mpz_t(), 1);
+  return r;
+}
+
+/// \brief -v
+inline mpz_class neg(const mpz_class &v) {
+  mpz_class r(v);
+  return r.neg();
+}
+
+/// \brief true if \p e is a constant of a built-in sort
+inline bool isValue(Expr e) {
+  return op::bv::is_bvnum(e) || isOpX<TRUE>(e) || isOpX<FALSE>(e) ||
+         isOpX<MPZ>(e);
+}
+} // namespace rewrite_detail
+
+/// \brief Simplifies terms bottom-up without an SMT solver
+///
+/// Every node is rewritten once its kids have been rewritten. Results are
+/// memoized by node id across calls, so that terms that share sub-terms
+/// with previously simplified terms (e.g., successive versions of a memory)
+/// are only traversed where they are new. The memo pins every result, so it
+/// is bounded by a number of entries and flushed as a whole by the first
+/// call that finds it full. The traversal uses an explicit stack and does
+/// not recurse on the depth of the term.
+///
+/// Rewriting is sound for any term, but only complete for the rules listed
+/// in the file comment. Terms that no rule applies to are returned as is.
+class ExprRewriter {
+  ExprFactory &m_efac;
+  op::boolop::TrivialSimplifier m_bool;
+  Expr m_true;
+  Expr m_false;
+
+  /// simplified form of every rewritten node, keyed by node id
+  DagVisitCache m_cache;
+  /// maximal number of memoized results, 0 for unbounded
+  size_t m_capacity;
+  /// 1 + largest free bound variable of a node (0 if closed), by node id
+  llvm::DenseMap<unsigned, unsigned> m_free;
+
+  /// set by a rule whose result must be rewritten again as a whole
+  bool m_again;
+  /// nesting of ITE lifting
+  unsigned m_liftDepth;
+
+  /// \brief Maximal nesting of ITE terms that operators are lifted over
+  static constexpr unsigned MAX_LIFT_DEPTH = 8;
+
+public:
+  /// \brief Default number of memoized results
+  static constexpr size_t DEFAULT_CAPACITY = 1 << 20;
+
+private:
+
+  // -- substitutes a closed term for a bound variable
+  struct Instantiate {
+    ExprRewriter &m_rw;
+    Expr m_val;
+    unsigned m_depth;
+
+    VisitAction operator()(Expr e) const {
+      if (m_rw.freeBound(e) <= m_depth)
+        return VisitAction::skipKids();
+      if (op::bind::isBVar(e)) {
+        unsigned idx = op::bind::bvarId(e);
+        if (idx == m_depth)
+          return VisitAction::changeTo(m_val);
+        // -- bound outside of the reduced lambda
+        return VisitAction::changeTo(
+            op::bind::bvar(idx - 1, op::bind::type(e)));
+      }
+      if (isOp<op::BinderOp>(e)) {
+        Instantiate inner{m_rw, m_val, m_depth + op::bind::numBound(e)};
+        ExprVector kids(e->args_begin(), e->args_end());
+        kids.back() = dagVisit(inner, kids.back());
+        return VisitAction::changeTo(e->efac().mkNary(e->op(), kids));
+      }
+      return VisitAction::doKids();
+    }
+  };
+
+public:
+  explicit ExprRewriter(ExprFactory &efac,
+                        size_t capacity = DEFAULT_CAPACITY)
+      : m_efac(efac), m_bool(efac), m_true(mk<TRUE>(efac)),
+        m_false(mk<FALSE>(efac)), m_capacity(capacity), m_again(false),
+        m_liftDepth(0) {}
+  ExprRewriter(const ExprRewriter &) = delete;
+
+  /// \brief Returns a simplified term equivalent to \p e
+  Expr simplify(Expr e) {
+    if (!e)
+      return e;
+    // -- the cache only grows past its capacity within one call. The
+    // -- results of the calls in progress are held by their own stacks.
+    if (m_capacity > 0 && m_cache.size() >= m_capacity)
+      reset();
+
+    struct Frame {
+      /// node being rewritten
+      Expr expr;
+      /// index of the next kid to rewrite
+      unsigned next;
+      /// position of the result of the first kid on the result stack
+      size_t base;
+      /// the node is waiting for the rewrite of a term it was rewritten to
+      bool forward;
+    };
+    std::vector<Frame> stack;
+    std::vector<Expr> results;
+
+    auto finish = [&](const Expr &e, Expr res) {
+      m_cache[e->getId()] = res;
+      // -- results are in normal form
+      if (res != e)
+        m_cache.insert({res->getId(), res});
+      results.push_back(std::move(res));
+    };
+
+    auto enter = [&](Expr e) {
+      if (isOpaque(e)) {
+        results.push_back(std::move(e));
+        return;
+      }
+      auto it = m_cache.find(e->getId());
+      if (it != m_cache.end()) {
+        results.push_back(it->second);
+        return;
+      }
+      stack.push_back(Frame{std::move(e), 0, results.size(), false});
+    };
+
+    enter(e);
+    while (!stack.empty()) {
+      Frame &top = stack.back();
+      if (top.forward) {
+        Expr res = std::move(results.back());
+        results.pop_back();
+        Expr n = std::move(top.expr);
+        stack.pop_back();
+        finish(n, std::move(res));
+        continue;
+      }
+
+      if (top.next < top.expr->arity()) {
+        // -- top is invalidated by enter()
+        enter(top.expr->arg(top.next++));
+        continue;
+      }
+
+      Expr n = top.expr;
+      auto kids = results.begin() + top.base;
+      bool changed = false;
+      for (unsigned i = 0, sz = n->arity(); i < sz && !changed; ++i)
+        changed = kids[i].get() != n->arg(i);
+      if (changed)
+        n = m_efac.mkNary(n->op(), kids, results.end());
+      results.erase(kids, results.end());
+
+      m_again = false;
+      Expr res = rewriteNode(n);
+      if (m_again && res != n) {
+        top.forward = true;
+        enter(std::move(res));
+        continue;
+      }
+
+      n = std::move(top.expr);
+      stack.pop_back();
+      finish(n, std::move(res));
+    }
+
+    assert(results.size() == 1);
+    return results.back();
+  }
+
+  /// \brief Forgets all memoized results
+  void reset() {
+    m_cache.clear();
+    m_free.clear();
+  }
+
+  /// \brief Number of memoized results
+  size_t size() const { return m_cache.size(); }
+  /// \brief Maximal number of memoized results, 0 if unbounded
+  size_t capacity() const { return m_capacity; }
+
+private:
+  /// \brief Nodes that are never rewritten
+  static bool isOpaque(const Expr &e) {
+    return e->arity() == 0 || e->isMutable() || isOpX<BIND>(e) ||
+           isOpX<FDECL>(e);
+  }
+
+  // -- bit-vector helpers
+
+  /// \brief Extracts the value and width of a bit-vector numeral
+  static bool isNum(const Expr &e, mpz_class &v, unsigned &w) {
+    if (!op::bv::isBvNum(e, w))
+      return false;
+    v = rewrite_detail::wrap(op::bv::toMpz(e), w);
+    return true;
+  }
+
+  Expr mkNum(const mpz_class &v, unsigned w) {
+    return op::bv::bvnum(rewrite_detail::wrap(v, w), w, m_efac);
+  }
+
+  Expr mkBool(bool b) { return b ? m_true : m_false; }
+
+  /// \brief Width of a bit-vector term, or 0 if it is not known locally
+  static unsigned width(Expr e) {
+    while (true) {
+      if (isOpX<BIND>(e))
+        return isOpX<BVSORT>(e->right()) ? op::bv::width(e->right()) : 0;
+      if (isOpX<FAPP>(e)) {
+        Expr fn = e->first();
+        if (isOpX<LAMBDA>(fn)) {
+          e = op::bind::body(fn);
+          continue;
+        }
+        if (!isOpX<FDECL>(fn))
+          return 0;
+        Expr ty = op::bind::rangeTy(fn);
+        // -- application of an array constant
+        if (isOpX<ARRAY_TY>(ty) && e->arity() == 2)
+          ty = op::sort::arrayValTy(ty);
+        return isOpX<BVSORT>(ty) ? op::bv::width(ty) : 0;
+      }
+      if (isOpX<BEXTRACT>(e))
+        return op::bv::high(e) - op::bv::low(e) + 1;
+      if (isOpX<BCONCAT>(e)) {
+        unsigned w = 0;
+        for (auto *k : llvm::make_range(e->args_begin(), e->args_end())) {
+          unsigned kw = width(k);
+          if (kw == 0)
+            return 0;
+          w += kw;
+        }
+        return w;
+      }
+      if (isOpX<BSEXT>(e) || isOpX<BZEXT>(e))
+        return op::bv::width(e->right());
+      if (isOpX<ITE>(e)) {
+        e = e->arg(1);
+        continue;
+      }
+      if (isOpX<SELECT>(e)) {
+        Expr a = e->left();
+        if (isOpX<STORE>(a)) {
+          e = a->arg(2);
+          continue;
+        }
+        if (op::bind::isArrayConst(a)) {
+          Expr ty = op::sort::arrayValTy(op::bind::rangeTy(a->first()));
+          return isOpX<BVSORT>(ty) ? op::bv::width(ty) : 0;
+        }
+        return 0;
+      }
+      if (isOpX<BNOT>(e) || isOpX<BNEG>(e) || isOpX<BAND>(e) ||
+          isOpX<BOR>(e) || isOpX<BXOR>(e) || isOpX<BNAND>(e) ||
+          isOpX<BNOR>(e) || isOpX<BXNOR>(e) || isOpX<BADD>(e) ||
+          isOpX<BSUB>(e) || isOpX<BMUL>(e) || isOpX<BUDIV>(e) ||
+          isOpX<BSDIV>(e) || isOpX<BUREM>(e) || isOpX<BSREM>(e) ||
+          isOpX<BSMOD>(e) || isOpX<BSHL>(e) || isOpX<BLSHR>(e) ||
+          isOpX<BASHR>(e)) {
+        e = e->first();
+        continue;
+      }
+      return 0;
+    }
+  }
+
+  /// \brief Splits \p e into \p base + \p off
+  ///
+  /// \p base is null if \p e is a numeral. Returns false if the width of
+  /// \p e is not known.
+  static bool splitOffset(Expr e, Expr &base, mpz_class &off, unsigned &w) {
+    if (isNum(e, off, w)) {
+      base = Expr();
+      return true;
+    }
+    if (isOpX<BADD>(e) && e->arity() == 2) {
+      if (isNum(e->right(), off, w)) {
+        base = e->left();
+        return true;
+      }
+      if (isNum(e->left(), off, w)) {
+        base = e->right();
+        return true;
+      }
+    }
+    base = e;
+    off = 0UL;
+    w = width(e);
+    return w > 0;
+  }
+
+  /// \brief Decides equality of two simplified terms
+  ///
+  /// \return 1 if they are equal, -1 if they are distinct, and 0 if unknown
+  static int compare(const Expr &a, const Expr &b) {
+    if (a == b)
+      return 1;
+    if (rewrite_detail::isValue(a) && rewrite_detail::isValue(b)) {
+      mpz_class va, vb;
+      unsigned wa, wb;
+      if (isNum(a, va, wa) && isNum(b, vb, wb))
+        return wa != wb ? 0 : va == vb ? 1 : -1;
+      // -- other values are hash-consed
+      bool ba = isOpX<TRUE>(a) || isOpX<FALSE>(a);
+      bool bb = isOpX<TRUE>(b) || isOpX<FALSE>(b);
+      if ((ba && bb) || (isOpX<MPZ>(a) && isOpX<MPZ>(b)))
+        return -1;
+      return 0;
+    }
+    // -- x + c1 and x + c2
+    Expr ba, bb;
+    mpz_class oa, ob;
+    unsigned wa, wb;
+    if (splitOffset(a, ba, oa, wa) && splitOffset(b, bb, ob, wb) && ba == bb &&
+        wa == wb)
+      return oa == ob ? 1 : -1;
+    return 0;
+  }
+
+  // -- bound variables
+
+  /// \brief 1 + index of the largest free bound variable of \p e
+  ///
+  /// 0 if \p e is closed. Memoized by node id.
+  unsigned freeBound(const Expr &e) {
+    auto direct = [](ENode *n, unsigned &res) {
+      if (n->arity() == 0 || isOpX<FDECL>(n)) {
+        res = 0;
+        return true;
+      }
+      if (op::bind::isBVar(n)) {
+        res = op::bind::bvarId(n) + 1;
+        return true;
+      }
+      return false;
+    };
+
+    unsigned res;
+    if (direct(e.get(), res))
+      return res;
+
+    std::vector<ENode *> todo{e.get()};
+    while (!todo.empty()) {
+      ENode *n = todo.back();
+      if (m_free.count(n->getId())) {
+        todo.pop_back();
+        continue;
+      }
+
+      bool ready = true;
+      unsigned max = 0;
+      for (ENode *k : llvm::make_range(n->args_begin(), n->args_end())) {
+        unsigned kf;
+        if (!direct(k, kf)) {
+          auto it = m_free.find(k->getId());
+          if (it == m_free.end()) {
+            todo.push_back(k);
+            ready = false;
+            continue;
+          }
+          kf = it->second;
+        }
+        max = std::max(max, kf);
+      }
+      if (!ready)
+        continue;
+
+      if (isOp<op::BinderOp>(n)) {
+        unsigned bound = n->arity() - 1;
+        max = max > bound ? max - bound : 0;
+      }
+      m_free[n->getId()] = max;
+      todo.pop_back();
+    }
+    return m_free.lookup(e->getId());
+  }
+
+  /// \brief Substitutes closed \p val for bound variable 0 of \p body
+  Expr instantiate(Expr body, Expr val) {
+    Instantiate inst{*this, val, 0};
+    return dagVisit(inst, body);
+  }
+
+  // -- rules. Kids of the node are already simplified
+
+  Expr rewriteNode(Expr e) {
+    if (isOpX<ITE>(e))
+      return rewriteIte(e);
+    if (isOp<BoolOp>(e))
+      return rewriteBool(e);
+    if (isOpX<EQ>(e) || isOpX<NEQ>(e))
+      return rewriteEq(e);
+    if (isOpX<BEXTRACT>(e))
+      return rewriteExtract(e);
+    if (isOpX<BCONCAT>(e))
+      return rewriteConcat(e);
+    if (isOp<BvOp>(e))
+      return rewriteBv(e);
+    if (isOpX<SELECT>(e))
+      return rewriteSelect(e);
+    if (isOpX<FAPP>(e))
+      return rewriteFapp(e);
+    return e;
+  }
+
+  Expr rewriteBool(Expr e) {
+    Expr res = m_bool(e);
+    if (res != e)
+      return res;
+
+    if ((isOpX<AND>(e) || isOpX<OR>(e)) && e->arity() > 2) {
+      // -- drop neutral elements
+      Expr unit = isOpX<AND>(e) ? m_true : m_false;
+      ExprVector args;
+      for (auto *a : llvm::make_range(e->args_begin(), e->args_end()))
+        if (a != unit.get())
+          args.push_back(a);
+      if (args.size() == e->arity())
+        return e;
+      if (args.empty())
+        return unit;
+      if (args.size() == 1)
+        return args[0];
+      return rewriteBool(m_efac.mkNary(e->op(), args));
+    }
+
+    if (isOpX<XOR>(e) && e->arity() == 2) {
+      Expr a = e->left(), b = e->right();
+      if (a == b)
+        return m_false;
+      if (isOpX<FALSE>(a))
+        return b;
+      if (isOpX<FALSE>(b))
+        return a;
+      if (isOpX<TRUE>(a))
+        return m_bool(mk<NEG>(b));
+      if (isOpX<TRUE>(b))
+        return m_bool(mk<NEG>(a));
+    }
+    return e;
+  }
+
+  Expr rewriteIte(Expr e) {
+    Expr c = e->arg(0), t = e->arg(1), f = e->arg(2);
+    if (isOpX<TRUE>(c))
+      return t;
+    if (isOpX<FALSE>(c))
+      return f;
+    if (t == f)
+      return t;
+
+    // -- ite(!c, t, f) = ite(c, f, t)
+    if (isOpX<NEG>(c))
+      return rewriteIte(mk<ITE>(c->left(), f, t));
+
+    // -- Boolean ITE
+    if (isOpX<TRUE>(t) && isOpX<FALSE>(f))
+      return c;
+    if (isOpX<FALSE>(t) && isOpX<TRUE>(f))
+      return m_bool(mk<NEG>(c));
+    if (isOpX<TRUE>(t))
+      return m_bool(mk<OR>(c, f));
+    if (isOpX<FALSE>(f))
+      return m_bool(mk<AND>(c, t));
+    if (isOpX<FALSE>(t))
+      return m_bool(mk<AND>(m_bool(mk<NEG>(c)), f));
+    if (isOpX<TRUE>(f))
+      return m_bool(mk<OR>(m_bool(mk<NEG>(c)), t));
+
+    // -- ite(c, ite(c, a, b), f) = ite(c, a, f)
+    if (isOpX<ITE>(t) && t->arg(0) == c)
+      return rewriteIte(mk<ITE>(c, t->arg(1), f));
+    // -- ite(c, t, ite(c, a, b)) = ite(c, t, b)
+    if (isOpX<ITE>(f) && f->arg(0) == c)
+      return rewriteIte(mk<ITE>(c, t, f->arg(2)));
+    return e;
+  }
+
+  Expr rewriteEq(Expr e) {
+    if (e->arity() != 2)
+      return e;
+    bool neq = isOpX<NEQ>(e);
+    Expr a = e->left(), b = e->right();
+
+    int cmp = compare(a, b);
+    if (cmp != 0)
+      return mkBool((cmp > 0) != neq);
+
+    // -- x = true is x
+    if (isOpX<TRUE>(b) || isOpX<FALSE>(b))
+      std::swap(a, b);
+    if (isOpX<TRUE>(a))
+      return neq ? m_bool(mk<NEG>(b)) : b;
+    if (isOpX<FALSE>(a))
+      return neq ? b : m_bool(mk<NEG>(b));
+
+    return liftIte(e);
+  }
+
+  Expr rewriteBv(Expr e) {
+    using namespace rewrite_detail;
+    if (e->arity() == 1) {
+      Expr a = e->first();
+      mpz_class v;
+      unsigned w;
+      if (isNum(a, v, w)) {
+        if (isOpX<BNOT>(e))
+          mpz_xor(v.get_mpz_t(), v.get_mpz_t(), ones(w).get_mpz_t());
+        else if (isOpX<BNEG>(e))
+          v = neg(v);
+        else
+          return e;
+        return mkNum(v, w);
+      }
+      // -- involutions
+      if ((isOpX<BNOT>(e) && isOpX<BNOT>(a)) ||
+          (isOpX<BNEG>(e) && isOpX<BNEG>(a)))
+        return a->first();
+      return liftIte(e);
+    }
+
+    if (isOpX<BSEXT>(e) || isOpX<BZEXT>(e)) {
+      Expr a = e->left();
+      unsigned ow = op::bv::width(e->right());
+      mpz_class v;
+      unsigned w;
+      if (isNum(a, v, w))
+        return mkNum(isOpX<BSEXT>(e) ? toSigned(v, w) : v, ow);
+      if (width(a) == ow)
+        return a;
+      return liftIte(e);
+    }
+
+    if (e->arity() != 2)
+      return e;
+
+    Expr a = e->left(), b = e->right();
+    mpz_class va, vb;
+    unsigned wa = 0, wb = 0;
+    bool na = isNum(a, va, wa), nb = isNum(b, vb, wb);
+    unsigned w = na ? wa : wb;
+
+    if (na && nb && wa == wb)
+      return foldBinary(e, va, vb, w);
+
+    // -- put the numeral of commutative operators on the right
+    if (na && !nb &&
+        (isOpX<BADD>(e) || isOpX<BMUL>(e) || isOpX<BAND>(e) ||
+         isOpX<BOR>(e) || isOpX<BXOR>(e))) {
+      std::swap(a, b);
+      std::swap(va, vb);
+      std::swap(na, nb);
+      e = m_efac.mkBin(e->op(), a, b);
+    }
+
+    if (isOpX<BADD>(e)) {
+      if (nb && vb.sgn() == 0)
+        return a;
+      // -- (x + c1) + c2 = x + (c1 + c2)
+      mpz_class vc;
+      unsigned wc;
+      if (nb && isOpX<BADD>(a) && a->arity() == 2 && isNum(a->right(), vc, wc)) {
+        mpz_class sum;
+        mpz_add(sum.get_mpz_t(), vb.get_mpz_t(), vc.get_mpz_t());
+        sum = wrap(sum, w);
+        return sum.sgn() == 0 ? a->left()
+                              : mk<BADD>(a->left(), mkNum(sum, w));
+      }
+    } else if (isOpX<BSUB>(e)) {
+      if (a == b && (w = width(a)))
+        return mkNum(0UL, w);
+      // -- x - c = x + (-c)
+      if (nb)
+        return rewriteBv(mk<BADD>(a, mkNum(neg(vb), w)));
+    } else if (isOpX<BMUL>(e)) {
+      if (nb && vb.sgn() == 0)
+        return b;
+      if (nb && vb == mpz_class(1UL))
+        return a;
+    } else if (isOpX<BAND>(e) || isOpX<BOR>(e)) {
+      bool isAnd = isOpX<BAND>(e);
+      if (a == b)
+        return a;
+      if (nb && vb.sgn() == 0)
+        return isAnd ? b : a;
+      if (nb && vb == ones(w))
+        return isAnd ? a : b;
+    } else if (isOpX<BXOR>(e)) {
+      if (a == b && (w = width(a)))
+        return mkNum(0UL, w);
+      if (nb && vb.sgn() == 0)
+        return a;
+    } else if (isOpX<BSHL>(e) || isOpX<BLSHR>(e) || isOpX<BASHR>(e)) {
+      if (nb && vb.sgn() == 0)
+        return a;
+      if (nb && !isOpX<BASHR>(e) && vb >= (unsigned long)w)
+        return mkNum(0UL, w);
+    } else if (isOpX<BUDIV>(e)) {
+      if (nb && vb == mpz_class(1UL))
+        return a;
+    } else if (isOpX<BUREM>(e)) {
+      if (nb && vb == mpz_class(1UL))
+        return mkNum(0UL, w);
+    } else if (isOpX<BULE>(e) || isOpX<BSLE>(e) || isOpX<BUGE>(e) ||
+               isOpX<BSGE>(e)) {
+      if (a == b)
+        return m_true;
+      // -- 0 <= x
+      if ((isOpX<BULE>(e) && na && va.sgn() == 0) ||
+          (isOpX<BUGE>(e) && nb && vb.sgn() == 0))
+        return m_true;
+    } else if (isOpX<BULT>(e) || isOpX<BSLT>(e) || isOpX<BUGT>(e) ||
+               isOpX<BSGT>(e)) {
+      if (a == b)
+        return m_false;
+      // -- x < 0
+      if ((isOpX<BULT>(e) && nb && vb.sgn() == 0) ||
+          (isOpX<BUGT>(e) && na && va.sgn() == 0))
+        return m_false;
+    }
+    return liftIte(e);
+  }
+
+  /// \brief Folds a binary bit-vector operator over numerals
+  Expr foldBinary(Expr e, const mpz_class &va, const mpz_class &vb,
+                  unsigned w) {
+    using namespace rewrite_detail;
+    mpz_class r;
+    mpz_ptr rp = r.get_mpz_t();
+    mpz_srcptr ap = va.get_mpz_t(), bp = vb.get_mpz_t();
+
+    if (isOpX<BADD>(e))
+      mpz_add(rp, ap, bp);
+    else if (isOpX<BSUB>(e))
+      mpz_sub(rp, ap, bp);
+    else if (isOpX<BMUL>(e))
+      mpz_mul(rp, ap, bp);
+    else if (isOpX<BAND>(e) || isOpX<BNAND>(e))
+      mpz_and(rp, ap, bp);
+    else if (isOpX<BOR>(e) || isOpX<BNOR>(e))
+      mpz_ior(rp, ap, bp);
+    else if (isOpX<BXOR>(e) || isOpX<BXNOR>(e))
+      mpz_xor(rp, ap, bp);
+    else if (isOpX<BUDIV>(e)) {
+      // -- division by zero is all ones in SMT-LIB
+      if (vb.sgn() == 0)
+        r = ones(w);
+      else
+        mpz_fdiv_q(rp, ap, bp);
+    } else if (isOpX<BUREM>(e)) {
+      if (vb.sgn() == 0)
+        r = va;
+      else
+        mpz_fdiv_r(rp, ap, bp);
+    } else if (isOpX<BSDIV>(e) || isOpX<BSREM>(e) || isOpX<BSMOD>(e)) {
+      if (vb.sgn() == 0) {
+        // -- signed division by zero depends on the sign of the dividend
+        if (!isOpX<BSREM>(e) && !isOpX<BSMOD>(e))
+          return e;
+        r = va;
+      } else {
+        mpz_class sa = toSigned(va, w), sb = toSigned(vb, w);
+        if (isOpX<BSDIV>(e))
+          mpz_tdiv_q(rp, sa.get_mpz_t(), sb.get_mpz_t());
+        else if (isOpX<BSREM>(e))
+          mpz_tdiv_r(rp, sa.get_mpz_t(), sb.get_mpz_t());
+        else
+          // -- the remainder has the sign of the divisor
+          mpz_fdiv_r(rp, sa.get_mpz_t(), sb.get_mpz_t());
+      }
+    } else if (isOpX<BSHL>(e) || isOpX<BLSHR>(e) || isOpX<BASHR>(e)) {
+      unsigned long sh =
+          vb >= (unsigned long)w ? (unsigned long)w : vb.get_ui();
+      if (isOpX<BSHL>(e))
+        mpz_mul_2exp(rp, ap, sh);
+      else if (isOpX<BLSHR>(e))
+        mpz_fdiv_q_2exp(rp, ap, sh);
+      else
+        mpz_fdiv_q_2exp(rp, toSigned(va, w).get_mpz_t(), sh);
+    } else if (isOpX<BULT>(e))
+      return mkBool(va < vb);
+    else if (isOpX<BULE>(e))
+      return mkBool(va <= vb);
+    else if (isOpX<BUGT>(e))
+      return mkBool(va > vb);
+    else if (isOpX<BUGE>(e))
+      return mkBool(va >= vb);
+    else if (isOpX<BSLT>(e))
+      return mkBool(toSigned(va, w) < toSigned(vb, w));
+    else if (isOpX<BSLE>(e))
+      return mkBool(toSigned(va, w) <= toSigned(vb, w));
+    else if (isOpX<BSGT>(e))
+      return mkBool(toSigned(va, w) > toSigned(vb, w));
+    else if (isOpX<BSGE>(e))
+      return mkBool(toSigned(va, w) >= toSigned(vb, w));
+    else
+      return e;
+
+    if (isOpX<BNAND>(e) || isOpX<BNOR>(e) || isOpX<BXNOR>(e))
+      mpz_xor(rp, rp, ones(w).get_mpz_t());
+    return mkNum(r, w);
+  }
+
+  Expr rewriteExtract(Expr e) {
+    unsigned hi = op::bv::high(e), lo = op::bv::low(e);
+    Expr x = op::bv::earg(e);
+    bool changed = false;
+
+    // -- narrow down the term that the bits come from
+    while (true) {
+      mpz_class v;
+      unsigned w;
+      if (isNum(x, v, w)) {
+        mpz_class r;
+        mpz_fdiv_q_2exp(r.get_mpz_t(), v.get_mpz_t(), lo);
+        return mkNum(r, hi - lo + 1);
+      }
+
+      if (isOpX<BEXTRACT>(x)) {
+        unsigned base = op::bv::low(x);
+        hi += base;
+        lo += base;
+        x = op::bv::earg(x);
+        changed = true;
+        continue;
+      }
+
+      if (isOpX<BCONCAT>(x) && x->arity() == 2) {
+        unsigned wl = width(x->right());
+        if (wl > 0 && hi < wl) {
+          x = x->right();
+          changed = true;
+          continue;
+        }
+        if (wl > 0 && lo >= wl) {
+          hi -= wl;
+          lo -= wl;
+          x = x->left();
+          changed = true;
+          continue;
+        }
+      }
+
+      if (isOpX<BZEXT>(x) || isOpX<BSEXT>(x)) {
+        unsigned wx = width(x->left());
+        if (wx > 0 && hi < wx) {
+          x = x->left();
+          changed = true;
+          continue;
+        }
+        if (wx > 0 && lo >= wx && isOpX<BZEXT>(x))
+          return mkNum(0UL, hi - lo + 1);
+      }
+      break;
+    }
+
+    // -- all bits of x
+    if (lo == 0 && width(x) == hi + 1)
+      return x;
+    if (changed)
+      e = op::bv::extract(hi, lo, x);
+    return liftIte(e);
+  }
+
+  Expr rewriteConcat(Expr e) {
+    if (e->arity() != 2)
+      return e;
+    Expr a = e->left(), b = e->right();
+
+    mpz_class va, vb;
+    unsigned wa, wb;
+    if (isNum(a, va, wa) && isNum(b, vb, wb)) {
+      mpz_class r;
+      mpz_mul_2exp(r.get_mpz_t(), va.get_mpz_t(), wb);
+      mpz_ior(r.get_mpz_t(), r.get_mpz_t(), vb.get_mpz_t());
+      return mkNum(r, wa + wb);
+    }
+
+    // -- adjacent slices of the same term
+    auto fuse = [this](Expr hi, Expr lo) -> Expr {
+      if (isOpX<BEXTRACT>(hi) && isOpX<BEXTRACT>(lo) &&
+          op::bv::earg(hi) == op::bv::earg(lo) &&
+          op::bv::low(hi) == op::bv::high(lo) + 1)
+        return rewriteExtract(op::bv::extract(
+            op::bv::high(hi), op::bv::low(lo), op::bv::earg(hi)));
+      return Expr();
+    };
+
+    if (Expr r = fuse(a, b))
+      return r;
+    // -- concat(x[h:m], concat(x[m-1:l], y)) = concat(x[h:l], y)
+    if (isOpX<BCONCAT>(b) && b->arity() == 2)
+      if (Expr r = fuse(a, b->left()))
+        return rewriteConcat(op::bv::concat(r, b->right()));
+    // -- concat(concat(y, x[h:m]), x[m-1:l]) = concat(y, x[h:l])
+    if (isOpX<BCONCAT>(a) && a->arity() == 2)
+      if (Expr r = fuse(a->right(), b))
+        return rewriteConcat(op::bv::concat(a->left(), r));
+    return e;
+  }
+
+  /// \brief Read-over-write on arrays
+  Expr rewriteSelect(Expr e) {
+    Expr arr = e->left(), idx = e->right();
+    while (isOpX<STORE>(arr)) {
+      int cmp = compare(arr->arg(1), idx);
+      if (cmp > 0)
+        return arr->arg(2);
+      if (cmp == 0)
+        break;
+      arr = arr->arg(0);
+    }
+    if (isOpX<CONST_ARRAY>(arr))
+      return arr->right();
+    return arr == e->left() ? e : op::array::select(arr, idx);
+  }
+
+  /// \brief Read-over-write on lambda memories
+  ///
+  /// A write to a memory \c m is a lambda of the form
+  /// \c (lambda (a) (ite c v (m a))). A read at a closed address skips the
+  /// writes whose condition is false at that address, and is replaced by
+  /// the written value if the condition is true. Applications of any other
+  /// lambda are not reduced, so that the size of the term does not grow.
+  Expr rewriteFapp(Expr e) {
+    Expr fn = e->first();
+    if (!isOpX<LAMBDA>(fn) || e->arity() != 2)
+      return e;
+    Expr addr = e->arg(1);
+    if (freeBound(addr) != 0)
+      return e;
+
+    while (isOpX<LAMBDA>(fn) && op::bind::numBound(fn) == 1) {
+      Expr body = op::bind::body(fn);
+      if (!isOpX<ITE>(body))
+        break;
+
+      // -- the else branch must read the previous memory at the address
+      Expr els = body->arg(2);
+      if (!isOpX<FAPP>(els) || els->arity() != 2 ||
+          !op::bind::isBVar(els->arg(1)) || op::bind::bvarId(els->arg(1)) ||
+          freeBound(els->first()) != 0)
+        break;
+
+      Expr c = simplify(instantiate(body->arg(0), addr));
+      if (isOpX<TRUE>(c)) {
+        m_again = true;
+        return instantiate(body->arg(1), addr);
+      }
+      if (!isOpX<FALSE>(c))
+        break;
+      fn = els->first();
+    }
+
+    if (fn == e->first())
+      return e;
+    m_again = true;
+    return op::bind::fapp(fn, addr);
+  }
+
+  /// \brief Lifts \p e over an ITE argument whose branches fold to values
+  ///
+  /// \c op(ite(c, t, f), k) is rewritten to \c ite(c, op(t, k), op(f, k))
+  /// if all other arguments are constants and both applications simplify
+  /// to values.
+  Expr liftIte(Expr e) {
+    if (m_liftDepth >= MAX_LIFT_DEPTH)
+      return e;
+
+    int pos = -1;
+    for (unsigned i = 0, sz = e->arity(); i < sz; ++i) {
+      Expr a = e->arg(i);
+      if (isOpX<ITE>(a)) {
+        if (pos >= 0)
+          return e;
+        pos = i;
+      } else if (!rewrite_detail::isValue(a) && a->arity() > 0)
+        return e;
+    }
+    if (pos < 0)
+      return e;
+
+    Expr ite = e->arg(pos);
+    ExprVector args(e->args_begin(), e->args_end());
+
+    ++m_liftDepth;
+    bool again = m_again;
+    args[pos] = ite->arg(1);
+    Expr t = rewriteNode(m_efac.mkNary(e->op(), args));
+    args[pos] = ite->arg(2);
+    Expr f = rewriteNode(m_efac.mkNary(e->op(), args));
+    m_again = again;
+    --m_liftDepth;
+
+    if (!rewrite_detail::isValue(t) || !rewrite_detail::isValue(f))
+      return e;
+    return rewriteIte(mk<ITE>(ite->arg(0), t, f));
+  }
+};
+} // namespace expr
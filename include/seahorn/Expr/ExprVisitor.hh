@@ -3,6 +3,8 @@
 
 #include "seahorn/Expr/ExprCore.hh"
 
+#include "llvm/ADT/DenseMap.h"
+
 namespace expr {
 struct BoolExprFn {
   virtual ~BoolExprFn() {}
@@ -27,55 +29,49 @@ struct ExprFn {
   virtual Expr apply(Expr e) = 0;
 };
 
-namespace {
-template <typename T> struct ExprFunctionoid : public ExprFn {
-  using fn_type = std::shared_ptr<T>;
-
-  fn_type fn;
-
-  ExprFunctionoid(T *f) : fn_type(fn) {}
-  ExprFunctionoid(fn_type f) : fn(f) {}
-  Expr apply(Expr e) { return (*fn)(e); }
-};
-} // namespace
-
 class VisitAction {
 protected:
   bool m_skipKids;
   Expr m_expr;
 
 private:
-  std::shared_ptr<ExprFn> m_fn;
+  /// \brief Rewriter applied after the kids are visited. Null for identity
+  std::shared_ptr<const void> m_rw;
+  Expr (*m_apply)(const void *, Expr);
+
+  template <typename R> static Expr applyRewriter(const void *r, Expr e) {
+    return (*static_cast<R *>(const_cast<void *>(r)))(e);
+  }
 
 public:
   // skipKids or doKids
-  VisitAction(bool kids = false)
-      : m_skipKids(kids), m_fn(new ExprFunctionoid<IdentityRewriter>(
-                             std::make_shared<IdentityRewriter>())) {}
+  VisitAction(bool kids = false) : m_skipKids(kids), m_apply(nullptr) {}
+
+  // changeTo or doKids
+  VisitAction(Expr e, bool kids = false)
+      : m_skipKids(kids), m_expr(e), m_apply(nullptr) {}
 
   // changeTo or doKidsRewrite
   template <typename R>
-  VisitAction(Expr e, bool kids = false,
-              std::shared_ptr<R> r = std::make_shared<IdentityRewriter>())
-      : m_skipKids(kids), m_expr(e), m_fn(new ExprFunctionoid<R>(r)) {}
+  VisitAction(Expr e, bool kids, std::shared_ptr<R> r)
+      : m_skipKids(kids), m_expr(e), m_rw(std::move(r)),
+        m_apply(&applyRewriter<R>) {}
 
   bool isSkipKids() { return m_skipKids && m_expr.get() == nullptr; }
   bool isChangeTo() { return m_skipKids && m_expr.get() != nullptr; }
   bool isDoKids() { return !m_skipKids && m_expr.get() == nullptr; }
   bool isChangeDoKidsRewrite() { return !m_skipKids && m_expr.get() != nullptr; }
 
-  Expr rewrite(Expr v) { return m_fn->apply(v); }
+  Expr rewrite(Expr v) { return m_apply ? m_apply(m_rw.get(), v) : v; }
 
   Expr getExpr() { return m_expr; }
 
   static inline VisitAction skipKids() { return VisitAction(true); }
   static inline VisitAction doKids() { return VisitAction(false); }
-  static inline VisitAction changeTo(Expr e) {
-    return VisitAction(e, true, std::make_shared<IdentityRewriter>());
-  }
+  static inline VisitAction changeTo(Expr e) { return VisitAction(e, true); }
 
   static inline VisitAction changeDoKids(Expr e) {
-    return VisitAction(e, false, std::make_shared<IdentityRewriter>());
+    return VisitAction(e, false);
   }
 
   template <typename R>
@@ -85,63 +81,116 @@ public:
 
 };
 
-using DagVisitCache = std::unordered_map<ENode *, Expr>;
+/// \brief Results of a DAG visit, keyed by node id
+///
+/// Node ids are never reused, so the cache does not need to keep the visited
+/// nodes alive and can be reused by the caller across several visits.
+using DagVisitCache = llvm::DenseMap<unsigned, Expr>;
+
+namespace visit_detail {
+/// \brief A node whose kids are being visited
+struct VisitFrame {
+  /// the visited node
+  Expr expr;
+  /// action returned by the visitor for \p expr
+  VisitAction va;
+  /// node whose kids are visited
+  Expr res;
+  /// index of the next kid of \p res to visit
+  unsigned next;
+  /// position of the result of the first kid on the result stack
+  size_t base;
+};
 
+/// \brief Visits the DAG below \p expr without recursion
+///
+/// The visitor is called in pre-order and kids are visited left to right,
+/// exactly as a recursive traversal would. Results are assembled in
+/// post-order on an explicit stack, so the depth of the DAG is only limited
+/// by memory. If \p cache is not null, the results of shared nodes are
+/// memoized in it.
 template <typename ExprVisitor>
-Expr visit(ExprVisitor &v, Expr expr, DagVisitCache &cache) {
+Expr visit(ExprVisitor &v, Expr expr, DagVisitCache *cache) {
   if (!expr)
     return expr;
 
-  if (expr->use_count() > 1) {
-    DagVisitCache::const_iterator cit = cache.find(&*expr);
-    if (cit != cache.end())
-      return cit->second;
-  }
+  std::vector<VisitFrame> stack;
+  std::vector<Expr> results;
 
-  VisitAction va = v(expr);
-  Expr res;
+  auto finish = [&](const Expr &e, Expr res) {
+    if (cache && e->use_count() > 1)
+      (*cache)[e->getId()] = res;
+    results.push_back(std::move(res));
+  };
 
-  if (va.isSkipKids())
-    res = expr;
-  else if (va.isChangeTo())
-    res = va.getExpr();
-  else {
-    res = va.isChangeDoKidsRewrite() ? va.getExpr() : expr;
-    if (res->arity() > 0) {
-      bool changed = false;
-      std::vector<Expr> kids;
-
-      for (auto b = res->args_begin(), e = res->args_end(); b != e; ++b) {
-        Expr k = visit(v, *b, cache);
-        kids.push_back(k);
-        changed = (changed || k.get() != *b);
+  // -- calls the visitor on e. Pushes a frame if the kids must be visited,
+  // -- otherwise pushes the result
+  auto enter = [&](Expr e) {
+    if (cache && e->use_count() > 1) {
+      auto cit = cache->find(e->getId());
+      if (cit != cache->end()) {
+        results.push_back(cit->second);
+        return;
       }
+    }
 
-      if (changed) {
-        if (!res->isMutable())
-          res = res->getFactory().mkNary(res->op(), kids.begin(), kids.end());
-        else
-          res->renew_args(kids.begin(), kids.end());
-      }
+    VisitAction va = v(e);
+    if (va.isSkipKids())
+      finish(e, e);
+    else if (va.isChangeTo())
+      finish(e, va.getExpr());
+    else {
+      Expr res = va.isChangeDoKidsRewrite() ? va.getExpr() : e;
+      if (res->arity() == 0)
+        finish(e, va.rewrite(res));
+      else
+        stack.push_back(
+            VisitFrame{std::move(e), std::move(va), res, 0, results.size()});
     }
+  };
 
-    res = va.rewrite(res);
-  }
+  enter(expr);
+  while (!stack.empty()) {
+    VisitFrame &top = stack.back();
+    if (top.next < top.res->arity()) {
+      // -- top is invalidated by enter()
+      enter(top.res->arg(top.next++));
+      continue;
+    }
 
-  if (expr->use_count() > 1) {
-    expr->Ref();
-    cache[&*expr] = res;
+    Expr res = top.res;
+    auto kids = results.begin() + top.base;
+    bool changed = false;
+    for (unsigned i = 0, sz = res->arity(); i < sz && !changed; ++i)
+      changed = kids[i].get() != res->arg(i);
+
+    if (changed) {
+      if (!res->isMutable())
+        res = res->getFactory().mkNary(res->op(), kids, results.end());
+      else
+        res->renew_args(kids, results.end());
+    }
+    results.erase(kids, results.end());
+
+    res = top.va.rewrite(res);
+    Expr e = std::move(top.expr);
+    stack.pop_back();
+    finish(e, std::move(res));
   }
 
-  return res;
+  assert(results.size() == 1);
+  return results.back();
 }
+} // namespace visit_detail
 
-inline void clearDagVisitCache(DagVisitCache &cache) {
-  for (DagVisitCache::value_type &kv : cache)
-    kv.first->efac().Deref(kv.first);
-  cache.clear();
+/// \brief Visits the DAG below \p expr memoizing results of shared nodes
+template <typename ExprVisitor>
+Expr visit(ExprVisitor &v, Expr expr, DagVisitCache &cache) {
+  return visit_detail::visit(v, expr, &cache);
 }
 
+inline void clearDagVisitCache(DagVisitCache &cache) { cache.clear(); }
+
 template <typename ExprVisitor>
 struct DagVisit : public std::unary_function<Expr, Expr> {
   ExprVisitor &m_v;
@@ -167,39 +216,9 @@ void dagVisit(ExprVisitor &v, const ExprVector &vec) {
   }
 }
 
+/// \brief Visits \p expr as a tree, without memoization
 template <typename ExprVisitor> Expr visit(ExprVisitor &v, Expr expr) {
-  VisitAction va = v(expr);
-
-  if (va.isSkipKids())
-    return expr;
-
-  if (va.isChangeTo())
-    return va.getExpr();
-
-  Expr res = va.isChangeDoKidsRewrite() ? va.getExpr() : expr;
-
-  if (res->arity() == 0)
-    return va.rewrite(res);
-
-  bool changed = false;
-  std::vector<Expr> kids;
-
-  for (auto b = res->args_begin(), e = res->args_end(); b != e; ++b) {
-    Expr k = visit(v, *b);
-    kids.push_back(k);
-    changed = (changed || k.get() != *b);
-  }
-
-  if (changed) {
-    if (!res->isMutable())
-      res = res->getFactory().mkNary(res->op(), kids.begin(), kids.end());
-    else
-      res->renew_args(kids.begin(), kids.end());
-  }
-
-  res = va.rewrite(res);
-
-  return res;
+  return visit_detail::visit(v, expr, nullptr);
 }
 } // namespace expr
 
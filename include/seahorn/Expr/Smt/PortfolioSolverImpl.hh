@@ -0,0 +1,82 @@
+#pragma once
+
+#include "seahorn/Expr/Smt/Solver.hh"
+
+#include <functional>
+#include <vector>
+
+namespace seahorn {
+namespace solver {
+
+/* A portfolio of solvers.
+
+   Formulas are asserted to every solver. A check runs all solvers at
+   once, each on its own thread, and the first SAT or UNSAT answer
+   wins. The other solvers are interrupted. Models and unsat cores
+   come from the solver that won the last check.
+
+   Solvers never share state, but they marshal expressions while
+   checking with assumptions. Hence, the expression factory must be
+   concurrent (see ExprFactory(bool)).
+*/
+class portfolio_solver_impl : public Solver {
+public:
+  using model_ref = typename Solver::model_ref;
+  using solver_ref = std::unique_ptr<Solver>;
+
+private:
+  expr::ExprFactory &m_efac;
+  std::vector<solver_ref> m_solvers;
+  /* index of the solver that answered the last check, or -1 */
+  int m_winner;
+  SolverResult m_last_result;
+  /* timeout of a check in seconds, 0 for none */
+  unsigned m_timeout;
+
+  /* Runs check on every solver and returns the first definitive answer */
+  SolverResult race(const std::function<SolverResult(Solver &)> &check);
+
+public:
+  portfolio_solver_impl(expr::ExprFactory &efac,
+                        std::vector<solver_ref> solvers);
+
+  ~portfolio_solver_impl() = default;
+
+  SolverKind get_kind() const override { return SolverKind::PORTFOLIO; }
+
+  /* Solvers of the portfolio */
+  const std::vector<solver_ref> &solvers() const { return m_solvers; }
+
+  /* Solver that answered the last check, if any */
+  Solver *winner() const {
+    return m_winner < 0 ? nullptr : m_solvers[m_winner].get();
+  }
+
+  /* Bound the time of every check. 0 disables the timeout */
+  void set_timeout(unsigned sec) { m_timeout = sec; }
+
+  bool add(expr::Expr exp) override;
+
+  SolverResult check() override;
+
+  SolverResult check_with_assumptions(const expr_const_it_range &lits) override;
+
+  void unsat_core(expr::ExprVector &out) override;
+
+  void push() override;
+
+  void pop() override;
+
+  model_ref get_model() override;
+
+  void reset() override;
+
+  void interrupt() override;
+
+  void to_smt_lib(llvm::raw_ostream &o) override;
+};
+
+/* Name of a solver kind, as used by command line options and Stats */
+const char *solver_kind_name(SolverKind kind);
+} // namespace solver
+} // namespace seahorn
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "seahorn/Expr/Expr.hh"
+
+#include "llvm/Support/raw_ostream.h"
+
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace seahorn {
+/// \brief Writes expressions in SMT-LIB2 straight to a stream
+///
+/// Needs no solver context. Every term is written once: terms used more
+/// than once are named, with define-fun by defineShared() when they are
+/// closed and their sort is known, and with let otherwise. The output is
+/// linear in the size of the DAG, and only the names of shared terms are
+/// kept in memory. Terms are written without recursion.
+class SmtLibWriter {
+public:
+  explicit SmtLibWriter(llvm::raw_ostream &out)
+      : m_out(out), m_nextName(0), m_unsupported(0) {}
+
+  llvm::raw_ostream &out() { return m_out; }
+
+  /// number of terms written so far that have no SMT-LIB counterpart
+  unsigned unsupported() const { return m_unsupported; }
+
+  void writeSort(expr::Expr sort);
+  /// writes the name of a function declaration
+  void writeSymbol(expr::Expr fdecl);
+  /// writes e, naming its shared sub-terms with let
+  void writeTerm(expr::Expr e);
+
+  /// writes (declare-fun ...) for fdecl
+  void declareFun(expr::Expr fdecl);
+  /// fdecl is declared elsewhere, or bound, and must not be declared
+  void markDeclared(expr::Expr fdecl) { m_declared.insert(fdecl); }
+  /// declares every uninterpreted function and constant of e that is
+  /// not declared yet
+  void declare(expr::Expr e);
+
+  /// defines every closed term used more than once in f with define-fun,
+  /// including the ones under binders
+  void defineShared(const expr::ExprVector &f);
+
+  /// writes the conjunction f as a sequence of asserts, preceded by the
+  /// declarations and definitions it needs
+  void assertAll(const expr::ExprVector &f);
+
+private:
+  struct Token {
+    enum Kind { TEXT, TERM, LET, ACTION } kind;
+    std::string text;
+    expr::Expr e;
+    std::function<void()> action;
+  };
+  /// name of a shared term, and the number of binders it is under
+  struct Binding {
+    unsigned id;
+    unsigned depth;
+  };
+
+  llvm::raw_ostream &m_out;
+  /// tokens left to write, last one first
+  std::vector<Token> m_todo;
+  /// binders around the term being written, innermost last
+  expr::ExprVector m_binders;
+  /// shared terms in scope
+  std::unordered_map<expr::Expr, Binding> m_names;
+  unsigned m_nextName;
+  expr::ExprSet m_declared;
+  /// sorts of terms, null when unknown. Reset after each call.
+  std::unordered_map<expr::Expr, expr::Expr> m_sorts;
+  unsigned m_unsupported;
+
+  void pushText(std::string s);
+  void pushTerm(expr::Expr e, Token::Kind kind = Token::TERM);
+  void run();
+
+  const Binding *lookup(expr::Expr e) const;
+  bool isAtom(expr::Expr e) const;
+  bool writeAtom(expr::Expr e);
+  void expand(expr::Expr e);
+  void expandLet(expr::Expr e);
+  template <typename F> void forEachKid(expr::Expr e, F f) const;
+  /// sub-terms of roots that are not atoms or named, in post-order, with
+  /// their number of uses. Binders are leaves unless binders is set.
+  void collectUses(const expr::ExprVector &roots,
+                   std::unordered_map<expr::Expr, unsigned> &uses,
+                   expr::ExprVector &post, bool binders = false) const;
+
+  expr::Expr sortOf(expr::Expr e);
+  std::string sortString(expr::Expr sort);
+  unsigned bvWidth(expr::Expr e);
+};
+} // namespace seahorn
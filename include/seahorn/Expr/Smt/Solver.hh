@@ -15,7 +15,7 @@ namespace seahorn {
 namespace solver {
 
 /** Kind of solver **/
-enum class SolverKind { Z3 , YICES2};
+enum class SolverKind { Z3 , YICES2, PORTFOLIO};
 
 /** Result of the check */
 enum class SolverResult {
@@ -68,6 +68,10 @@ public:
 
   /** Write asserted formulas to SMT-LIB format **/
   virtual void to_smt_lib(llvm::raw_ostream& o) = 0;
+
+  /** Stop a running check. Can be called from another thread. The
+      interrupted check returns UNKNOWN **/
+  virtual void interrupt() {}
     
 };
 }
@@ -80,6 +80,9 @@ public:
 
   /** Print asserted formulas to SMT-LIB format **/
   void to_smt_lib(llvm::raw_ostream& o);
+
+  /** Stop a running check */
+  void interrupt();
   
   ycache_t& get_cache(void);
   
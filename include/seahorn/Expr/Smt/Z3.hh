@@ -12,8 +12,6 @@
 #include <unordered_map>
 #include <unordered_set>
 
-#include <boost/bimap.hpp>
-#include <boost/bimap/unordered_set_of.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/logic/tribool.hpp>
 #include <boost/range/algorithm/copy.hpp>
@@ -22,21 +20,9 @@
 #include "seahorn/Expr/Expr.hh"
 #include "seahorn/Expr/ExprInterp.hh"
 #include "seahorn/Expr/ExprLlvm.hh"
-
-namespace z3 {
-struct ast_ptr_hash : public std::unary_function<ast, std::size_t> {
-  std::size_t operator()(const ast &ast) const {
-    std::hash<Z3_ast> hasher;
-    return hasher(static_cast<Z3_ast>(ast));
-  }
-};
-
-struct ast_ptr_equal_to : public std::binary_function<ast, ast, bool> {
-  bool operator()(const ast &a1, const ast &a2) const {
-    return static_cast<Z3_ast>(a1) == static_cast<Z3_ast>(a2);
-  }
-};
-} // namespace z3
+#include "seahorn/Expr/Smt/SmtLibWriter.hh"
+#include "seahorn/Expr/Smt/ZCache.hh"
+#include "seahorn/Support/SeaLog.hh"
 
 namespace seahorn {
 // -- fixedpoint class is missing from z3++.h
@@ -188,12 +174,9 @@ using namespace boost;
  */
 template <typename M, typename U> class ZContext {
 public:
-  using expr_cache_map = boost::bimaps::unordered_set_of<Expr>;
-  using z_cache_map = boost::bimaps::unordered_set_of<z3::ast, z3::ast_ptr_hash,
-                                                      z3::ast_ptr_equal_to>;
-  using cache_type = boost::bimap<expr_cache_map, z_cache_map>;
-  using expr_cache_type = typename cache_type::left_map;
-  using z_cache_type = typename cache_type::right_map;
+  using cache_type = ZCache;
+  using expr_cache_type = typename cache_type::expr_view;
+  using z_cache_type = typename cache_type::z_view;
 
 private:
   typedef ZContext<M, U> this_type;
@@ -254,14 +237,30 @@ protected:
   }
 
 public:
-  ZContext(ExprFactory &ef) : efac(ef), ctx(m_c) { init(); }
-  ZContext(ExprFactory &ef, z3::config &c) : efac(ef), ctx(c) { init(); }
+  ZContext(ExprFactory &ef) : efac(ef), ctx(m_c), cache(ZCacheBudget) {
+    init();
+  }
+  ZContext(ExprFactory &ef, z3::config &c)
+      : efac(ef), ctx(c), cache(ZCacheBudget) {
+    init();
+  }
   ZContext(const ZContext &) = delete;
 
-  ~ZContext() { cache.clear(); }
+  ~ZContext() {
+    cache.flushStats();
+    cache.clear();
+  }
+
+  /// \brief Cache of terminal expressions converted to and from Z3
+  ZCache &getCache() { return cache; }
 
   template <typename V> void set(char const *p, V v) { ctx.set(p, v); }
 
+  /// \brief Interrupts the running solver of this context, if any
+  ///
+  /// Safe to call from another thread
+  void interrupt() { ctx.interrupt(); }
+
   std::string toSmtLib(Expr e) {
     return boost::lexical_cast<std::string>(this->toAst(e));
   }
@@ -504,23 +503,21 @@ public:
   OutputStream &toSmtLibAssuming(OutputStream &out, const Range &rng) {
     ExprVector asserts;
     assertions(std::back_inserter(asserts));
-    out << z3.toSmtLibDecls(asserts);
-    out << "\n";
-
-#ifdef ZSOLVER_PRETTY_PRINT
-    // -- inefficient due to lack of sharing between expressions
-    for (const Expr &a : asserts)
-      out << "(assert " << z3.toSmtLib(a) << ")\n";
-#else
-    Z3_set_ast_print_mode(z3.get_ctx(), Z3_PRINT_SMTLIB2_COMPLIANT);
-    out << "(assert " << z3.toSmtLib(mknary<AND>(mk<TRUE>(efac), asserts))
-        << ")\n";
-#endif
+    // -- written without going through Z3, keeping the sharing
+    SmtLibWriter w(out);
+    for (const Expr &a : rng)
+      w.declare(a);
+    w.assertAll(asserts);
 
     out << "(check-sat";
-    for (const Expr &a : rng)
-      out << " " << *a;
+    for (const Expr &a : rng) {
+      out << " ";
+      w.writeTerm(a);
+    }
     out << ")\n";
+    if (w.unsupported() > 0)
+      WARN << "ZSolver: " << w.unsupported()
+           << " terms have no SMT-LIB2 counterpart";
     return out;
   }
 
@@ -632,7 +629,10 @@ public:
                                     Z3_to_func_decl(ctx, z3.toAst(fdecl)));
   }
 
-  template <typename Range> void addRule(const Range &vars, Expr rule) {
+  /// Adds a rule universally quantified over vars. A named rule is
+  /// reported by getCexRuleNames
+  template <typename Range>
+  void addRule(const Range &vars, Expr rule, const std::string &name = "") {
     if (isOpX<TRUE>(rule))
       return;
 
@@ -661,7 +661,9 @@ public:
                                               0, NULL, ast));
     }
 
-    Z3_fixedpoint_add_rule(ctx, fp, qexpr, static_cast<Z3_symbol>(0));
+    Z3_symbol sym = name.empty() ? static_cast<Z3_symbol>(0)
+                                 : Z3_mk_string_symbol(ctx, name.c_str());
+    Z3_fixedpoint_add_rule(ctx, fp, qexpr, sym);
   }
 
   void addQuery(Expr q) { m_queries.push_back(q); }
@@ -903,6 +905,22 @@ public:
       res.push_back(z3.toExpr(rule));
     }
   }
+
+  /// Names of the rules returned by getCexRules, in the same order. Rules
+  /// without a name, such as the one added for the query, have an empty name
+  void getCexRuleNames(std::vector<std::string> &res) {
+    Z3_symbol sym = Z3_fixedpoint_get_rule_names_along_trace(ctx, fp);
+    std::string names(Z3_get_symbol_string(ctx, sym));
+    size_t start = 0;
+    while (true) {
+      size_t end = names.find(';', start);
+      std::string name = names.substr(start, end - start);
+      res.push_back(name == "<null>" ? std::string() : name);
+      if (end == std::string::npos)
+        break;
+      start = end + 1;
+    }
+  }
 };
 
 } // namespace seahorn
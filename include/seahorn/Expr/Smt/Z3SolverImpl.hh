@@ -5,6 +5,8 @@
 #include "seahorn/Expr/Smt/Z3ModelImpl.hh"
 #include "llvm/Support/raw_ostream.h"
 
+#include <mutex>
+
 namespace seahorn {
 namespace solver {
 
@@ -13,7 +15,43 @@ class z3_solver_impl : public Solver {
   std::unique_ptr<EZ3> m_zctx;
   std::unique_ptr<ZSolver<EZ3>> m_solver;
   SolverResult m_last_result;
-  
+  /// guards m_in_check and m_interrupted
+  std::mutex m_interrupt_mutex;
+  /// true while a check is running
+  bool m_in_check;
+  /// true if the running check was interrupted
+  bool m_interrupted;
+
+  /// Runs \p solve and clears an interrupt that arrives after Z3 returned.
+  /// Z3 keeps such an interrupt and fails the next push or pop with it
+  template <typename Solve> SolverResult run_check(Solve solve) {
+    {
+      std::lock_guard<std::mutex> lock(m_interrupt_mutex);
+      m_in_check = true;
+      m_interrupted = false;
+    }
+    auto res = solve();
+    bool stale;
+    {
+      std::lock_guard<std::mutex> lock(m_interrupt_mutex);
+      m_in_check = false;
+      stale = m_interrupted;
+    }
+    // -- a check resets the interrupt of the context. One on an empty
+    // -- solver is immediate
+    if (stale)
+      ZSolver<EZ3>(*m_zctx).solve();
+
+    if (res) {
+      m_last_result = SolverResult::SAT;
+    } else if (!res) {
+      m_last_result = SolverResult::UNSAT;
+    } else {
+      m_last_result = SolverResult::UNKNOWN;
+    }
+    return m_last_result;
+  }
+
 public:
 
   using model_ref = typename Solver::model_ref;
@@ -23,7 +61,9 @@ public:
     , m_efac(efac)
     , m_zctx(new EZ3(m_efac))
     , m_solver(new ZSolver<EZ3>(*m_zctx))
-    , m_last_result(SolverResult::UNKNOWN) {}
+    , m_last_result(SolverResult::UNKNOWN)
+    , m_in_check(false)
+    , m_interrupted(false) {}
 
   ~z3_solver_impl() = default;
   
@@ -40,28 +80,12 @@ public:
   
   /** Check for satisfiability */
   virtual SolverResult check() override {
-    auto res = m_solver->solve();
-    if (res) {
-      m_last_result = SolverResult::SAT;
-    } else if (!res) {
-      m_last_result = SolverResult::UNSAT;
-    } else {
-      m_last_result = SolverResult::UNKNOWN; 
-    }
-    return m_last_result;
+    return run_check([this]() { return m_solver->solve(); });
   }
 
   
   virtual SolverResult check_with_assumptions(const expr_const_it_range& lits) override {
-    auto res = m_solver->solveAssuming(lits);
-    if (res) {
-      m_last_result = SolverResult::SAT;
-    } else if (!res) {
-      m_last_result = SolverResult::UNSAT;
-    } else {
-      m_last_result = SolverResult::UNKNOWN; 
-    }
-    return m_last_result;
+    return run_check([&]() { return m_solver->solveAssuming(lits); });
   }
 
   virtual void unsat_core(expr::ExprVector& out) override {
@@ -95,6 +119,15 @@ public:
     m_solver->toSmtLib(o);
 
   }
+
+  /** Stop a running check. Has no effect if no check is running */
+  virtual void interrupt() override {
+    std::lock_guard<std::mutex> lock(m_interrupt_mutex);
+    if (!m_in_check)
+      return;
+    m_interrupted = true;
+    m_zctx->interrupt();
+  }
 };
 }
 }
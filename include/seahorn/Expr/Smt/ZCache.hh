@@ -0,0 +1,177 @@
+#pragma once
+/**
+   Bounded bidirectional cache between Expr and z3::ast
+ */
+
+#include "z3++.h"
+
+#include <boost/bimap.hpp>
+#include <boost/bimap/list_of.hpp>
+#include <boost/bimap/unordered_set_of.hpp>
+
+#include "seahorn/Expr/Expr.hh"
+
+namespace z3 {
+struct ast_ptr_hash : public std::unary_function<ast, std::size_t> {
+  std::size_t operator()(const ast &ast) const {
+    std::hash<Z3_ast> hasher;
+    return hasher(static_cast<Z3_ast>(ast));
+  }
+};
+
+struct ast_ptr_equal_to : public std::binary_function<ast, ast, bool> {
+  bool operator()(const ast &a1, const ast &a2) const {
+    return static_cast<Z3_ast>(a1) == static_cast<Z3_ast>(a2);
+  }
+};
+} // namespace z3
+
+namespace seahorn {
+/// \brief Memory budget, in MB, of the cache of every new ZContext
+///
+/// 0 means that the cache is unbounded. Set by --zctx-cache-budget
+extern unsigned ZCacheBudget;
+
+/// \brief Bidirectional cache between Expr and z3::ast
+///
+/// Keeps the terminal expressions (constants, declarations, sorts) that have
+/// been converted between Expr and Z3 so that a Z3 term can be converted back
+/// to the Expr it came from. The cache pins both sides of every entry.
+///
+/// The cache is optionally bounded by a number of entries. Entries are kept
+/// in least recently used order and are evicted only when the Expr is not
+/// referenced outside of the cache, since otherwise a Z3 term that refers to
+/// it could no longer be converted back to the same Expr. Entries that are
+/// still in use get a second chance and are moved to the back.
+class ZCache {
+public:
+  using relation_type = boost::bimap<
+      boost::bimaps::unordered_set_of<expr::Expr>,
+      boost::bimaps::unordered_set_of<z3::ast, z3::ast_ptr_hash,
+                                      z3::ast_ptr_equal_to>,
+      boost::bimaps::list_of_relation>;
+
+  /// \brief One direction of the cache
+  ///
+  /// Has the map interface used by the marshal and unmarshal functions.
+  /// Lookups mark entries as recently used, insertions evict old entries.
+  template <typename Map> class View {
+    ZCache &m_cache;
+    Map &m_map;
+
+  public:
+    using key_type = typename Map::key_type;
+    using value_type = typename Map::value_type;
+    using iterator = typename Map::iterator;
+    using const_iterator = typename Map::const_iterator;
+
+    View(ZCache &cache, Map &map) : m_cache(cache), m_map(map) {}
+    View(const View &) = delete;
+
+    const_iterator find(const key_type &k) {
+      auto it = m_map.find(k);
+      if (it == m_map.end()) {
+        ++m_cache.m_misses;
+        return it;
+      }
+      ++m_cache.m_hits;
+      m_cache.m_map.relocate(m_cache.m_map.end(), m_cache.m_map.project_up(it));
+      return it;
+    }
+
+    const_iterator end() const { return m_map.end(); }
+
+    std::pair<iterator, bool> insert(const value_type &v) {
+      auto res = m_map.insert(v);
+      if (res.second)
+        m_cache.shrink();
+      return res;
+    }
+
+    size_t size() const { return m_map.size(); }
+  };
+
+  using expr_view = View<relation_type::left_map>;
+  using z_view = View<relation_type::right_map>;
+
+  /// \brief Estimated memory used by one entry, including the pinned terms
+  static constexpr size_t ENTRY_BYTES = 256;
+  /// \brief Number of entries inspected for eviction per insertion
+  static constexpr unsigned EVICT_SCAN = 8;
+
+private:
+  relation_type m_map;
+  /// maximal number of entries, 0 for unbounded
+  size_t m_capacity;
+
+  unsigned m_hits;
+  unsigned m_misses;
+  unsigned m_evictions;
+  size_t m_peak;
+
+  /// \brief Evicts least recently used entries that exceed the capacity
+  ///
+  /// Inspects a bounded number of entries so that an insertion is constant
+  /// time even if most entries are in use. The cache may temporarily exceed
+  /// its capacity.
+  void shrink() {
+    if (m_map.size() > m_peak)
+      m_peak = m_map.size();
+    if (m_capacity == 0)
+      return;
+    for (unsigned n = 0; n < EVICT_SCAN && m_map.size() > m_capacity; ++n)
+      evictFront();
+  }
+
+  /// \brief Evicts the least recently used entry unless it is in use
+  void evictFront() {
+    auto it = m_map.begin();
+    if (it->left->use_count() > 1)
+      m_map.relocate(m_map.end(), it);
+    else {
+      m_map.erase(it);
+      ++m_evictions;
+    }
+  }
+
+public:
+  expr_view left;
+  z_view right;
+
+  /// \brief Creates a cache whose size is bounded by \p budgetMB
+  explicit ZCache(unsigned budgetMB = 0)
+      : m_capacity(capacityFor(budgetMB)), m_hits(0), m_misses(0),
+        m_evictions(0), m_peak(0), left(*this, m_map.left),
+        right(*this, m_map.right) {}
+  ZCache(const ZCache &) = delete;
+
+  /// \brief Number of entries that fit in \p budgetMB (0 is unbounded)
+  static size_t capacityFor(unsigned budgetMB) {
+    return (size_t(budgetMB) << 20) / ENTRY_BYTES;
+  }
+
+  /// \brief Bounds the number of entries. 0 means unbounded
+  void setCapacity(size_t capacity) {
+    m_capacity = capacity;
+    if (m_capacity == 0)
+      return;
+    // -- inspect every entry at most once
+    for (size_t n = m_map.size(); n > 0 && m_map.size() > m_capacity; --n)
+      evictFront();
+  }
+  size_t capacity() const { return m_capacity; }
+
+  size_t size() const { return m_map.size(); }
+  void clear() { m_map.clear(); }
+
+  unsigned hits() const { return m_hits; }
+  unsigned misses() const { return m_misses; }
+  unsigned evictions() const { return m_evictions; }
+  size_t peak() const { return m_peak; }
+
+  /// \brief Adds the hit, miss and eviction counts to Stats
+  ///
+  /// Counts are reset so that the cache can be flushed several times.
+  void flushStats();
+};
+} // namespace seahorn
@@ -15,7 +15,11 @@
 #include "seahorn/Support/Stats.hh"
 
 #include <algorithm>
+#include <list>
 #include <map>
+#include <set>
+#include <tuple>
+#include <unordered_map>
 
 namespace seahorn
 {
@@ -25,15 +29,19 @@ namespace seahorn
   class HornClauseDB;
   class HornRule
   {
+    friend class HornClauseDB;
+
     ExprVector m_vars;
     Expr m_head;
     Expr m_body;
+    /// id given by the database that holds the rule, 0 if none
+    unsigned m_id;
 
   public:
     template <typename Range>
     HornRule (Range &v, Expr b) :
       m_vars (boost::begin (v), boost::end (v)),
-      m_head (b), m_body (mk<TRUE>(b->efac ()))
+      m_head (b), m_body (mk<TRUE>(b->efac ())), m_id (0)
     {
       if ((b->arity () == 2) && isOpX<IMPL> (b))
       {
@@ -47,12 +55,12 @@ namespace seahorn
     template <typename Range>
     HornRule (Range &v, Expr head, Expr body) :
       m_vars (boost::begin (v), boost::end (v)),
-      m_head (head), m_body (body)
+      m_head (head), m_body (body), m_id (0)
     { }
 
     HornRule (const HornRule &r) :
       m_vars (r.m_vars),
-      m_head (r.m_head), m_body (r.m_body)
+      m_head (r.m_head), m_body (r.m_body), m_id (r.m_id)
     {}
 
     size_t hash () const
@@ -64,11 +72,24 @@ namespace seahorn
       return res;
     }
 
+    /// structural equality. Expressions are hash-consed so comparing
+    /// them is constant time.
     bool operator==(const HornRule & other) const
-    { return hash() == other.hash ();}
+    {
+      return m_head == other.m_head && m_body == other.m_body &&
+        m_vars == other.m_vars;
+    }
 
+    /// order by the ids of head, body and variables
     bool operator<(const HornRule & other) const
-    { return hash() < other.hash ();}
+    {
+      return std::tie (m_head, m_body, m_vars) <
+        std::tie (other.m_head, other.m_body, other.m_vars);
+    }
+
+    /// stable id of the rule in its database (or of the rule it was
+    /// copied from). 0 if the rule was never added to a database.
+    unsigned id () const {return m_id;}
 
     // return only the body of the horn clause
     Expr body () const {return m_body;}
@@ -100,8 +121,18 @@ namespace seahorn
     friend class HornRule;
   public:
 
-    typedef std::vector<HornRule> RuleVector;
+    /// rules are kept in a list so that pointers and iterators to a
+    /// rule stay valid while other rules are added or removed
+    typedef std::list<HornRule> RuleVector;
     typedef boost::container::flat_set<Expr> expr_set_type;
+
+    /// orders rules by id, i.e., by insertion order
+    struct RuleIdLess
+    {
+      bool operator() (const HornRule *x, const HornRule *y) const
+      {return x->id () < y->id ();}
+    };
+    typedef std::set<HornRule*, RuleIdLess> horn_set_type;
     struct IsRelation : public std::unary_function<Expr, bool>
     {
       const HornClauseDB &m_db;
@@ -116,19 +147,24 @@ namespace seahorn
     expr_set_type m_rels;
     mutable ExprVector m_vars;
     RuleVector m_rules;
+    /// maps the id of a rule to its position in m_rules
+    std::unordered_map<unsigned, RuleVector::iterator> m_rule_ids;
+    unsigned m_next_rule_id;
     ExprVector m_queries;
     std::map<Expr, ExprVector> m_constraints;
     std::map<Expr, ExprVector> m_invariants;
 
-    /// indexes
+    /// indexes, updated by addRule and removeRule
 
-
-    typedef boost::container::flat_set<HornRule*> horn_set_type;
     typedef std::map<Expr, horn_set_type > index_type;
     /// maps a relation to rules it appears in the body
     index_type m_body_idx;
     /// maps a relation to rules it appears in the head
     index_type m_head_idx;
+    /// maps a Boolean function declaration that is not registered as a
+    /// relation to rules it appears in the body. registerRelation
+    /// moves its rules to the body index.
+    index_type m_pending_idx;
 
     const ExprVector &getVars () const;
 
@@ -137,26 +173,38 @@ namespace seahorn
 
     /// resets all indexes
     void resetIndexes ();
+    /// adds r to (removes r from) the use/def indexes
+    void indexRule (HornRule &r);
+    void unindexRule (HornRule &r);
+
+    /// returns the position of a rule structurally equal to r, or
+    /// end(). Constant time if r is a copy of a rule of this database.
+    RuleVector::iterator findRule (const HornRule &r);
 
   public:
 
-    HornClauseDB (ExprFactory &efac) : m_efac (efac) {}
+    HornClauseDB (ExprFactory &efac) : m_efac (efac), m_next_rule_id (1) {}
+    /// rules are referenced by the indexes
+    HornClauseDB (const HornClauseDB &) = delete;
 
     ExprFactory &getExprFactory () {return m_efac;}
 
-    void registerRelation (Expr fdecl) {m_rels.insert (fdecl);}
+    /// rules added before fdecl is registered are moved to its use
+    /// index, so relations can be registered in any order
+    void registerRelation (Expr fdecl);
     const expr_set_type& getRelations () const {return m_rels;}
     bool hasRelation (Expr fdecl) const
     { return m_rels.count (fdecl) > 0; }
     /// number of relational predicates
     unsigned relSize () { return m_rels.size ();}
 
-    /// -- build use/def indexes
+    /// -- rebuild use/def indexes from scratch. Indexes are kept up
+    /// -- to date by addRule and removeRule, so this is only needed
+    /// -- after a rule of getRules() is modified in place.
     void buildIndexes ();
 
     /// -- returns rules that use fdecl
     /// -- i.e., rules in which fdecl appears in the body
-    /// -- requires indexes (see buildIndexes())
     const horn_set_type &use (Expr fdecl) const
     {
       auto it = m_body_idx.find (fdecl);
@@ -166,7 +214,6 @@ namespace seahorn
 
     /// -- returns rules that define fdecl
     /// -- i.e., rules in which fdecl appears in the head
-    /// -- requires indexes (see buildIndexes())
     const horn_set_type &def (Expr fdecl) const
     {
       auto it = m_head_idx.find (fdecl);
@@ -183,13 +230,8 @@ namespace seahorn
       addRule (HornRule (vars, rule));
     }
 
-    void addRule (const HornRule &rule)
-    {
-      m_rules.push_back (rule);
-      boost::copy (rule.vars (), std::back_inserter (m_vars));
-      resetIndexes ();
-
-    }
+    /// adds a copy of rule with a fresh id
+    void addRule (const HornRule &rule);
 
     const ExprVector &getVars ()
     {
@@ -200,10 +242,18 @@ namespace seahorn
       return m_vars;
     }
 
-    void removeRule (const HornRule &r)
+    /// removes one rule structurally equal to r, if any
+    void removeRule (const HornRule &r);
+
+    /// adds the relations, rules, queries, constraints and invariants
+    /// of db, in the order in which they appear in db
+    void append (const HornClauseDB &db);
+
+    /// returns the rule with the given id, or nullptr if it was removed
+    HornRule *getRule (unsigned id)
     {
-      m_rules.erase (std::remove (m_rules.begin(), m_rules.end(), r));
-      resetIndexes ();
+      auto it = m_rule_ids.find (id);
+      return it == m_rule_ids.end () ? nullptr : &*(it->second);
     }
 
 
@@ -236,18 +286,28 @@ namespace seahorn
 
     raw_ostream& write (raw_ostream& o) const;
 
-    /// load current HornClauseDB to a given FixedPoint object
+    /// Writes the rules and queries in SMT-LIB2 without a solver.
+    /// With fpExtensions, in the declare-rel/rule/query format of Z3,
+    /// otherwise as pure SMT-LIB2 in the HORN logic. Constraints are
+    /// not written.
+    raw_ostream& writeSmtLib (raw_ostream& o, bool fpExtensions) const;
+
+    /// load current HornClauseDB to a given FixedPoint object. If
+    /// nameRules, each rule is named by its id in the FixedPoint
     template <typename FP>
     void loadZFixedPoint (FP &fp,
                           bool skipConstraints = false,
-                          bool skipQuery = false) const
+                          bool skipQuery = false,
+                          bool nameRules = false) const
     {
       ScopedStats _st_("HornClauseDB::loadZFixedPoint");
       for (auto &p: getRelations ())
         fp.registerRelation (p);
 
       for (auto &rule: getRules ())
-        fp.addRule (rule.vars (), rule.get ());
+        fp.addRule (rule.vars (), rule.get (),
+                    nameRules ? boost::lexical_cast<std::string> (rule.id ())
+                              : std::string ());
 
       for (auto &r : getRelations ())
         if (!skipConstraints && (hasConstraints (r) || hasInvariants (r)))
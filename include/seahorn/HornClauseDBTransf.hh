@@ -2,6 +2,10 @@
 #pragma once
 
 #include "seahorn/HornClauseDB.hh"
+#include "seahorn/HornDbModel.hh"
+#include "seahorn/HornModelConverter.hh"
+
+#include "seahorn/Expr/Smt/EZ3.hh"
 
 namespace seahorn {
 
@@ -12,4 +16,51 @@ void normalizeHornClauseHeads(HornClauseDB &db);
 // created for the relations that contain Finite Maps as arguments)
 void removeFiniteMapsHornClausesTransf(HornClauseDB &db, HornClauseDB &tdb);
 
+// Maps models and counterexamples of a database simplified by
+// preprocessHornClauses back to the original database
+class HornPreprocessConverter : public HornModelConverter {
+  friend void preprocessHornClauses(HornClauseDB &db, HornClauseDB &tdb,
+                                    HornPreprocessConverter &conv);
+
+  HornClauseDB *m_db;
+  HornClauseDB *m_tdb;
+  // -- used to eliminate quantifiers in the models of inlined relations
+  EZ3 *m_zctx;
+
+  // -- relations that do not reach a query
+  ExprSet m_sliced;
+  // -- relations that cannot be derived
+  ExprSet m_dead;
+  // -- inlined relations with their only defining rule, in inlining order
+  std::vector<std::pair<Expr, HornRule>> m_inlined;
+  // -- relation of db to relation of tdb and its arguments kept in tdb
+  std::map<Expr, std::pair<Expr, std::vector<unsigned>>> m_relMap;
+  // -- rules of db that a rule of tdb stands for, in derivation order
+  std::map<unsigned, std::vector<const HornRule *>> m_origin;
+
+public:
+  HornPreprocessConverter() : m_db(nullptr), m_tdb(nullptr), m_zctx(nullptr) {}
+  HornPreprocessConverter(EZ3 &zctx)
+      : m_db(nullptr), m_tdb(nullptr), m_zctx(&zctx) {}
+  virtual ~HornPreprocessConverter() {}
+
+  // -- in is a model of tdb, out becomes a model of db
+  bool convert(HornDbModel &in, HornDbModel &out);
+
+  // -- rewrites the rules of a counterexample of tdb (as returned by
+  // -- ZFixedPoint::getCexRules) into rules of db. names are the names of
+  // -- the rules (ZFixedPoint::getCexRuleNames) when tdb is loaded with
+  // -- its rules named. Returns false if a named rule is not a rule of tdb.
+  bool convertCex(const ExprVector &in, const std::vector<std::string> &names,
+                  ExprVector &out) const;
+};
+
+// Simplifies the Horn Clauses before they are given to a solver: keeps
+// only the cone of influence of the queries, removes relations that
+// cannot be derived, inlines relations that form linear chains and
+// removes arguments that are never used. tdb is an empty db that will
+// contain db after transformation. conv maps results of tdb back to db.
+void preprocessHornClauses(HornClauseDB &db, HornClauseDB &tdb,
+                           HornPreprocessConverter &conv);
+
 } // namespace seahorn
@@ -5,6 +5,7 @@
 #include "llvm/IR/Module.h"
 #include "boost/logic/tribool.hpp"
 #include "seahorn/HornDbModel.hh"
+#include "seahorn/HornClauseDBTransf.hh"
 
 #include "seahorn/Expr/Smt/EZ3.hh"
 
@@ -15,8 +16,20 @@ namespace seahorn
   class HornSolver : public llvm::ModulePass
   {
     boost::tribool m_result;
+    // -- context of m_fp when it is not the one of HornifyModule
+    std::unique_ptr<EZ3> m_zctx;
     std::unique_ptr<ZFixedPoint <EZ3> >  m_fp;
+    // -- preprocessed database given to m_fp, if any
+    std::unique_ptr<HornClauseDB> m_tdb;
+    std::unique_ptr<HornPreprocessConverter> m_converter;
     
+    /// sets the parameters of a configuration and loads db
+    void loadFixedPoint (ZFixedPoint<EZ3> &fp, EZ3 &zctx, HornClauseDB &db,
+                         unsigned config);
+    /// races k configurations and keeps the fixedpoint of the first
+    /// one that answers
+    boost::tribool runPortfolio (HornClauseDB &db, unsigned k);
+
     void printCex ();
     void estimateSizeInvars (Module &M);
 
@@ -33,9 +46,21 @@ namespace seahorn
     virtual void getAnalysisUsage (AnalysisUsage &AU) const;
     virtual StringRef getPassName () const {return "HornSolver";}
     ZFixedPoint<EZ3>& getZFixedPoint () {return *m_fp;}
+
+    /// model of the database of HornifyModule. Returns false if the
+    /// model of the preprocessed database cannot be mapped back.
+    bool getModel (HornDbModel &model);
+    /// counterexample rules over the database of HornifyModule
+    void getCexRules (ExprVector &rules);
     
     boost::tribool getResult () {return m_result;}
-    void releaseMemory () {m_fp.reset (nullptr);}
+    void releaseMemory ()
+    {
+      m_fp.reset (nullptr);
+      m_zctx.reset (nullptr);
+      m_converter.reset (nullptr);
+      m_tdb.reset (nullptr);
+    }
     
   };
 
@@ -47,14 +47,21 @@ namespace seahorn
     void extractFunctionInfo (const BasicBlock &BB);
   public:
     HornifyFunction (HornifyModule &parent, bool interproc = false) :
+      HornifyFunction (parent, parent.getHornClauseDB (), interproc) {}
+    /// clauses are added to db instead of the database of parent
+    HornifyFunction (HornifyModule &parent, HornClauseDB &db,
+                     bool interproc = false) :
       m_parent (parent), m_sem (m_parent.symExec ()),
-      m_db (m_parent.getHornClauseDB ()),
+      m_db (db),
       m_zctx (parent.getZContext ()),
       m_efac (m_zctx.getExprFactory ()), m_interproc (interproc) {}
 
     virtual ~HornifyFunction () {}
     HornClauseDB &getHornClauseDB () {return m_db;}
     virtual void runOnFunction (Function &F) = 0;
+    /// declares the summary predicate of F, if any, and its basic rules.
+    /// Once declared, runOnFunction does not declare it again.
+    void declareSummary (const Function &F);
     // bool checkProperty(ExprVector prop, Expr &inv);
   };
 
@@ -66,6 +73,9 @@ namespace seahorn
     SmallHornifyFunction (HornifyModule &parent,
                           bool interproc = false) :
       HornifyFunction (parent, interproc) {}
+    SmallHornifyFunction (HornifyModule &parent, HornClauseDB &db,
+                          bool interproc = false) :
+      HornifyFunction (parent, db, interproc) {}
 
     virtual void runOnFunction (Function &F);
   } ;
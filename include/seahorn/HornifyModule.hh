@@ -49,6 +49,12 @@ namespace seahorn
     HornClauseDB& getHornClauseDB () {return m_db;}
     virtual bool runOnModule (Module &M);
     virtual bool runOnFunction (Function &F);
+    /// -- computes everything needed to hornify F.
+    /// -- Returns false if F has no body
+    bool initFunction (Function &F);
+    /// -- hornifies functions concurrently, each into its own database,
+    /// -- and appends the databases to m_db in the order of fns
+    void runOnFunctionsParallel (const std::vector<Function*> &fns);
     virtual void getAnalysisUsage (AnalysisUsage &AU) const;
     virtual StringRef getPassName () const {return "HornifyModule";}
 
@@ -12,6 +12,9 @@
 #include "seahorn/Expr/Smt/EZ3.hh"
 #include "seahorn/HornClauseDBWto.hh"
 
+#include <atomic>
+#include <memory>
+
 namespace seahorn
 {
   using namespace llvm;
@@ -106,6 +109,61 @@ namespace seahorn
 	  bool validateRule(HornRule r, ZSolver<EZ3> &solver);
 	  std::map<Expr, ZSolver<EZ3>> assignEachRelationASolver();
   };
+
+  /*
+   * One solver per relation that is never popped. Each candidate lemma
+   * is guarded by an activation literal, rules are checked under
+   * assumptions, and every head lemma falsified by a model is dropped
+   * at once. Top-level components of the WTO are solved once the
+   * components they depend on are done, independent ones in parallel.
+   */
+  class Houdini_Assumptions : public HoudiniContext
+  {
+  private:
+	  struct RelCands
+	  {
+		  Expr fapp;               // relation applied to its bound variables
+		  ExprVector lemmas;       // candidate lemmas over the arguments of fapp
+		  ExprVector lits;         // activation literal of each lemma
+		  std::vector<char> active;
+		  std::vector<unsigned> defs;  // rules defining the relation
+		  std::vector<unsigned> uses;  // rules using the relation in their body
+		  std::unique_ptr<ZSolver<EZ3>> solver;
+		  unsigned comp;
+	  };
+	  struct RuleCands
+	  {
+		  const HornRule *rule;
+		  unsigned head;
+		  std::vector<unsigned> body;  // relations in the body, no duplicates
+		  Expr tag;                    // enables the transition relation
+		  ExprVector head_lits;        // h_k <=> k-th head lemma on the head args
+		  ExprVector asserts;          // added to the solver of the head
+		  unsigned guards;
+		  char queued;
+	  };
+
+	  std::vector<RelCands> m_rels;
+	  std::vector<RuleCands> m_rules;
+	  std::map<Expr, unsigned> m_relIdx;
+	  std::map<HornRule, unsigned> m_ruleIdx;
+	  // -- rules of each top-level component of the wto, in wto order
+	  std::vector<std::vector<unsigned>> m_comps;
+	  // -- updated by all workers
+	  std::atomic<unsigned> m_checks;
+	  std::atomic<unsigned> m_dropped;
+
+	  void init();
+	  void solveComponent(unsigned c, EZ3 &zctx);
+	  bool checkRule(unsigned ri, std::vector<unsigned> &falsified);
+	  void weaken(unsigned ri, const std::vector<unsigned> &falsified);
+
+  public:
+	  Houdini_Assumptions(Houdini& houdini, HornClauseDBWto &db_wto, std::list<HornRule> &workList) :
+		  HoudiniContext(houdini, db_wto, workList), m_checks(0), m_dropped(0) { init(); }
+	  void run();
+	  bool validateRule(HornRule r, ZSolver<EZ3> &solver);
+  };
 }
 
 #endif /* HOUDNINI__HH_ */
@@ -2,6 +2,8 @@
 #define __LIVE_SYMBOLS__HH_
 
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/SparseBitVector.h"
 #include "llvm/IR/Function.h"
 
 #include "seahorn/OperationalSemantics.hh"
@@ -14,42 +16,44 @@ using namespace expr;
 
 class LiveInfo {
   ExprVector m_live;
-  ExprVector m_defs;
-  llvm::SmallVector<ExprVector, 16> m_edgeDefs;
 
 public:
   LiveInfo() {}
-  LiveInfo(const LiveInfo &o)
-      : m_live(o.m_live), m_defs(o.m_defs), m_edgeDefs(o.m_edgeDefs) {}
+  LiveInfo(const LiveInfo &o) : m_live(o.m_live) {}
 
   LiveInfo &operator=(LiveInfo o) {
     std::swap(m_live, o.m_live);
-    std::swap(m_defs, o.m_defs);
-    std::swap(m_edgeDefs, o.m_edgeDefs);
     return *this;
   }
 
   void setLive(const ExprVector &l);
-  void setDefs(const ExprVector &d);
-  void addEdgeDef(const ExprVector &d);
   /// add live variables. These should not be already live
   void addLive(ExprVector &v);
   /// like addLive but v can contain variables already live
   void unionLive(ExprVector &v);
 
   const ExprVector &live() const { return m_live; }
-  const ExprVector &defs() const { return m_defs; }
-  const ExprVector &edge_defs(unsigned i) const { return m_edgeDefs[i]; }
 };
 
 /// Computes the set of live symbols (variables) at every BasicBlock
 /// of a function. Parameterized by the symbolic execution semantics.
+///
+/// Uses and definitions of a block are read off the IR using the
+/// registers and the isTracked() predicate of the semantics. Blocks
+/// whose effect depends on the semantics (calls, global initialization
+/// in main) are symbolically executed instead. Liveness is then solved
+/// over sets of register indices.
+///
+/// With \p symExecOnly, every block and phi-edge is symbolically
+/// executed. This is the reference the IR-derived sets are checked
+/// against: they must be equal or a superset.
 class LiveSymbols {
   const Function &m_f;
   ExprFactory &m_efac;
 
   OperationalSemantics &m_sem;
   ExprVector m_side;
+  bool m_symExecOnly;
 
   std::vector<const BasicBlock *> m_rtopo;
 
@@ -57,6 +61,36 @@ class LiveSymbols {
   DenseMap<const BasicBlock *, LiveInfo> m_liveInfo;
   Expr trueE;
 
+  using RegSet = SparseBitVector<>;
+  /// -- local use/def of a block, as sets of register indices
+  struct UseDef {
+    /// registers read before being defined, and later the live ones
+    RegSet live;
+    RegSet defs;
+    /// definitions on the edge to each successor
+    SmallVector<RegSet, 2> edgeDefs;
+  };
+  DenseMap<const BasicBlock *, UseDef> m_useDef;
+  /// -- symbolic registers and their indices
+  ExprVector m_regs;
+  DenseMap<const ENode *, unsigned> m_regIdx;
+
+  unsigned regIdx(Expr reg);
+  /// -- marks the register of v as used in ud, unless defined earlier
+  void use(OpSemContext &ctx, const Value &v, UseDef &ud);
+  void use(Expr reg, UseDef &ud);
+  void def(OpSemContext &ctx, const Value &v, RegSet &defs);
+
+  /// -- true if use/def of bb cannot be read off the IR
+  bool needsSymExec(const BasicBlock &bb) const;
+  void irUseDef(OpSemContext &ctx, const BasicBlock &bb, UseDef &ud);
+  void symExecUseDef(const BasicBlock &bb, UseDef &ud);
+  /// -- uses and defs of the phi-nodes of bb on the edge from \p from
+  void phiUseDef(OpSemContext &ctx, const BasicBlock &bb,
+                 const BasicBlock &from, RegSet &uses, RegSet &defs);
+  void symExecPhiUseDef(const BasicBlock &bb, const BasicBlock &from,
+                        RegSet &uses, RegSet &defs);
+
   void symExec(OpSemContext &ctx, const BasicBlock &bb);
   void symExecPhi(OpSemContext &ctx, const BasicBlock &bb,
                   const BasicBlock &from);
@@ -67,17 +101,22 @@ class LiveSymbols {
   void patchArgsAndGlobals();
   /// -- compute global live info by propagating local live info
   void globalPass();
+  /// -- convert live registers to the LiveInfo of each block
+  void exportLive();
 
 public:
-  LiveSymbols(const Function &F, ExprFactory &efac, OperationalSemantics &semantics)
-      : m_f(F), m_efac(efac), m_sem(semantics), m_gstore(efac) {
+  LiveSymbols(const Function &F, ExprFactory &efac,
+              OperationalSemantics &semantics, bool symExecOnly = false)
+      : m_f(F), m_efac(efac), m_sem(semantics), m_symExecOnly(symExecOnly),
+        m_gstore(efac) {
     trueE = mk<TRUE>(m_efac);
   }
 
   LiveSymbols(const LiveSymbols &o)
       : m_f(o.m_f), m_efac(o.m_efac), m_sem(o.m_sem), m_side(),
-        m_rtopo(o.m_rtopo), m_gstore(o.m_gstore), m_liveInfo(o.m_liveInfo),
-        trueE(o.trueE) {}
+        m_symExecOnly(o.m_symExecOnly), m_rtopo(o.m_rtopo), m_gstore(o.m_gstore), m_liveInfo(o.m_liveInfo),
+        trueE(o.trueE), m_useDef(o.m_useDef), m_regs(o.m_regs),
+        m_regIdx(o.m_regIdx) {}
 
   void run();
   void operator()() { run(); }
@@ -85,7 +85,7 @@ public:
   }
   /// \brief Copy constructor with optionally new \p values and \p side
   OpSemContext(SymStore &values, ExprVector &side, const OpSemContext &o)
-      : m_values(o.m_values), m_side(o.m_side), m_rely(o.m_rely),
+      : m_values(values), m_side(side), m_rely(o.m_rely),
         m_guarantee(o.m_guarantee), m_pathCond(o.m_pathCond),
         m_trueE(o.m_trueE), m_falseE(o.m_falseE) {}
   OpSemContext(const OpSemContext &) = delete;
@@ -72,10 +72,11 @@ public:
 #else
 
 #include "seahorn/LiveSymbols.hh"
+#include "seahorn/PathBmcMuc.hh"
+#include "seahorn/PathBmcUtil.hh"
 #include "clam/Clam.hh"
 
 #include <memory>
-#include <queue>
 #include <unordered_set>
 
 namespace clam {
@@ -166,6 +167,9 @@ protected:
   std::unique_ptr<solver::Solver> m_boolean_solver;
   // solver used to solve a path formula over arrays, bitvectors, etc
   std::unique_ptr<solver::Solver> m_smt_path_solver;
+  // solves path formulas instead of m_smt_path_solver with
+  // --horn-bmc-muc=incremental
+  std::unique_ptr<path_bmc::incremental_muc> m_inc_muc;
   // model of a path formula
   solver::Solver::model_ref m_model;
   /// last result of the main solver (m_boolean_solver)
@@ -177,7 +181,9 @@ protected:
   std::unordered_set<Expr> m_blocking_clauses;
 
   // Queue for unsolved path formulas
-  std::queue<std::pair<unsigned, ExprVector>> m_unsolved_path_formulas;
+  path_bmc::unsolved_path_queue m_unsolved_path_formulas;
+  // Time budget of all retries of unsolved paths
+  path_bmc::retry_budget m_retry_budget;
   // Count number of path
   unsigned m_num_paths;
 
@@ -214,6 +220,36 @@ protected:
       const PathBmcTrace &trace, const expr_invariants_map_t &invariants,
       const expr_invariants_map_t &path_constraints);
 
+  /// Check feasibility of path_formula using solver, or inc_muc if
+  /// not null. If unsat (or inconclusive) then path_cond is the
+  /// generalization of the path used to block it. solver_calls is the
+  /// number of checks done. Only solver and inc_muc are modified so
+  /// it can be called by several threads, each with its own solvers.
+  solver::SolverResult solve_path(solver::Solver &solver,
+                                  path_bmc::incremental_muc *inc_muc,
+                                  const ExprVector &path_formula,
+                                  const ExprMap &path_cond_map,
+                                  ExprVector &path_cond,
+                                  unsigned &solver_calls) const;
+
+  /// Enumerate and solve paths using num_workers threads to solve
+  /// path formulas. The result is stored in m_result.
+  void solve_paths_in_parallel(unsigned num_workers);
+
+  /// Try again to solve an unsolved path with a bigger timeout, at
+  /// most max_timeout. Only solver and p are modified.
+  solver::SolverResult retry_path(solver::Solver &solver,
+                                  path_bmc::unsolved_path_queue::path &p,
+                                  unsigned max_timeout) const;
+
+  /// Retry the paths in m_unsolved_path_formulas using num_workers
+  /// threads until one is sat, all are unsat, or the time budget
+  /// runs out. The result is stored in m_result.
+  void retry_unsolved_paths(unsigned num_workers);
+
+  /// Return the clause that blocks path_cond
+  Expr mk_blocking_clause(const ExprVector &path_cond);
+
   // Build Crab CFG, run pre-analyses, etc
   void initialize_ai();
   
@@ -260,7 +296,9 @@ protected:
   Expr eval(Expr e);
   
   /// For debugging
-  void to_smt_lib(const ExprVector &path, std::string prefix = "");
+  /// path_id is used to name the file. If negative, m_num_paths is used.
+  void to_smt_lib(const ExprVector &path, std::string prefix = "",
+                  int path_id = -1);
 };
 
 } // end namespace seahorn
@@ -1,6 +1,11 @@
+#pragma once
+
 #include "seahorn/Expr/ExprLlvm.hh"
 #include "seahorn/Expr/Smt/Solver.hh"
 
+#include <deque>
+#include <memory>
+
 namespace seahorn {
 namespace path_bmc {
 
@@ -8,20 +13,27 @@ enum class MucMethodKind {
   MUC_NONE,
   MUC_DELETION,
   MUC_ASSUMPTIONS,
-  MUC_BINARY_SEARCH
+  MUC_BINARY_SEARCH,
+  MUC_INCREMENTAL
 };
 
 /** General API to compute unsat cores **/
 class minimal_unsat_core {
 protected:
   solver::Solver &m_solver;
+  /* number of calls to the solver */
+  unsigned m_calls;
 
 public:
-  minimal_unsat_core(solver::Solver &solver) : m_solver(solver) {}
+  minimal_unsat_core(solver::Solver &solver) : m_solver(solver), m_calls(0) {}
+
+  virtual ~minimal_unsat_core() {}
 
   virtual void run(const expr::ExprVector &f, expr::ExprVector &core) = 0;
 
   virtual std::string get_name(void) const = 0;
+
+  unsigned solver_calls() const { return m_calls; }
 };
 
 class muc_with_assumptions : public minimal_unsat_core {
@@ -76,5 +88,46 @@ public:
   std::string get_name() const override { return "QuickXplain"; }
 };
 
+/*
+  Incremental MUC shared by all the paths of a search.
+
+  The solver is never reset between paths. Each conjunct of a path
+  formula is asserted once under an activation literal, so the work
+  done on conjuncts shared by several paths (e.g., a common prefix) is
+  kept by the solver. A path is checked with its literals as
+  assumptions, and the core is minimized by deletion using the core of
+  each check to drop several conjuncts at once. Cores of previous
+  paths are cached: a path that contains one is unsat without calling
+  the solver.
+*/
+class incremental_muc : public minimal_unsat_core {
+  std::unique_ptr<solver::Solver> m_owned_solver;
+  /* conjuncts asserted under their activation literal */
+  expr::ExprSet m_asserted;
+  /* cores of previous paths, most recent last */
+  std::deque<expr::ExprVector> m_cores;
+  unsigned m_timeout; /*seconds*/
+
+  expr::Expr literal(expr::Expr e);
+  solver::SolverResult check(const expr::ExprVector &lits, unsigned timeout);
+  bool cached_core(const expr::ExprVector &f, expr::ExprVector &core);
+
+public:
+  /* timeout (sec) is for each check done to minimize a core */
+  incremental_muc(std::unique_ptr<solver::Solver> solver, unsigned timeout);
+
+  /* Check the satisfiability of f within timeout (sec). If unsat then
+     core is a minimal unsat core of f. If sat then the solver has a
+     model of f. */
+  solver::SolverResult solve(const expr::ExprVector &f, unsigned timeout,
+                             expr::ExprVector &core);
+
+  void run(const expr::ExprVector &f, expr::ExprVector &core) override;
+
+  std::string get_name() const override { return "Incremental MUC"; }
+
+  solver::Solver &get_solver() { return m_solver; }
+};
+
 } // end namespace path_bmc
 } // end namespace seahorn
@@ -2,9 +2,15 @@
 
 #include "seahorn/Expr/Expr.hh"
 
+#include <chrono>
+#include <climits>
+#include <functional>
+#include <vector>
+
 namespace seahorn {
 namespace solver {
 class Solver;
+enum class SolverResult;
 }
 } // namespace seahorn
 
@@ -20,6 +26,89 @@ public:
   ~scoped_solver();
   solver::Solver &get() { return m_solver; }
 };
+
+/* Path formulas that could not be solved within their time budget.
+
+   pop() returns the path that looks easiest: the one with the
+   smallest budget so far and then the smallest formula. Each retry
+   of a path doubles its budget.
+*/
+class unsolved_path_queue {
+public:
+  struct path {
+    /* number of the path in the enumeration */
+    unsigned id;
+    expr::ExprVector formula;
+    /* size of the formula as a DAG */
+    size_t size;
+    /* timeout (sec) of the last attempt */
+    unsigned timeout;
+    /* number of attempts */
+    unsigned attempts;
+
+    /* Timeout (sec) of the next attempt */
+    unsigned next_timeout() const {
+      return timeout > UINT_MAX / 2 ? UINT_MAX : 2 * timeout;
+    }
+  };
+
+private:
+  std::vector<path> m_heap;
+
+public:
+  /* Add a path that timed out after timeout seconds */
+  void push(unsigned id, expr::ExprVector formula, unsigned timeout);
+  /* Put back a path after another attempt */
+  void push(path p);
+  path pop();
+  bool empty() const { return m_heap.empty(); }
+  size_t size() const { return m_heap.size(); }
+  /* Paths in no particular order */
+  const std::vector<path> &paths() const { return m_heap; }
+};
+
+/* Wall-clock time budget shared by all retries of unsolved paths.
+
+   The clock starts with the first retry, whether it is interleaved
+   with the enumeration of paths or done after it. A budget of 0
+   seconds is unbounded.
+*/
+class retry_budget {
+  using clock = std::chrono::steady_clock;
+  unsigned m_budget;
+  bool m_started;
+  clock::time_point m_deadline;
+
+public:
+  explicit retry_budget(unsigned budget = 0)
+      : m_budget(budget), m_started(false) {}
+  /* Start the clock if it is not running yet */
+  void start();
+  bool bounded() const { return m_budget > 0; }
+  /* Seconds left, rounded up. UINT_MAX if unbounded and m_budget if the
+     clock has not started */
+  unsigned time_left() const;
+  bool expired() const { return time_left() == 0; }
+  /* Requires that the clock has started and the budget is bounded */
+  clock::time_point deadline() const { return m_deadline; }
+};
+
+/* Literals of the Boolean abstraction along a whole path. They block
+   the path when no unsat core is known. */
+expr::ExprVector whole_path_cond(const expr::ExprMap &bool_map);
+
+/* Solve a path with solve, which sets the path condition of an unsat
+   path and counts its solver calls.
+
+   If solve throws (e.g., a solver interrupted outside of a check),
+   the path is unknown and path_cond gets the whole path, so the path
+   is blocked as an unknown path is. The path condition may not have
+   been set, and an empty one would block every path. */
+solver::SolverResult solve_path_guarded(
+    const std::function<solver::SolverResult(expr::ExprVector &, unsigned &)>
+        &solve,
+    const expr::ExprMap &bool_map, expr::ExprVector &path_cond,
+    unsigned &solver_calls);
 } // namespace path_bmc
 } // namespace seahorn
 
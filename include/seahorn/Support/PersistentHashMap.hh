@@ -0,0 +1,220 @@
+#pragma once
+/// A persistent hash map: copies share their structure
+
+#include "llvm/Support/MathExtras.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace seahorn {
+
+/// \brief A hash map whose copies are O(1) and share structure
+///
+/// A hash array mapped trie. Each node covers 5 bits of the hash and keeps
+/// only the slots that are in use. Copying the map copies the root pointer.
+/// A write copies the nodes on the path to the key that are shared with
+/// another map, and updates the others in place, so a map that is not
+/// shared is updated as cheaply as a mutable one. Keys whose hashes are
+/// equal are kept in a list at the bottom of the trie.
+///
+/// Nodes are reference counted. As with the standard containers, a map may
+/// not be used by two threads at the same time, but maps that share
+/// structure may be.
+template <typename K, typename V, typename Hash = std::hash<K>,
+          typename Equal = std::equal_to<K>>
+class PersistentHashMap {
+public:
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = std::pair<K, V>;
+
+private:
+  static constexpr unsigned kBits = 5;
+  static constexpr unsigned kMask = (1u << kBits) - 1;
+  static constexpr unsigned kHashBits = sizeof(size_t) * 8;
+
+  struct Node;
+  using NodePtr = std::shared_ptr<Node>;
+
+  /// a key and its value, or a sub-trie
+  struct Slot {
+    NodePtr child;
+    value_type kv;
+    size_t hash;
+  };
+
+  /// Below kHashBits, slot i is for the i-th bit set in bitmap. At
+  /// kHashBits and more, slots are a list of keys with equal hashes.
+  struct Node {
+    uint32_t bitmap = 0;
+    std::vector<Slot> slots;
+  };
+
+  NodePtr m_root;
+  size_t m_size = 0;
+
+  static uint32_t bitFor(size_t hash, unsigned shift) {
+    return 1u << ((hash >> shift) & kMask);
+  }
+  static unsigned indexOf(const Node &n, uint32_t bit) {
+    return llvm::countPopulation(n.bitmap & (bit - 1));
+  }
+
+public:
+  class const_iterator {
+    friend class PersistentHashMap;
+    /// nodes from the root, and the slot visited in each
+    std::vector<std::pair<const Node *, unsigned>> m_stack;
+
+    explicit const_iterator(const Node *root) {
+      if (root) {
+        m_stack.push_back({root, 0});
+        settle();
+      }
+    }
+
+    /// moves to the first key at or after the current slot
+    void settle() {
+      while (!m_stack.empty()) {
+        auto &top = m_stack.back();
+        if (top.second >= top.first->slots.size()) {
+          m_stack.pop_back();
+          if (!m_stack.empty())
+            ++m_stack.back().second;
+          continue;
+        }
+        const Slot &s = top.first->slots[top.second];
+        if (!s.child)
+          return;
+        m_stack.push_back({s.child.get(), 0});
+      }
+    }
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = PersistentHashMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type *;
+    using reference = const value_type &;
+
+    const_iterator() = default;
+
+    reference operator*() const {
+      return m_stack.back().first->slots[m_stack.back().second].kv;
+    }
+    pointer operator->() const { return &**this; }
+
+    const_iterator &operator++() {
+      ++m_stack.back().second;
+      settle();
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator res(*this);
+      ++*this;
+      return res;
+    }
+
+    bool operator==(const const_iterator &o) const {
+      return m_stack == o.m_stack;
+    }
+    bool operator!=(const const_iterator &o) const { return !(*this == o); }
+  };
+  using iterator = const_iterator;
+
+  size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+  void clear() {
+    m_root.reset();
+    m_size = 0;
+  }
+  void swap(PersistentHashMap &o) {
+    std::swap(m_root, o.m_root);
+    std::swap(m_size, o.m_size);
+  }
+
+  const_iterator begin() const { return const_iterator(m_root.get()); }
+  const_iterator end() const { return const_iterator(); }
+
+  /// \brief Returns the value of \p key, or nullptr if there is none
+  const V *lookup(const K &key) const {
+    size_t hash = Hash()(key);
+    const Node *n = m_root.get();
+    for (unsigned shift = 0; n; shift += kBits) {
+      if (shift >= kHashBits) {
+        for (const Slot &s : n->slots)
+          if (Equal()(s.kv.first, key))
+            return &s.kv.second;
+        return nullptr;
+      }
+      uint32_t bit = bitFor(hash, shift);
+      if (!(n->bitmap & bit))
+        return nullptr;
+      const Slot &s = n->slots[indexOf(*n, bit)];
+      if (!s.child)
+        return s.hash == hash && Equal()(s.kv.first, key) ? &s.kv.second
+                                                          : nullptr;
+      n = s.child.get();
+    }
+    return nullptr;
+  }
+
+  size_t count(const K &key) const { return lookup(key) ? 1 : 0; }
+
+  /// \brief Maps \p key to \p val
+  void set(const K &key, V val) {
+    size_t hash = Hash()(key);
+    NodePtr *ref = &m_root;
+    for (unsigned shift = 0;; shift += kBits) {
+      // -- copy the nodes that other maps still use
+      if (!*ref)
+        *ref = std::make_shared<Node>();
+      else if (ref->use_count() > 1)
+        *ref = std::make_shared<Node>(**ref);
+      Node &n = **ref;
+
+      if (shift >= kHashBits) {
+        for (Slot &s : n.slots)
+          if (Equal()(s.kv.first, key)) {
+            s.kv.second = std::move(val);
+            return;
+          }
+        n.slots.push_back({nullptr, {key, std::move(val)}, hash});
+        ++m_size;
+        return;
+      }
+
+      uint32_t bit = bitFor(hash, shift);
+      unsigned idx = indexOf(n, bit);
+      if (!(n.bitmap & bit)) {
+        n.slots.insert(n.slots.begin() + idx,
+                       Slot{nullptr, {key, std::move(val)}, hash});
+        n.bitmap |= bit;
+        ++m_size;
+        return;
+      }
+
+      Slot &s = n.slots[idx];
+      if (!s.child) {
+        if (s.hash == hash && Equal()(s.kv.first, key)) {
+          s.kv.second = std::move(val);
+          return;
+        }
+        // -- move the key of the slot one level down
+        NodePtr child = std::make_shared<Node>();
+        if (shift + kBits < kHashBits)
+          child->bitmap = bitFor(s.hash, shift + kBits);
+        child->slots.push_back(std::move(s));
+        s = Slot{std::move(child), value_type(), 0};
+      }
+      ref = &s.child;
+    }
+  }
+};
+
+} // namespace seahorn
@@ -1,55 +1,97 @@
 #pragma once
 
+#include <algorithm>
 #include <map>
+#include <string>
 
 #include <sys/resource.h>
 #include <sys/time.h>
+#include <time.h>
 
 #include "llvm/Support/Format.h"
 #include "llvm/Support/raw_ostream.h"
 #include <iosfwd>
 
 namespace seahorn {
+/** Measures wall-clock, user and system time. User and system time are
+    those of the whole process, so they include time spent in all
+    threads (e.g., solver threads). */
 class Stopwatch {
 private:
-  long started;
-  long finished;
-  long timeElapsed;
+  // -- all times are in microseconds
+  struct Sample {
+    long user;
+    long sys;
+    long wall;
+  };
+
+  Sample started;
+  Sample elapsed;
+  bool running;
+  // -- peak resident set size of the whole process, in KB, when the
+  // -- watch was last stopped. Not the footprint of the timed phase.
+  long processMaxRss;
+
+  static Sample now() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    Sample s;
+    s.user = ru.ru_utime.tv_sec * 1000000L + ru.ru_utime.tv_usec;
+    s.sys = ru.ru_stime.tv_sec * 1000000L + ru.ru_stime.tv_usec;
+    s.wall = ts.tv_sec * 1000000L + ts.tv_nsec / 1000L;
+    return s;
+  }
 
-  long systemTime() const {
+  static long peakRss() {
     struct rusage ru;
     getrusage(RUSAGE_SELF, &ru);
-    long r = ru.ru_utime.tv_sec * 1000000L + ru.ru_utime.tv_usec;
-    return r;
+    return ru.ru_maxrss;
+  }
+
+  Sample current() const {
+    if (!running)
+      return elapsed;
+    Sample n = now();
+    n.user = elapsed.user + n.user - started.user;
+    n.sys = elapsed.sys + n.sys - started.sys;
+    n.wall = elapsed.wall + n.wall - started.wall;
+    return n;
   }
 
 public:
-  Stopwatch() { start(); }
+  Stopwatch() : processMaxRss(0) { start(); }
 
   void start() {
-    started = systemTime();
-    finished = -1;
-    timeElapsed = 0;
+    elapsed.user = elapsed.sys = elapsed.wall = 0;
+    running = true;
+    started = now();
   }
 
   void stop() {
-    if (finished < started) {
-      finished = systemTime();
+    if (running) {
+      elapsed = current();
+      running = false;
+      processMaxRss = std::max(processMaxRss, peakRss());
     }
   }
 
   void resume() {
-    if (finished >= started) {
-      timeElapsed += finished - started;
-      started = systemTime();
-      finished = -1;
+    if (!running) {
+      started = now();
+      running = true;
     }
   }
 
-  long getTimeElapsed() const {
-    if (finished < started)
-      return timeElapsed + systemTime() - started;
-    return timeElapsed + finished - started;
+  /// user time
+  long getTimeElapsed() const { return current().user; }
+  long getSystemTimeElapsed() const { return current().sys; }
+  long getWallTimeElapsed() const { return current().wall; }
+  /// peak resident set size of the whole process, in KB, as of the last
+  /// stop (or now, if running). Earlier phases count as well.
+  long getProcessPeakRss() const {
+    return running ? std::max(processMaxRss, peakRss()) : processMaxRss;
   }
 
   void Print(std::ostream &out) const;
@@ -105,31 +147,58 @@ inline llvm::raw_ostream &operator<<(llvm::raw_ostream &OS,
   return OS;
 }
 
-class Stats {
-private:
-  static std::map<std::string, unsigned> counters;
-  static std::map<std::string, Stopwatch> sw;
-  static std::map<std::string, Averager> av;
-  static std::map<std::string, std::string> ss;
+struct StatsTimer;
+struct StatsCounter;
 
+/** Global statistics. All methods are thread-safe. Timers and counters
+    can be interned once and then used through their handles. Unlike
+    names, handles are not looked up under the global lock, so hot paths
+    and worker threads should use them. */
+class Stats {
 public:
+  /// handles of interned timers and counters, valid until the end of
+  /// the program
+  typedef StatsTimer *TimerId;
+  typedef StatsCounter *CounterId;
+
+  static TimerId timer(const std::string &name);
+  static CounterId counter(const std::string &name);
+
   static unsigned get(const std::string &n);
+  static unsigned get(CounterId c);
   static double avg(const std::string &n, double v);
   static unsigned uset(const std::string &n, unsigned v);
+  static unsigned uset(CounterId c, unsigned v);
+  /// atomically adds v to a counter and returns the new value
+  static unsigned add(const std::string &n, unsigned v);
+  static unsigned add(CounterId c, unsigned v);
+  /// atomically raises a counter to v if it is smaller and returns the
+  /// new value
+  static unsigned max(const std::string &n, unsigned v);
+  static unsigned max(CounterId c, unsigned v);
 
   static void sset(const std::string &n, const std::string &v);
-  static std::string &sget(const std::string &n);
+  static std::string sget(const std::string &n);
 
   static void count(const std::string &name);
+  static void count(CounterId c);
 
   static void start(const std::string &name);
   static void stop(const std::string &name);
   static void resume(const std::string &name);
+  static void start(TimerId t);
+  static void stop(TimerId t);
+  static void resume(TimerId t);
 
   /** Outputs all statistics to std output */
   static void Print(std::ostream &OS);
   static void Print(llvm::raw_ostream &OS);
   static void PrintBrunch(llvm::raw_ostream &OS);
+  /** Outputs all statistics in JSON. Timers form a tree following the
+      nesting of ScopedStats */
+  static void PrintJson(llvm::raw_ostream &OS);
+  /** Outputs all statistics in CSV, one row per statistic */
+  static void PrintCsv(llvm::raw_ostream &OS);
 };
 
 /**
@@ -163,18 +232,20 @@ public:
   }
 };
 
+/** Measures the time spent in a scope. ScopedStats that are nested in
+    the same thread form a tree: a timer is a child of the timer of the
+    enclosing scope the first time it runs. A scope nested in a scope
+    of the same timer (e.g., recursion) is not measured twice. */
 class ScopedStats {
-  std::string m_name;
+  Stats::TimerId m_timer;
+  bool m_active;
+
+  void enter(bool reset);
 
 public:
-  ScopedStats(const std::string &name, bool reset = false) : m_name(name) {
-    if (reset) {
-      m_name += ".last";
-      Stats::start(m_name);
-    } else
-      Stats::resume(m_name);
-  }
-  ~ScopedStats() { Stats::stop(m_name); }
+  ScopedStats(const std::string &name, bool reset = false);
+  ScopedStats(Stats::TimerId timer) : m_timer(timer) { enter(false); }
+  ~ScopedStats();
 };
 
 } // namespace seahorn
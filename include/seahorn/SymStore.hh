@@ -4,11 +4,11 @@
 
 #include "seahorn/Expr/Expr.hh"
 #include "seahorn/Expr/ExprVisitor.hh"
+#include "seahorn/Support/PersistentHashMap.hh"
 
 #include "llvm/Support/raw_ostream.h"
 #include <map>
 #include <memory>
-#include <unordered_map>
 
 namespace seahorn {
 using namespace expr;
@@ -39,7 +39,10 @@ class SymStore : public std::unary_function<Expr, Expr> {
 
 public:
   typedef std::shared_ptr<SymStore> SymStorePtr;
-  typedef std::unordered_map<Expr, Expr> ExprExprMap;
+  /// Copies of the map share structure. Copying a store, as done to fork
+  /// an OpSemContext or to keep the state at a cut-point, is O(1) and only
+  /// the writes made after the copy use new memory.
+  typedef PersistentHashMap<Expr, Expr> ExprExprMap;
 
 protected:
   /// Parent store, if any
@@ -101,11 +104,11 @@ public:
 
   ExprFactory &getExprFactory() { return m_efac; }
 
-  bool isDefined(Expr key) const { return m_Store.count(key) > 0; }
+  bool isDefined(Expr key) const { return m_Store.lookup(key) != nullptr; }
 
   Expr at(Expr key) const {
-    if (isDefined(key))
-      return m_Store.at(key);
+    if (const Expr *val = m_Store.lookup(key))
+      return *val;
     return Expr(0);
   }
 
@@ -114,8 +117,6 @@ public:
 
   typedef ExprExprMap::iterator iterator;
   typedef ExprExprMap::const_iterator const_iterator;
-  iterator begin() { return m_Store.begin(); }
-  iterator end() { return m_Store.end(); }
   const_iterator begin() const { return m_Store.begin(); }
   const_iterator end() const { return m_Store.end(); }
 
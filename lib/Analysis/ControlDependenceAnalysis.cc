@@ -14,7 +14,7 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/PostOrderIterator.h"
-#include "llvm/ADT/SparseBitVector.h"
+#include "llvm/ADT/SCCIterator.h"
 
 #include "llvm/Support/raw_ostream.h"
 
@@ -38,8 +38,22 @@ class ControlDependenceAnalysisImpl
   DenseMap<const BasicBlock *, unsigned> m_BBToIdx;
   /// \brief list of basic blocks in reverse-topological order
   std::vector<const BasicBlock *> m_postOrderBlocks;
-  /// \brief a map from a basic blocks to all reachable blocks
-  mutable DenseMap<const BasicBlock *, SparseBitVector<>> m_reach;
+  /// \brief maps basic blocks to their SCC. SCCs are numbered in
+  /// reverse-topological order of the condensed CFG.
+  DenseMap<const BasicBlock *, unsigned> m_BBToScc;
+  /// \brief successors of each SCC in the condensed CFG
+  std::vector<SmallVector<unsigned, 2>> m_sccSuccs;
+  /// \brief DFS post-order number of each SCC in the condensed CFG
+  std::vector<unsigned> m_post;
+  /// \brief smallest post-order number in the DFS subtree of each SCC
+  std::vector<unsigned> m_treeLow;
+  /// \brief smallest post-order number of any SCC reachable from each SCC
+  std::vector<unsigned> m_low;
+  /// \brief answers to reachability queries that needed a search
+  mutable DenseMap<std::pair<unsigned, unsigned>, bool> m_reachCache;
+  /// \brief visited marks of a search, valid if equal to m_epoch
+  mutable std::vector<unsigned> m_visited;
+  mutable unsigned m_epoch = 0;
   /// \brief maps a basic block to its control dependent blocks
   DenseMap<const BasicBlock *, SmallVector<BasicBlock *, 4>> m_cdInfo;
 
@@ -67,6 +81,17 @@ private:
 
   // Initializes reachability information and PO numbering.
   void initReach();
+
+  /// \brief false only if SCC \p src cannot reach SCC \p dst
+  bool mayReach(unsigned src, unsigned dst) const {
+    return dst < src && m_low[src] <= m_low[dst] && m_post[dst] < m_post[src];
+  }
+  /// \brief true only if SCC \p src reaches SCC \p dst through DFS tree edges
+  bool treeReach(unsigned src, unsigned dst) const {
+    return m_treeLow[src] <= m_post[dst] && m_post[dst] <= m_post[src];
+  }
+  /// \brief Returns true if SCC \p src reaches SCC \p dst
+  bool sccReachable(unsigned src, unsigned dst) const;
 };
 
 void ControlDependenceAnalysisImpl::calculate(PostDominatorTree &PDT) {
@@ -121,45 +146,105 @@ void ControlDependenceAnalysisImpl::calculate(PostDominatorTree &PDT) {
 
 void ControlDependenceAnalysisImpl::initReach() {
   m_postOrderBlocks.reserve(m_function.size());
-  DenseMap<BasicBlock *, unsigned> poNums;
-  poNums.reserve(m_function.size());
   unsigned num = 0;
   for (BasicBlock *BB : llvm::post_order(&m_function.getEntryBlock())) {
     m_postOrderBlocks.push_back(BB);
-    poNums[BB] = num;
     m_BBToIdx[BB] = num;
-    m_reach[BB].set(num);
-
     ++num;
   }
 
-  // Cache predecessors to avoid linear walks over basic block terminators
-  // -- the default predecessors(BB) interface is inefficient for checking
-  // containment.
-  std::vector<SmallDenseSet<BasicBlock *, 4>> inverseSuccessors(
-      m_BBToIdx.size());
+  // Reachability is answered on the DAG of SCCs. scc_iterator visits SCCs in
+  // reverse-topological order, so every edge of the DAG goes from a higher
+  // to a lower SCC number.
+  unsigned numSccs = 0;
+  for (auto I = scc_begin(&m_function); !I.isAtEnd(); ++I, ++numSccs)
+    for (BasicBlock *BB : *I)
+      m_BBToScc[BB] = numSccs;
+
+  m_sccSuccs.resize(numSccs);
+  for (auto &kv : m_BBToScc) {
+    auto &succs = m_sccSuccs[kv.second];
+    for (const BasicBlock *succ : successors(kv.first)) {
+      unsigned s = m_BBToScc[succ];
+      if (s != kv.second)
+        succs.push_back(s);
+    }
+  }
+  for (auto &succs : m_sccSuccs) {
+    std::sort(succs.begin(), succs.end());
+    succs.erase(std::unique(succs.begin(), succs.end()), succs.end());
+  }
 
-  for (auto &BB : m_function)
-    for (auto *succ : successors(&BB)) {
-      m_reach[&BB].set(m_BBToIdx[succ]);
-      inverseSuccessors[m_BBToIdx[succ]].insert(&BB);
+  // Label each SCC with its post-order number in a DFS of the DAG, the
+  // interval of post-order numbers of its DFS subtree, and the smallest
+  // post-order number it reaches. A reaches B only if B's interval
+  // [m_low, m_post] is contained in A's; it does if B is in A's subtree.
+  m_post.resize(numSccs);
+  m_treeLow.resize(numSccs);
+  m_low.resize(numSccs);
+  m_visited.assign(numSccs, 0);
+  unsigned postNum = 0;
+  // -- the SCC of the entry block is the last one and reaches all others
+  std::vector<std::pair<unsigned, unsigned>> stack;
+  if (numSccs > 0) {
+    stack.push_back({numSccs - 1, 0});
+    m_visited[numSccs - 1] = 1;
+    m_treeLow[numSccs - 1] = postNum;
+  }
+  while (!stack.empty()) {
+    unsigned scc = stack.back().first;
+    unsigned &next = stack.back().second;
+    if (next < m_sccSuccs[scc].size()) {
+      unsigned succ = m_sccSuccs[scc][next++];
+      if (!m_visited[succ]) {
+        m_visited[succ] = 1;
+        m_treeLow[succ] = postNum;
+        stack.push_back({succ, 0});
+      }
+      continue;
     }
+    stack.pop_back();
+    m_post[scc] = postNum++;
+    m_low[scc] = m_treeLow[scc];
+    for (unsigned succ : m_sccSuccs[scc])
+      m_low[scc] = std::min(m_low[scc], m_low[succ]);
+  }
+  m_visited.assign(numSccs, 0);
+}
 
-  // Calculate rechability by processing BBs in reverse.
-  bool changed = true;
-  while (changed) {
-    changed = false;
-    for (auto *BB : m_postOrderBlocks) {
-      auto &currReach = m_reach[BB];
-      for (BasicBlock *pred : inverseSuccessors[m_BBToIdx[BB]]) {
-        auto &predReach = m_reach[pred];
-        const size_t initSize = predReach.count();
-        predReach |= currReach;
-        if (predReach.count() != initSize)
-          changed = true;
+bool ControlDependenceAnalysisImpl::sccReachable(unsigned src,
+                                                 unsigned dst) const {
+  if (src == dst)
+    return true;
+  if (!mayReach(src, dst))
+    return false;
+  if (treeReach(src, dst))
+    return true;
+
+  auto cached = m_reachCache.find({src, dst});
+  if (cached != m_reachCache.end())
+    return cached->second;
+
+  // Depth-first search from src that only enters SCCs that may reach dst.
+  ++m_epoch;
+  bool res = false;
+  SmallVector<unsigned, 32> worklist = {src};
+  m_visited[src] = m_epoch;
+  while (!worklist.empty() && !res) {
+    unsigned scc = worklist.pop_back_val();
+    for (unsigned succ : m_sccSuccs[scc]) {
+      if (succ == dst || treeReach(succ, dst)) {
+        res = true;
+        break;
+      }
+      if (m_visited[succ] != m_epoch && mayReach(succ, dst)) {
+        m_visited[succ] = m_epoch;
+        worklist.push_back(succ);
       }
     }
   }
+  m_reachCache[{src, dst}] = res;
+  return res;
 }
 
 llvm::ArrayRef<llvm::BasicBlock *>
@@ -171,11 +256,11 @@ ControlDependenceAnalysisImpl::getCDBlocks(llvm::BasicBlock *BB) const {
 
 bool ControlDependenceAnalysisImpl::isReachable(BasicBlock *Src,
                                                 BasicBlock *Dst) const {
-  auto it = m_reach.find(Src);
-  assert(it != m_reach.end());
-  auto dstIdxIt = m_BBToIdx.find(Dst);
-  assert(dstIdxIt != m_BBToIdx.end());
-  return it->second.test(dstIdxIt->second);
+  auto srcIt = m_BBToScc.find(Src);
+  assert(srcIt != m_BBToScc.end());
+  auto dstIt = m_BBToScc.find(Dst);
+  assert(dstIt != m_BBToScc.end());
+  return sccReachable(srcIt->second, dstIt->second);
 }
 
 } // anonymous namespace
@@ -1,73 +1,395 @@
 #include "seahorn/Support/Stats.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <deque>
 #include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 namespace seahorn {
-std::map<std::string, unsigned> Stats::counters;
-std::map<std::string, Stopwatch> Stats::sw;
-std::map<std::string, Averager> Stats::av;
-std::map<std::string, std::string> Stats::ss;
+struct StatsTimer {
+  std::string name;
+  // -- guards sw, parent and nested. Timers have their own lock so that
+  // -- starting and stopping them does not contend on the registry.
+  std::mutex mtx;
+  Stopwatch sw;
+  // -- enclosing timer in the tree of ScopedStats, if any
+  StatsTimer *parent;
+  bool nested;
+  StatsTimer(const std::string &n) : name(n), parent(nullptr), nested(false) {}
+
+  Stopwatch watch() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return sw;
+  }
+  StatsTimer *getParent() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return parent;
+  }
+};
+
+struct StatsCounter {
+  std::string name;
+  std::atomic<unsigned> value;
+  StatsCounter(const std::string &n) : name(n), value(0) {}
+};
+
+namespace {
+/// Storage of all statistics. Records live in deques so that handles
+/// stay valid while new ones are added.
+struct StatsRegistry {
+  std::mutex mtx;
+  std::deque<StatsTimer> timers;
+  std::unordered_map<std::string, StatsTimer *> timerIdx;
+  std::deque<StatsCounter> counters;
+  std::unordered_map<std::string, StatsCounter *> counterIdx;
+  std::map<std::string, Averager> av;
+  std::map<std::string, std::string> ss;
+
+  StatsTimer *timer(const std::string &name) {
+    auto it = timerIdx.find(name);
+    if (it != timerIdx.end())
+      return it->second;
+    timers.emplace_back(name);
+    // -- a timer does not run until it is started or resumed
+    timers.back().sw.stop();
+    return timerIdx[name] = &timers.back();
+  }
+
+  StatsCounter *counter(const std::string &name) {
+    auto it = counterIdx.find(name);
+    if (it != counterIdx.end())
+      return it->second;
+    counters.emplace_back(name);
+    return counterIdx[name] = &counters.back();
+  }
+
+  template <typename T>
+  std::vector<T *> sorted(std::deque<T> &recs) {
+    std::vector<T *> res;
+    for (T &r : recs)
+      res.push_back(&r);
+    std::sort(res.begin(), res.end(),
+              [](const T *x, const T *y) { return x->name < y->name; });
+    return res;
+  }
+};
+
+StatsRegistry &registry() {
+  static StatsRegistry r;
+  return r;
+}
+
+/// timers of the ScopedStats that are active in this thread
+thread_local std::vector<StatsTimer *> activeScopes;
+} // namespace
+
+Stats::TimerId Stats::timer(const std::string &name) {
+  StatsRegistry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mtx);
+  return r.timer(name);
+}
 
-void Stats::count(const std::string &name) { ++counters[name]; }
-double Stats::avg(const std::string &n, double v) { return av[n].add(v); }
+Stats::CounterId Stats::counter(const std::string &name) {
+  StatsRegistry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mtx);
+  return r.counter(name);
+}
+
+void Stats::count(const std::string &name) { count(counter(name)); }
+void Stats::count(CounterId c) { ++c->value; }
+double Stats::avg(const std::string &n, double v) {
+  StatsRegistry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mtx);
+  return r.av[n].add(v);
+}
 unsigned Stats::uset(const std::string &n, unsigned v) {
-  return counters[n] = v;
+  return uset(counter(n), v);
+}
+unsigned Stats::uset(CounterId c, unsigned v) { return c->value = v; }
+unsigned Stats::add(const std::string &n, unsigned v) {
+  return add(counter(n), v);
+}
+unsigned Stats::add(CounterId c, unsigned v) { return c->value += v; }
+unsigned Stats::max(const std::string &n, unsigned v) {
+  return max(counter(n), v);
+}
+unsigned Stats::max(CounterId c, unsigned v) {
+  unsigned cur = c->value;
+  while (cur < v && !c->value.compare_exchange_weak(cur, v))
+    ;
+  return std::max(cur, v);
+}
+unsigned Stats::get(const std::string &n) { return get(counter(n)); }
+unsigned Stats::get(CounterId c) { return c->value; }
+
+void Stats::sset(const std::string &n, const std::string &v) {
+  StatsRegistry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mtx);
+  r.ss[n] = v;
+}
+std::string Stats::sget(const std::string &n) {
+  StatsRegistry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mtx);
+  return r.ss[n];
+}
+
+void Stats::start(const std::string &name) { start(timer(name)); }
+void Stats::stop(const std::string &name) { stop(timer(name)); }
+void Stats::resume(const std::string &name) { resume(timer(name)); }
+
+void Stats::start(TimerId t) {
+  std::lock_guard<std::mutex> lock(t->mtx);
+  t->sw.start();
+}
+void Stats::stop(TimerId t) {
+  std::lock_guard<std::mutex> lock(t->mtx);
+  t->sw.stop();
+}
+void Stats::resume(TimerId t) {
+  std::lock_guard<std::mutex> lock(t->mtx);
+  t->sw.resume();
 }
-unsigned Stats::get(const std::string &n) { return counters[n]; }
 
-void Stats::sset(const std::string &n, const std::string &v) { ss[n] = v; }
-std::string &Stats::sget(const std::string &n) { return ss[n]; }
+ScopedStats::ScopedStats(const std::string &name, bool reset) {
+  m_timer = Stats::timer(reset ? name + ".last" : name);
+  enter(reset);
+}
+
+void ScopedStats::enter(bool reset) {
+  m_active = std::find(activeScopes.begin(), activeScopes.end(), m_timer) ==
+             activeScopes.end();
+  if (!m_active)
+    return;
+  {
+    std::lock_guard<std::mutex> lock(m_timer->mtx);
+    if (!m_timer->nested) {
+      m_timer->nested = true;
+      m_timer->parent = activeScopes.empty() ? nullptr : activeScopes.back();
+    }
+  }
+  activeScopes.push_back(m_timer);
+  if (reset)
+    Stats::start(m_timer);
+  else
+    Stats::resume(m_timer);
+}
 
-void Stats::start(const std::string &name) { sw[name].start(); }
-void Stats::stop(const std::string &name) { sw[name].stop(); }
-void Stats::resume(const std::string &name) { sw[name].resume(); }
+ScopedStats::~ScopedStats() {
+  if (!m_active)
+    return;
+  assert(!activeScopes.empty() && activeScopes.back() == m_timer);
+  activeScopes.pop_back();
+  Stats::stop(m_timer);
+}
 
 /** Outputs all statistics to std output */
 void Stats::Print(std::ostream &OS) {
-  for (auto &kv : ss)
-    OS << kv.first << ": " << kv.second << "\n";
-  for (auto &kv : counters)
-    OS << kv.first << ": " << kv.second << "\n";
-  for (auto &kv : sw)
+  StatsRegistry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mtx);
+  for (auto &kv : r.ss)
     OS << kv.first << ": " << kv.second << "\n";
+  for (StatsCounter *c : r.sorted(r.counters))
+    OS << c->name << ": " << c->value << "\n";
+  for (StatsTimer *t : r.sorted(r.timers))
+    OS << t->name << ": " << t->watch() << "\n";
 
-  for (auto &kv : av)
+  for (auto &kv : r.av)
     OS << kv.first << ": " << kv.second << "\n";
 }
 
 void Stats::PrintBrunch(llvm::raw_ostream &OS) {
+  StatsRegistry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mtx);
   OS << "\n\n************** BRUNCH STATS ***************** \n";
-  for (auto &kv : ss)
+  for (auto &kv : r.ss)
     OS << "BRUNCH_STAT " << kv.first << " " << kv.second << "\n";
 
-  for (auto &kv : counters)
-    OS << "BRUNCH_STAT " << kv.first << " " << kv.second << "\n";
+  for (StatsCounter *c : r.sorted(r.counters))
+    OS << "BRUNCH_STAT " << c->name << " " << c->value << "\n";
 
-  for (auto &kv : sw)
-    OS << "BRUNCH_STAT " << kv.first << " "
-       << llvm::format("%.2f", (kv.second).toSeconds()) << "\n";
+  for (StatsTimer *t : r.sorted(r.timers))
+    OS << "BRUNCH_STAT " << t->name << " "
+       << llvm::format("%.2f", t->watch().toSeconds()) << "\n";
 
-  for (auto &kv : av)
+  for (auto &kv : r.av)
     OS << "BRUNCH_STAT " << kv.first << " " << kv.second << "\n";
 
   OS << "************** BRUNCH STATS END ***************** \n";
 }
 
 void Stats::Print(llvm::raw_ostream &OS) {
+  StatsRegistry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mtx);
   OS << "\n\n************** STATS ***************** \n";
-  for (auto &kv : ss)
-    OS << kv.first << ": " << kv.second << "\n";
-  for (auto &kv : counters)
+  for (auto &kv : r.ss)
     OS << kv.first << ": " << kv.second << "\n";
+  for (StatsCounter *c : r.sorted(r.counters))
+    OS << c->name << ": " << c->value << "\n";
 
-  for (auto &kv : sw)
-    OS << kv.first << ": " << kv.second << "\n";
+  for (StatsTimer *t : r.sorted(r.timers))
+    OS << t->name << ": " << t->watch() << "\n";
 
-  for (auto &kv : av)
+  for (auto &kv : r.av)
     OS << kv.first << ": " << kv.second << "\n";
 
   OS << "************** STATS END ***************** \n";
 }
 
+static void printJsonString(llvm::raw_ostream &OS, const std::string &s) {
+  OS << '"';
+  for (char c : s) {
+    switch (c) {
+    case '"':
+      OS << "\\\"";
+      break;
+    case '\\':
+      OS << "\\\\";
+      break;
+    case '\n':
+      OS << "\\n";
+      break;
+    case '\t':
+      OS << "\\t";
+      break;
+    default:
+      if ((unsigned char)c < 0x20)
+        OS << llvm::format("\\u%04x", (unsigned)c);
+      else
+        OS << c;
+    }
+  }
+  OS << '"';
+}
+
+static double toSec(long usec) { return (double)usec / 1000000; }
+
+static void printJsonTimer(
+    llvm::raw_ostream &OS, StatsTimer *t,
+    const std::map<StatsTimer *, std::vector<StatsTimer *>> &children,
+    unsigned indent) {
+  std::string pad(indent, ' ');
+  Stopwatch sw = t->watch();
+  OS << pad << "{\"name\": ";
+  printJsonString(OS, t->name);
+  OS << llvm::format(", \"wall\": %.3f, \"user\": %.3f, \"sys\": %.3f",
+                     toSec(sw.getWallTimeElapsed()), toSec(sw.getTimeElapsed()),
+                     toSec(sw.getSystemTimeElapsed()))
+     << ", \"process_peak_rss_kb\": " << sw.getProcessPeakRss();
+  auto it = children.find(t);
+  if (it != children.end()) {
+    OS << ", \"children\": [\n";
+    bool first = true;
+    for (StatsTimer *c : it->second) {
+      if (!first)
+        OS << ",\n";
+      first = false;
+      printJsonTimer(OS, c, children, indent + 2);
+    }
+    OS << "\n" << pad << "]";
+  }
+  OS << "}";
+}
+
+void Stats::PrintJson(llvm::raw_ostream &OS) {
+  StatsRegistry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mtx);
+  OS << "{\n  \"strings\": {";
+  bool first = true;
+  for (auto &kv : r.ss) {
+    OS << (first ? "\n    " : ",\n    ");
+    first = false;
+    printJsonString(OS, kv.first);
+    OS << ": ";
+    printJsonString(OS, kv.second);
+  }
+  OS << "\n  },\n  \"counters\": {";
+  first = true;
+  for (StatsCounter *c : r.sorted(r.counters)) {
+    OS << (first ? "\n    " : ",\n    ");
+    first = false;
+    printJsonString(OS, c->name);
+    OS << ": " << c->value;
+  }
+  OS << "\n  },\n  \"averages\": {";
+  first = true;
+  for (auto &kv : r.av) {
+    OS << (first ? "\n    " : ",\n    ");
+    first = false;
+    printJsonString(OS, kv.first);
+    OS << ": " << kv.second;
+  }
+  OS << "\n  },\n  \"timers\": [\n";
+  std::map<StatsTimer *, std::vector<StatsTimer *>> children;
+  std::vector<StatsTimer *> roots;
+  for (StatsTimer *t : r.sorted(r.timers)) {
+    if (StatsTimer *p = t->getParent())
+      children[p].push_back(t);
+    else
+      roots.push_back(t);
+  }
+  first = true;
+  for (StatsTimer *t : roots) {
+    if (!first)
+      OS << ",\n";
+    first = false;
+    printJsonTimer(OS, t, children, 4);
+  }
+  OS << "\n  ]\n}\n";
+}
+
+static void printCsvField(llvm::raw_ostream &OS, const std::string &s) {
+  if (s.find_first_of(",\"\n") == std::string::npos) {
+    OS << s;
+    return;
+  }
+  OS << '"';
+  for (char c : s) {
+    if (c == '"')
+      OS << '"';
+    OS << c;
+  }
+  OS << '"';
+}
+
+void Stats::PrintCsv(llvm::raw_ostream &OS) {
+  StatsRegistry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mtx);
+  OS << "kind,name,parent,value,wall,user,sys,process_peak_rss_kb\n";
+  for (auto &kv : r.ss) {
+    OS << "string,";
+    printCsvField(OS, kv.first);
+    OS << ",,";
+    printCsvField(OS, kv.second);
+    OS << ",,,,\n";
+  }
+  for (StatsCounter *c : r.sorted(r.counters)) {
+    OS << "counter,";
+    printCsvField(OS, c->name);
+    OS << ",," << c->value << ",,,,\n";
+  }
+  for (auto &kv : r.av) {
+    OS << "average,";
+    printCsvField(OS, kv.first);
+    OS << ",," << kv.second << ",,,,\n";
+  }
+  for (StatsTimer *t : r.sorted(r.timers)) {
+    Stopwatch sw = t->watch();
+    OS << "timer,";
+    printCsvField(OS, t->name);
+    OS << ",";
+    if (StatsTimer *p = t->getParent())
+      printCsvField(OS, p->name);
+    OS << llvm::format(",,%.3f,%.3f,%.3f,", toSec(sw.getWallTimeElapsed()),
+                       toSec(sw.getTimeElapsed()),
+                       toSec(sw.getSystemTimeElapsed()))
+       << sw.getProcessPeakRss() << "\n";
+  }
+}
+
 void Stopwatch::Print(std::ostream &out) const {
   long time = getTimeElapsed();
   long h = time / 3600000000L;
@@ -2,13 +2,24 @@
 #include "seahorn/Transforms/Instrumentation/ShadowMemDsa.hh"
 #include "seahorn/UfoOpSem.hh"
 
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/IR/CFG.h"
 #include "llvm/IR/DebugInfo.h"
 #include "llvm/IR/DebugLoc.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Support/CommandLine.h"
 
 #include "boost/container/flat_set.hpp"
 #include "seahorn/Support/SeaDebug.h"
+#include "seahorn/Support/Stats.hh"
+#include "seahorn/Expr/ExprAig.hh"
 #include "seahorn/Expr/ExprLlvm.hh"
 
+static llvm::cl::opt<bool>
+    BmcAig("horn-bmc-aig",
+           llvm::cl::desc("Simplify the boolean structure of the BMC formula "
+                          "with an And-Inverter Graph before solving"),
+           llvm::cl::init(false));
 
 namespace seahorn {
 void BmcEngine::addCutPoint(const CutPoint &cp) {
@@ -59,12 +70,132 @@ void BmcEngine::encode(bool assert_formula) {
   }
 
   if (assert_formula) {
-    for (Expr v : m_side)
-      m_smt_solver.assertExpr(v);
+    if (BmcAig) {
+      // -- m_side is kept as is for counterexamples and unsat cores
+      ExprVector simp;
+      boolop::aig(m_side, simp);
+      for (Expr v : simp)
+        if (!isOpX<TRUE>(v))
+          m_smt_solver.assertExpr(v);
+    } else {
+      for (Expr v : m_side)
+        m_smt_solver.assertExpr(v);
+    }
   }
 }
 
+namespace {
+/// true if \p bb calls a function that marks a failed assertion
+bool isFailureBlock(const llvm::BasicBlock &bb) {
+  for (const Instruction &inst : bb) {
+    auto *ci = dyn_cast<CallInst>(&inst);
+    if (!ci)
+      continue;
+    const Function *fn = ci->getCalledFunction();
+    if (fn && (fn->getName().equals("verifier.error") ||
+               fn->getName().equals("seahorn.fail")))
+      return true;
+  }
+  return false;
+}
+} // namespace
+
+void BmcEngine::addProperties() {
+  assert(m_fn);
+  SmallPtrSet<const BasicBlock *, 8> failures;
+  for (const BasicBlock &bb : *m_fn)
+    if (isFailureBlock(bb))
+      failures.insert(&bb);
+
+  // -- properties are numbered in the order of their source blocks in the
+  // -- function, not in the order of the use lists of failure blocks
+  for (const BasicBlock &bb : *m_fn) {
+    if (failures.count(&bb) && pred_begin(&bb) == pred_end(&bb))
+      m_props.emplace_back(nullptr, &bb);
+    // -- bb may branch to a failure block more than once
+    SmallPtrSet<const BasicBlock *, 4> seen;
+    for (const BasicBlock *succ : successors(&bb))
+      if (failures.count(succ) && seen.insert(succ).second)
+        m_props.emplace_back(&bb, succ);
+  }
+}
+
+void BmcEngine::encodeProperties() {
+  assert(!m_states.empty());
+  SymStore &s = m_states.back();
+  Expr trueE = mk<TRUE>(m_efac);
+
+  for (BmcProperty &p : m_props) {
+    Expr dstV = s.eval(getSymbReg(*p.dst));
+    if (!p.src) {
+      p.guard = dstV;
+      continue;
+    }
+
+    // -- the edge is taken if both blocks execute and the branch at the
+    // -- source goes to the failure block
+    Expr cond = trueE;
+    auto *br = dyn_cast<BranchInst>(p.src->getTerminator());
+    if (br && br->isConditional() &&
+        br->getSuccessor(0) != br->getSuccessor(1)) {
+      const Value &c = *br->getCondition();
+      if (auto *ci = dyn_cast<ConstantInt>(&c))
+        cond = ci->isOne() == (br->getSuccessor(0) == p.dst)
+                   ? trueE
+                   : mk<FALSE>(m_efac);
+      else if (m_sem.isTracked(c)) {
+        cond = s.eval(getSymbReg(c));
+        if (br->getSuccessor(0) != p.dst)
+          cond = boolop::lneg(cond);
+      }
+    }
+    p.guard = boolop::land(s.eval(getSymbReg(*p.src)),
+                           boolop::land(dstV, cond));
+  }
+}
+
+boost::tribool BmcEngine::solveProperties(
+    std::function<void(const BmcProperty &, BmcTrace &)> onFail) {
+  encode();
+  encodeProperties();
+
+  unsigned numFailed = 0;
+  bool unknown = false;
+  for (unsigned i = 0, sz = m_props.size(); i < sz; ++i) {
+    BmcProperty &p = m_props[i];
+    // -- an indicator literal enables the guard of the current property
+    Expr lit = bind::boolConst(
+        mkTerm<std::string>("bmc.prop." + std::to_string(i), m_efac));
+    m_smt_solver.assertExpr(mk<IMPL>(lit, p.guard));
+
+    ExprVector assumptions{lit};
+    p.result = m_smt_solver.solveAssuming(assumptions);
+    if (p.result) {
+      ++numFailed;
+      m_result = true;
+      auto model = m_smt_solver.getModel();
+      BmcTrace trace(*this, model);
+      onFail(p, trace);
+      // -- block the violation so that it is not found again
+      m_smt_solver.assertExpr(mk<NEG>(p.guard));
+    } else if (boost::indeterminate(p.result))
+      unknown = true;
+  }
+
+  Stats::uset("bmc.props", m_props.size());
+  Stats::uset("bmc.props_failed", numFailed);
+
+  if (numFailed > 0)
+    m_result = true;
+  else if (unknown)
+    m_result = boost::indeterminate;
+  else
+    m_result = false;
+  return m_result;
+}
+
 void BmcEngine::reset() {
+  m_props.clear();
   m_cps.clear();
   m_cpg = nullptr;
   m_fn = nullptr;
@@ -1,6 +1,7 @@
 #include "llvm/Analysis/PostDominators.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/Dominators.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/InstIterator.h"
@@ -20,6 +21,8 @@
 #include "seahorn/Analysis/GateAnalysis.hh"
 #include "seahorn/Bmc.hh"
 #include "seahorn/CexHarness.hh"
+#include "seahorn/Expr/ExprAig.hh"
+#include "seahorn/Expr/ExprRewriter.hh"
 #include "seahorn/BvOpSem.hh"
 #include "seahorn/BvOpSem2.hh"
 #include "seahorn/DfCoiAnalysis.hh"
@@ -32,6 +35,9 @@
 namespace seahorn {
 // defined in HornCex.cc
 extern std::string HornCexFile;
+// defined in PathBmc.cc
+extern solver::SolverKind SmtSolver;
+extern unsigned PathWorkers;
 }
 
 // XXX temporary debugging aid
@@ -47,10 +53,27 @@ static llvm::cl::opt<bool> ComputeCoi("horn-bmc-coi",
                                       llvm::cl::desc("Compute DataFlow-based COI"),
                                       llvm::cl::init(false), llvm::cl::Hidden);
 
+static llvm::cl::opt<bool> MultiProp(
+    "horn-bmc-multi-prop",
+    llvm::cl::desc("Check every assertion separately and report a verdict "
+                   "and a counterexample for each of them"),
+    llvm::cl::init(false));
+
 namespace {
 using namespace llvm;
 using namespace seahorn;
 
+/// \brief Prints the source location of a BMC property
+void printPropertyLoc(raw_ostream &out, const BmcProperty &p) {
+  const BasicBlock &bb = p.src ? *p.src : *p.dst;
+  const DebugLoc &dloc = bb.getTerminator()->getDebugLoc();
+  if (dloc)
+    out << cast<DIScope>(dloc.getScope())->getFilename() << ":"
+        << dloc.getLine();
+  else
+    out << bb.getName() << " -> " << p.dst->getName();
+}
+
 class BmcPass : public llvm::ModulePass {
 public:
   // Available BMC engines
@@ -174,7 +197,11 @@ public:
       return false;
     }
 
-    ExprFactory efac;
+    // -- solvers of a portfolio and path workers marshal expressions
+    // -- concurrently
+    ExprFactory efac(m_engine == BmcEngineKind::path_bmc &&
+                     (SmtSolver == solver::SolverKind::PORTFOLIO ||
+                      PathWorkers > 1));
 
     if (m_engine == BmcEngineKind::mono_bmc) {
 
@@ -205,11 +232,12 @@ public:
 
       Stats::uset("bmc.dag_sz", dagSize(bmc.getFormula()));
       Stats::uset("bmc.circ_sz", boolop::circSize(bmc.getFormula()));
+      Stats::uset("bmc.aig_sz", boolop::aigSize(bmc.getFormula()));
 
       LOG("bmc.simplify",
           // --
           Expr vc = mknary<AND>(bmc.getFormula());
-          Expr vc_simpl = z3_simplify(bmc.zctx(), vc);
+          Expr vc_simpl = ExprRewriter(vc->efac()).simplify(vc);
           llvm::errs() << "VC:\n"
                        << z3_to_smtlib(bmc.zctx(), vc) << "\n~~~~\n"
                        << "Simplified VC:\n"
@@ -224,7 +252,40 @@ public:
         return false;
       }
 
-      auto res = bmc.solve();
+      boost::tribool res;
+      if (MultiProp) {
+        bmc.addProperties();
+        unsigned id = 0;
+        bool dumpCex = StringRef(HornCexFile).endswith(".ll") ||
+                       StringRef(HornCexFile).endswith(".bc");
+        res = bmc.solveProperties([&](const BmcProperty &p, BmcTrace &trace) {
+          LOG("cex", errs() << "Trace for property ";
+              printPropertyLoc(errs(), p); errs() << "\n";
+              trace.print(errs()););
+          // -- the harness is generated for the first violated property
+          if (dumpCex) {
+            auto const &tli =
+                getAnalysis<TargetLibraryInfoWrapperPass>().getTLI();
+            BmcTraceWrapper trace_wrapper(trace);
+            dumpLLVMCex(trace_wrapper, HornCexFile,
+                        F.getParent()->getDataLayout(), tli, F.getContext());
+            dumpCex = false;
+          }
+        });
+        for (const BmcProperty &p : bmc.getProperties()) {
+          outs() << "property " << ++id << " (";
+          printPropertyLoc(outs(), p);
+          outs() << "): ";
+          if (p.result)
+            outs() << "sat";
+          else if (!p.result)
+            outs() << "unsat";
+          else
+            outs() << "unknown";
+          outs() << "\n";
+        }
+      } else
+        res = bmc.solve();
       Stats::stop("BMC");
 
       if (res)
@@ -254,14 +315,15 @@ public:
 
 
       
-      LOG("cex", if (res) {
+      // -- in multi-property mode, traces are reported by solveProperties
+      LOG("cex", if (res && !MultiProp) {
 	  errs() << "Analyzed Function:\n" << F << "\n";
 	  errs() << "Trace \n";
 	  BmcTrace trace(bmc.getTrace());	  
 	  trace.print(errs());
 	});
 
-      if (res) {
+      if (res && !MultiProp) {
 	StringRef CexFileRef(HornCexFile);
 	if (CexFileRef != "") {
 	  if (CexFileRef.endswith(".ll") || CexFileRef.endswith(".bc")) {
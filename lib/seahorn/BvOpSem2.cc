@@ -77,6 +77,12 @@ static llvm::cl::opt<bool> SimplifyOnWrite(
     llvm::cl::desc("Simplify expressions as they are written to memory"),
     llvm::cl::init(false));
 
+static llvm::cl::opt<bool> SimplifyWithZ3(
+    "horn-bv2-simplify-z3",
+    llvm::cl::desc("Use z3 instead of the native rewriter to simplify "
+                   "expressions written to memory"),
+    llvm::cl::init(false));
+
 namespace {
 const Value *extractUniqueScalar(CallSite &cs) {
   if (!EnableUniqueScalars2)
@@ -1704,52 +1710,59 @@ Bv2OpSemContext::Bv2OpSemContext(SymStore &values, ExprVector &side,
       m_bb(o.m_bb), m_inst(o.m_inst), m_prev(o.m_prev),
       m_readRegister(o.m_readRegister), m_writeRegister(o.m_writeRegister),
       m_scalar(o.m_scalar), m_trfrReadReg(o.m_trfrReadReg),
-      m_fparams(o.m_fparams), m_ignored(o.m_ignored),
-      m_registers(o.m_registers), m_alu(nullptr), m_memManager(nullptr),
-      m_parent(&o), zeroE(o.zeroE), oneE(o.oneE), m_z3(o.m_z3),
-      m_z3_simplifier(o.m_z3_simplifier) {
+      m_fparams(o.m_fparams), m_alu(nullptr), m_memManager(nullptr),
+      m_parent(&o), zeroE(o.zeroE), oneE(o.oneE), m_rewriter(o.m_rewriter),
+      m_z3(o.m_z3), m_z3_simplifier(o.m_z3_simplifier) {
   setPathCond(o.getPathCond());
 }
 
+EZ3 &Bv2OpSemContext::z3() {
+  if (!m_z3)
+    m_z3.reset(new EZ3(efac()));
+  return *m_z3;
+}
+
+Expr Bv2OpSemContext::simplify(Expr u) {
+  if (!SimplifyWithZ3) {
+    if (!m_rewriter)
+      m_rewriter.reset(new ExprRewriter(efac()));
+    return m_rewriter->simplify(u);
+  }
+
+  if (!m_z3_simplifier)
+    m_z3_simplifier.reset(new ZSimplifier<EZ3>(z3()));
+  return m_z3_simplifier->simplify(u);
+}
+
 void Bv2OpSemContext::write(Expr v, Expr u) {
   if (SimplifyOnWrite) {
-    ScopedStats _st_("opsem.simplify");
-    if (!m_z3) {
-      m_z3.reset(new EZ3(efac()));
-      m_z3_simplifier.reset(new ZSimplifier<EZ3>(*m_z3));
-    }
-
-    ZParams<EZ3> params(*m_z3);
-    params.set("ctrl_c", true);
-    // params.set("timeout", 10000U /*ms*/);
-    // params.set("flat", false);
-    // params.set("ite_extra_rules", false /*default=false*/);
-    // Expr _u = z3_simplify(*m_z3, u, params);
+    static Stats::TimerId simplifyTimer = Stats::timer("opsem.simplify");
+    ScopedStats _st_(simplifyTimer);
 
     Expr _u;
 
     if (strct::isStructVal(u)) {
       llvm::SmallVector<Expr, 8> kids;
       for (unsigned i = 0, sz = u->arity(); i < sz; ++i)
-        kids.push_back(m_z3_simplifier->simplify(u->arg(i)));
+        kids.push_back(simplify(u->arg(i)));
       _u = strct::mk(kids);
     } else {
-      _u = m_z3_simplifier->simplify(u);
+      _u = simplify(u);
     }
 
     LOG("opsem.simplify",
         //
         if (!isOpX<LAMBDA>(_u) && !isOpX<ITE>(_u) && dagSize(_u) > 100) {
           errs() << "Term after simplification:\n"
-                 << m_z3->toSmtLib(_u) << "\n";
+                 << z3().toSmtLib(_u) << "\n";
         });
 
     LOG("opsem.dump.subformulae",
         if ((isOpX<EQ>(_u) || isOpX<NEG>(_u)) && dagSize(_u) > 100) {
           static unsigned cnt = 0;
           std::ofstream file("assert." + std::to_string(++cnt) + ".smt2");
-          file << m_z3->toSmtLibDecls(_u) << "\n";
-          file << "(assert " << m_z3->toSmtLib(_u) << ")\n";
+          file << z3().toSmtLibDecls(_u) << "\n";
+          file << "(assert " << z3().toSmtLib(_u) << ")\n";
         });
     u = _u;
   }
@@ -1882,7 +1895,9 @@ void Bv2OpSemContext::onBasicBlockEntry(const BasicBlock &bb) {
 }
 
 void Bv2OpSemContext::declareRegister(Expr v) { m_registers.insert(v); }
-bool Bv2OpSemContext::isKnownRegister(Expr v) { return m_registers.count(v); }
+bool Bv2OpSemContext::isKnownRegister(Expr v) const {
+  return m_registers.count(v) || (m_parent && m_parent->isKnownRegister(v));
+}
 
 Expr Bv2OpSemContext::mkRegister(const llvm::BasicBlock &bb) {
   if (Expr r = getRegister(bb))
@@ -5,6 +5,7 @@
 #include "seahorn/Support/SeaLog.hh"
 
 #include "seahorn/Expr/ExprLlvm.hh"
+#include "seahorn/Expr/ExprRewriter.hh"
 #include "seahorn/Expr/Smt/EZ3.hh"
 
 namespace seahorn {
@@ -61,6 +62,9 @@ private:
   ExprVector m_fparams;
 
   /// \brief Instructions that were treated as a noop by the machine
+  ///
+  /// A forked context only keeps the ones added after the fork, as for
+  /// registers and values below, and asks its parent for the others
   DenseSet<const Instruction *> m_ignored;
 
   using FlatExprSet = boost::container::flat_set<Expr>;
@@ -96,9 +100,16 @@ private:
   Expr oneE;
 
   /// \brief local simplifier
+  std::shared_ptr<ExprRewriter> m_rewriter;
+  /// \brief local z3 context, used by the z3 simplifier and for logging
   std::shared_ptr<EZ3> m_z3;
   std::shared_ptr<ZSimplifier<EZ3>> m_z3_simplifier;
 
+  /// \brief Returns the local z3 context, creating it if needed
+  EZ3 &z3();
+  /// \brief Simplifies \p u with the local simplifier
+  Expr simplify(Expr u);
+
 public:
   /// \brief Create a new context with given semantics, values, and side
   Bv2OpSemContext(Bv2OpSem &sem, SymStore &values, ExprVector &side);
@@ -220,7 +231,7 @@ public:
   /// \brief declare \p v as a new register for the machine
   void declareRegister(Expr v);
   /// \brief Returns true if \p is a known register
-  bool isKnownRegister(Expr v);
+  bool isKnownRegister(Expr v) const;
 
   /// \brief Create a register of the correct sort to hold the value returned by
   /// the instruction
@@ -258,7 +269,7 @@ public:
 
   /// \brief Return true if \p inst is ignored by the semantics
   bool isIgnored(const Instruction &inst) const {
-    return m_ignored.count(&inst);
+    return m_ignored.count(&inst) || (m_parent && m_parent->isIgnored(inst));
   }
 
   // \brief Mark \p inst to be ignored
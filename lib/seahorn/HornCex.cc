@@ -125,9 +125,8 @@ bool HornCex::runOnFunction(Module &M, Function &F) {
 
   Stats::resume("CexValidation");
 
-  auto &fp = hs.getZFixedPoint();
   ExprVector rules;
-  fp.getCexRules(rules);
+  hs.getCexRules(rules);
   boost::reverse(rules);
 
   // extract a trace of basic blocks corresponding to the counterexample
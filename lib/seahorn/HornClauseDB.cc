@@ -7,17 +7,27 @@
 #include <boost/lexical_cast.hpp>
 
 #include "seahorn/Expr/ExprLlvm.hh"
+#include "seahorn/Expr/Smt/SmtLibWriter.hh"
 #include "seahorn/Support/SeaDebug.h"
+#include "seahorn/Support/SeaLog.hh"
 
 #include <sstream>
 
 namespace seahorn
 {
 
+  namespace
+  {
+    /// declarations that are, or may later be registered as, relations
+    bool isBoolFdecl (Expr e)
+    {return bind::isFdecl (e) && isOpX<BOOL_TY> (bind::rangeTy (e));}
+  }
+
   void HornClauseDB::resetIndexes ()
   {
     m_body_idx.clear ();
     m_head_idx.clear ();
+    m_pending_idx.clear ();
   }
   
   void HornClauseDB::buildIndexes ()
@@ -25,35 +35,108 @@ namespace seahorn
     resetIndexes ();
       
     /// update indexes
-    for (HornRule &r : m_rules)
-    {
-      // -- update head index
-      m_head_idx [bind::fname (r.head ())].insert (&r);
-      // -- update body index
-      ExprVector use;
-      r.used_relations (*this, std::back_inserter (use));
-      for (Expr decl : use) m_body_idx[decl].insert (&r);
+    for (HornRule &r : m_rules) indexRule (r);
+  }
 
+  void HornClauseDB::indexRule (HornRule &r)
+  {
+    // -- ids only grow, so r goes at the end of every set
+    // -- update head index
+    horn_set_type &defs = m_head_idx [bind::fname (r.head ())];
+    defs.insert (defs.end (), &r);
+    // -- update body index. Declarations that are not relations yet
+    // -- go to the pending index until they are registered.
+    ExprVector use;
+    filter (r.body (), isBoolFdecl, std::back_inserter (use));
+    for (Expr decl : use)
+    {
+      index_type &idx = hasRelation (decl) ? m_body_idx : m_pending_idx;
+      horn_set_type &uses = idx [decl];
+      uses.insert (uses.end (), &r);
     }
   }
 
+  void HornClauseDB::unindexRule (HornRule &r)
+  {
+    auto unindex = [&r] (index_type &idx, Expr decl)
+    {
+      auto it = idx.find (decl);
+      if (it == idx.end ()) return;
+      it->second.erase (&r);
+      if (it->second.empty ()) idx.erase (it);
+    };
+
+    unindex (m_head_idx, bind::fname (r.head ()));
+    ExprVector use;
+    filter (r.body (), isBoolFdecl, std::back_inserter (use));
+    for (Expr decl : use)
+      unindex (hasRelation (decl) ? m_body_idx : m_pending_idx, decl);
+  }
+
+  void HornClauseDB::registerRelation (Expr fdecl)
+  {
+    if (!m_rels.insert (fdecl).second) return;
+    auto it = m_pending_idx.find (fdecl);
+    if (it == m_pending_idx.end ()) return;
+    m_body_idx [fdecl] = std::move (it->second);
+    m_pending_idx.erase (it);
+  }
+
+  HornClauseDB::RuleVector::iterator HornClauseDB::findRule (const HornRule &r)
+  {
+    auto it = m_rule_ids.find (r.id ());
+    if (it != m_rule_ids.end () && *(it->second) == r) return it->second;
+    // -- r was not copied from this database
+    return std::find (m_rules.begin (), m_rules.end (), r);
+  }
+
+  void HornClauseDB::addRule (const HornRule &rule)
+  {
+    m_rules.push_back (rule);
+    HornRule &r = m_rules.back ();
+    r.m_id = m_next_rule_id++;
+    m_rule_ids [r.m_id] = std::prev (m_rules.end ());
+    boost::copy (rule.vars (), std::back_inserter (m_vars));
+    indexRule (r);
+  }
+
+  void HornClauseDB::removeRule (const HornRule &r)
+  {
+    auto it = findRule (r);
+    if (it == m_rules.end ()) return;
+    unindexRule (*it);
+    m_rule_ids.erase (it->id ());
+    m_rules.erase (it);
+  }
+
+  void HornClauseDB::append (const HornClauseDB &db)
+  {
+    assert (&db != this);
+    for (Expr rel : db.m_rels) registerRelation (rel);
+    for (const HornRule &r : db.m_rules) addRule (r);
+    boost::copy (db.m_queries, std::back_inserter (m_queries));
+    // -- lemmas are stored over bound variables and can be copied as is
+    for (auto &kv : db.m_constraints)
+      boost::copy (kv.second, std::back_inserter (m_constraints [kv.first]));
+    for (auto &kv : db.m_invariants)
+      boost::copy (kv.second, std::back_inserter (m_invariants [kv.first]));
+  }
+
   void HornClauseDBCallGraph::buildCallGraph ()
   {
-    // indexes must be first computed
-    m_db.buildIndexes ();
-    
+    // -- the use/def indexes are kept up to date by the database
     for (auto p: m_db.getRelations ())
     {
       // -- callees
       HornClauseDB::expr_set_type callees;
-      const boost::container::flat_set<HornRule*>& uses = m_db.use(p);
+      const HornClauseDB::horn_set_type& uses = m_db.use(p);
       for (const HornRule* r: uses)
       { callees.insert(bind::fname(r->head())); }
       m_callees.insert(std::make_pair(p, callees));
 
       // -- callers
       HornClauseDB::expr_set_type callers;
-      const boost::container::flat_set<HornRule*>& defs = m_db.def(p);
+      const HornClauseDB::horn_set_type& defs = m_db.def(p);
       for (const HornRule* r: defs)
         filter (r->body (), HornClauseDB::IsRelation(m_db),
                 std::inserter(callers, callers.begin())); 
@@ -185,6 +268,109 @@ namespace seahorn
     return o;
   }
 
+  raw_ostream& HornClauseDB::writeSmtLib (raw_ostream& o,
+                                          bool fpExtensions) const
+  {
+    ScopedStats _st_("HornClauseDB::writeSmtLib");
+    SmtLibWriter w (o);
+
+    // -- variables of all rules, in the order they first appear
+    ExprVector vars;
+    ExprSet seen;
+    for (auto &r : m_rules)
+      for (Expr v : r.vars ())
+        if (seen.insert (v).second) vars.push_back (v);
+
+    if (!fpExtensions) o << "(set-logic HORN)\n";
+    for (Expr rel : m_rels)
+    {
+      w.markDeclared (rel);
+      if (!fpExtensions) { w.declareFun (rel); continue; }
+      o << "(declare-rel ";
+      w.writeSymbol (rel);
+      o << " (";
+      for (unsigned i = 0, sz = bind::domainSz (rel); i < sz; ++i)
+      {
+        if (i > 0) o << " ";
+        w.writeSort (bind::domainTy (rel, i));
+      }
+      o << "))\n";
+    }
+    for (Expr v : vars)
+    {
+      Expr decl = bind::fname (v);
+      w.markDeclared (decl);
+      if (!fpExtensions) continue;
+      o << "(declare-var ";
+      w.writeSymbol (decl);
+      o << " ";
+      w.writeSort (bind::rangeTy (decl));
+      o << ")\n";
+    }
+    // -- uninterpreted functions
+    for (auto &r : m_rules) w.declare (r.get ());
+    for (Expr q : m_queries) w.declare (q);
+
+    // -- (forall ((v Sort) ...) or nothing when there are no variables
+    auto forall = [&] (const ExprVector &vs) {
+      if (vs.empty ()) return false;
+      o << "(forall (";
+      for (unsigned i = 0, sz = vs.size (); i < sz; ++i)
+      {
+        Expr decl = bind::fname (vs [i]);
+        o << (i > 0 ? " (" : "(");
+        w.writeSymbol (decl);
+        o << " ";
+        w.writeSort (bind::rangeTy (decl));
+        o << ")";
+      }
+      o << ") ";
+      return true;
+    };
+
+    for (auto &r : m_rules)
+    {
+      if (fpExtensions)
+      {
+        o << "(rule ";
+        w.writeTerm (r.get ());
+        o << ")\n";
+        continue;
+      }
+      o << "(assert ";
+      bool q = forall (r.vars ());
+      w.writeTerm (r.get ());
+      o << (q ? "))\n" : ")\n");
+    }
+
+    for (Expr q : m_queries)
+    {
+      if (fpExtensions)
+      {
+        o << "(query ";
+        w.writeTerm (q);
+        o << ")\n";
+        continue;
+      }
+      // -- variables of the query, if any
+      ExprVector qvars;
+      filter (q, [&] (Expr e) { return seen.count (e) > 0; },
+              std::back_inserter (qvars));
+      o << "(assert ";
+      bool quant = forall (qvars);
+      o << "(=> ";
+      w.writeTerm (q);
+      o << (quant ? " false)))\n" : " false))\n");
+    }
+    if (!fpExtensions) o << "(check-sat)\n";
+
+    if (w.unsupported () > 0)
+      WARN << "HornClauseDB: " << w.unsupported ()
+           << " terms have no SMT-LIB2 counterpart";
+    o.flush ();
+    return o;
+  }
+
   HornClauseDB::horn_set_type HornClauseDB::m_empty_set;
   HornClauseDB::expr_set_type HornClauseDBCallGraph::m_expr_empty_set;
 
@@ -1,6 +1,12 @@
 #include "seahorn/HornClauseDBTransf.hh"
 #include "seahorn/FiniteMapTransf.hh"
 
+#include "seahorn/Expr/Smt/Z3.hh"
+#include "seahorn/Support/SeaDebug.h"
+#include "seahorn/Support/Stats.hh"
+
+#include <cstdlib>
+
 namespace seahorn {
 using namespace expr;
 
@@ -127,4 +133,473 @@ void removeFiniteMapsHornClausesTransf(HornClauseDB &db, HornClauseDB &tdb) {
   }
 }
 
+// -- relation applied to the constants V_0, ..., V_n, as in initDBModelFromFP
+static Expr relApp(Expr rel) {
+  ExprVector args;
+  Expr v = mkTerm<std::string>("V", rel->efac());
+  for (unsigned i = 0, sz = bind::domainSz(rel); i < sz; ++i)
+    args.push_back(bind::mkConst(variant::variant(i, v), bind::domainTy(rel, i)));
+  return bind::fapp(rel, args);
+}
+
+// -- top-level conjuncts of e
+static void getConjuncts(Expr e, ExprVector &out) {
+  if (isOpX<AND>(e)) {
+    for (auto it = e->args_begin(), end = e->args_end(); it != end; ++it)
+      getConjuncts(*it, out);
+  } else if (!isOpX<TRUE>(e))
+    out.push_back(e);
+}
+
+// -- conjuncts of body other than app. False if app is not a top-level
+// -- conjunct or also occurs below another one, e.g., under a negation
+static bool removeTopLevelApp(Expr body, Expr app, ExprVector &rest) {
+  ExprVector conj;
+  getConjuncts(body, conj);
+  bool found = false;
+  for (Expr c : conj) {
+    if (c == app)
+      found = true;
+    else if (contains(c, app))
+      return false;
+    else
+      rest.push_back(c);
+  }
+  return found;
+}
+
+// -- relations applied in the body of a rule, without duplicates
+static ExprVector bodyRelations(HornRule &r, HornClauseDB &db) {
+  ExprVector res;
+  r.used_relations(db, std::back_inserter(res));
+  return res;
+}
+
+// Replaces app, the only relation application in the body of ru, by the
+// body of rd, the only rule defining it. rest are the other conjuncts of
+// the body of ru. Variables of rd are renamed apart.
+static HornRule inlineRule(const HornRule &rd, const HornRule &ru, Expr app,
+                           const ExprVector &rest, unsigned &fresh) {
+  ExprFactory &efac = app->efac();
+  Expr head = rd.head();
+  ExprSet rdVars(rd.vars().begin(), rd.vars().end());
+  ExprVector vars(ru.vars());
+
+  // -- head arguments that are distinct variables become the actual
+  // -- arguments, the others are kept as equalities
+  ExprMap sub;
+  std::vector<unsigned> eqs;
+  for (unsigned i = 0, sz = bind::domainSz(bind::fname(head)); i < sz; ++i) {
+    Expr h = head->arg(i + 1);
+    if (rdVars.count(h) && !sub.count(h))
+      sub[h] = app->arg(i + 1);
+    else
+      eqs.push_back(i);
+  }
+  for (Expr v : rd.vars()) {
+    if (sub.count(v))
+      continue;
+    Expr name = variant::variant(
+        fresh++, variant::tag(bind::fname(bind::fname(v)), "inl"));
+    Expr nv = bind::mkConst(name, bind::typeOf(v));
+    sub[v] = nv;
+    vars.push_back(nv);
+  }
+
+  ExprVector body;
+  body.push_back(replace(rd.body(), sub));
+  for (unsigned i : eqs)
+    body.push_back(mk<EQ>(replace(head->arg(i + 1), sub), app->arg(i + 1)));
+  boost::copy(rest, std::back_inserter(body));
+
+  return HornRule(vars, ru.head(),
+                  mknary<AND>(mk<TRUE>(efac), body.begin(), body.end()));
+}
+
+void preprocessHornClauses(HornClauseDB &db, HornClauseDB &tdb,
+                           HornPreprocessConverter &conv) {
+  ScopedStats _st_("HornClauseDB::preprocess");
+  ExprFactory &efac = tdb.getExprFactory();
+  conv.m_db = &db;
+  conv.m_tdb = &tdb;
+
+  // -- work on a copy of db. Each rule of wdb remembers the rules of db
+  // -- it stands for.
+  HornClauseDB wdb(efac);
+  std::map<unsigned, std::vector<const HornRule *>> origin;
+  for (Expr rel : db.getRelations())
+    wdb.registerRelation(rel);
+  for (const HornRule &r : db.getRules()) {
+    wdb.addRule(r);
+    origin[wdb.getRules().back().id()] = {&r};
+  }
+  auto eraseRule = [&](HornRule *r) {
+    origin.erase(r->id());
+    wdb.removeRule(*r);
+  };
+
+  // -- relations of the queries are never transformed
+  ExprSet queryRels;
+  for (Expr q : db.getQueries()) {
+    ExprVector apps;
+    get_all_pred_apps(q, db, std::back_inserter(apps));
+    for (Expr app : apps)
+      queryRels.insert(bind::fname(app));
+  }
+
+  // -- cone of influence of the queries
+  ExprSet coi(queryRels.begin(), queryRels.end());
+  ExprVector todo(coi.begin(), coi.end());
+  while (!todo.empty()) {
+    Expr rel = todo.back();
+    todo.pop_back();
+    for (HornRule *r : wdb.def(rel))
+      for (Expr b : bodyRelations(*r, wdb))
+        if (coi.insert(b).second)
+          todo.push_back(b);
+  }
+  std::vector<HornRule *> worklist;
+  for (HornRule &r : wdb.getRules())
+    if (!coi.count(bind::fname(r.head())))
+      worklist.push_back(&r);
+  for (HornRule *r : worklist)
+    eraseRule(r);
+  for (Expr rel : db.getRelations())
+    if (!coi.count(rel))
+      conv.m_sliced.insert(rel);
+
+  // -- relations that can be derived, by a least fixpoint from the facts
+  ExprSet live;
+  std::map<HornRule *, unsigned> pending;
+  for (HornRule &r : wdb.getRules()) {
+    unsigned n = bodyRelations(r, wdb).size();
+    pending[&r] = n;
+    Expr head = bind::fname(r.head());
+    if (n == 0 && live.insert(head).second)
+      todo.push_back(head);
+  }
+  while (!todo.empty()) {
+    Expr rel = todo.back();
+    todo.pop_back();
+    for (HornRule *r : wdb.use(rel)) {
+      Expr head = bind::fname(r->head());
+      if (--pending[r] == 0 && live.insert(head).second)
+        todo.push_back(head);
+    }
+  }
+  worklist.clear();
+  for (auto &kv : pending)
+    if (kv.second > 0)
+      worklist.push_back(kv.first);
+  for (HornRule *r : worklist)
+    eraseRule(r);
+  for (Expr rel : coi)
+    if (!live.count(rel))
+      conv.m_dead.insert(rel);
+
+  // -- inline relations with one defining and one using rule when both
+  // -- rules are linear. The rules of the chain are merged into one.
+  ExprSet inlined;
+  unsigned fresh = 0;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (Expr rel : db.getRelations()) {
+      if (!live.count(rel) || inlined.count(rel) || queryRels.count(rel) ||
+          db.hasConstraints(rel) || db.hasInvariants(rel))
+        continue;
+      if (wdb.def(rel).size() != 1 || wdb.use(rel).size() != 1)
+        continue;
+      HornRule *rd = *wdb.def(rel).begin();
+      HornRule *ru = *wdb.use(rel).begin();
+      if (rd == ru)
+        continue;
+      ExprVector rdApps, ruApps;
+      get_all_pred_apps(rd->body(), wdb, std::back_inserter(rdApps));
+      get_all_pred_apps(ru->body(), wdb, std::back_inserter(ruApps));
+      if (rdApps.size() > 1 || ruApps.size() != 1)
+        continue;
+      // -- only an application that is a top-level conjunct can be
+      // -- replaced by the body of rd
+      ExprVector ruRest;
+      if (!removeTopLevelApp(ru->body(), ruApps[0], ruRest))
+        continue;
+
+      HornRule merged = inlineRule(*rd, *ru, ruApps[0], ruRest, fresh);
+      std::vector<const HornRule *> org = origin[rd->id()];
+      boost::copy(origin[ru->id()], std::back_inserter(org));
+      conv.m_inlined.push_back(std::make_pair(rel, *rd));
+      eraseRule(rd);
+      eraseRule(ru);
+      wdb.addRule(merged);
+      origin[wdb.getRules().back().id()] = std::move(org);
+      inlined.insert(rel);
+      changed = true;
+    }
+  }
+
+  // -- an argument of a relation is unused if, wherever the relation is
+  // -- applied in a body, it is a variable that occurs nowhere else in
+  // -- the rule. Removing arguments may make others unused.
+  std::map<Expr, std::vector<bool>> kept;
+  for (Expr rel : live)
+    if (!queryRels.count(rel) && !inlined.count(rel))
+      kept[rel].assign(bind::domainSz(rel), true);
+  auto isKept = [&kept](Expr rel, unsigned i) {
+    auto it = kept.find(rel);
+    return it == kept.end() || it->second[i];
+  };
+  IsPredApp isPredApp(wdb);
+  changed = true;
+  while (changed) {
+    changed = false;
+    std::map<Expr, std::vector<bool>> used;
+    for (auto &kv : kept)
+      used[kv.first].assign(kv.second.size(), false);
+
+    for (HornRule &r : wdb.getRules()) {
+      ExprSet vars(r.vars().begin(), r.vars().end());
+      ExprVector conj, apps;
+      getConjuncts(r.body(), conj);
+
+      // -- occurrences of variables as kept arguments of relations, and
+      // -- variables occurring anywhere else
+      std::map<Expr, unsigned> count;
+      ExprSet other;
+      auto countArgs = [&](Expr app) {
+        Expr rel = bind::fname(app);
+        for (unsigned i = 0, sz = bind::domainSz(rel); i < sz; ++i) {
+          if (!isKept(rel, i))
+            continue;
+          Expr a = app->arg(i + 1);
+          if (vars.count(a))
+            ++count[a];
+          else
+            filter(a, bind::IsConst(), std::inserter(other, other.begin()));
+        }
+      };
+      countArgs(r.head());
+      for (Expr c : conj) {
+        if (isPredApp(c)) {
+          countArgs(c);
+          apps.push_back(c);
+        } else
+          filter(c, bind::IsConst(), std::inserter(other, other.begin()));
+      }
+
+      // -- relations applied below the top-level conjunction use all
+      // -- their arguments
+      ExprSet top(apps.begin(), apps.end());
+      ExprVector all;
+      get_all_pred_apps(r.body(), wdb, std::back_inserter(all));
+      for (Expr app : all) {
+        auto it = used.find(bind::fname(app));
+        if (it != used.end() && !top.count(app))
+          it->second.assign(it->second.size(), true);
+      }
+
+      for (Expr app : apps) {
+        auto it = used.find(bind::fname(app));
+        if (it == used.end())
+          continue;
+        for (unsigned i = 0, sz = it->second.size(); i < sz; ++i) {
+          Expr a = app->arg(i + 1);
+          if (!vars.count(a) || count[a] != 1 || other.count(a))
+            it->second[i] = true;
+        }
+      }
+    }
+
+    for (auto &kv : kept)
+      for (unsigned i = 0, sz = kv.second.size(); i < sz; ++i)
+        if (kv.second[i] && !used[kv.first][i]) {
+          kv.second[i] = false;
+          changed = true;
+        }
+  }
+
+  // -- build tdb from the relations that are left
+  ExprSet rels(queryRels.begin(), queryRels.end());
+  for (HornRule &r : wdb.getRules()) {
+    rels.insert(bind::fname(r.head()));
+    for (Expr b : bodyRelations(r, wdb))
+      rels.insert(b);
+  }
+  unsigned removedArgs = 0;
+  for (Expr rel : db.getRelations()) {
+    if (!rels.count(rel))
+      continue;
+    std::vector<unsigned> keep;
+    for (unsigned i = 0, sz = bind::domainSz(rel); i < sz; ++i)
+      if (isKept(rel, i))
+        keep.push_back(i);
+
+    Expr nrel = rel;
+    if (keep.size() != bind::domainSz(rel)) {
+      ExprVector sorts;
+      for (unsigned i : keep)
+        sorts.push_back(bind::domainTy(rel, i));
+      sorts.push_back(bind::rangeTy(rel));
+      nrel = bind::fdecl(variant::tag(bind::fname(rel), "elim"), sorts);
+      removedArgs += bind::domainSz(rel) - keep.size();
+    }
+    tdb.registerRelation(nrel);
+    conv.m_relMap[rel] = std::make_pair(nrel, keep);
+  }
+
+  auto project = [&conv](Expr app) {
+    auto &m = conv.m_relMap.at(bind::fname(app));
+    if (m.first == bind::fname(app))
+      return app;
+    ExprVector args;
+    for (unsigned i : m.second)
+      args.push_back(app->arg(i + 1));
+    return bind::fapp(m.first, args);
+  };
+
+  for (HornRule &r : wdb.getRules()) {
+    ExprVector apps;
+    get_all_pred_apps(r.body(), wdb, std::back_inserter(apps));
+    ExprMap sub;
+    for (Expr app : apps)
+      sub[app] = project(app);
+    tdb.addRule(HornRule(r.vars(), project(r.head()), replace(r.body(), sub)));
+    conv.m_origin[tdb.getRules().back().id()] = origin[r.id()];
+  }
+
+  for (Expr q : db.getQueries())
+    tdb.addQuery(q);
+
+  // -- constraints and invariants keep the conjuncts over kept arguments
+  auto projectLemma = [&](Expr rel, Expr lemma) {
+    ExprSet dropped;
+    Expr app = relApp(rel);
+    const std::vector<unsigned> &keep = conv.m_relMap.at(rel).second;
+    for (unsigned i = 0, k = 0, sz = bind::domainSz(rel); i < sz; ++i) {
+      if (k < keep.size() && keep[k] == i)
+        ++k;
+      else
+        dropped.insert(app->arg(i + 1));
+    }
+    ExprVector conj, res;
+    getConjuncts(lemma, conj);
+    for (Expr c : conj) {
+      ExprVector consts;
+      filter(c, bind::IsConst(), std::back_inserter(consts));
+      if (std::none_of(consts.begin(), consts.end(),
+                       [&dropped](Expr v) { return dropped.count(v) > 0; }))
+        res.push_back(c);
+    }
+    return mknary<AND>(mk<TRUE>(efac), res.begin(), res.end());
+  };
+  for (auto &kv : conv.m_relMap) {
+    Expr rel = kv.first;
+    Expr app = relApp(rel);
+    Expr napp = project(app);
+    if (db.hasConstraints(rel))
+      tdb.addConstraint(napp, projectLemma(rel, db.getConstraints(app)));
+    if (db.hasInvariants(rel))
+      tdb.addInvariant(napp, projectLemma(rel, db.getInvariants(app)));
+  }
+
+  Stats::uset("horn.preprocess.sliced", conv.m_sliced.size());
+  Stats::uset("horn.preprocess.dead", conv.m_dead.size());
+  Stats::uset("horn.preprocess.inlined", conv.m_inlined.size());
+  Stats::uset("horn.preprocess.removed_args", removedArgs);
+  LOG("horn-preprocess",
+      errs() << "Preprocessed Horn clauses: " << db.getRules().size()
+             << " rules, " << db.getRelations().size() << " relations -> "
+             << tdb.getRules().size() << " rules, "
+             << tdb.getRelations().size() << " relations\n";);
+}
+
+bool HornPreprocessConverter::convert(HornDbModel &in, HornDbModel &out) {
+  assert(m_db && m_tdb);
+  ExprFactory &efac = m_db->getExprFactory();
+
+  for (Expr rel : m_db->getRelations()) {
+    Expr app = relApp(rel);
+    if (m_sliced.count(rel)) {
+      // -- does not reach a query, anything is a model
+      out.addDef(app, mk<TRUE>(efac));
+      continue;
+    }
+    if (m_dead.count(rel)) {
+      out.addDef(app, mk<FALSE>(efac));
+      continue;
+    }
+    auto it = m_relMap.find(rel);
+    if (it == m_relMap.end())
+      continue;
+    ExprVector args;
+    for (unsigned i : it->second.second)
+      args.push_back(app->arg(i + 1));
+    out.addDef(app, in.getDef(bind::fapp(it->second.first, args)));
+  }
+
+  // -- an inlined relation is the image of its defining rule. Later
+  // -- inlined relations may appear in the rule, so go backwards.
+  for (auto it = m_inlined.rbegin(), end = m_inlined.rend(); it != end;
+       ++it) {
+    Expr rel = it->first;
+    const HornRule &rd = it->second;
+    Expr app = relApp(rel);
+
+    ExprVector conj;
+    Expr head = rd.head();
+    for (unsigned i = 0, sz = bind::domainSz(rel); i < sz; ++i)
+      conj.push_back(mk<EQ>(app->arg(i + 1), head->arg(i + 1)));
+    ExprVector apps;
+    get_all_pred_apps(rd.body(), *m_db, std::back_inserter(apps));
+    ExprMap sub;
+    for (Expr a : apps)
+      sub[a] = out.getDef(a);
+    conj.push_back(replace(rd.body(), sub));
+    Expr def = mknary<AND>(mk<TRUE>(efac), conj.begin(), conj.end());
+
+    ExprSet vars(rd.vars().begin(), rd.vars().end());
+    if (!vars.empty()) {
+      if (!m_zctx)
+        return false;
+      // -- exists V . def is not forall V . !def
+      try {
+        def = mk<NEG>(z3_forall_elim(*m_zctx, mk<NEG>(def), vars));
+      } catch (z3::exception &e) {
+        LOG("horn-preprocess", errs() << "Failed to eliminate quantifiers: "
+                                      << e.msg() << "\n";);
+        return false;
+      }
+    }
+    out.addDef(app, def);
+  }
+  return true;
+}
+
+bool HornPreprocessConverter::convertCex(const ExprVector &in,
+                                         const std::vector<std::string> &names,
+                                         ExprVector &out) const {
+  assert(m_db && m_tdb);
+  if (names.size() != in.size())
+    return false;
+
+  for (unsigned i = 0, sz = in.size(); i < sz; ++i) {
+    // -- rules added by the solver, e.g., for the query, have no name
+    if (names[i].empty()) {
+      out.push_back(in[i]);
+      continue;
+    }
+    // -- other rules are named by their id in tdb
+    char *end = nullptr;
+    unsigned long id = std::strtoul(names[i].c_str(), &end, 10);
+    auto it = *end == '\0' ? m_origin.find(id) : m_origin.end();
+    if (it == m_origin.end())
+      return false;
+    // -- a cex lists its rules from the query back to the entry
+    for (auto rit = it->second.rbegin(), rend = it->second.rend();
+         rit != rend; ++rit)
+      out.push_back((*rit)->get());
+  }
+  return true;
+}
+
 } // namespace seahorn
@@ -10,8 +10,13 @@
 
 #include "boost/range/algorithm/reverse.hpp"
 
+#include <chrono>
 #include <climits>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include "seahorn/Support/SeaDebug.h"
+#include "seahorn/Support/SeaLog.hh"
 
 using namespace llvm;
 
@@ -31,6 +36,11 @@ static llvm::cl::opt<bool>
     SkipConstraints("horn-skip-constraints", cl::Hidden, cl::init(false),
                  cl::desc ("Enabled when number of predicates exceeds 200"));
 
+static llvm::cl::opt<bool> Preprocess(
+    "horn-preprocess", cl::init(false),
+    cl::desc("Simplify the Horn clauses before solving: slicing, removal of "
+             "dead relations and unused arguments, inlining of linear chains"));
+
 static llvm::cl::opt<bool>
 Subsumption ("horn-subsumption", cl::Hidden, cl::init(true),
              cl::desc ("Setting to false helps with cex"));
@@ -95,20 +105,40 @@ static llvm::cl::opt<bool>
               cl::desc("Use euf generalizer for equalities"));
 
 namespace seahorn {
-  char HornSolver::ID = 0;
-
-  bool HornSolver::runOnModule(Module &M) {
-    Stats::sset ("Result", "UNKNOWN");
-
-    HornifyModule &hm = getAnalysis<HornifyModule> ();
-
-    // Load the Horn clause database
-    auto &db = hm.getHornClauseDB ();
+  unsigned HornPortfolio;
+}
 
-    m_fp.reset (new ZFixedPoint<EZ3> (hm.getZContext ()));
-    ZFixedPoint<EZ3> &fp = *m_fp;
+static llvm::cl::opt<unsigned, true> XHornPortfolio(
+    "horn-portfolio",
+    llvm::cl::desc("Run this many Spacer configurations in parallel and "
+                   "keep the first answer"),
+    llvm::cl::location(seahorn::HornPortfolio), llvm::cl::init(1u));
+
+// -- configurations of the portfolio. The first one is the configuration
+// -- given on the command line, the others change one or two options.
+static const char *SpacerConfigNames[] = {
+    "default",     "no-weak-abs", "iuc-0", "no-child-order",
+    "iuc-arith-2", "no-euf-gen",  "weak-abs-iuc-2"};
+static const unsigned NumSpacerConfigs =
+    sizeof(SpacerConfigNames) / sizeof(SpacerConfigNames[0]);
+
+static void setSpacerParams(seahorn::ZParams<seahorn::EZ3> &params,
+                            unsigned config) {
+    bool weakAbs = WeakAbs;
+    bool childOrder = HornChildren;
+    bool eufGen = UseEufGen;
+    unsigned iuc = IUC;
+    unsigned iucArith = IUCArith;
+    switch (config) {
+    case 1: weakAbs = !weakAbs; break;
+    case 2: iuc = 0; break;
+    case 3: childOrder = !childOrder; break;
+    case 4: iucArith = 2; break;
+    case 5: eufGen = !eufGen; break;
+    case 6: weakAbs = true; iuc = 2; break;
+    default: break;
+    }
 
-    ZParams<EZ3> params (hm.getZContext ());
     params.set(":engine", ChcEngine);
     // -- disable slicing so that we can use cover
     params.set (":xform.slice", false);
@@ -119,7 +149,7 @@ namespace seahorn {
     // -- disable propagate_variable_equivalences in tail_simplifier
     params.set (":xform.tail_simplifier_pve", false);
     params.set (":xform.subsumption_checker", Subsumption);
-    params.set(":spacer.order_children", HornChildren ? 1U : 0U);
+    params.set(":spacer.order_children", childOrder ? 1U : 0U);
     params.set(":spacer.max_num_contexts", PdrContexts);
     params.set(":spacer.elim_aux", true);
     params.set(":spacer.reach_dnf", true);
@@ -127,29 +157,158 @@ namespace seahorn {
     params.set(":spacer.use_bg_invs",
 	       UseInvariant == solver_detail::INACTIVE ||
 	       UseInvariant == solver_detail::BG_ONLY);
-    params.set(":spacer.weak_abs", WeakAbs);
+    params.set(":spacer.weak_abs", weakAbs);
     params.set(":spacer.mbqi", UseMbqi);
-    params.set(":spacer.iuc", IUC);
-    params.set(":spacer.iuc.arith", IUCArith);
+    params.set(":spacer.iuc", iuc);
+    params.set(":spacer.iuc.arith", iucArith);
     // -- less incremental but constraints are popped after pushed in
     //    the solver
     params.set(":spacer.keep_proxy", KeepProxy);
     params.set(":spacer.ground_pobs", false);
-    params.set(":spacer.use_euf_gen", UseEufGen);
+    params.set(":spacer.use_euf_gen", eufGen);
     params.set(":spacer.max_level", HornMaxDepth);
+}
+
+namespace seahorn {
+  char HornSolver::ID = 0;
+
+  void HornSolver::loadFixedPoint(ZFixedPoint<EZ3> &fp, EZ3 &zctx,
+                                  HornClauseDB &db, unsigned config) {
+    ZParams<EZ3> params (zctx);
+    setSpacerParams(params, config);
     fp.set (params);
 
-    db.loadZFixedPoint (fp, SkipConstraints);
+    // -- rules of a preprocessed db are named so that a cex can be
+    // -- mapped back to the rules they stand for
+    db.loadZFixedPoint (fp, SkipConstraints, false, bool(m_converter));
 
     if (UseInvariant == solver_detail::INACTIVE) {
       params.set(":spacer.use_bg_invs", false);
       fp.set(params);
     }
-    
+  }
+
+  boost::tribool HornSolver::runPortfolio(HornClauseDB &db, unsigned k) {
+    ExprFactory &efac = db.getExprFactory();
+
+    // -- every configuration gets a fresh context since an interrupted
+    // -- context cannot be reused. The rules are loaded into each
+    // -- context before the race, but each worker still marshals the
+    // -- query in query(), which reads the ExprFactory. This is why the
+    // -- portfolio requires a concurrent factory.
+    std::vector<std::unique_ptr<EZ3>> zctxs;
+    std::vector<std::unique_ptr<ZFixedPoint<EZ3>>> fps;
+    for (unsigned i = 0; i < k; ++i) {
+      zctxs.push_back(llvm::make_unique<EZ3>(efac));
+      fps.push_back(llvm::make_unique<ZFixedPoint<EZ3>>(*zctxs.back()));
+      loadFixedPoint(*fps.back(), *zctxs.back(), db, i);
+    }
+
     Stats::resume ("Horn");
-    m_result = fp.query ();
+    std::mutex mtx;
+    std::condition_variable done_cv;
+    unsigned done = 0;
+    int winner = -1;
+    std::vector<boost::tribool> results(k, boost::indeterminate);
+    std::vector<char> running(k, 0);
+
+    std::vector<std::thread> threads;
+    threads.reserve(k);
+    for (unsigned i = 0; i < k; ++i) {
+      threads.emplace_back([&, i]() {
+        {
+          std::lock_guard<std::mutex> lock(mtx);
+          running[i] = 1;
+        }
+        boost::tribool res = boost::indeterminate;
+        try {
+          res = fps[i]->query();
+        } catch (z3::exception &e) {
+          // -- interrupted or failed
+        }
+        std::lock_guard<std::mutex> lock(mtx);
+        running[i] = 0;
+        results[i] = res;
+        if (winner < 0 && !boost::indeterminate(res))
+          winner = i;
+        ++done;
+        done_cv.notify_one();
+      });
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(mtx);
+      // -- once there is an answer keep interrupting the others until
+      // -- they return. An interrupt that arrives before the query
+      // -- starts can be lost.
+      while (done < k) {
+        if (winner >= 0) {
+          for (unsigned i = 0; i < k; ++i)
+            if (running[i])
+              zctxs[i]->interrupt();
+          done_cv.wait_for(lock, std::chrono::milliseconds(10));
+        } else
+          done_cv.wait(lock);
+      }
+    }
+    for (auto &t : threads)
+      t.join();
     Stats::stop ("Horn");
 
+    unsigned w = winner >= 0 ? winner : 0;
+    if (winner >= 0) {
+      Stats::sset("horn.portfolio.winner", SpacerConfigNames[w]);
+      Stats::count(std::string("horn.portfolio.wins.") +
+                   SpacerConfigNames[w]);
+    } else
+      Stats::count("horn.portfolio.unknown");
+    LOG("horn-portfolio", errs() << "Horn portfolio winner: "
+                                 << (winner >= 0 ? SpacerConfigNames[w] : "none")
+                                 << "\n";);
+
+    // -- keep the fixedpoint of the winner for models and cex
+    m_fp.reset(nullptr);
+    m_zctx = std::move(zctxs[w]);
+    m_fp = std::move(fps[w]);
+    return results[w];
+  }
+
+  bool HornSolver::runOnModule(Module &M) {
+    Stats::sset ("Result", "UNKNOWN");
+
+    HornifyModule &hm = getAnalysis<HornifyModule> ();
+
+    // Load the Horn clause database
+    auto &db = hm.getHornClauseDB ();
+
+    if (Preprocess) {
+      m_tdb.reset(new HornClauseDB(db.getExprFactory()));
+      m_converter.reset(new HornPreprocessConverter(hm.getZContext()));
+      preprocessHornClauses(db, *m_tdb, *m_converter);
+    } else {
+      m_tdb.reset(nullptr);
+      m_converter.reset(nullptr);
+    }
+    HornClauseDB &qdb = m_tdb ? *m_tdb : db;
+
+    unsigned portfolio = std::min<unsigned>(HornPortfolio, NumSpacerConfigs);
+    if (portfolio > 1 && !db.getExprFactory().isConcurrent()) {
+      WARN << "horn portfolio requires a concurrent expression factory";
+      portfolio = 1;
+    }
+
+    if (portfolio > 1) {
+      m_result = runPortfolio(qdb, portfolio);
+    } else {
+      m_fp.reset (new ZFixedPoint<EZ3> (hm.getZContext ()));
+      m_zctx.reset(nullptr);
+      loadFixedPoint(*m_fp, hm.getZContext(), qdb, 0);
+
+      Stats::resume ("Horn");
+      m_result = m_fp->query ();
+      Stats::stop ("Horn");
+    }
+
     if (m_result)
       outs() << "sat";
     else if (!m_result)
@@ -163,12 +322,12 @@ namespace seahorn {
     else if (!m_result)
       Stats::sset("Result", "TRUE");
 
-    LOG("answer", if (m_result || !m_result) errs() << fp.getAnswer() << "\n";);
+    LOG("answer", if (m_result || !m_result) errs() << m_fp->getAnswer() << "\n";);
 
     if (PrintAnswer && !m_result) {
       HornDbModel dbModel;
-      initDBModelFromFP(dbModel, db, fp);
-      printInvars(M, dbModel);
+      if (getModel(dbModel))
+        printInvars(M, dbModel);
     } else if (PrintAnswer && m_result)
       printCex ();
 
@@ -183,12 +342,44 @@ void HornSolver::getAnalysisUsage(AnalysisUsage &AU) const {
     AU.setPreservesAll ();
   }
 
+bool HornSolver::getModel(HornDbModel &model) {
+  HornifyModule &hm = getAnalysis<HornifyModule>();
+  if (!m_converter) {
+    initDBModelFromFP(model, hm.getHornClauseDB(), *m_fp);
+    return true;
+  }
+
+  HornDbModel tdbModel;
+  initDBModelFromFP(tdbModel, *m_tdb, *m_fp);
+  if (!m_converter->convert(tdbModel, model)) {
+    // -- a partial model would give invariants of the wrong predicates
+    ERR << "failed to map the model back to the original clauses";
+    return false;
+  }
+  return true;
+}
+
+void HornSolver::getCexRules(ExprVector &rules) {
+  if (!m_converter) {
+    m_fp->getCexRules(rules);
+    return;
+  }
+
+  ExprVector trules;
+  std::vector<std::string> names;
+  m_fp->getCexRules(trules);
+  m_fp->getCexRuleNames(names);
+  if (!m_converter->convertCex(trules, names, rules)) {
+    ERR << "failed to map the counterexample back to the original clauses";
+    rules.clear();
+  }
+}
+
 void HornSolver::printCex() {
-    ZFixedPoint<EZ3> fp = *m_fp;
     //outs () << *fp.getCex () << "\n";
 
     ExprVector rules;
-    fp.getCexRules (rules);
+    getCexRules (rules);
     boost::reverse (rules);
   for (Expr r : rules) {
       Expr src;
@@ -218,7 +409,9 @@ void HornSolver::printCex() {
 
 void HornSolver::estimateSizeInvars(Module &M) {
     HornifyModule &hm = getAnalysis<HornifyModule> ();
-    ZFixedPoint<EZ3> fp = *m_fp;
+    HornDbModel model;
+    if (!getModel(model))
+      return;
 
     Expr allInvars;
     bool first = true;
@@ -231,7 +424,7 @@ void HornSolver::estimateSizeInvars(Module &M) {
         continue;
         Expr bbPred = hm.bbPredicate (BB);
         const ExprVector &live = hm.live (BB);
-        Expr invars = fp.getCoverDelta (bind::fapp (bbPred, live));
+        Expr invars = model.getDef (bind::fapp (bbPred, live));
         numBlocks++;
         if (first) {
           allInvars = invars;
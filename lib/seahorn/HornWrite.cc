@@ -13,6 +13,12 @@ InternalWriter("horn-fp-internal-writer",
                llvm::cl::desc("Use internal writer for Horn SMT2 format. (Default)"),
                llvm::cl::init(true),llvm::cl::Hidden);
 
+static llvm::cl::opt<bool>
+StreamWriter("horn-stream-writer",
+             llvm::cl::desc("Stream Horn SMT2 formats with the SMT-LIB2 "
+                            "writer of seahorn instead of building them in Z3"),
+             llvm::cl::init(false));
+
 enum HCFormat { SMT2, CLP, PURESMT2, MCMT};
 static llvm::cl::opt<HCFormat>
 HornClauseFormat("horn-format",
@@ -64,38 +70,47 @@ namespace seahorn
       McMtWriter<llvm::raw_fd_ostream> writer (db, hm.getZContext ());
       writer.write (m_out);
     }
-    else 
+    else
     {
-      // Use local ZFixedPoint object to translate to SMT2. 
-      //
-      // When HornWrite is called hm.getZFixedPoint () might be still
-      // empty so we need to dump first the content of HornClauseDB
-      // into fp.
-      ZFixedPoint<EZ3> fp (hm.getZContext ());
-      // -- skip constraints since they are not supported.
-      // -- do not skip the query
-      db.loadZFixedPoint (fp, true, false);
-
-      if (HornClauseFormat == PURESMT2)
-      {
-        // -- disable fixedpoint extension
-        ZParams<EZ3> params (hm.getZContext ());
-        params.set (":print_fixedpoint_extensions", false);
-        fp.set (params);
-      }
-      
       // -- write header
       setInfo (m_out, "original", M.getModuleIdentifier ());
       std::string version ("SeaHorn v.");
       version += SEAHORN_VERSION_INFO;
       setInfo (m_out, "authors", version);
-      
-      if (HornClauseFormat == PURESMT2 || !InternalWriter)
-        m_out << fp.toString () << "\n";
+
+      if (StreamWriter)
+      {
+        // -- streams the clauses without building them in Z3 or in memory
+        // -- skip constraints since they are not supported.
+        db.writeSmtLib (m_out, HornClauseFormat == SMT2);
+      }
       else
-        m_out << fp << "\n";
+      {
+        // Use local ZFixedPoint object to translate to SMT2.
+        //
+        // When HornWrite is called hm.getZFixedPoint () might be still
+        // empty so we need to dump first the content of HornClauseDB
+        // into fp.
+        ZFixedPoint<EZ3> fp (hm.getZContext ());
+        // -- skip constraints since they are not supported.
+        // -- do not skip the query
+        db.loadZFixedPoint (fp, true, false);
+
+        if (HornClauseFormat == PURESMT2)
+        {
+          // -- disable fixedpoint extension
+          ZParams<EZ3> params (hm.getZContext ());
+          params.set (":print_fixedpoint_extensions", false);
+          fp.set (params);
+        }
+
+        if (HornClauseFormat == PURESMT2 || !InternalWriter)
+          m_out << fp.toString () << "\n";
+        else
+          m_out << fp << "\n";
+      }
     }
-    
+
     m_out.flush ();
     return false;
   }
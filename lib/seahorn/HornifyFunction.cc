@@ -35,6 +35,9 @@ void HornifyFunction::extractFunctionInfo(const BasicBlock &BB) {
   // main does not need a summary
   if (F.getName().equals("main"))
     return;
+  // already declared by declareSummary
+  if (m_sem.hasFunctionInfo(F) && m_sem.getFunctionInfo(F).sumPred)
+    return;
 
   FunctionInfo &fi = m_sem.getFunctionInfo(F);
 
@@ -146,6 +149,13 @@ void HornifyFunction::extractFunctionInfo(const BasicBlock &BB) {
               mk<OR>(mk<NEG>(postArgs[0]), mk<NEG>(postArgs[1]), postArgs[2])));
 }
 
+void HornifyFunction::declareSummary(const Function &F) {
+  if (!m_interproc || m_sem.isAbstracted(F))
+    return;
+  if (const BasicBlock *exit = findExitBlock(F))
+    extractFunctionInfo(*exit);
+}
+
 void SmallHornifyFunction::runOnFunction(Function &F) {
 
   if (m_sem.isAbstracted(F))
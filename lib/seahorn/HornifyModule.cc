@@ -10,6 +10,7 @@
 #include "llvm/Analysis/CallGraph.h"
 #include "llvm/IR/CFG.h"
 #include "llvm/IR/Function.h"
+#include "llvm/IR/GetElementPtrTypeIterator.h"
 #include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Support/CommandLine.h"
@@ -39,6 +40,9 @@
 #include "seahorn/ClpOpSem.hh"
 #include "seahorn/UfoOpSem.hh"
 
+#include <atomic>
+#include <thread>
+
 using namespace llvm;
 using namespace seahorn;
 
@@ -100,10 +104,31 @@ static llvm::cl::opt<bool>
                  llvm::cl::desc("Use inter-procedural encoding with memory"),
                  llvm::cl::init(false));
 
+static llvm::cl::opt<unsigned> HornifyThreads(
+    "horn-threads",
+    llvm::cl::desc("Number of threads generating Horn clauses of functions "
+                   "in parallel. Ignored with a warning unless the step is "
+                   "small or clpsmall, without --horn-inter-proc-mem, and "
+                   "the program is not recursive"),
+    llvm::cl::init(1));
+
+// -- true if --horn-threads can be honored, as far as the options tell.
+// -- The cut-point graph used by the large-step and flat encodings and
+// -- the memory encoding keep state shared by all functions. Recursion
+// -- is only known once the call graph is built.
+static bool canHornifyInParallel() {
+  return HornifyThreads > 1 && !InterProcMem &&
+         (Step == hm_detail::SMALL_STEP || Step == hm_detail::CLP_SMALL_STEP);
+}
+
 namespace seahorn {
 // counters for copying the new inter-proc vcgen
 // only updated if the log "inter_mem_counters" is active
 extern InterMemStats g_im_stats;
+// defined in Houdini.cc
+extern unsigned HoudiniWorkers;
+// defined in HornSolver.cc
+extern unsigned HornPortfolio;
 }
 
 namespace seahorn {
@@ -136,14 +161,23 @@ bool shouldBeAbstracted(const Function &fn) {
   return false;
 }
 
+// -- the factory is concurrent if Houdini workers, the horn portfolio, or
+// -- parallel hornification create expressions
 HornifyModule::HornifyModule()
-    : ModulePass(ID), m_zctx(m_efac), m_db(m_efac), m_td(0), m_canFail(0) {}
+    : ModulePass(ID),
+      m_efac(HoudiniWorkers > 1 || HornPortfolio > 1 ||
+             canHornifyInParallel()),
+      m_zctx(m_efac), m_db(m_efac),
+      m_td(0), m_canFail(0) {}
 
 bool HornifyModule::runOnModule(Module &M) {
   ScopedStats _st("HornifyModule");
 
   bool Changed = false;
   m_td = &M.getDataLayout();
+  if (HornifyThreads > 1 && !canHornifyInParallel())
+    WARN << "--horn-threads is ignored: only the small and clpsmall steps "
+            "without --horn-inter-proc-mem are hornified in parallel";
   m_canFail = getAnalysisIfAvailable<CanFail>();
 
   typename UfoOpSem::FunctionPtrSet abs_fns;
@@ -281,11 +315,14 @@ bool HornifyModule::runOnModule(Module &M) {
   }
 
   CallGraph &CG = getAnalysis<CallGraphWrapperPass>().getCallGraph();
+  std::vector<Function *> fns;
+  bool recursive = false;
   for (auto it = scc_begin(&CG); !it.isAtEnd(); ++it) {
     const std::vector<CallGraphNode *> &scc = *it;
     CallGraphNode *cgn = scc.front();
     Function *f = cgn->getFunction();
     if (it.hasLoop() || scc.size() > 1) {
+      recursive = true;
       errs() << "WARNING RECURSION at " << (f ? f->getName() : "nil") << "\n";
       errs() << "SCC is: ";
       for (auto sccn : scc) {
@@ -304,9 +341,20 @@ bool HornifyModule::runOnModule(Module &M) {
     // assert (!it.hasLoop () && "Recursion not yet supported");
     // assert (scc.size () == 1 && "Recursion not supported");
     if (f)
-      Changed = (runOnFunction(*f) || Changed);
+      fns.push_back(f);
   }
 
+  // -- clauses of a function only depend on the summaries of its callees,
+  // -- so functions can be hornified concurrently once all summaries are
+  // -- declared
+  if (canHornifyInParallel() && recursive)
+    WARN << "--horn-threads is ignored: the program is recursive";
+  if (canHornifyInParallel() && !recursive)
+    runOnFunctionsParallel(fns);
+  else
+    for (Function *f : fns)
+      Changed = (runOnFunction(*f) || Changed);
+
   if (!m_db.hasQuery()) {
     // --- This may happen if the exit block of main is unreachable
     //     but still the main function can fail.
@@ -375,7 +423,7 @@ bool HornifyModule::runOnModule(Module &M) {
   return Changed;
 }
 
-bool HornifyModule::runOnFunction(Function &F) {
+bool HornifyModule::initFunction(Function &F) {
   // -- skip functions without a body
   if (F.isDeclaration() || F.empty())
     return false;
@@ -393,18 +441,6 @@ bool HornifyModule::runOnFunction(Function &F) {
   // hornify function.
   /*CutPointGraph &cpg =*/getAnalysis<CutPointGraph>(F);
 
-  boost::scoped_ptr<HornifyFunction> hf(
-      new SmallHornifyFunction(*this, InterProc));
-  if (Step == hm_detail::LARGE_STEP)
-    hf.reset(new LargeHornifyFunction(*this, InterProc));
-  else if (Step == hm_detail::FLAT_SMALL_STEP ||
-           Step == hm_detail::CLP_FLAT_SMALL_STEP)
-    hf.reset(new FlatSmallHornifyFunction(*this, InterProc));
-  else if (Step == hm_detail::FLAT_LARGE_STEP)
-    hf.reset(new FlatLargeHornifyFunction(*this, InterProc));
-  else if (Step == hm_detail::INC_SMALL_STEP)
-    hf.reset(new IncSmallHornifyFunction(*this, InterProc));
-
   /// -- allocate LiveSymbols
   auto r = m_ls.insert(std::make_pair(&F, LiveSymbols(F, m_efac, *m_sem)));
   assert(r.second);
@@ -419,6 +455,24 @@ bool HornifyModule::runOnFunction(Function &F) {
   r.first->second.run();
 
   LOG("inter_mem_counters", tmp_im_stats.copyTo(g_im_stats));
+  return true;
+}
+
+bool HornifyModule::runOnFunction(Function &F) {
+  if (!initFunction(F))
+    return false;
+
+  boost::scoped_ptr<HornifyFunction> hf(
+      new SmallHornifyFunction(*this, InterProc));
+  if (Step == hm_detail::LARGE_STEP)
+    hf.reset(new LargeHornifyFunction(*this, InterProc));
+  else if (Step == hm_detail::FLAT_SMALL_STEP ||
+           Step == hm_detail::CLP_FLAT_SMALL_STEP)
+    hf.reset(new FlatSmallHornifyFunction(*this, InterProc));
+  else if (Step == hm_detail::FLAT_LARGE_STEP)
+    hf.reset(new FlatLargeHornifyFunction(*this, InterProc));
+  else if (Step == hm_detail::INC_SMALL_STEP)
+    hf.reset(new IncSmallHornifyFunction(*this, InterProc));
 
   /// -- hornify function
   hf->runOnFunction(F);
@@ -426,6 +480,67 @@ bool HornifyModule::runOnFunction(Function &F) {
   return false;
 }
 
+/// \brief Computes the layouts used by the GEPs of \p F
+///
+/// DataLayout caches struct layouts lazily and without a lock. The
+/// operational semantics asks for them when it encodes a GEP, so they
+/// are computed before the workers share the DataLayout.
+static void computeGepLayouts(const Function &F, const DataLayout &dl) {
+  for (const Instruction &I : instructions(F)) {
+    const GetElementPtrInst *gep = dyn_cast<GetElementPtrInst>(&I);
+    if (!gep)
+      continue;
+    for (auto GTI = gep_type_begin(gep), GTE = gep_type_end(gep); GTI != GTE;
+         ++GTI) {
+      if (StructType *st = GTI.getStructTypeOrNull())
+        dl.getStructLayout(st);
+      else
+        dl.getTypeStoreSize(GTI.getIndexedType());
+    }
+  }
+}
+
+void HornifyModule::runOnFunctionsParallel(const std::vector<Function *> &fns) {
+  ScopedStats _st("HornifyModule.parallel");
+
+  // -- everything shared by the workers is computed in order: live
+  // -- symbols, basic block predicates, struct layouts, and summaries of
+  // -- callees, which are needed by the live symbols of their callers
+  std::vector<Function *> bodies;
+  for (Function *f : fns) {
+    if (!initFunction(*f))
+      continue;
+    for (auto &BB : *f)
+      bbPredicate(BB);
+    computeGepLayouts(*f, *m_td);
+    SmallHornifyFunction(*this, InterProc).declareSummary(*f);
+    bodies.push_back(f);
+  }
+
+  // -- each function is hornified into its own database
+  std::vector<std::unique_ptr<HornClauseDB>> dbs;
+  for (unsigned i = 0, sz = bodies.size(); i < sz; ++i)
+    dbs.push_back(llvm::make_unique<HornClauseDB>(m_efac));
+
+  std::atomic<unsigned> next(0);
+  auto worker = [&]() {
+    for (unsigned i = next++; i < bodies.size(); i = next++)
+      SmallHornifyFunction(*this, *dbs[i], InterProc)
+          .runOnFunction(*bodies[i]);
+  };
+  std::vector<std::thread> threads;
+  unsigned numThreads = std::min<unsigned>(HornifyThreads, bodies.size());
+  for (unsigned t = 0; t < numThreads; ++t)
+    threads.emplace_back(worker);
+  for (auto &t : threads)
+    t.join();
+
+  // -- merge in call graph order so that the result does not depend on
+  // -- the schedule
+  for (auto &db : dbs)
+    m_db.append(*db);
+}
+
 void HornifyModule::getAnalysisUsage(llvm::AnalysisUsage &AU) const {
   AU.setPreservesAll();
 
@@ -16,6 +16,13 @@
 
 #include "seahorn/Support/Stats.hh"
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
 using namespace llvm;
 
 namespace seahorn
@@ -26,6 +33,35 @@ namespace seahorn
   #define NAIVE 0
   #define EACH_RULE_A_SOLVER 1
   #define EACH_RELATION_A_SOLVER 2
+  #define EACH_RELATION_A_SOLVER_WITH_ASSUMPTIONS 3
+
+  enum class HoudiniConfig
+  {
+	  naive = NAIVE,
+	  rule = EACH_RULE_A_SOLVER,
+	  relation = EACH_RELATION_A_SOLVER,
+	  assumptions = EACH_RELATION_A_SOLVER_WITH_ASSUMPTIONS
+  };
+
+  static llvm::cl::opt<HoudiniConfig> XHoudiniConfig(
+      "horn-houdini-config", llvm::cl::desc("Houdini solving strategy"),
+      llvm::cl::values(
+          clEnumValN(HoudiniConfig::naive, "naive", "One solver for all rules"),
+          clEnumValN(HoudiniConfig::rule, "rule", "One solver per rule"),
+          clEnumValN(HoudiniConfig::relation, "relation",
+                     "One solver per relation"),
+          clEnumValN(HoudiniConfig::assumptions, "assumptions",
+                     "One solver per relation with candidates under "
+                     "assumptions")),
+      llvm::cl::init(HoudiniConfig::rule));
+
+  unsigned HoudiniWorkers;
+
+  static llvm::cl::opt<unsigned, true> XHoudiniWorkers(
+      "horn-houdini-workers",
+      llvm::cl::desc("Number of threads solving independent components of "
+                     "the WTO with --horn-houdini-config=assumptions"),
+      llvm::cl::location(HoudiniWorkers), llvm::cl::init(1u));
 
   /*HoudiniPass methods begin*/
 
@@ -35,8 +71,7 @@ namespace seahorn
   {
     HornifyModule &hm = getAnalysis<HornifyModule> ();
 
-    //Use commandline option to replace it.
-    int config = EACH_RULE_A_SOLVER;
+    int config = static_cast<int>(XHoudiniConfig.getValue());
 
     Stats::resume ("Houdini inv");
     Houdini houdini(hm);
@@ -166,6 +201,11 @@ namespace seahorn
 		  Houdini_Each_Solver_Per_Relation houdini_solver_per_relation(*this, db_wto, workList);
 		  houdini_solver_per_relation.run();
 	  }
+	  else if (config == EACH_RELATION_A_SOLVER_WITH_ASSUMPTIONS)
+	  {
+		  Houdini_Assumptions houdini_assumptions(*this, db_wto, workList);
+		  houdini_assumptions.run();
+	  }
 	  else if (config == NAIVE)
 	  {
 		  Houdini_Naive houdini_naive(*this, db_wto, workList);
@@ -435,6 +475,465 @@ namespace seahorn
   	  return relationToSolverMap;
   }
 
+  namespace
+  {
+	  // -- collects the relations of a wto element
+	  class WtoRelations : public WtoElementVisitor<Expr>
+	  {
+		  ExprVector &m_out;
+	  public:
+		  WtoRelations(ExprVector &out) : m_out(out) {}
+		  void visit(const wto_singleton_t &s) { m_out.push_back(s.get()); }
+		  void visit(const wto_component_t &c)
+		  {
+			  m_out.push_back(c.head());
+			  for (auto &e : c)
+			  {
+				  e.accept(this);
+			  }
+		  }
+	  };
+
+	  Expr mkHoudiniLit(const std::string &name, ExprFactory &efac)
+	  {
+		  return bind::boolConst(mkTerm<std::string>("houdini." + name, efac));
+	  }
+  }
+
+  /*
+   * Build the literals and the formulas of every rule, and split the
+   * relations into the top-level components of the wto. Only the
+   * main thread creates expressions here.
+   */
+  void Houdini_Assumptions::init()
+  {
+	  auto &m_hm = m_houdini.getHornifyModule();
+	  auto &db = m_hm.getHornClauseDB();
+	  ExprFactory &efac = m_hm.getExprFactory();
+
+	  for(Expr rel : db.getRelations())
+	  {
+		  unsigned ri = m_rels.size();
+		  m_relIdx[rel] = ri;
+		  m_rels.emplace_back();
+		  RelCands &rc = m_rels.back();
+
+		  ExprVector arg_list;
+		  for(int i=0; i<bind::domainSz(rel); i++)
+		  {
+			  arg_list.push_back(bind::fapp(bind::bvar(i, bind::domainTy(rel, i))));
+		  }
+		  rc.fapp = bind::fapp(rel, arg_list);
+
+		  Expr cand = m_houdini.getCandidateModel().getDef(rc.fapp);
+		  if(isOpX<AND>(cand))
+		  {
+			  rc.lemmas.insert(rc.lemmas.end(), cand->args_begin(), cand->args_end());
+		  }
+		  else
+		  {
+			  rc.lemmas.push_back(cand);
+		  }
+		  rc.lemmas.erase(std::remove_if(rc.lemmas.begin(), rc.lemmas.end(),
+		                                 [](Expr e) { return isOpX<TRUE>(e); }),
+		                  rc.lemmas.end());
+		  for(unsigned k=0; k<rc.lemmas.size(); k++)
+		  {
+			  rc.lits.push_back(mkHoudiniLit("cand." + std::to_string(ri) + "." + std::to_string(k), efac));
+		  }
+		  rc.active.assign(rc.lemmas.size(), true);
+		  rc.comp = 0;
+	  }
+
+	  // -- k-th lemma of relation ri over the arguments of app
+	  auto instantiate = [this](unsigned ri, unsigned k, Expr app)
+	  {
+		  const RelCands &rc = m_rels[ri];
+		  ExprMap argMap;
+		  for(int i=0; i<bind::domainSz(bind::fname(app)); i++)
+		  {
+			  argMap.insert(std::make_pair(rc.fapp->arg(i+1), app->arg(i+1)));
+		  }
+		  return replace(rc.lemmas[k], argMap);
+	  };
+
+	  for(HornRule &r : db.getRules())
+	  {
+		  unsigned ri = m_rules.size();
+		  m_ruleIdx[r] = ri;
+		  m_rules.emplace_back();
+		  RuleCands &rc = m_rules.back();
+		  rc.rule = &r;
+		  rc.head = m_relIdx.at(bind::fname(r.head()));
+		  rc.guards = 0;
+		  rc.queued = false;
+		  m_rels[rc.head].defs.push_back(ri);
+
+		  rc.tag = mkHoudiniLit("tag." + std::to_string(ri), efac);
+		  rc.asserts.push_back(mk<IMPL>(rc.tag, extractTransitionRelation(r, db)));
+
+		  // -- lemmas of the body hold if the rule and the lemma are enabled
+		  ExprVector body_pred_apps;
+		  get_all_pred_apps(r.body(), db, std::back_inserter(body_pred_apps));
+		  for(Expr body_app : body_pred_apps)
+		  {
+			  unsigned q = m_relIdx.at(bind::fname(body_app));
+			  if(std::find(rc.body.begin(), rc.body.end(), q) == rc.body.end())
+			  {
+				  rc.body.push_back(q);
+				  m_rels[q].uses.push_back(ri);
+			  }
+			  for(unsigned k=0; k<m_rels[q].lemmas.size(); k++)
+			  {
+				  rc.asserts.push_back(mk<IMPL>(mk<AND>(rc.tag, m_rels[q].lits[k]), instantiate(q, k, body_app)));
+			  }
+		  }
+
+		  // -- h_k names the k-th lemma of the head
+		  for(unsigned k=0; k<m_rels[rc.head].lemmas.size(); k++)
+		  {
+			  Expr h = mkHoudiniLit("head." + std::to_string(ri) + "." + std::to_string(k), efac);
+			  rc.head_lits.push_back(h);
+			  rc.asserts.push_back(mk<IFF>(h, instantiate(rc.head, k, r.head())));
+		  }
+	  }
+
+	  // -- one component per top-level element of the wto. Relations
+	  // -- that the wto does not reach share one extra component.
+	  std::map<Expr, unsigned> wtoPos;
+	  unsigned num_comps = 0;
+	  for(auto &e : m_db_wto)
+	  {
+		  ExprVector rels;
+		  WtoRelations vis(rels);
+		  e.accept(&vis);
+		  for(Expr rel : rels)
+		  {
+			  auto it = m_relIdx.find(rel);
+			  if(it == m_relIdx.end())
+			  {
+				  continue;
+			  }
+			  m_rels[it->second].comp = num_comps;
+			  unsigned p = wtoPos.size();
+			  wtoPos[rel] = p;
+		  }
+		  num_comps++;
+	  }
+	  bool unreached = false;
+	  for(RelCands &rc : m_rels)
+	  {
+		  if(!wtoPos.count(bind::fname(rc.fapp)))
+		  {
+			  rc.comp = num_comps;
+			  unreached = true;
+		  }
+	  }
+	  if(unreached)
+	  {
+		  num_comps++;
+	  }
+
+	  // -- rules of each component, sorted by the wto position of their
+	  // -- head. Ties keep the order of the work list.
+	  m_comps.resize(num_comps);
+	  for(HornRule &r : m_workList)
+	  {
+		  unsigned ri = m_ruleIdx.at(r);
+		  m_comps[m_rels[m_rules[ri].head].comp].push_back(ri);
+	  }
+	  auto pos = [&](unsigned ri)
+	  {
+		  auto it = wtoPos.find(bind::fname(m_rules[ri].rule->head()));
+		  return it == wtoPos.end() ? wtoPos.size() : it->second;
+	  };
+	  for(std::vector<unsigned> &comp : m_comps)
+	  {
+		  std::stable_sort(comp.begin(), comp.end(),
+		                   [&](unsigned a, unsigned b) { return pos(a) < pos(b); });
+	  }
+	  LOG("houdini", errs() << "COMPONENTS: " << m_comps.size() << "\n";);
+  }
+
+  void Houdini_Assumptions::run()
+  {
+	  auto &m_hm = m_houdini.getHornifyModule();
+	  ExprFactory &efac = m_hm.getExprFactory();
+
+	  // -- components wait for the components used in their bodies
+	  std::vector<unsigned> pending(m_comps.size(), 0);
+	  std::vector<std::set<unsigned>> succs(m_comps.size());
+	  for(const RuleCands &rc : m_rules)
+	  {
+		  unsigned c = m_rels[rc.head].comp;
+		  for(unsigned q : rc.body)
+		  {
+			  unsigned d = m_rels[q].comp;
+			  if(d != c && succs[d].insert(c).second)
+			  {
+				  pending[c]++;
+			  }
+		  }
+	  }
+	  std::deque<unsigned> ready;
+	  for(unsigned c=0; c<m_comps.size(); c++)
+	  {
+		  if(pending[c] == 0)
+		  {
+			  ready.push_back(c);
+		  }
+	  }
+
+	  // -- workers share the expression factory, so it must be concurrent
+	  unsigned num_workers = efac.isConcurrent() ? std::max(1u, std::min<unsigned>(HoudiniWorkers, m_comps.size())) : 1;
+	  // -- the first worker uses the context of HornifyModule. Contexts
+	  // -- are created before the threads are started.
+	  std::vector<std::unique_ptr<EZ3>> zctxs;
+	  for(unsigned i=1; i<num_workers; i++)
+	  {
+		  zctxs.push_back(llvm::make_unique<EZ3>(efac));
+	  }
+
+	  std::mutex mtx;
+	  std::condition_variable cv;
+	  unsigned done = 0;
+	  auto worker = [&](unsigned i)
+	  {
+		  EZ3 &zctx = i == 0 ? m_hm.getZContext() : *zctxs[i-1];
+		  std::unique_lock<std::mutex> lock(mtx);
+		  while(true)
+		  {
+			  cv.wait(lock, [&] { return !ready.empty() || done == m_comps.size(); });
+			  if(ready.empty())
+			  {
+				  return;
+			  }
+			  unsigned c = ready.front();
+			  ready.pop_front();
+			  lock.unlock();
+			  solveComponent(c, zctx);
+			  lock.lock();
+			  done++;
+			  for(unsigned s : succs[c])
+			  {
+				  if(--pending[s] == 0)
+				  {
+					  ready.push_back(s);
+				  }
+			  }
+			  cv.notify_all();
+		  }
+	  };
+
+	  if(num_workers == 1)
+	  {
+		  worker(0);
+	  }
+	  else
+	  {
+		  std::vector<std::thread> threads;
+		  for(unsigned i=0; i<num_workers; i++)
+		  {
+			  threads.emplace_back(worker, i);
+		  }
+		  for(std::thread &t : threads)
+		  {
+			  t.join();
+		  }
+	  }
+	  m_workList.clear();
+	  Stats::uset("Houdini checks", m_checks);
+	  Stats::uset("Houdini dropped candidates", m_dropped);
+
+	  // -- store the lemmas left in the candidate model
+	  unsigned kept = 0;
+	  for(RelCands &rc : m_rels)
+	  {
+		  rc.solver.reset();
+		  ExprVector lemmas;
+		  for(unsigned k=0; k<rc.lemmas.size(); k++)
+		  {
+			  if(rc.active[k])
+			  {
+				  lemmas.push_back(rc.lemmas[k]);
+			  }
+		  }
+		  kept += lemmas.size();
+		  Expr cand = lemmas.empty() ? mk<TRUE>(efac)
+		      : (lemmas.size() == 1 ? lemmas[0]
+		         : mknary<AND>(lemmas.begin(), lemmas.end()));
+		  m_houdini.getCandidateModel().addDef(rc.fapp, cand);
+	  }
+	  Stats::uset("Houdini kept candidates", kept);
+  }
+
+  /*
+   * Weaken the relations of component c until all its rules are
+   * valid. Only the relations of c are modified, and the components
+   * used in its bodies are done, so workers need no locks here.
+   */
+  void Houdini_Assumptions::solveComponent(unsigned c, EZ3 &zctx)
+  {
+	  std::deque<unsigned> workList;
+	  try
+	  {
+		  for(unsigned ri : m_comps[c])
+		  {
+			  RuleCands &rc = m_rules[ri];
+			  RelCands &head = m_rels[rc.head];
+			  if(!head.solver)
+			  {
+				  head.solver.reset(new ZSolver<EZ3>(zctx));
+			  }
+			  for(Expr e : rc.asserts)
+			  {
+				  head.solver->assertExpr(e);
+			  }
+			  rc.queued = true;
+			  workList.push_back(ri);
+		  }
+
+		  std::vector<unsigned> falsified;
+		  while(!workList.empty())
+		  {
+			  LOG("houdini", errs() << "WORKLIST SIZE: " << workList.size() << "\n";);
+			  unsigned ri = workList.front();
+			  workList.pop_front();
+			  RuleCands &rc = m_rules[ri];
+			  rc.queued = false;
+			  LOG("houdini", errs() << "RULE HEAD: " << *(rc.rule->head()) << "\n";);
+			  LOG("houdini", errs() << "RULE BODY: " << *(rc.rule->body()) << "\n";);
+
+			  while(checkRule(ri, falsified) != UNSAT)
+			  {
+				  weaken(ri, falsified);
+				  for(unsigned u : m_rels[rc.head].uses)
+				  {
+					  RuleCands &user = m_rules[u];
+					  if(u != ri && !user.queued && m_rels[user.head].comp == c)
+					  {
+						  user.queued = true;
+						  workList.push_back(u);
+					  }
+				  }
+			  }
+		  }
+	  }
+	  catch(z3::exception &e)
+	  {
+		  // -- no candidate of the component is known to hold
+		  LOG("houdini", errs() << "Z3 EXCEPTION: " << e.msg() << "\n";);
+		  for(unsigned ri : m_comps[c])
+		  {
+			  RelCands &head = m_rels[m_rules[ri].head];
+			  head.active.assign(head.active.size(), false);
+		  }
+	  }
+  }
+
+  /*
+   * Check that rule r implies the lemmas of its head left. Every
+   * active lemma is enabled by its literal, and a fresh guard requires
+   * one active lemma of the head to be false. The guard is disabled
+   * after the check, so the solver is never popped. If sat, falsified
+   * gets every head lemma that is false in the model.
+   */
+  bool Houdini_Assumptions::checkRule(unsigned ri, std::vector<unsigned> &falsified)
+  {
+	  RuleCands &rc = m_rules[ri];
+	  RelCands &head = m_rels[rc.head];
+	  ZSolver<EZ3> &solver = *head.solver;
+	  ExprFactory &efac = rc.tag->efac();
+	  falsified.clear();
+
+	  ExprVector violated;
+	  for(unsigned k=0; k<head.lemmas.size(); k++)
+	  {
+		  if(head.active[k])
+		  {
+			  violated.push_back(mk<NEG>(rc.head_lits[k]));
+		  }
+	  }
+	  if(violated.empty())
+	  {
+		  return UNSAT;
+	  }
+
+	  Expr guard = mkHoudiniLit("guard." + std::to_string(ri) + "." + std::to_string(rc.guards++), efac);
+	  solver.assertExpr(mk<IMPL>(guard, mknary<OR>(mk<FALSE>(efac), violated.begin(), violated.end())));
+
+	  ExprVector assumptions;
+	  assumptions.push_back(rc.tag);
+	  assumptions.push_back(guard);
+	  for(unsigned q : rc.body)
+	  {
+		  const RelCands &body = m_rels[q];
+		  for(unsigned k=0; k<body.lemmas.size(); k++)
+		  {
+			  if(body.active[k])
+			  {
+				  assumptions.push_back(body.lits[k]);
+			  }
+		  }
+	  }
+
+	  m_checks++;
+	  boost::tribool isSat = solver.solveAssuming(assumptions);
+	  if(isSat)
+	  {
+		  LOG("houdini", errs() << "SAT\n";);
+		  ZModel<EZ3> m = solver.getModel();
+		  for(unsigned k=0; k<head.lemmas.size(); k++)
+		  {
+			  if(head.active[k] && isOpX<FALSE>(m.eval(rc.head_lits[k])))
+			  {
+				  falsified.push_back(k);
+			  }
+		  }
+	  }
+	  else if(!isSat)
+	  {
+		  LOG("houdini", errs() << "UNSAT\n";);
+	  }
+	  else
+	  {
+		  LOG("houdini", errs() << "INDETERMINATE\n";);
+	  }
+	  solver.assertExpr(mk<NEG>(guard));
+	  return !isSat ? UNSAT : SAT_OR_INDETERMIN;
+  }
+
+  /*
+   * Drop every lemma in falsified from the head of rule ri. If the
+   * solver answered indeterminate, drop the first active lemma.
+   */
+  void Houdini_Assumptions::weaken(unsigned ri, const std::vector<unsigned> &falsified)
+  {
+	  RelCands &head = m_rels[m_rules[ri].head];
+	  if(falsified.empty())
+	  {
+		  LOG("houdini", errs() << "INDETERMINATE REACHED" << "\n");
+		  auto it = std::find(head.active.begin(), head.active.end(), true);
+		  assert(it != head.active.end());
+		  *it = false;
+		  m_dropped++;
+		  return;
+	  }
+	  for(unsigned k : falsified)
+	  {
+		  head.active[k] = false;
+	  }
+	  m_dropped += falsified.size();
+	  LOG("houdini", errs() << "DROPPED " << falsified.size() << " LEMMAS OF " << *(bind::fname(head.fapp)) << "\n";);
+  }
+
+  bool Houdini_Assumptions::validateRule(HornRule r, ZSolver<EZ3> &solver)
+  {
+	  // -- rules are checked in the solver of their head
+	  std::vector<unsigned> falsified;
+	  return checkRule(m_ruleIdx.at(r), falsified);
+  }
+
   /*
    * Given a rule, weaken its head's candidate
    */
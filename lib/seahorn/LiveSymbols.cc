@@ -6,6 +6,7 @@
 
 #include "seahorn/Support/SortTopo.hh"
 #include "llvm/Analysis/CFG.h"
+#include "llvm/IR/IntrinsicInst.h"
 
 namespace seahorn {
 
@@ -14,18 +15,6 @@ void LiveInfo::setLive(const ExprVector &l) {
   boost::sort(m_live);
 }
 
-void LiveInfo::setDefs(const ExprVector &d) {
-  m_defs.assign(d.begin(), d.end());
-  boost::sort(m_defs);
-}
-
-void LiveInfo::addEdgeDef(const ExprVector &d) {
-  m_edgeDefs.push_back(ExprVector());
-  ExprVector &defs = m_edgeDefs.back();
-  defs.assign(d.begin(), d.end());
-  boost::sort(defs);
-}
-
 void LiveInfo::addLive(ExprVector &v) {
   if (v.size() == 0)
     return;
@@ -57,6 +46,7 @@ void LiveSymbols::run() {
     patchArgsAndGlobals();
   // -- propagate local def/use over the CFG.
   globalPass();
+  exportLive();
 
   // HACK: skip main() because it is not treated as a function (i.e., no
   // summary)
@@ -76,12 +66,40 @@ void LiveSymbols::dump() const {
            << "\n";
 }
 
-void LiveSymbols::patchArgsAndGlobals() {
-  LiveInfo &li = m_liveInfo[&m_f.getEntryBlock()];
+unsigned LiveSymbols::regIdx(Expr reg) {
+  auto r = m_regIdx.insert(std::make_pair(&*reg, m_regs.size()));
+  if (r.second)
+    m_regs.push_back(reg);
+  return r.first->second;
+}
+
+void LiveSymbols::use(Expr reg, UseDef &ud) {
+  // -- constants are not registers
+  if (!reg || !bind::isFapp(reg))
+    return;
+  unsigned idx = regIdx(reg);
+  if (!ud.defs.test(idx))
+    ud.live.set(idx);
+}
+
+void LiveSymbols::use(OpSemContext &ctx, const Value &v, UseDef &ud) {
+  if (isa<BasicBlock>(v) || isa<MetadataAsValue>(v))
+    return;
+  use(m_sem.mkSymbReg(v, ctx), ud);
+}
+
+void LiveSymbols::def(OpSemContext &ctx, const Value &v, RegSet &defs) {
+  Expr reg = m_sem.mkSymbReg(v, ctx);
+  if (reg && bind::isFapp(reg))
+    defs.set(regIdx(reg));
+}
 
-  ExprVector extras;
+void LiveSymbols::patchArgsAndGlobals() {
+  UseDef &entry = m_useDef[&m_f.getEntryBlock()];
 
-  for (Expr v : li.live()) {
+  RegSet extras;
+  for (unsigned idx : entry.live) {
+    Expr v = m_regs[idx];
     assert(bind::isFapp(v));
     Expr u = bind::fname(bind::fname(v));
     if (!isOpX<VALUE>(u))
@@ -90,112 +108,198 @@ void LiveSymbols::patchArgsAndGlobals() {
     const Value *val = getTerm<const Value *>(u);
 
     if (isa<Argument>(val) || isa<GlobalVariable>(val))
-      extras.push_back(v);
+      extras.set(idx);
   }
 
   // find block with return and make extras live there
   for (const BasicBlock *bb : m_rtopo)
     if (isa<ReturnInst>(bb->getTerminator())) {
-      m_liveInfo[bb].addLive(extras);
+      m_useDef[bb].live |= extras;
       break;
     }
 }
 
+bool LiveSymbols::needsSymExec(const BasicBlock &bb) const {
+  // -- globals are initialized on entry to main
+  if (&bb == &m_f.getEntryBlock() && m_f.getName().equals("main"))
+    return true;
+
+  for (const Instruction &I : bb) {
+    // -- intrinsics are skipped, except for memory ones
+    if (const IntrinsicInst *II = dyn_cast<IntrinsicInst>(&I)) {
+      if (isa<MemIntrinsic>(II))
+        return true;
+      continue;
+    }
+    // -- calls read and write the error flag, memory regions, and
+    // -- whatever else the semantics of the callee says
+    if (isa<CallInst>(I) || isa<InvokeInst>(I))
+      return true;
+  }
+  return false;
+}
+
+void LiveSymbols::irUseDef(OpSemContext &ctx, const BasicBlock &bb,
+                           UseDef &ud) {
+  // -- the error flag is read on entry to every block
+  use(m_sem.errorFlag(bb), ud);
+
+  for (const Instruction &I : bb) {
+    if (isa<PHINode>(I) || isa<IntrinsicInst>(I))
+      continue;
+
+    if (const BranchInst *br = dyn_cast<BranchInst>(&I)) {
+      if (br->isConditional())
+        use(ctx, *br->getCondition(), ud);
+      continue;
+    }
+    if (const ReturnInst *ret = dyn_cast<ReturnInst>(&I)) {
+      // -- return value of main is not used
+      if (ret->getNumOperands() > 0 && !m_f.getName().equals("main"))
+        use(ctx, *ret->getOperand(0), ud);
+      continue;
+    }
+
+    // -- a successful access through a gep implies that the base of
+    // -- the gep is not null. Assume that the semantics says so.
+    const Value *ptr = nullptr;
+    if (const LoadInst *LI = dyn_cast<LoadInst>(&I))
+      ptr = LI->getPointerOperand();
+    else if (const StoreInst *SI = dyn_cast<StoreInst>(&I))
+      ptr = SI->getPointerOperand();
+    if (ptr)
+      if (const GetElementPtrInst *gep =
+              dyn_cast<GetElementPtrInst>(ptr->stripPointerCasts()))
+        use(ctx, *gep->getPointerOperand(), ud);
+
+    // -- untracked instructions are not executed
+    if (!m_sem.isTracked(I))
+      continue;
+
+    // -- a load reads memory only after a shadow.mem.load call
+    if (!isa<LoadInst>(I))
+      for (const Value *op : I.operand_values())
+        use(ctx, *op, ud);
+    def(ctx, I, ud.defs);
+  }
+}
+
+void LiveSymbols::symExecUseDef(const BasicBlock &bb, UseDef &ud) {
+  SymStore s(m_gstore, true);
+  OpSemContextPtr ctx = m_sem.mkContext(s, m_side);
+  // -- execute the basic block and the condition of the terminator
+  symExec(*ctx, bb);
+
+  LOG("live", errs() << "After executing " << bb.getName() << "\n"
+                     << "Got live vars: " << s.uses().size() << "\n";
+      for (auto i
+           : s.uses()) { errs() << *i << " "; } errs()
+      << "\n";);
+
+  // -- live and defs based on what is read/written by symbolic execution
+  for (Expr u : s.uses())
+    ud.live.set(regIdx(u));
+  for (Expr d : s.defs())
+    ud.defs.set(regIdx(d));
+}
+
+void LiveSymbols::phiUseDef(OpSemContext &ctx, const BasicBlock &bb,
+                            const BasicBlock &from, RegSet &uses,
+                            RegSet &defs) {
+  // -- all incoming values are read before any phi-node is defined
+  UseDef ud;
+  for (const Instruction &I : bb) {
+    const PHINode *phi = dyn_cast<PHINode>(&I);
+    if (!phi)
+      break;
+    if (!m_sem.isTracked(*phi))
+      continue;
+    use(ctx, *phi->getIncomingValueForBlock(&from), ud);
+    def(ctx, *phi, defs);
+  }
+  uses = std::move(ud.live);
+}
+
+void LiveSymbols::symExecPhiUseDef(const BasicBlock &bb,
+                                   const BasicBlock &from, RegSet &uses,
+                                   RegSet &defs) {
+  SymStore s(m_gstore, true);
+  OpSemContextPtr ctx = m_sem.mkContext(s, m_side);
+  symExecPhi(*ctx, bb, from);
+
+  for (Expr u : s.uses())
+    uses.set(regIdx(u));
+  for (Expr d : s.defs())
+    defs.set(regIdx(d));
+}
+
 void LiveSymbols::localPass() {
   RevTopoSort(m_f, m_rtopo);
+  OpSemContextPtr ctx = m_sem.mkContext(m_gstore, m_side);
 
   for (const BasicBlock *bb : m_rtopo) {
-    LiveInfo &li = m_liveInfo[bb];
+    UseDef &ud = m_useDef[bb];
 
     // // -- no live variables at any terminal basic block of the main function
     // if (llvm::succ_begin (bb) == llvm::succ_end (bb) &&
     //     m_f.getName ().equals ("main")) continue;
 
-    SymStore s(m_gstore, true);
-    OpSemContextPtr ctx = m_sem.mkContext(s, m_side);
-    // -- execute the basic block and the condition of the terminator
-    symExec(*ctx, *bb);
-
-    LOG("live", errs() << "After executing " << bb->getName() << "\n"
-                       << "Got live vars: " << s.uses().size() << "\n";
-        for (auto i
-             : s.uses()) { errs() << *i << " "; } errs()
-        << "\n";);
+    if (m_symExecOnly || needsSymExec(*bb))
+      symExecUseDef(*bb, ud);
+    else
+      irUseDef(*ctx, *bb, ud);
 
-    // -- live and defs based on what is read/written by symbolic execution
-    li.setLive(s.uses());
-    li.setDefs(s.defs());
-
-    // -- execute phi-nodes on the edges and update block's live
-    // -- symbols and edge definitions
+    // -- phi-nodes on the edges update block's live symbols and edge
+    // -- definitions
     for (const llvm::BasicBlock *succ : llvm::successors(bb)) {
-      SymStore ss(m_gstore, true);
-      OpSemContextPtr cctx = m_sem.mkContext(ss, m_side);
-      // -- execute the phi-nodes
-      symExecPhi(*cctx, *succ, *bb);
-
-      LOG("live", errs() << "After executing phiNodes on the edge: "
-                         << bb->getName() << "->" << succ->getName() << " got "
-                         << ss.uses().size() << " uses\n";
-          for (auto i
-               : ss.uses()) { errs() << *i << " "; } errs()
-          << "\n";);
-      li.addEdgeDef(ss.defs());
-
-      // compute extra live variables by finding new uses at the edge
-      ExprVector uses(ss.uses().size());
-      boost::copy(ss.uses(), uses.begin());
-      boost::sort(uses);
-
-      ExprVector uses2;
-      uses2.reserve(uses.size());
-      boost::set_difference(uses, li.defs(), std::back_inserter(uses2));
-      uses.clear();
-      boost::set_difference(uses2, li.live(), std::back_inserter(uses));
-      li.addLive(uses);
+      RegSet uses, defs;
+      if (m_symExecOnly)
+        symExecPhiUseDef(*succ, *bb, uses, defs);
+      else
+        phiUseDef(*ctx, *succ, *bb, uses, defs);
+      uses.intersectWithComplement(ud.defs);
+      ud.live |= uses;
+      ud.edgeDefs.push_back(std::move(defs));
     }
     // -- at this point local live information for bb is computed
   }
-  // -- at this point all local live information is computed for all
-  // -- basic blocks. Can update global uses.
+  m_side.clear();
 }
 
 void LiveSymbols::globalPass() {
   // -- propagate live symbol information until nothing can be propagated
-  // -- based on local live symbol information computed by initialize()
+  // -- based on local live symbol information computed by localPass()
   bool dirty;
   do {
     dirty = false;
     for (const BasicBlock *src : m_rtopo) {
       unsigned idx = 0;
-      LiveInfo &srcLi = m_liveInfo[src];
+      UseDef &srcUd = m_useDef[src];
 
       for (const BasicBlock *dst :
            boost::make_iterator_range(succ_begin(src), succ_end(src))) {
-        LiveInfo &dstLi = m_liveInfo[dst];
-
-        ExprVector live;
-        live.reserve(dstLi.live().size());
-
-        ExprVector live2;
-        live2.reserve(live.size());
-
-        boost::set_difference(dstLi.live(), srcLi.edge_defs(idx++),
-                              std::back_inserter(live));
-        boost::set_difference(live, srcLi.defs(), std::back_inserter(live2));
-
-        live.clear();
-        boost::set_difference(live2, srcLi.live(), std::back_inserter(live));
-
-        if (!live.empty()) {
-          dirty = true;
-          srcLi.addLive(live);
-        }
+        RegSet live(m_useDef[dst].live);
+        live.intersectWithComplement(srcUd.edgeDefs[idx++]);
+        live.intersectWithComplement(srcUd.defs);
+        dirty |= (srcUd.live |= live);
       }
     }
   } while (dirty);
 }
 
+void LiveSymbols::exportLive() {
+  for (const BasicBlock *bb : m_rtopo) {
+    ExprVector live;
+    for (unsigned idx : m_useDef[bb].live)
+      live.push_back(m_regs[idx]);
+    m_liveInfo[bb].setLive(live);
+  }
+  // -- only the live symbols are kept
+  m_useDef.clear();
+  m_regIdx.clear();
+  m_regs.clear();
+}
+
 void LiveSymbols::symExec(OpSemContext &ctx, const BasicBlock &bb) {
   m_sem.exec(bb, ctx);
   m_side.clear();
@@ -13,8 +13,13 @@ seahorn::PathBmcTrace seahorn::PathBmcEngine::getTrace() {
       "Path bmc engine only available if Clam is available", __FILE__,
       __LINE__);
 }
+namespace seahorn {
+solver::SolverKind SmtSolver = solver::SolverKind::Z3;
+unsigned PathWorkers = 1;
+}
 /* End dummy implementation for PathBmcEngine if Clam is not available */
 #else
+#include "seahorn/Expr/ExprAig.hh"
 #include "seahorn/Expr/ExprLlvm.hh"
 #include "seahorn/Expr/ExprSimplifier.hh"
 #include "seahorn/Expr/Smt/Solver.hh"
@@ -22,6 +27,8 @@ seahorn::PathBmcTrace seahorn::PathBmcEngine::getTrace() {
 #include "seahorn/Expr/Smt/Yices2SolverImpl.hh"
 #endif
 #include "seahorn/Expr/Smt/Model.hh"
+#include "seahorn/Expr/Smt/PortfolioSolverImpl.hh"
+#include "seahorn/Expr/Smt/SmtLibWriter.hh"
 #include "seahorn/Expr/Smt/Z3SolverImpl.hh"
 #include "seahorn/LoadCrab.hh"
 #include "seahorn/PathBmc.hh"
@@ -50,6 +57,12 @@ seahorn::PathBmcTrace seahorn::PathBmcEngine::getTrace() {
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 
 /**
@@ -93,6 +106,8 @@ path_bmc::MucMethodKind MucMethod;
 unsigned PathTimeout;
 unsigned MucTimeout;
 std::string SmtOutDir;
+unsigned PathWorkers;
+unsigned RetryBudget;
 }
 
 static llvm::cl::opt<seahorn::solver::SolverKind, true>
@@ -100,7 +115,11 @@ static llvm::cl::opt<seahorn::solver::SolverKind, true>
               llvm::cl::values(clEnumValN(seahorn::solver::SolverKind::Z3, "z3",
                                           "z3 SMT solver"),
                                clEnumValN(seahorn::solver::SolverKind::YICES2,
-                                          "yices2", "Yices2 SMT solver")),
+                                          "yices2", "Yices2 SMT solver"),
+                               clEnumValN(seahorn::solver::SolverKind::PORTFOLIO,
+                                          "portfolio",
+                                          "Run --horn-bmc-portfolio solvers "
+                                          "in parallel")),
               llvm::cl::desc("Choose SMT solver used for the Path Bmc engine"),
 	      llvm::cl::location(seahorn::SmtSolver),
               llvm::cl::init(seahorn::solver::SolverKind::Z3));
@@ -152,7 +171,10 @@ static llvm::cl::opt<enum seahorn::path_bmc::MucMethodKind, true> XMucMethod(
         clEnumValN(seahorn::path_bmc::MucMethodKind::MUC_DELETION, "deletion",
                    "Deletion-based method"),
         clEnumValN(seahorn::path_bmc::MucMethodKind::MUC_BINARY_SEARCH,
-                   "quickXplain", "QuickXplain method")),
+                   "quickXplain", "QuickXplain method"),
+        clEnumValN(seahorn::path_bmc::MucMethodKind::MUC_INCREMENTAL,
+                   "incremental",
+                   "Deletion-based method with one solver for all paths")),
     llvm::cl::location(seahorn::MucMethod),
     llvm::cl::init(seahorn::path_bmc::MucMethodKind::MUC_ASSUMPTIONS));
 
@@ -175,6 +197,35 @@ static llvm::cl::opt<std::string, true> XSmtOutDir(
     llvm::cl::location(seahorn::SmtOutDir),
     llvm::cl::init(""), llvm::cl::value_desc("directory"));
 
+static llvm::cl::list<seahorn::solver::SolverKind> PortfolioSolvers(
+    "horn-bmc-portfolio",
+    llvm::cl::desc("Solvers of the portfolio used by the Path Bmc engine "
+                   "(default: z3 and, if available, yices2)"),
+    llvm::cl::values(clEnumValN(seahorn::solver::SolverKind::Z3, "z3",
+                                "z3 SMT solver"),
+                     clEnumValN(seahorn::solver::SolverKind::YICES2, "yices2",
+                                "Yices2 SMT solver")),
+    llvm::cl::CommaSeparated);
+
+static llvm::cl::opt<unsigned, true> XPathWorkers(
+    "horn-bmc-path-workers",
+    llvm::cl::desc("Number of threads solving path formulas in Path Bmc "
+                   "engine. With --horn-bmc-crab, only unsolved paths are "
+                   "retried in parallel"),
+    llvm::cl::location(seahorn::PathWorkers), llvm::cl::init(1u));
+
+static llvm::cl::opt<unsigned, true> XRetryBudget(
+    "horn-bmc-retry-budget",
+    llvm::cl::desc("Time budget (sec) for retrying unsolved paths in Path Bmc "
+                   "engine (0 for no limit)"),
+    llvm::cl::location(seahorn::RetryBudget), llvm::cl::init(0u));
+
+static llvm::cl::opt<bool> PathAig(
+    "horn-bmc-path-aig",
+    llvm::cl::desc("Simplify the boolean abstraction of the Path Bmc engine "
+                   "with an And-Inverter Graph"),
+    llvm::cl::init(false));
+
 namespace seahorn {
 
 // To print messages with timestamps
@@ -759,30 +810,90 @@ solver::SolverResult PathBmcEngine::path_encoding_and_solve_with_smt(
   //   to_smt_lib(path_formula);
   // }
 
-  /*****************************************************************
-   * This check might be expensive if path_formula contains complex
-   * bitvector/floating point expressions.
-   * TODO: make decisions `a la` mcsat to solve faster. We will use
-   * here invariants to make only those decisions which are
-   * consistent with the invariants.
-   *****************************************************************/
-  m_smt_path_solver->reset();
-  // TODO: add here path_constraints to help
-  for (Expr e : path_formula) {
-    m_smt_path_solver->add(e);
-  }
-
-  solver::SolverResult res;
-  {
-    path_bmc::scoped_solver ss(*m_smt_path_solver, PathTimeout);
-    res = ss.get().check();
-  }
+  unsigned solver_calls = 0;
+  solver::SolverResult res =
+      solve_path(*m_smt_path_solver, m_inc_muc.get(), path_formula,
+                 path_cond_map, m_path_cond, solver_calls);
+  Stats::avg("BMC path-based: solver calls per path", solver_calls);
   if (res == solver::SolverResult::SAT) {
-    m_model = m_smt_path_solver->get_model();
+    m_model = m_inc_muc ? m_inc_muc->get_solver().get_model()
+                        : m_smt_path_solver->get_model();
     if (SmtOutDir != "") {
       to_smt_lib(path_formula, "sat");
     }
+  } else if (res == solver::SolverResult::UNKNOWN) {
+    Stats::count("BMC total number of unknown symbolic paths");
+    // We pretend the query is unsat to keep going but remember the
+    // unknown query in m_unsolved_path_formulas.
+    res = solver::SolverResult::UNSAT;
+    // -- Enqueue the unknown path formula
+    m_unsolved_path_formulas.push(m_num_paths, path_formula, PathTimeout);
+
+    if (SmtOutDir != "") {
+      to_smt_lib(path_formula, "unknown");
+    }
+  }
+
+  return res;
+}
+
+/*
+  Solve a path formula with the given solver.
+
+  If the formula is not sat then path_cond is a generalization of the
+  path: the path condition of a minimal unsat core, or of the whole
+  path if the solver returned unknown. The solver keeps the model if
+  the formula is sat. If inc_muc is not null then it solves the path
+  (and keeps the model) instead of solver.
+
+  Only the solver is modified: workers call it concurrently, each with
+  its own solver.
+*/
+solver::SolverResult PathBmcEngine::solve_path(
+    solver::Solver &solver, path_bmc::incremental_muc *inc_muc,
+    const ExprVector &path_formula, const ExprMap &path_cond_map,
+    ExprVector &path_cond, unsigned &solver_calls) const {
+  ExprVector unsat_core;
+  solver::SolverResult res;
+  if (inc_muc) {
+    unsigned calls = inc_muc->solver_calls();
+    res = inc_muc->solve(path_formula, PathTimeout, unsat_core);
+    solver_calls = inc_muc->solver_calls() - calls;
+    if (res == solver::SolverResult::SAT) {
+      return res;
+    }
+    if (res == solver::SolverResult::UNSAT) {
+      LOG("bmc", get_os() << "SMT proved unsat. Size of path formula="
+                          << path_formula.size() << ". ");
+    } else {
+      LOG("bmc", get_os() << "SMT returned unknown. Size of path formula="
+                          << path_formula.size() << ". ");
+      unsat_core.assign(path_formula.begin(), path_formula.end());
+      res = solver::SolverResult::UNKNOWN;
+    }
   } else {
+    /*****************************************************************
+     * This check might be expensive if path_formula contains complex
+     * bitvector/floating point expressions.
+     * TODO: make decisions `a la` mcsat to solve faster. We will use
+     * here invariants to make only those decisions which are
+     * consistent with the invariants.
+     *****************************************************************/
+    solver.reset();
+    // TODO: add here path_constraints to help
+    for (Expr e : path_formula) {
+      solver.add(e);
+    }
+
+    {
+      path_bmc::scoped_solver ss(solver, PathTimeout);
+      res = ss.get().check();
+    }
+    solver_calls = 1;
+    if (res == solver::SolverResult::SAT) {
+      return res;
+    }
+
     // Stats::resume ("BMC path-based: SMT unsat core");
     // --- Compute minimal unsat core of the path formula
     enum path_bmc::MucMethodKind muc_method = MucMethod;
@@ -792,72 +903,102 @@ solver::SolverResult PathBmcEngine::path_encoding_and_solve_with_smt(
     } else {
       LOG("bmc", get_os() << "SMT returned unknown. Size of path formula="
                           << path_formula.size() << ". ");
-      Stats::count("BMC total number of unknown symbolic paths");
-
       muc_method = path_bmc::MucMethodKind::MUC_NONE;
-      // We pretend the query is unsat to keep going but remember the
-      // unknown query in m_unsolved_path_formulas.
-      res = solver::SolverResult::UNSAT;
-      // -- Enqueue the unknown path formula
-      m_unsolved_path_formulas.push(std::make_pair(m_num_paths, path_formula));
-
-      if (SmtOutDir != "") {
-        to_smt_lib(path_formula, "unknown");
-      }
+      res = solver::SolverResult::UNKNOWN;
     }
 
-    ExprVector unsat_core;
     switch (muc_method) {
     case path_bmc::MucMethodKind::MUC_NONE: {
       unsat_core.assign(path_formula.begin(), path_formula.end());
       break;
     }
     case path_bmc::MucMethodKind::MUC_DELETION: {
-      path_bmc::deletion_muc muc(*m_smt_path_solver, MucTimeout);
+      path_bmc::deletion_muc muc(solver, MucTimeout);
       muc.run(path_formula, unsat_core);
+      solver_calls += muc.solver_calls();
       break;
     }
     case path_bmc::MucMethodKind::MUC_BINARY_SEARCH: {
-      path_bmc::binary_search_muc muc(*m_smt_path_solver, MucTimeout);
+      path_bmc::binary_search_muc muc(solver, MucTimeout);
       muc.run(path_formula, unsat_core);
+      solver_calls += muc.solver_calls();
       break;
     }
     case path_bmc::MucMethodKind::MUC_ASSUMPTIONS:
     default: {
-      path_bmc::muc_with_assumptions muc(*m_smt_path_solver);
+      path_bmc::muc_with_assumptions muc(solver);
       muc.run(path_formula, unsat_core);
+      solver_calls += muc.solver_calls();
       break;
     }
     }
-    // Stats::stop ("BMC path-based: SMT unsat core");
+  }
+  // Stats::stop ("BMC path-based: SMT unsat core");
 
-    LOG("bmc", get_os() << "Size of unsat core=" << unsat_core.size() << "\n";);
-    
-    LOG("bmc-details", 
-	errs() << "unsat core=\n";
-	for (auto e: unsat_core) {
-	  errs () << *e << "\n";
-	});
-    
-    // Stats::resume ("BMC path-based: blocking clause");
-    // -- Refine the Boolean abstraction using the unsat core
-    ExprSet path_cond_set;
-    for (Expr e : unsat_core) {
-      auto it = path_cond_map.find(e);
-      // It's possible that an implicant has no active booleans.
-      // For instance, corner cases where the whole program is a
-      // single block.
-      if (it != path_cond_map.end()) {
-        path_cond_set.insert(it->second);
-      }
+  LOG("bmc", get_os() << "Size of unsat core=" << unsat_core.size() << "\n";);
+
+  LOG("bmc-details",
+      errs() << "unsat core=\n";
+      for (auto e: unsat_core) {
+        errs () << *e << "\n";
+      });
+
+  // Stats::resume ("BMC path-based: blocking clause");
+  // -- Refine the Boolean abstraction using the unsat core
+  ExprSet path_cond_set;
+  for (Expr e : unsat_core) {
+    auto it = path_cond_map.find(e);
+    // It's possible that an implicant has no active booleans.
+    // For instance, corner cases where the whole program is a
+    // single block.
+    if (it != path_cond_map.end()) {
+      path_cond_set.insert(it->second);
     }
-    m_path_cond.assign(path_cond_set.begin(), path_cond_set.end());
-    // Stats::stop ("BMC path-based: blocking clause");
   }
+  path_cond.assign(path_cond_set.begin(), path_cond_set.end());
+  // Stats::stop ("BMC path-based: blocking clause");
 
   return res;
 }
 
+/// \brief Records the outcome of retrying an unsolved path
+static void set_retry_status(unsigned id, const std::string &status) {
+  Stats::sset("bmc.retry.path_" + std::to_string(id), status);
+}
+
+/// \brief Creates a solver of the given kind
+static std::unique_ptr<solver::Solver> mkSolver(solver::SolverKind kind,
+                                                ExprFactory &efac) {
+  switch (kind) {
+  case solver::SolverKind::Z3:
+    return llvm::make_unique<solver::z3_solver_impl>(efac);
+  case solver::SolverKind::YICES2:
+#ifdef WITH_YICES2
+    return llvm::make_unique<solver::yices_solver_impl>(efac);
+#else
+    assertion_failed("Compile with YICES2_HOME option", __FILE__, __LINE__);
+    break;
+#endif
+  case solver::SolverKind::PORTFOLIO: {
+    std::vector<solver::SolverKind> kinds(PortfolioSolvers.begin(),
+                                          PortfolioSolvers.end());
+    if (kinds.empty()) {
+      kinds.push_back(solver::SolverKind::Z3);
+#ifdef WITH_YICES2
+      kinds.push_back(solver::SolverKind::YICES2);
+#endif
+    }
+    std::vector<std::unique_ptr<solver::Solver>> solvers;
+    for (solver::SolverKind k : kinds)
+      solvers.push_back(mkSolver(k, efac));
+    return llvm::make_unique<solver::portfolio_solver_impl>(efac,
+                                                            std::move(solvers));
+  }
+  }
+  assertion_failed("Unsupported smt solver", __FILE__, __LINE__);
+  return nullptr;
+}
+
 PathBmcEngine::PathBmcEngine(LegacyOperationalSemantics &sem,
 			     const llvm::TargetLibraryInfo &tli,
 			     sea_dsa::ShadowMem &sm)
@@ -867,29 +1008,21 @@ PathBmcEngine::PathBmcEngine(LegacyOperationalSemantics &sem,
       m_tli(tli), m_sm(sm),
       m_cfg_builder_man(nullptr), m_crab_path_solver(nullptr) {
 
-  if (SmtSolver == solver::SolverKind::Z3) {
-    m_boolean_solver = llvm::make_unique<solver::z3_solver_impl>(sem.efac());
-    m_smt_path_solver = llvm::make_unique<solver::z3_solver_impl>(sem.efac());
-    // Tuning m_aux_solver_solver's parameters
-    // auto &s = static_cast<solver::z3_solver_impl&>(*m_smt_path_solver);
-    // ZParams<EZ3> params(s.get_context());
-    // params.set(":model_compress", false);
-    // params.set(":proof", false);
-    // s.get_solver().set(params);
-
-    // z3n_set_param(":model_compress", false);
-    // z3n_set_param(":proof", false);
-  } else if (SmtSolver == solver::SolverKind::YICES2) {
-#ifdef WITH_YICES2
-    m_boolean_solver = llvm::make_unique<solver::yices_solver_impl>(sem.efac());
-    m_smt_path_solver =
-        llvm::make_unique<solver::yices_solver_impl>(sem.efac());
-#else
-    assertion_failed("Compile with YICES2_HOME option", __FILE__, __LINE__);
-#endif
-  } else {
-    assertion_failed("Unsupported smt solver", __FILE__, __LINE__);
+  m_boolean_solver = mkSolver(SmtSolver, sem.efac());
+  m_smt_path_solver = mkSolver(SmtSolver, sem.efac());
+  if (MucMethod == path_bmc::MucMethodKind::MUC_INCREMENTAL) {
+    m_inc_muc = llvm::make_unique<path_bmc::incremental_muc>(
+        mkSolver(SmtSolver, sem.efac()), MucTimeout);
   }
+  // Tuning m_aux_solver_solver's parameters
+  // auto &s = static_cast<solver::z3_solver_impl&>(*m_smt_path_solver);
+  // ZParams<EZ3> params(s.get_context());
+  // params.set(":model_compress", false);
+  // params.set(":proof", false);
+  // s.get_solver().set(params);
+
+  // z3n_set_param(":model_compress", false);
+  // z3n_set_param(":proof", false);
 }
 
 PathBmcEngine::~PathBmcEngine() {}
@@ -905,7 +1038,8 @@ void PathBmcEngine::addCutPoint(const CutPoint &cp) {
 }
 
 // Print a path to a SMT-LIB file (for debugging purposes)
-void PathBmcEngine::to_smt_lib(const ExprVector &f, std::string prefix) {
+void PathBmcEngine::to_smt_lib(const ExprVector &f, std::string prefix,
+                               int path_id) {
   assert(SmtOutDir != "");
 
   std::error_code EC;
@@ -925,7 +1059,9 @@ void PathBmcEngine::to_smt_lib(const ExprVector &f, std::string prefix) {
     return;
   }
   // create a file name
-  std::string Filename("path_" + prefix + "_" + std::to_string(m_num_paths));
+  std::string Filename(
+      "path_" + prefix + "_" +
+      std::to_string(path_id < 0 ? m_num_paths : (unsigned)path_id));
   {
     time_t now = time(0);
     struct tm tstruct;
@@ -947,23 +1083,25 @@ void PathBmcEngine::to_smt_lib(const ExprVector &f, std::string prefix) {
   }
 
   // dump the formula to the file descriptor
-  m_smt_path_solver->reset();
-  for (Expr e : f) {
-    m_smt_path_solver->add(e);
+  SmtLibWriter w(fd);
+  w.assertAll(f);
+  fd << "(check-sat)\n";
+  if (w.unsupported() > 0) {
+    WARN << Filename << ": " << w.unsupported()
+         << " terms have no SMT-LIB2 counterpart";
   }
-  m_smt_path_solver->to_smt_lib(fd);
-  m_smt_path_solver->reset();
 }
 
 raw_ostream &PathBmcEngine::toSmtLib(raw_ostream &o) {
   encode();
 
-  m_smt_path_solver->reset();
-  for (Expr e : m_precise_side) {
-    m_smt_path_solver->add(e);
+  SmtLibWriter w(o);
+  w.assertAll(m_precise_side);
+  o << "(check-sat)\n";
+  if (w.unsupported() > 0) {
+    WARN << "PathBmcEngine: " << w.unsupported()
+         << " terms have no SMT-LIB2 counterpart";
   }
-  m_smt_path_solver->to_smt_lib(o);
-  m_smt_path_solver->reset();
   return o;
 }
 
@@ -1008,6 +1146,579 @@ void PathBmcEngine::solve_bool_abstraction() {
   Stats::stop("BMC path-based: enumeration path solver");
 }
 
+/*
+  Parallel version of the main loop of solve().
+
+  The main thread enumerates paths from the Boolean abstraction and
+  each worker solves path formulas with its own solver. A path is
+  blocked as soon as it is enumerated so that the main thread can
+  keep enumerating while the path is being solved. Blocking clauses
+  computed by the workers from minimal unsat cores are added to the
+  Boolean abstraction by the main thread. The first sat path
+  interrupts the other workers.
+
+  Unknown paths go to m_unsolved_path_formulas. While there are no new
+  paths to solve, idle workers retry them with exponentially bigger
+  timeouts, within the same --horn-bmc-retry-budget as
+  retry_unsolved_paths. One worker is always left for new paths.
+
+  Only the main thread touches Stats, m_boolean_solver and the rest of
+  the engine state. Workers only share m_unsolved_path_formulas.
+*/
+void PathBmcEngine::solve_paths_in_parallel(unsigned num_workers) {
+  struct PathQuery {
+    unsigned id;
+    ExprVector formula;
+    ExprMap bool_map;
+  };
+  struct PathAnswer {
+    unsigned id;
+    solver::SolverResult res;
+    // -- the formula is only kept if the path is unknown
+    ExprVector formula;
+    ExprVector path_cond;
+    unsigned solver_calls;
+  };
+
+  std::vector<std::unique_ptr<solver::Solver>> solvers;
+  std::vector<std::unique_ptr<path_bmc::incremental_muc>> inc_mucs;
+  for (unsigned i = 0; i < num_workers; ++i) {
+    solvers.push_back(mkSolver(SmtSolver, sem().efac()));
+    if (m_inc_muc) {
+      inc_mucs.push_back(llvm::make_unique<path_bmc::incremental_muc>(
+          mkSolver(SmtSolver, sem().efac()), MucTimeout));
+    }
+  }
+
+  std::mutex mtx;
+  // -- signals new queries to the workers
+  std::condition_variable query_cv;
+  // -- signals answers and idle workers to the main thread
+  std::condition_variable answer_cv;
+  std::deque<PathQuery> queries;
+  std::vector<PathAnswer> answers;
+  // -- number of queries without an answer
+  unsigned pending = 0;
+  // -- number of workers that have not exited
+  unsigned active = num_workers;
+  // -- no more queries will be produced
+  bool done = false;
+  // -- solvers that are inside a check. Only those are interrupted.
+  std::vector<char> running(num_workers, 0);
+  bool enumerating = false;
+  // -- the sat path, if any
+  int winner = -1;
+  PathQuery sat_query;
+  bool sat_retry = false;
+  solver::Solver::model_ref sat_model;
+  // -- workers retrying unsolved paths, and which ones
+  unsigned retrying = 0;
+  std::vector<char> retrying_worker(num_workers, 0);
+  unsigned retry_attempts = 0;
+  std::vector<unsigned> retry_unsat;
+
+  // -- interrupt every solver still running. Requires mtx.
+  auto cancel = [&]() {
+    for (unsigned i = 0; i < num_workers; ++i) {
+      if (running[i]) {
+        solvers[i]->interrupt();
+        if (m_inc_muc) {
+          inc_mucs[i]->get_solver().interrupt();
+        }
+      }
+    }
+    if (enumerating) {
+      m_boolean_solver->interrupt();
+    }
+  };
+
+  // -- interrupt the retries still running once the retry budget is
+  // -- spent, since some theories do not honor timeouts. Requires mtx.
+  auto cancel_expired_retries = [&]() {
+    if (retrying == 0 || !m_retry_budget.bounded() ||
+        !m_retry_budget.expired()) {
+      return false;
+    }
+    for (unsigned i = 0; i < num_workers; ++i) {
+      if (retrying_worker[i]) {
+        solvers[i]->interrupt();
+      }
+    }
+    return true;
+  };
+  // -- wait for cv, but not past the deadline of the retries. Requires mtx.
+  auto wait_answer = [&](std::unique_lock<std::mutex> &lock) {
+    if (cancel_expired_retries()) {
+      answer_cv.wait_for(lock, std::chrono::milliseconds(10));
+    } else if (retrying > 0 && m_retry_budget.bounded()) {
+      answer_cv.wait_until(lock, m_retry_budget.deadline());
+    } else {
+      answer_cv.wait(lock);
+    }
+  };
+
+  auto worker = [&](unsigned i) {
+    // -- requires mtx
+    auto can_retry = [&] {
+      return !done && !m_unsolved_path_formulas.empty() &&
+             retrying + 1 < num_workers && !m_retry_budget.expired();
+    };
+    while (true) {
+      PathQuery q;
+      path_bmc::unsolved_path_queue::path p;
+      bool retry = false;
+      unsigned timeout = 0;
+      {
+        std::unique_lock<std::mutex> lock(mtx);
+        query_cv.wait(lock, [&] {
+          return winner >= 0 || done || !queries.empty() || can_retry();
+        });
+        if (winner >= 0) {
+          break;
+        }
+        if (!queries.empty()) {
+          q = std::move(queries.front());
+          queries.pop_front();
+        } else if (can_retry()) {
+          p = m_unsolved_path_formulas.pop();
+          retry = true;
+          ++retrying;
+          retrying_worker[i] = 1;
+          // -- same budget and cap as retry_unsolved_paths
+          m_retry_budget.start();
+          timeout = m_retry_budget.time_left();
+          answer_cv.notify_one();
+        } else {
+          break;
+        }
+        running[i] = 1;
+      }
+
+      if (retry) {
+        solver::SolverResult res;
+        try {
+          res = retry_path(*solvers[i], p, timeout);
+        } catch (...) {
+          res = solver::SolverResult::UNKNOWN;
+        }
+
+        std::lock_guard<std::mutex> lock(mtx);
+        running[i] = 0;
+        --retrying;
+        retrying_worker[i] = 0;
+        ++retry_attempts;
+        if (winner >= 0) {
+          break;
+        }
+        if (res == solver::SolverResult::SAT) {
+          winner = i;
+          sat_model = solvers[i]->get_model();
+          sat_query.id = p.id;
+          sat_query.formula = std::move(p.formula);
+          sat_retry = true;
+          cancel();
+          answer_cv.notify_one();
+        } else if (res == solver::SolverResult::UNSAT) {
+          retry_unsat.push_back(p.id);
+        } else {
+          m_unsolved_path_formulas.push(std::move(p));
+        }
+        query_cv.notify_one();
+        continue;
+      }
+      answer_cv.notify_one();
+
+      PathAnswer a;
+      a.id = q.id;
+      a.solver_calls = 0;
+      // -- an interrupt that arrives outside of a check (e.g., while
+      // -- computing a core) makes the solver throw
+      a.res = path_bmc::solve_path_guarded(
+          [&](ExprVector &path_cond, unsigned &calls) {
+            return solve_path(*solvers[i],
+                              m_inc_muc ? inc_mucs[i].get() : nullptr,
+                              q.formula, q.bool_map, path_cond, calls);
+          },
+          q.bool_map, a.path_cond, a.solver_calls);
+
+      std::lock_guard<std::mutex> lock(mtx);
+      running[i] = 0;
+      if (winner >= 0) {
+        break;
+      }
+      if (a.res == solver::SolverResult::SAT) {
+        winner = i;
+        sat_model = m_inc_muc ? inc_mucs[i]->get_solver().get_model()
+                              : solvers[i]->get_model();
+        sat_query = std::move(q);
+        cancel();
+      } else {
+        if (a.res != solver::SolverResult::UNSAT) {
+          a.res = solver::SolverResult::UNKNOWN;
+          if (SmtOutDir != "") {
+            a.formula = q.formula;
+          }
+          m_unsolved_path_formulas.push(q.id, std::move(q.formula),
+                                        PathTimeout);
+          query_cv.notify_one();
+        }
+        answers.push_back(std::move(a));
+        --pending;
+      }
+      answer_cv.notify_one();
+    }
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      --active;
+    }
+    answer_cv.notify_one();
+  };
+
+  // -- the stats of the enumeration are updated while the workers run
+  Stats::CounterId num_paths_stat =
+      Stats::counter("BMC total number of symbolic paths");
+  Stats::CounterId unknown_paths_stat =
+      Stats::counter("BMC total number of unknown symbolic paths");
+  Stats::CounterId smt_paths_stat =
+      Stats::counter("BMC number symbolic paths discharged by SMT");
+  Stats::TimerId get_model_timer = Stats::timer("BMC path-based: get model");
+  Stats::TimerId cex_timer = Stats::timer("BMC path-based: create a cex");
+
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < num_workers; ++i) {
+    threads.emplace_back(worker, i);
+  }
+
+  bool exhausted = false;
+  while (true) {
+    std::vector<PathAnswer> ready;
+    {
+      std::unique_lock<std::mutex> lock(mtx);
+      // -- keep about two queries per worker waiting
+      while (!(winner >= 0 || !answers.empty() ||
+               (exhausted ? pending == 0
+                          : queries.size() < 2 * num_workers))) {
+        wait_answer(lock);
+      }
+      if (winner >= 0) {
+        break;
+      }
+      ready.swap(answers);
+      if (exhausted && pending == 0 && ready.empty()) {
+        break;
+      }
+    }
+
+    // -- refine the Boolean abstraction with the answers
+    for (PathAnswer &a : ready) {
+      Stats::avg("BMC path-based: solver calls per path", a.solver_calls);
+      if (a.res == solver::SolverResult::UNKNOWN) {
+        Stats::count(unknown_paths_stat);
+        if (SmtOutDir != "") {
+          to_smt_lib(a.formula, "unknown", a.id);
+        }
+      }
+      // -- the path is already blocked. A clause from a core can also
+      // -- be learned twice since paths are solved out of order
+      Expr bc = mk_blocking_clause(a.path_cond);
+      if (m_blocking_clauses.insert(bc).second) {
+        LOG("bmc-details",
+            errs() << "Added blocking clause to refine Boolean abstraction: "
+                   << *bc << "\n";);
+        m_boolean_solver->add(bc);
+      }
+      Stats::count(smt_paths_stat);
+    }
+
+    if (exhausted) {
+      continue;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      if (winner >= 0) {
+        break;
+      }
+      enumerating = true;
+    }
+    solve_bool_abstraction();
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      enumerating = false;
+      if (winner >= 0) {
+        break;
+      }
+    }
+
+    if (m_result != solver::SolverResult::SAT) {
+      // -- wait for the answers of the paths being solved
+      exhausted = true;
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        done = true;
+      }
+      query_cv.notify_all();
+      continue;
+    }
+    ++m_num_paths;
+    Stats::count(num_paths_stat);
+
+    LOG("bmc", get_os(true) << m_num_paths << ": enumerated\n");
+    Stats::resume(get_model_timer);
+    solver::Solver::model_ref model = m_boolean_solver->get_model();
+    Stats::stop(get_model_timer);
+
+    Stats::resume(cex_timer);
+    PathBmcTrace cex(*this, model);
+    Stats::stop(cex_timer);
+
+    PathQuery q;
+    q.id = m_num_paths;
+    q.formula = cex.get_implicant_formula();
+    q.bool_map = cex.get_implicant_bools_map();
+
+    // -- block the whole path until a worker learns a better clause
+    // -- (same clause as the one learned if the path is unknown)
+    Expr bc = mk_blocking_clause(path_bmc::whole_path_cond(q.bool_map));
+    m_blocking_clauses.insert(bc);
+    m_boolean_solver->add(bc);
+
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      queries.push_back(std::move(q));
+      ++pending;
+    }
+    query_cv.notify_one();
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+    done = true;
+    query_cv.notify_all();
+    // -- keep interrupting until every worker exits. An interrupt that
+    // -- arrives before a solver starts a check can be lost.
+    while (active > 0) {
+      if (winner >= 0) {
+        cancel();
+      }
+      cancel_expired_retries();
+      answer_cv.wait_for(lock, std::chrono::milliseconds(10));
+    }
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  Stats::add("bmc.retry.attempts", retry_attempts);
+  for (unsigned id : retry_unsat) {
+    set_retry_status(id, "unsat");
+  }
+  if (winner >= 0) {
+    if (sat_retry) {
+      set_retry_status(sat_query.id, "sat");
+    }
+    LOG("bmc", get_os(true) << "Path " << sat_query.id << " proved sat!\n";);
+    // -- the model refers to the solver of the winner
+    std::swap(m_smt_path_solver, solvers[winner]);
+    if (m_inc_muc) {
+      std::swap(m_inc_muc, inc_mucs[winner]);
+    }
+    m_model = sat_model;
+    m_result = solver::SolverResult::SAT;
+    if (SmtOutDir != "") {
+      to_smt_lib(sat_query.formula, "sat", sat_query.id);
+    }
+  }
+}
+
+solver::SolverResult
+PathBmcEngine::retry_path(solver::Solver &solver,
+                          path_bmc::unsolved_path_queue::path &p,
+                          unsigned max_timeout) const {
+  unsigned timeout = std::min(p.next_timeout(), max_timeout);
+  solver.reset();
+  for (Expr e : p.formula) {
+    solver.add(e);
+  }
+  solver::SolverResult res;
+  {
+    path_bmc::scoped_solver ss(solver, timeout);
+    res = ss.get().check();
+  }
+  p.timeout = timeout;
+  ++p.attempts;
+
+  if (res == solver::SolverResult::SAT) {
+    LOG("bmc", get_os(true) << "Path " << p.id << " proved sat!\n";);
+  } else if (res == solver::SolverResult::UNSAT) {
+    LOG("bmc", get_os(true) << "Path " << p.id << " proved unsat!\n";);
+  } else {
+    LOG("bmc", get_os(true) << "Path " << p.id
+                            << " cannot be proved unsat with timeout="
+                            << timeout << "\n";);
+  }
+  return res;
+}
+
+/*
+  Retry unsolved paths until one is sat or all are unsat.
+
+  Each worker takes the easiest path of m_unsolved_path_formulas and
+  tries again with twice the last timeout. The timeout of an attempt
+  never exceeds what is left of --horn-bmc-retry-budget, and solvers
+  still running when the budget runs out are interrupted since some
+  theories do not honor timeouts. The outcome of every path is in
+  Stats.
+*/
+void PathBmcEngine::retry_unsolved_paths(unsigned num_workers) {
+  // -- the budget may already be in use by retries interleaved with
+  // -- solve_paths_in_parallel
+  m_retry_budget.start();
+  const bool bounded = m_retry_budget.bounded();
+  auto time_left = [&]() { return m_retry_budget.time_left(); };
+
+  num_workers = std::max(
+      1u, std::min<unsigned>(num_workers, m_unsolved_path_formulas.size()));
+  // -- a single worker uses m_smt_path_solver
+  std::vector<std::unique_ptr<solver::Solver>> solvers;
+  for (unsigned i = 0; num_workers > 1 && i < num_workers; ++i) {
+    solvers.push_back(mkSolver(SmtSolver, sem().efac()));
+  }
+  auto get_solver = [&](unsigned i) -> solver::Solver & {
+    return num_workers > 1 ? *solvers[i] : *m_smt_path_solver;
+  };
+
+  std::mutex mtx;
+  std::condition_variable cv;
+  // -- paths taken by a worker
+  unsigned in_flight = 0;
+  unsigned active = num_workers;
+  unsigned attempts = 0;
+  std::vector<char> running(num_workers, 0);
+  std::vector<unsigned> unsat;
+  int winner = -1;
+  path_bmc::unsolved_path_queue::path sat_path;
+  solver::Solver::model_ref sat_model;
+
+  // -- interrupt every solver still running. Requires mtx.
+  auto cancel = [&]() {
+    for (unsigned i = 0; i < num_workers; ++i) {
+      if (running[i]) {
+        get_solver(i).interrupt();
+      }
+    }
+  };
+
+  auto worker = [&](unsigned i) {
+    while (true) {
+      path_bmc::unsolved_path_queue::path p;
+      unsigned timeout;
+      {
+        std::unique_lock<std::mutex> lock(mtx);
+        // -- a path being retried by another worker may come back
+        cv.wait(lock, [&] {
+          return winner >= 0 || !m_unsolved_path_formulas.empty() ||
+                 in_flight == 0;
+        });
+        timeout = time_left();
+        if (winner >= 0 || m_unsolved_path_formulas.empty() || timeout == 0) {
+          break;
+        }
+        p = m_unsolved_path_formulas.pop();
+        ++in_flight;
+        running[i] = 1;
+      }
+
+      solver::SolverResult res;
+      try {
+        res = retry_path(get_solver(i), p, timeout);
+      } catch (...) {
+        // -- an interrupt that arrives outside of a check
+        res = solver::SolverResult::UNKNOWN;
+      }
+
+      std::lock_guard<std::mutex> lock(mtx);
+      running[i] = 0;
+      --in_flight;
+      ++attempts;
+      if (winner < 0) {
+        if (res == solver::SolverResult::SAT) {
+          winner = i;
+          sat_model = get_solver(i).get_model();
+          sat_path = std::move(p);
+          cancel();
+        } else if (res == solver::SolverResult::UNSAT) {
+          unsat.push_back(p.id);
+        } else {
+          // -- put it back and try next time with a bigger timeout
+          m_unsolved_path_formulas.push(std::move(p));
+        }
+      }
+      cv.notify_all();
+    }
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      --active;
+    }
+    cv.notify_all();
+  };
+
+  // -- workers run on their own threads, even if there is only one,
+  // -- so that this thread can interrupt them
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < num_workers; ++i) {
+    threads.emplace_back(worker, i);
+  }
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+    // -- keep interrupting until every worker exits. An interrupt that
+    // -- arrives before a solver starts a check can be lost.
+    while (active > 0) {
+      if (winner >= 0 || (bounded && m_retry_budget.expired())) {
+        cancel();
+        cv.wait_for(lock, std::chrono::milliseconds(10));
+      } else if (bounded) {
+        cv.wait_until(lock, m_retry_budget.deadline());
+      } else {
+        cv.wait(lock);
+      }
+    }
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  Stats::add("bmc.retry.attempts", attempts);
+  for (unsigned id : unsat) {
+    set_retry_status(id, "unsat");
+  }
+  for (auto &p : m_unsolved_path_formulas.paths()) {
+    set_retry_status(p.id, "unknown");
+  }
+  Stats::uset("BMC total number of unknown symbolic paths",
+              m_unsolved_path_formulas.size());
+
+  if (winner >= 0) {
+    set_retry_status(sat_path.id, "sat");
+    // -- the model refers to the solver of the winner
+    if (num_workers > 1) {
+      std::swap(m_smt_path_solver, solvers[winner]);
+    }
+    m_model = sat_model;
+    m_result = solver::SolverResult::SAT;
+    if (SmtOutDir != "") {
+      to_smt_lib(sat_path.formula, "sat", sat_path.id);
+    }
+  } else if (m_unsolved_path_formulas.empty()) {
+    // -- we were able to discharge all the paths!
+    m_result = solver::SolverResult::UNSAT;
+  } else {
+    WARN << "Path-based BMC ran out of time retrying "
+         << m_unsolved_path_formulas.size() << " unsolved paths";
+    m_result = solver::SolverResult::UNKNOWN;
+  }
+}
+
 solver::SolverResult PathBmcEngine::solve() {
   LOG("bmc", get_os(true) << "Starting path-based BMC \n";);
 
@@ -1030,6 +1741,15 @@ solver::SolverResult PathBmcEngine::solve() {
   Stats::resume("BMC path-based: initial boolean abstraction");
   ExprVector abs_side;
   path_bmc::bool_abstraction(m_precise_side, abs_side);
+  if (PathAig) {
+    ExprVector aig_side;
+    op::boolop::aig(abs_side, aig_side);
+    abs_side.clear();
+    // -- facts that became true are dropped
+    std::copy_if(aig_side.begin(), aig_side.end(),
+                 std::back_inserter(abs_side),
+                 [](Expr e) { return !isOpX<TRUE>(e); });
+  }
   // XXX: we use m_boolean_solver for keeping the abstraction.
   for (Expr v : abs_side) {
     LOG("bmc-details", errs() << "\t" << *v << "\n";);
@@ -1045,149 +1765,122 @@ solver::SolverResult PathBmcEngine::solve() {
    * unsat, blocking clauses are added to avoid exploring the same
    * path.
    **/
-  while (true) {
-    solve_bool_abstraction();
-    
-    // keep going while we can generate a path from the boolean
-    // abstraction
-    if (m_result != solver::SolverResult::SAT) {
-      break;
+  m_retry_budget = path_bmc::retry_budget(RetryBudget);
+  const bool parallel = PathWorkers > 1 && !UseCrabForSolvingPaths;
+  if (PathWorkers > 1 && UseCrabForSolvingPaths) {
+    WARN << "--horn-bmc-path-workers only applies to unsolved paths with "
+            "--horn-bmc-crab";
+  }
+
+  if (parallel) {
+    // -- Same loop as below but paths are solved by several threads
+    Stats::uset("bmc.path_workers", PathWorkers);
+    Stats::resume("BMC path-based: parallel path solving");
+    solve_paths_in_parallel(PathWorkers);
+    Stats::stop("BMC path-based: parallel path solving");
+    if (m_result == solver::SolverResult::SAT) {
+      return m_result;
     }
-    ++m_num_paths;
-    Stats::count("BMC total number of symbolic paths");
+  } else {
+    while (true) {
+      solve_bool_abstraction();
+    
+      // keep going while we can generate a path from the boolean
+      // abstraction
+      if (m_result != solver::SolverResult::SAT) {
+        break;
+      }
+      ++m_num_paths;
+      Stats::count("BMC total number of symbolic paths");
 
-    LOG("bmc", get_os(true) << m_num_paths << ": ");
-    Stats::resume("BMC path-based: get model");
-    solver::Solver::model_ref model = m_boolean_solver->get_model();
-    Stats::stop("BMC path-based: get model");
+      LOG("bmc", get_os(true) << m_num_paths << ": ");
+      Stats::resume("BMC path-based: get model");
+      solver::Solver::model_ref model = m_boolean_solver->get_model();
+      Stats::stop("BMC path-based: get model");
 
-    LOG("bmc-details", errs() << "Model " << m_num_paths << " found: \n"
-                              << *model << "\n";);
+      LOG("bmc-details", errs() << "Model " << m_num_paths << " found: \n"
+                                << *model << "\n";);
 
-    Stats::resume("BMC path-based: create a cex");
-    PathBmcTrace cex(*this, model);
-    Stats::stop("BMC path-based: create a cex");
-
-    expr_invariants_map_t path_constraints;
-    if (UseCrabForSolvingPaths) {
-      crab_invariants_map_t crab_path_constraints /*unused*/;
-      bool keep_path_constraints = false;
-      Stats::resume("BMC path-based: solving path + learning clauses with AI");
-      bool res = path_encoding_and_solve_with_ai(cex, keep_path_constraints,
-						 crab_path_constraints, path_constraints);
-      Stats::stop("BMC path-based: solving path + learning clauses with AI");
-
-      LOG("bmc-ai", if (!path_constraints.empty()) {
-        errs() << "\nPath constraints (post-conditions) inferred by AI\n";
-        for (auto &kv : path_constraints) {
-          errs() << "\t" << kv.first->getName() << ": ";
-          if (kv.second.empty()) {
-            errs() << "true\n";
-          } else {
-            errs() << "{";
-            for (auto e : kv.second) {
-              errs() << *e << ";";
+      Stats::resume("BMC path-based: create a cex");
+      PathBmcTrace cex(*this, model);
+      Stats::stop("BMC path-based: create a cex");
+
+      expr_invariants_map_t path_constraints;
+      if (UseCrabForSolvingPaths) {
+        crab_invariants_map_t crab_path_constraints /*unused*/;
+        bool keep_path_constraints = false;
+        Stats::resume("BMC path-based: solving path + learning clauses with AI");
+        bool res = path_encoding_and_solve_with_ai(cex, keep_path_constraints,
+  						 crab_path_constraints, path_constraints);
+        Stats::stop("BMC path-based: solving path + learning clauses with AI");
+
+        LOG("bmc-ai", if (!path_constraints.empty()) {
+          errs() << "\nPath constraints (post-conditions) inferred by AI\n";
+          for (auto &kv : path_constraints) {
+            errs() << "\t" << kv.first->getName() << ": ";
+            if (kv.second.empty()) {
+              errs() << "true\n";
+            } else {
+              errs() << "{";
+              for (auto e : kv.second) {
+                errs() << *e << ";";
+              }
+              errs() << "}\n";
             }
-            errs() << "}\n";
+          }
+        });
+
+        if (!res) {
+          bool ok = block_path();
+          if (ok) {
+            Stats::count("BMC number symbolic paths discharged by AI");
+            continue;
+          } else {
+            ERR << "Path-based BMC added the same blocking clause again";
+            m_result = solver::SolverResult::UNKNOWN;
+            return m_result;
           }
         }
-      });
+      }
 
-      if (!res) {
+      Stats::resume("BMC path-based: solving path + learning clauses with SMT");
+      // XXX: the semantics of invariants and path_constraints (e.g.,
+      // linear integer arithmetic) might differ from the semantics used
+      // by the smt (e.g., bitvectors).
+      solver::SolverResult res = path_encoding_and_solve_with_smt(
+          cex, invariants, path_constraints /*unused*/);
+      Stats::stop("BMC path-based: solving path + learning clauses with SMT");
+      if (res == solver::SolverResult::SAT) {
+        if (UseCrabForSolvingPaths) {
+          // Temporary: for profiling crab
+          crab::CrabStats::PrintBrunch(crab::outs());
+        }
+        m_result = res;
+        return res;
+      } else {
+        // if res is unknown we still add a blocking clause to skip
+        // the path.
         bool ok = block_path();
-        if (ok) {
-          Stats::count("BMC number symbolic paths discharged by AI");
-          continue;
-        } else {
+        if (!ok) {
           ERR << "Path-based BMC added the same blocking clause again";
           m_result = solver::SolverResult::UNKNOWN;
           return m_result;
         }
+        Stats::count("BMC number symbolic paths discharged by SMT");
       }
     }
-
-    Stats::resume("BMC path-based: solving path + learning clauses with SMT");
-    // XXX: the semantics of invariants and path_constraints (e.g.,
-    // linear integer arithmetic) might differ from the semantics used
-    // by the smt (e.g., bitvectors).
-    solver::SolverResult res = path_encoding_and_solve_with_smt(
-        cex, invariants, path_constraints /*unused*/);
-    Stats::stop("BMC path-based: solving path + learning clauses with SMT");
-    if (res == solver::SolverResult::SAT) {
-      if (UseCrabForSolvingPaths) {
-        // Temporary: for profiling crab
-        crab::CrabStats::PrintBrunch(crab::outs());
-      }
-      m_result = res;
-      return res;
-    } else {
-      // if res is unknown we still add a blocking clause to skip
-      // the path.
-      bool ok = block_path();
-      if (!ok) {
-        ERR << "Path-based BMC added the same blocking clause again";
-        m_result = solver::SolverResult::UNKNOWN;
-        return m_result;
-      }
-      Stats::count("BMC number symbolic paths discharged by SMT");
-    }
   }
 
   if (!m_unsolved_path_formulas.empty()) {
-    m_result = solver::SolverResult::UNKNOWN;
-
     LOG("bmc",
         get_os()
             << "Checking again unsolved paths with increasing timeout ...\n");
-    // XXX: can be user parameter
-    const unsigned timeout_delta = 10; // (seconds)
-    std::unordered_map<unsigned, unsigned> timeout_map;
-    while (!m_unsolved_path_formulas.empty()) {
-      auto kv = m_unsolved_path_formulas.front();
-      m_unsolved_path_formulas.pop();
-
-      m_smt_path_solver->reset();
-      for (Expr e : kv.second) {
-        m_smt_path_solver->add(e);
-      }
-
-      unsigned timeout;
-      auto it = timeout_map.find(kv.first);
-      if (it == timeout_map.end()) {
-        timeout_map.insert(
-            std::make_pair(kv.first, PathTimeout + timeout_delta));
-        timeout = PathTimeout + timeout_delta;
-      } else {
-        timeout = it->second + timeout_delta;
-        it->second = timeout;
-      }
-
-      solver::SolverResult res;
-      {
-        path_bmc::scoped_solver ss(*m_smt_path_solver, timeout);
-        res = ss.get().check();
-      }
-      if (res == solver::SolverResult::SAT) {
-        m_model = m_smt_path_solver->get_model();
-        if (SmtOutDir != "") {
-          to_smt_lib(kv.second, "sat");
-        }
-        LOG("bmc", get_os(true) << "Path " << kv.first << " proved sat!\n";);
-        m_result = solver::SolverResult::SAT;
-        return m_result;
-      } else if (res == solver::SolverResult::UNSAT) {
-        LOG("bmc", get_os(true) << "Path " << kv.first << " proved unsat!\n";);
-      } else {
-        LOG("bmc", get_os(true) << "Path " << kv.first
-                                << " cannot be proved unsat with timeout="
-                                << timeout << "\n";);
-        // put it back in the queue and try next time with a bigger timeout
-        m_unsolved_path_formulas.push(kv);
-      }
+    Stats::resume("BMC path-based: retrying unsolved paths");
+    retry_unsolved_paths(PathWorkers);
+    Stats::stop("BMC path-based: retrying unsolved paths");
+    if (m_result == solver::SolverResult::SAT) {
+      return m_result;
     }
-    // If we reach this point we were able to discharge all the paths!
-    Stats::uset("BMC total number of unknown symbolic paths", 0);
-    m_result = solver::SolverResult::UNSAT;
   }
 
   if (m_num_paths == 0) {
@@ -1202,16 +1895,19 @@ solver::SolverResult PathBmcEngine::solve() {
   return m_result;
 }
 
+Expr PathBmcEngine::mk_blocking_clause(const ExprVector &path_cond) {
+  if (path_cond.empty()) {
+    WARN << "No path condition generated. Trivially unsat ...";
+    return mk<FALSE>(sem().efac());
+  }
+  return op::boolop::lneg(op::boolop::land(path_cond));
+}
+
 bool PathBmcEngine::block_path() {
   Stats::resume("BMC path-based: adding blocking clauses");
 
   // -- Refine the Boolean abstraction
-  Expr bc = mk<FALSE>(sem().efac());
-  if (m_path_cond.empty()) {
-    WARN << "No path condition generated. Trivially unsat ...";
-  } else {
-    bc = op::boolop::lneg(op::boolop::land(m_path_cond));
-  }
+  Expr bc = mk_blocking_clause(m_path_cond);
   LOG("bmc-details",
       errs() << "Added blocking clause to refine Boolean abstraction: " << *bc
              << "\n";);
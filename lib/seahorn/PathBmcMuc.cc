@@ -4,6 +4,8 @@
 #include "seahorn/Expr/ExprLlvm.hh"
 #include "seahorn/Expr/Smt/Solver.hh"
 
+#include <algorithm>
+
 namespace seahorn {
 namespace path_bmc {
 
@@ -23,6 +25,7 @@ void muc_with_assumptions::unsat_core(const ExprVector &f, bool simplify,
 
   ExprVector core;
   m_solver.push();
+  ++m_calls;
   solver::SolverResult res = m_solver.check_with_assumptions(assumptions);
   if (res == solver::SolverResult::UNSAT) {
     m_solver.unsat_core(core);
@@ -38,6 +41,7 @@ void muc_with_assumptions::unsat_core(const ExprVector &f, bool simplify,
       assumptions.assign(core.begin(), core.end());
       core.clear();
       m_solver.push();
+      ++m_calls;
       res = m_solver.check_with_assumptions(assumptions);
       assert(res == solver::SolverResult::UNSAT);
       m_solver.unsat_core(core);
@@ -48,6 +52,7 @@ void muc_with_assumptions::unsat_core(const ExprVector &f, bool simplify,
     for (unsigned i = 0; i < core.size();) {
       Expr saved = core[i];
       core[i] = core.back();
+      ++m_calls;
       res = m_solver.check_with_assumptions(
           llvm::make_range(core.begin(), core.end() - 1));
       if (res == solver::SolverResult::SAT)
@@ -85,6 +90,7 @@ solver::SolverResult deletion_muc::check(deletion_muc::const_iterator it,
   solver::SolverResult res;
   {
     path_bmc::scoped_solver ss(m_solver, m_timeout);
+    ++m_calls;
     res = ss.get().check();
   }
   return res;
@@ -139,6 +145,7 @@ void binary_search_muc::qx(const ExprVector &target, unsigned begin,
                            unsigned end, bool skip, ExprVector &out) {
   if (!skip) {
     path_bmc::scoped_solver ss(m_solver, m_timeout);
+    ++m_calls;
     auto res = ss.get().check();
     if (res == solver::SolverResult::UNSAT) {
       return;
@@ -201,5 +208,110 @@ void binary_search_muc::run(const ExprVector &formula, ExprVector &out) {
   qx(formula, i, j, skip, out);
 }
 
+// -- bounds the state kept by incremental_muc
+static const unsigned IncMucMaxLiterals = 50000;
+static const unsigned IncMucMaxCores = 256;
+
+incremental_muc::incremental_muc(std::unique_ptr<solver::Solver> solver,
+                                 unsigned timeout)
+    : minimal_unsat_core(*solver), m_owned_solver(std::move(solver)),
+      m_timeout(timeout) {}
+
+Expr incremental_muc::literal(Expr e) {
+  Expr a = bind::boolConst(mk<ASM>(e));
+  if (m_asserted.insert(e).second) {
+    m_solver.add(mk<IMPL>(a, e));
+  }
+  return a;
+}
+
+solver::SolverResult incremental_muc::check(const ExprVector &lits,
+                                            unsigned timeout) {
+  path_bmc::scoped_solver ss(m_solver, timeout);
+  ++m_calls;
+  return ss.get().check_with_assumptions(lits);
+}
+
+bool incremental_muc::cached_core(const ExprVector &f, ExprVector &core) {
+  ExprSet fs(f.begin(), f.end());
+  for (auto it = m_cores.rbegin(), et = m_cores.rend(); it != et; ++it) {
+    if (std::all_of(it->begin(), it->end(),
+                    [&fs](Expr e) { return fs.count(e) > 0; })) {
+      core.insert(core.end(), it->begin(), it->end());
+      return true;
+    }
+  }
+  return false;
+}
+
+solver::SolverResult incremental_muc::solve(const ExprVector &f,
+                                            unsigned timeout,
+                                            ExprVector &core) {
+  if (cached_core(f, core)) {
+    return solver::SolverResult::UNSAT;
+  }
+
+  if (m_asserted.size() > IncMucMaxLiterals) {
+    m_solver.reset();
+    m_asserted.clear();
+  }
+
+  ExprVector lits;
+  lits.reserve(f.size());
+  for (Expr e : f) {
+    lits.push_back(literal(e));
+  }
+  solver::SolverResult res = check(lits, timeout);
+  if (res != solver::SolverResult::UNSAT) {
+    return res;
+  }
+
+  // -- minimize the core by deletion. If a check is unsat then its
+  // -- core replaces the current one. Literals before i are needed.
+  ExprVector lcore;
+  m_solver.unsat_core(lcore);
+  for (unsigned i = 0; i < lcore.size();) {
+    Expr saved = lcore[i];
+    lcore[i] = lcore.back();
+    lcore.pop_back();
+    solver::SolverResult r = check(lcore, m_timeout);
+    if (r == solver::SolverResult::UNSAT) {
+      ExprVector c;
+      m_solver.unsat_core(c);
+      ExprSet cs(c.begin(), c.end());
+      // -- a literal kept after a timeout might not be in the new core
+      i = std::count_if(lcore.begin(), lcore.begin() + i,
+                        [&cs](Expr e) { return cs.count(e) > 0; });
+      lcore.erase(std::remove_if(lcore.begin(), lcore.end(),
+                                 [&cs](Expr e) { return cs.count(e) == 0; }),
+                  lcore.end());
+    } else {
+      // -- sat or timeout: keep it. Put it back in place of the
+      // -- literal that filled its slot, which is the end if i was last.
+      lcore.push_back(saved);
+      std::swap(lcore[i++], lcore.back());
+    }
+  }
+
+  // unwrap the core from ASM to corresponding expressions
+  ExprVector out;
+  out.reserve(lcore.size());
+  for (Expr c : lcore) {
+    out.push_back(bind::fname(bind::fname(c))->arg(0));
+  }
+  core.insert(core.end(), out.begin(), out.end());
+  m_cores.push_back(std::move(out));
+  if (m_cores.size() > IncMucMaxCores) {
+    m_cores.pop_front();
+  }
+  return res;
+}
+
+void incremental_muc::run(const ExprVector &f, ExprVector &core) {
+  if (solve(f, m_timeout, core) != solver::SolverResult::UNSAT) {
+    core.assign(f.begin(), f.end());
+  }
+}
+
 } // namespace path_bmc
 } // namespace seahorn
@@ -4,21 +4,32 @@
 #ifdef WITH_YICES2
 #include "seahorn/Expr/Smt/Yices2SolverImpl.hh"
 #endif
+#include "seahorn/Expr/Smt/PortfolioSolverImpl.hh"
 #include "seahorn/Expr/Smt/Z3SolverImpl.hh"
 
+#include <algorithm>
+#include <climits>
+
 namespace seahorn {
 namespace path_bmc {
 
-scoped_solver::scoped_solver(solver::Solver &solver, unsigned timeout /*sec*/)
-    : m_solver(solver) {
-  if (m_solver.get_kind() == solver::SolverKind::Z3) {
+/* Set the timeout (sec) of a solver. UINT_MAX disables it */
+static void set_timeout(solver::Solver &solver, unsigned timeout) {
+  if (solver.get_kind() == solver::SolverKind::Z3) {
     solver::z3_solver_impl &z3 =
-        static_cast<solver::z3_solver_impl &>(m_solver);
+        static_cast<solver::z3_solver_impl &>(solver);
     ZParams<EZ3> params(z3.get_context());
     // We should check here for possible overflow if timeout is
     // given, e.g., in miliseconds.
-    params.set(":timeout", timeout * 1000);
+    params.set(":timeout", timeout == UINT_MAX ? 4294967295u : timeout * 1000);
     z3.get_solver().set(params);
+  } else if (solver.get_kind() == solver::SolverKind::PORTFOLIO) {
+    // -- the portfolio interrupts all its solvers when the time is up
+    solver::portfolio_solver_impl &portfolio =
+        static_cast<solver::portfolio_solver_impl &>(solver);
+    portfolio.set_timeout(timeout == UINT_MAX ? 0 : timeout);
+    for (auto &s : portfolio.solvers())
+      set_timeout(*s, timeout);
   } else {
 #ifdef WITH_YICES2
     // TODOX: add timeout capabilities to Yices2
@@ -26,16 +37,88 @@ scoped_solver::scoped_solver(solver::Solver &solver, unsigned timeout /*sec*/)
   }
 }
 
+scoped_solver::scoped_solver(solver::Solver &solver, unsigned timeout /*sec*/)
+    : m_solver(solver) {
+  set_timeout(m_solver, timeout);
+}
+
 scoped_solver::~scoped_solver() {
-  if (m_solver.get_kind() == solver::SolverKind::Z3) {
-    solver::z3_solver_impl &z3 =
-        static_cast<solver::z3_solver_impl &>(m_solver);
-    ZParams<EZ3> params(z3.get_context());
-    params.set(":timeout", 4294967295u); // disable timeout
-    z3.get_solver().set(params);
+  set_timeout(m_solver, UINT_MAX); // disable timeout
+}
+
+/* Order of the heap: true if p1 looks harder than p2 */
+static bool harder(const unsolved_path_queue::path &p1,
+                   const unsolved_path_queue::path &p2) {
+  if (p1.timeout != p2.timeout)
+    return p1.timeout > p2.timeout;
+  return p1.size > p2.size;
+}
+
+void unsolved_path_queue::push(unsigned id, expr::ExprVector formula,
+                               unsigned timeout) {
+  path p;
+  p.id = id;
+  p.size = expr::dagSize(formula);
+  p.formula = std::move(formula);
+  p.timeout = timeout;
+  p.attempts = 0;
+  push(std::move(p));
+}
+
+void unsolved_path_queue::push(path p) {
+  m_heap.push_back(std::move(p));
+  std::push_heap(m_heap.begin(), m_heap.end(), harder);
+}
+
+unsolved_path_queue::path unsolved_path_queue::pop() {
+  assert(!m_heap.empty());
+  std::pop_heap(m_heap.begin(), m_heap.end(), harder);
+  path p = std::move(m_heap.back());
+  m_heap.pop_back();
+  return p;
+}
+
+void retry_budget::start() {
+  if (m_started) {
+    return;
+  }
+  m_started = true;
+  m_deadline = clock::now() + std::chrono::seconds(m_budget);
+}
+
+unsigned retry_budget::time_left() const {
+  if (!bounded()) {
+    return UINT_MAX;
+  }
+  if (!m_started) {
+    return m_budget;
   }
+  auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                  m_deadline - clock::now())
+                  .count();
+  return left > 0 ? (left + 999) / 1000 : 0;
 }
 
+expr::ExprVector whole_path_cond(const expr::ExprMap &bool_map) {
+  expr::ExprSet path_cond_set;
+  for (auto &kv : bool_map) {
+    path_cond_set.insert(kv.second);
+  }
+  return expr::ExprVector(path_cond_set.begin(), path_cond_set.end());
+}
+
+solver::SolverResult solve_path_guarded(
+    const std::function<solver::SolverResult(expr::ExprVector &, unsigned &)>
+        &solve,
+    const expr::ExprMap &bool_map, expr::ExprVector &path_cond,
+    unsigned &solver_calls) {
+  try {
+    return solve(path_cond, solver_calls);
+  } catch (...) {
+    path_cond = whole_path_cond(bool_map);
+    return solver::SolverResult::UNKNOWN;
+  }
+}
 
 namespace expr_utils {
 bool isEdge(Expr e) {
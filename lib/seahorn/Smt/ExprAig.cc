@@ -0,0 +1,537 @@
+/// And-Inverter Graphs over the Boolean structure of expressions
+#include "seahorn/Expr/ExprAig.hh"
+#include "seahorn/Expr/Expr.hh"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/CommandLine.h"
+
+#include "z3++.h"
+
+#include <boost/functional/hash.hpp>
+
+#include <unordered_map>
+
+static llvm::cl::opt<unsigned> FraigChecks(
+    "aig-fraig-checks",
+    llvm::cl::desc("Maximal number of SAT checks used to merge equivalent "
+                   "AIG nodes (0 disables fraiging)"),
+    llvm::cl::init(1000));
+
+static llvm::cl::opt<unsigned> FraigRlimit(
+    "aig-fraig-rlimit",
+    llvm::cl::desc("Resource limit of a single fraiging SAT check"),
+    llvm::cl::init(100000));
+
+namespace expr {
+namespace op {
+namespace boolop {
+namespace {
+/// \brief Edge of an AIG: index of the node times two, plus one if negated
+using AigLit = unsigned;
+
+const AigLit AIG_FALSE = 0;
+const AigLit AIG_TRUE = 1;
+
+inline AigLit aigNeg(AigLit l) { return l ^ 1; }
+inline unsigned aigNode(AigLit l) { return l >> 1; }
+inline bool aigIsNeg(AigLit l) { return l & 1; }
+inline AigLit aigLit(unsigned node, bool neg) { return (node << 1) | neg; }
+
+/// \brief Structurally hashed And-Inverter Graph
+///
+/// Node 0 is the constant false. Every other node is either an input,
+/// i.e., an arbitrary expression that is not a Boolean connective, or the
+/// conjunction of two edges. Kids are always created before their parents,
+/// so node indices are in topological order.
+class AigManager {
+  struct Node {
+    AigLit kid0;
+    AigLit kid1;
+    /// index in m_inputs, or -1 for AND nodes
+    int input;
+  };
+
+  std::vector<Node> m_nodes;
+  llvm::DenseMap<std::pair<unsigned, unsigned>, unsigned> m_strash;
+
+  /// expression of every input
+  ExprVector m_inputs;
+  /// input node of an expression, by expression id
+  llvm::DenseMap<unsigned, unsigned> m_inputNode;
+  /// literal of a converted expression, by expression id
+  llvm::DenseMap<unsigned, AigLit> m_exprLit;
+
+  /// \brief Maximal nesting of two-level rewriting
+  static constexpr unsigned MAX_REWRITE_DEPTH = 4;
+
+public:
+  AigManager() { m_nodes.push_back(Node{AIG_FALSE, AIG_FALSE, -1}); }
+
+  size_t numNodes() const { return m_nodes.size(); }
+  bool isInput(unsigned n) const { return m_nodes[n].input >= 0; }
+  bool isAnd(unsigned n) const { return n > 0 && m_nodes[n].input < 0; }
+  bool isAnd(AigLit l, bool neg) const {
+    return isAnd(aigNode(l)) && aigIsNeg(l) == neg;
+  }
+  AigLit kid0(unsigned n) const { return m_nodes[n].kid0; }
+  AigLit kid1(unsigned n) const { return m_nodes[n].kid1; }
+  Expr inputExpr(unsigned n) const { return m_inputs[m_nodes[n].input]; }
+
+  AigLit input(Expr e) {
+    auto it = m_inputNode.find(e->getId());
+    if (it != m_inputNode.end())
+      return aigLit(it->second, false);
+
+    unsigned n = m_nodes.size();
+    m_nodes.push_back(Node{AIG_FALSE, AIG_FALSE, (int)m_inputs.size()});
+    m_inputs.push_back(e);
+    m_inputNode[e->getId()] = n;
+    return aigLit(n, false);
+  }
+
+  /// \brief Conjunction of \p a and \p b
+  ///
+  /// Applies constant propagation and the two-level optimization rules of
+  /// Brummayer and Biere, Local Two-Level And-Inverter Graph Minimization
+  /// without Blowup, MEMICS 2006.
+  AigLit mkAnd(AigLit a, AigLit b, unsigned depth = 0) {
+    if (a > b)
+      std::swap(a, b);
+
+    // -- one-level rules
+    if (a == AIG_FALSE)
+      return AIG_FALSE;
+    if (a == AIG_TRUE || a == b)
+      return b;
+    if (a == aigNeg(b))
+      return AIG_FALSE;
+
+    if (depth < MAX_REWRITE_DEPTH) {
+      AigLit r;
+      if (rewriteAnd(a, b, depth, r) || rewriteAnd(b, a, depth, r))
+        return r;
+      if (rewriteAnd2(a, b, depth, r))
+        return r;
+    }
+
+    auto key = std::make_pair(a, b);
+    auto it = m_strash.find(key);
+    if (it != m_strash.end())
+      return aigLit(it->second, false);
+
+    unsigned n = m_nodes.size();
+    m_nodes.push_back(Node{a, b, -1});
+    m_strash[key] = n;
+    return aigLit(n, false);
+  }
+
+  AigLit mkOr(AigLit a, AigLit b) {
+    return aigNeg(mkAnd(aigNeg(a), aigNeg(b)));
+  }
+  AigLit mkXor(AigLit a, AigLit b) {
+    return mkOr(mkAnd(a, aigNeg(b)), mkAnd(aigNeg(a), b));
+  }
+  AigLit mkIte(AigLit c, AigLit t, AigLit e) {
+    return mkOr(mkAnd(c, t), mkAnd(aigNeg(c), e));
+  }
+
+  /// \brief Converts the Boolean structure of \p root
+  AigLit fromExpr(Expr root);
+
+  /// \brief Converts the cones of \p roots back to expressions
+  void toExpr(const std::vector<AigLit> &roots, ExprFactory &efac,
+              ExprVector &out) const;
+
+  /// \brief Marks the nodes in the cones of \p roots
+  std::vector<bool> cone(const std::vector<AigLit> &roots) const {
+    std::vector<bool> mark(m_nodes.size(), false);
+    std::vector<unsigned> todo;
+    for (AigLit r : roots)
+      todo.push_back(aigNode(r));
+    while (!todo.empty()) {
+      unsigned n = todo.back();
+      todo.pop_back();
+      if (mark[n])
+        continue;
+      mark[n] = true;
+      if (isAnd(n)) {
+        todo.push_back(aigNode(kid0(n)));
+        todo.push_back(aigNode(kid1(n)));
+      }
+    }
+    return mark;
+  }
+
+  /// \brief Number of AND nodes and inputs in the cones of \p roots
+  unsigned size(const std::vector<AigLit> &roots) const {
+    std::vector<bool> mark = cone(roots);
+    unsigned sz = 0;
+    for (unsigned n = 1, e = mark.size(); n < e; ++n)
+      sz += mark[n];
+    return sz;
+  }
+
+private:
+  /// \brief Two-level rules where \p a is compared with the kids of \p b
+  bool rewriteAnd(AigLit a, AigLit b, unsigned depth, AigLit &res) {
+    if (!isAnd(aigNode(b)))
+      return false;
+    AigLit b0 = kid0(aigNode(b)), b1 = kid1(aigNode(b));
+
+    if (!aigIsNeg(b)) {
+      // -- contradiction: (x & y) & !x = 0
+      if (b0 == aigNeg(a) || b1 == aigNeg(a)) {
+        res = AIG_FALSE;
+        return true;
+      }
+      // -- idempotence: (x & y) & x = x & y
+      if (b0 == a || b1 == a) {
+        res = b;
+        return true;
+      }
+      return false;
+    }
+
+    // -- subsumption: !(x & y) & !x = !x
+    if (b0 == aigNeg(a) || b1 == aigNeg(a)) {
+      res = a;
+      return true;
+    }
+    // -- substitution: !(x & y) & x = !y & x
+    if (b0 == a) {
+      res = mkAnd(aigNeg(b1), a, depth + 1);
+      return true;
+    }
+    if (b1 == a) {
+      res = mkAnd(aigNeg(b0), a, depth + 1);
+      return true;
+    }
+    return false;
+  }
+
+  /// \brief Two-level rules where both \p a and \p b are AND nodes
+  bool rewriteAnd2(AigLit a, AigLit b, unsigned depth, AigLit &res) {
+    if (!isAnd(aigNode(a)) || !isAnd(aigNode(b)))
+      return false;
+    AigLit a0 = kid0(aigNode(a)), a1 = kid1(aigNode(a));
+    AigLit b0 = kid0(aigNode(b)), b1 = kid1(aigNode(b));
+    bool na = aigIsNeg(a), nb = aigIsNeg(b);
+    auto opp = [](AigLit x, AigLit y) { return x == aigNeg(y); };
+
+    if (!na && !nb) {
+      // -- contradiction: (x & y) & (!x & z) = 0
+      if (opp(a0, b0) || opp(a0, b1) || opp(a1, b0) || opp(a1, b1)) {
+        res = AIG_FALSE;
+        return true;
+      }
+      return false;
+    }
+
+    if (na && nb) {
+      // -- resolution: !(x & y) & !(x & !y) = !x
+      if ((a0 == b0 && opp(a1, b1)) || (a0 == b1 && opp(a1, b0))) {
+        res = aigNeg(a0);
+        return true;
+      }
+      if ((a1 == b0 && opp(a0, b1)) || (a1 == b1 && opp(a0, b0))) {
+        res = aigNeg(a1);
+        return true;
+      }
+      return false;
+    }
+
+    // -- one negated, one positive AND node
+    if (!na) {
+      std::swap(a, b);
+      std::swap(a0, b0);
+      std::swap(a1, b1);
+    }
+    // -- a = !(a0 & a1), b = (b0 & b1)
+    // -- subsumption: !(x & y) & (!x & z) = !x & z
+    if (opp(a0, b0) || opp(a0, b1) || opp(a1, b0) || opp(a1, b1)) {
+      res = b;
+      return true;
+    }
+    // -- substitution: !(x & y) & (x & z) = !y & (x & z)
+    if (a0 == b0 || a0 == b1) {
+      res = mkAnd(aigNeg(a1), b, depth + 1);
+      return true;
+    }
+    if (a1 == b0 || a1 == b1) {
+      res = mkAnd(aigNeg(a0), b, depth + 1);
+      return true;
+    }
+    return false;
+  }
+};
+
+/// \brief true if \p e is a Boolean term that is not an input
+bool isConnective(ENode *e) {
+  return isOpX<TRUE>(e) || isOpX<FALSE>(e) || isOpX<NEG>(e) ||
+         isOpX<AND>(e) || isOpX<OR>(e) || isOpX<IMPL>(e) || isOpX<IFF>(e) ||
+         isOpX<XOR>(e);
+}
+
+/// \brief true if \p e is an equality between Boolean terms
+bool isBoolEq(ENode *e) {
+  if (!isOpX<EQ>(e) || e->arity() != 2)
+    return false;
+  for (ENode *k : llvm::make_range(e->args_begin(), e->args_end()))
+    if (isConnective(k) || bind::isBoolConst(k))
+      return true;
+  return false;
+}
+
+AigLit AigManager::fromExpr(Expr root) {
+  // -- ITE terms are Boolean only below a connective or at the root
+  auto isGate = [](ENode *n) {
+    return isConnective(n) || isBoolEq(n) || isOpX<ITE>(n);
+  };
+
+  std::vector<std::pair<ENode *, bool>> todo;
+  todo.push_back({root.get(), false});
+  while (!todo.empty()) {
+    ENode *n = todo.back().first;
+    if (m_exprLit.count(n->getId())) {
+      todo.pop_back();
+      continue;
+    }
+
+    if (!isGate(n)) {
+      m_exprLit[n->getId()] = input(n);
+      todo.pop_back();
+      continue;
+    }
+
+    if (!todo.back().second) {
+      todo.back().second = true;
+      for (ENode *k : llvm::make_range(n->args_begin(), n->args_end()))
+        if (!m_exprLit.count(k->getId()))
+          todo.push_back({k, false});
+      continue;
+    }
+    todo.pop_back();
+
+    llvm::SmallVector<AigLit, 4> kids;
+    for (ENode *k : llvm::make_range(n->args_begin(), n->args_end()))
+      kids.push_back(m_exprLit.lookup(k->getId()));
+
+    AigLit res;
+    if (isOpX<TRUE>(n))
+      res = AIG_TRUE;
+    else if (isOpX<FALSE>(n))
+      res = AIG_FALSE;
+    else if (isOpX<NEG>(n))
+      res = aigNeg(kids[0]);
+    else if (isOpX<AND>(n)) {
+      res = AIG_TRUE;
+      for (AigLit k : kids)
+        res = mkAnd(res, k);
+    } else if (isOpX<OR>(n)) {
+      res = AIG_FALSE;
+      for (AigLit k : kids)
+        res = mkOr(res, k);
+    } else if (isOpX<XOR>(n)) {
+      res = AIG_FALSE;
+      for (AigLit k : kids)
+        res = mkXor(res, k);
+    } else if (isOpX<IMPL>(n))
+      res = mkOr(aigNeg(kids[0]), kids[1]);
+    else if (isOpX<IFF>(n) || isOpX<EQ>(n))
+      res = aigNeg(mkXor(kids[0], kids[1]));
+    else {
+      assert(isOpX<ITE>(n));
+      res = mkIte(kids[0], kids[1], kids[2]);
+    }
+    m_exprLit[n->getId()] = res;
+  }
+  return m_exprLit.lookup(root->getId());
+}
+
+void AigManager::toExpr(const std::vector<AigLit> &roots, ExprFactory &efac,
+                        ExprVector &out) const {
+  std::vector<bool> mark = cone(roots);
+  // -- expression of every node in the cone. Kids precede their parents
+  ExprVector node(m_nodes.size());
+  auto lit = [&node](AigLit l) {
+    Expr e = node[aigNode(l)];
+    return aigIsNeg(l) ? lneg(e) : e;
+  };
+
+  node[0] = mk<FALSE>(efac);
+  for (unsigned n = 1, e = m_nodes.size(); n < e; ++n) {
+    if (!mark[n])
+      continue;
+    if (isInput(n))
+      node[n] = inputExpr(n);
+    else
+      node[n] = mk<AND>(lit(kid0(n)), lit(kid1(n)));
+  }
+
+  for (AigLit r : roots)
+    out.push_back(lit(r));
+}
+
+/// \brief Hash of a simulation signature
+struct SigHash {
+  size_t operator()(const std::vector<uint64_t> &sig) const {
+    return boost::hash_range(sig.begin(), sig.end());
+  }
+};
+
+/// \brief Number of 64-bit simulation words per node
+const unsigned SIM_WORDS = 4;
+
+/// \brief Merges nodes of \p src that are functionally equivalent
+///
+/// Nodes are simulated on random input patterns. A node whose signature
+/// matches (possibly negated) that of an earlier node is merged into it if a
+/// SAT check proves them equivalent. The result is built in \p dst and
+/// \p roots are updated to refer to it.
+void fraig(const AigManager &src, std::vector<AigLit> &roots,
+           AigManager &dst) {
+  std::vector<bool> mark = src.cone(roots);
+  size_t sz = src.numNodes();
+
+  // -- simulation
+  std::vector<uint64_t> sim(sz * SIM_WORDS, 0);
+  uint64_t seed = 0x9E3779B97F4A7C15ULL;
+  auto rand = [&seed]() {
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return seed;
+  };
+  auto simLit = [&sim](AigLit l, unsigned w) {
+    uint64_t v = sim[aigNode(l) * SIM_WORDS + w];
+    return aigIsNeg(l) ? ~v : v;
+  };
+  for (unsigned n = 1; n < sz; ++n) {
+    if (!mark[n])
+      continue;
+    for (unsigned w = 0; w < SIM_WORDS; ++w)
+      sim[n * SIM_WORDS + w] =
+          src.isInput(n) ? rand()
+                         : simLit(src.kid0(n), w) & simLit(src.kid1(n), w);
+  }
+
+  // -- z3 encoding of the cone, built on demand
+  z3::context ctx;
+  z3::solver solver(ctx);
+  z3::params params(ctx);
+  params.set("rlimit", (unsigned)FraigRlimit);
+  solver.set(params);
+  std::vector<Z3_ast> zNode(sz, nullptr);
+  z3::expr_vector pinned(ctx);
+  auto zLit = [&](AigLit l) {
+    z3::expr e(ctx, zNode[aigNode(l)]);
+    return aigIsNeg(l) ? !e : e;
+  };
+  auto encode = [&](unsigned n) {
+    z3::expr e = n == 0 ? ctx.bool_val(false)
+                 : src.isInput(n)
+                     ? ctx.bool_const(("i!" + std::to_string(n)).c_str())
+                     : zLit(src.kid0(n)) && zLit(src.kid1(n));
+    pinned.push_back(e);
+    zNode[n] = e;
+  };
+
+  // -- representative of every signature, possibly negated
+  std::unordered_map<std::vector<uint64_t>, AigLit, SigHash> reps;
+  // -- literal of dst that every node of src is mapped to
+  std::vector<AigLit> map(sz, AIG_FALSE);
+  auto mapLit = [&map](AigLit l) {
+    return map[aigNode(l)] ^ (AigLit)aigIsNeg(l);
+  };
+
+  unsigned checks = FraigChecks;
+  encode(0);
+  reps[std::vector<uint64_t>(SIM_WORDS, 0)] = AIG_FALSE;
+  for (unsigned n = 1; n < sz; ++n) {
+    if (!mark[n])
+      continue;
+    encode(n);
+
+    if (src.isInput(n))
+      map[n] = dst.input(src.inputExpr(n));
+    else
+      map[n] = dst.mkAnd(mapLit(src.kid0(n)), mapLit(src.kid1(n)));
+
+    // -- normalize the signature so that its first bit is 0
+    bool phase = sim[n * SIM_WORDS] & 1;
+    std::vector<uint64_t> sig(SIM_WORDS);
+    for (unsigned w = 0; w < SIM_WORDS; ++w)
+      sig[w] = phase ? ~sim[n * SIM_WORDS + w] : sim[n * SIM_WORDS + w];
+
+    AigLit self = aigLit(n, phase);
+    auto it = reps.find(sig);
+    if (it == reps.end()) {
+      reps.emplace(std::move(sig), self);
+      continue;
+    }
+
+    AigLit rep = it->second;
+    if (src.isInput(n) || mapLit(self) == mapLit(rep) || checks == 0)
+      continue;
+    --checks;
+
+    solver.push();
+    solver.add(zLit(self) != zLit(rep));
+    z3::check_result res = solver.check();
+    solver.pop();
+    if (res == z3::unsat)
+      map[n] = mapLit(rep) ^ (AigLit)phase;
+  }
+
+  for (AigLit &r : roots)
+    r = mapLit(r);
+}
+
+void aigify(const ExprVector &in, ExprVector &out, bool gather) {
+  if (in.empty())
+    return;
+
+  AigManager aig;
+  std::vector<AigLit> roots;
+  for (const Expr &e : in)
+    roots.push_back(aig.fromExpr(e));
+
+  ExprFactory &efac = in.front()->efac();
+  ExprVector res;
+  if (FraigChecks > 0) {
+    AigManager fraiged;
+    fraig(aig, roots, fraiged);
+    fraiged.toExpr(roots, efac, res);
+  } else
+    aig.toExpr(roots, efac, res);
+
+  for (Expr &e : res)
+    out.push_back(gather ? pp(e) : e);
+}
+} // namespace
+
+Expr aig(Expr e, bool gather) {
+  ExprVector in{e}, out;
+  aigify(in, out, gather);
+  return out.front();
+}
+
+void aig(const ExprVector &in, ExprVector &out, bool gather) {
+  aigify(in, out, gather);
+}
+
+unsigned aigSize(Expr e) {
+  AigManager aig;
+  return aig.size({aig.fromExpr(e)});
+}
+
+unsigned aigSize(const ExprVector &vec) {
+  AigManager aig;
+  std::vector<AigLit> roots;
+  for (const Expr &e : vec)
+    roots.push_back(aig.fromExpr(e));
+  return aig.size(roots);
+}
+} // namespace boolop
+} // namespace op
+} // namespace expr
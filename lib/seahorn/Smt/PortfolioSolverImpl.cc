@@ -0,0 +1,171 @@
+#include "seahorn/Expr/Smt/PortfolioSolverImpl.hh"
+#include "seahorn/Support/Stats.hh"
+
+#include "llvm/Support/raw_ostream.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace seahorn {
+namespace solver {
+
+const char *solver_kind_name(SolverKind kind) {
+  switch (kind) {
+  case SolverKind::Z3:
+    return "z3";
+  case SolverKind::YICES2:
+    return "yices2";
+  case SolverKind::PORTFOLIO:
+    return "portfolio";
+  }
+  return "unknown";
+}
+
+portfolio_solver_impl::portfolio_solver_impl(expr::ExprFactory &efac,
+                                             std::vector<solver_ref> solvers)
+    : Solver(), m_efac(efac), m_solvers(std::move(solvers)), m_winner(-1),
+      m_last_result(SolverResult::UNKNOWN), m_timeout(0) {
+  assert(!m_solvers.empty());
+  assert((m_solvers.size() == 1 || m_efac.isConcurrent()) &&
+         "portfolio requires a concurrent expression factory");
+}
+
+SolverResult portfolio_solver_impl::race(
+    const std::function<SolverResult(Solver &)> &check) {
+  m_winner = -1;
+  if (m_solvers.size() == 1) {
+    m_last_result = check(*m_solvers[0]);
+    if (m_last_result == SolverResult::SAT ||
+        m_last_result == SolverResult::UNSAT)
+      m_winner = 0;
+    return m_last_result;
+  }
+
+  std::mutex mtx;
+  std::condition_variable done_cv;
+  unsigned done = 0;
+  int winner = -1;
+  std::vector<SolverResult> results(m_solvers.size(), SolverResult::UNKNOWN);
+  // -- solvers that are inside check. Only those are interrupted, so that
+  // -- an interrupt does not outlive the check it was meant for
+  std::vector<char> running(m_solvers.size(), 0);
+
+  std::vector<std::thread> threads;
+  threads.reserve(m_solvers.size());
+  for (unsigned i = 0, sz = m_solvers.size(); i < sz; ++i) {
+    threads.emplace_back([&, i]() {
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        running[i] = 1;
+      }
+      SolverResult res = check(*m_solvers[i]);
+      std::lock_guard<std::mutex> lock(mtx);
+      running[i] = 0;
+      results[i] = res;
+      if (winner < 0 &&
+          (res == SolverResult::SAT || res == SolverResult::UNSAT))
+        winner = i;
+      ++done;
+      done_cv.notify_one();
+    });
+  }
+
+  using clock = std::chrono::steady_clock;
+  const bool bounded = m_timeout > 0;
+  const clock::time_point deadline =
+      clock::now() + std::chrono::seconds(m_timeout);
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+    // -- wait for an answer, then keep interrupting the losers until they
+    // -- return. An interrupt that arrives before a solver starts its
+    // -- search can be lost, hence it is repeated.
+    while (done < threads.size()) {
+      bool stop = winner >= 0 || (bounded && clock::now() >= deadline);
+      if (stop) {
+        for (unsigned i = 0, sz = m_solvers.size(); i < sz; ++i)
+          if (running[i])
+            m_solvers[i]->interrupt();
+        done_cv.wait_for(lock, std::chrono::milliseconds(10));
+      } else if (bounded)
+        done_cv.wait_until(lock, deadline);
+      else
+        done_cv.wait(lock);
+    }
+  }
+  for (auto &t : threads)
+    t.join();
+
+  m_winner = winner;
+  if (winner >= 0) {
+    m_last_result = results[winner];
+    Stats::count(std::string("portfolio.wins.") +
+                 solver_kind_name(m_solvers[winner]->get_kind()));
+    return m_last_result;
+  }
+
+  // -- no definitive answer: report an error only if every solver failed
+  m_last_result = SolverResult::ERROR;
+  for (SolverResult res : results)
+    if (res != SolverResult::ERROR)
+      m_last_result = SolverResult::UNKNOWN;
+  Stats::count("portfolio.unknown");
+  return m_last_result;
+}
+
+bool portfolio_solver_impl::add(expr::Expr exp) {
+  bool res = true;
+  for (auto &s : m_solvers)
+    res &= s->add(exp);
+  return res;
+}
+
+SolverResult portfolio_solver_impl::check() {
+  return race([](Solver &s) { return s.check(); });
+}
+
+SolverResult
+portfolio_solver_impl::check_with_assumptions(const expr_const_it_range &lits) {
+  return race(
+      [&lits](Solver &s) { return s.check_with_assumptions(lits); });
+}
+
+void portfolio_solver_impl::unsat_core(expr::ExprVector &out) {
+  assert(m_winner >= 0 && m_last_result == SolverResult::UNSAT);
+  m_solvers[m_winner]->unsat_core(out);
+}
+
+void portfolio_solver_impl::push() {
+  for (auto &s : m_solvers)
+    s->push();
+}
+
+void portfolio_solver_impl::pop() {
+  for (auto &s : m_solvers)
+    s->pop();
+}
+
+portfolio_solver_impl::model_ref portfolio_solver_impl::get_model() {
+  assert(m_winner >= 0 && m_last_result == SolverResult::SAT);
+  return m_solvers[m_winner]->get_model();
+}
+
+void portfolio_solver_impl::reset() {
+  for (auto &s : m_solvers)
+    s->reset();
+  m_winner = -1;
+  m_last_result = SolverResult::UNKNOWN;
+}
+
+void portfolio_solver_impl::interrupt() {
+  for (auto &s : m_solvers)
+    s->interrupt();
+}
+
+void portfolio_solver_impl::to_smt_lib(llvm::raw_ostream &o) {
+  // -- every solver has the same assertions
+  m_solvers[0]->to_smt_lib(o);
+}
+} // namespace solver
+} // namespace seahorn
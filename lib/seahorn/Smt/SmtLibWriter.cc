@@ -0,0 +1,918 @@
+#include "seahorn/Expr/Smt/SmtLibWriter.hh"
+#include "seahorn/Expr/ExprOpBinder.hh"
+#include "seahorn/Support/SeaLog.hh"
+
+#include "boost/lexical_cast.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <memory>
+
+namespace seahorn {
+using namespace expr;
+
+namespace {
+/// id of a name that was not bound before a let
+const unsigned kNoName = ~0u;
+
+std::string symbolName(Expr fname) {
+  if (isOpX<STRING>(fname))
+    return getTerm<std::string>(fname);
+  return boost::lexical_cast<std::string>(*fname);
+}
+
+bool isSimpleSymbol(const std::string &s) {
+  static const char *reserved[] = {"_",      "!",      "as",  "let",
+                                   "exists", "forall", "par", "match"};
+  if (s.empty() || std::isdigit(static_cast<unsigned char>(s[0])))
+    return false;
+  for (const char *r : reserved)
+    if (s == r)
+      return false;
+  return std::all_of(s.begin(), s.end(), [](char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) ||
+           (c != '\0' && std::strchr("~!@$%^&*_-+=<>.?/", c));
+  });
+}
+
+void writeQuoted(llvm::raw_ostream &out, const std::string &s) {
+  if (isSimpleSymbol(s)) {
+    out << s;
+    return;
+  }
+  // -- | and \ cannot appear in a quoted symbol
+  out << '|';
+  for (char c : s)
+    out << (c == '|' || c == '\\' ? '_' : c);
+  out << '|';
+}
+
+std::string mpzString(const expr::mpz_class &n) {
+  if (n.sgn() >= 0)
+    return n.to_string();
+  expr::mpz_class m(n);
+  return "(- " + m.neg().to_string() + ")";
+}
+
+std::string mpqString(const expr::mpq_class &q) {
+  expr::mpz_class num(mpq_numref(q.get_mpq_t()));
+  expr::mpz_class den(mpq_denref(q.get_mpq_t()));
+  bool neg = num.sgn() < 0;
+  if (neg)
+    num.neg();
+  std::string res = mpz_cmp_ui(den.get_mpz_t(), 1) == 0
+                        ? num.to_string() + ".0"
+                        : "(/ " + num.to_string() + ".0 " + den.to_string() +
+                              ".0)";
+  return neg ? "(- " + res + ")" : res;
+}
+
+/// (_ bvN w) for the value of n modulo 2^w
+std::string bvnumString(const expr::mpz_class &n, unsigned w) {
+  expr::mpz_class v;
+  mpz_fdiv_r_2exp(v.get_mpz_t(), n.get_mpz_t(), w);
+  return "(_ bv" + v.to_string() + " " + std::to_string(w) + ")";
+}
+
+bool isOverflowCheck(Expr e) {
+  if (!isOp<BvOp>(e))
+    return false;
+  switch (llvm::cast<BvOp>(e->op()).m_kind) {
+  case BvOpKind::SADD_NO_OVERFLOW:
+  case BvOpKind::UADD_NO_OVERFLOW:
+  case BvOpKind::SADD_NO_UNDERFLOW:
+  case BvOpKind::SSUB_NO_OVERFLOW:
+  case BvOpKind::SSUB_NO_UNDERFLOW:
+  case BvOpKind::USUB_NO_UNDERFLOW:
+  case BvOpKind::SMUL_NO_OVERFLOW:
+  case BvOpKind::UMUL_NO_OVERFLOW:
+  case BvOpKind::SMUL_NO_UNDERFLOW:
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool isBvPredicate(BvOpKind k) {
+  switch (k) {
+  case BvOpKind::BULT:
+  case BvOpKind::BSLT:
+  case BvOpKind::BULE:
+  case BvOpKind::BSLE:
+  case BvOpKind::BUGE:
+  case BvOpKind::BSGE:
+  case BvOpKind::BUGT:
+  case BvOpKind::BSGT:
+    return true;
+  default:
+    return false;
+  }
+}
+} // namespace
+
+void SmtLibWriter::pushText(std::string s) {
+  m_todo.push_back({Token::TEXT, std::move(s), Expr(), nullptr});
+}
+
+void SmtLibWriter::pushTerm(Expr e, Token::Kind kind) {
+  m_todo.push_back({kind, std::string(), e, nullptr});
+}
+
+void SmtLibWriter::run() {
+  while (!m_todo.empty()) {
+    Token tok = std::move(m_todo.back());
+    m_todo.pop_back();
+    switch (tok.kind) {
+    case Token::TEXT:
+      m_out << tok.text;
+      break;
+    case Token::ACTION:
+      tok.action();
+      break;
+    case Token::LET:
+      expandLet(tok.e);
+      break;
+    case Token::TERM:
+      if (const Binding *b = lookup(tok.e))
+        m_out << "e!" << b->id;
+      else if (!writeAtom(tok.e))
+        expand(tok.e);
+      break;
+    }
+  }
+}
+
+const SmtLibWriter::Binding *SmtLibWriter::lookup(Expr e) const {
+  auto it = m_names.find(e);
+  if (it == m_names.end())
+    return nullptr;
+  // -- a term under binders is only visible under the same binders
+  const Binding &b = it->second;
+  return b.depth == 0 || b.depth == m_binders.size() ? &b : nullptr;
+}
+
+bool SmtLibWriter::isAtom(Expr e) const {
+  return e->arity() == 0 || bv::is_bvnum(e) || bind::isBVar(e) ||
+         bind::IsConst()(e) || bind::isFdecl(e) || isOp<SimpleTypeOp>(e);
+}
+
+bool SmtLibWriter::writeAtom(Expr e) {
+  if (isOpX<TRUE>(e))
+    m_out << "true";
+  else if (isOpX<FALSE>(e))
+    m_out << "false";
+  else if (isOpX<MPZ>(e))
+    m_out << mpzString(getTerm<expr::mpz_class>(e));
+  else if (isOpX<MPQ>(e))
+    m_out << mpqString(getTerm<expr::mpq_class>(e));
+  else if (bv::is_bvnum(e))
+    m_out << bvnumString(bv::toMpz(e), bv::width(e->arg(1)));
+  else if (bind::IsConst()(e))
+    writeSymbol(bind::fname(e));
+  else if (bind::isBVar(e)) {
+    // -- de Bruijn index, the last variable of the innermost binder is 0
+    unsigned idx = bind::bvarId(e);
+    for (auto it = m_binders.rbegin(), end = m_binders.rend(); it != end;
+         ++it) {
+      unsigned n = bind::numBound(*it);
+      if (idx < n) {
+        writeQuoted(m_out, symbolName(bind::boundName(*it, n - 1 - idx)));
+        return true;
+      }
+      idx -= n;
+    }
+    ++m_unsupported;
+    m_out << boost::lexical_cast<std::string>(*e);
+  } else if (isAtom(e)) {
+    ++m_unsupported;
+    m_out << boost::lexical_cast<std::string>(*e);
+  } else
+    return false;
+  return true;
+}
+
+template <typename F> void SmtLibWriter::forEachKid(Expr e, F f) const {
+  if (isAtom(e) || isOp<BinderOp>(e))
+    return;
+  unsigned begin = 0, end = e->arity();
+  if (isOpX<FAPP>(e) && bind::isFdecl(bind::fname(e)))
+    begin = 1;
+  else if (isOpX<BEXTRACT>(e))
+    begin = 2;
+  else if (isOpX<BSEXT>(e) || isOpX<BZEXT>(e))
+    end = 1;
+  else if (isOpX<CONST_ARRAY>(e))
+    begin = 1;
+  // -- overflow checks are written with each argument twice
+  unsigned times = isOverflowCheck(e) ? 2 : 1;
+  for (unsigned i = begin; i < end; ++i)
+    for (unsigned t = 0; t < times; ++t)
+      f(e->arg(i));
+}
+
+void SmtLibWriter::collectUses(const ExprVector &roots,
+                               std::unordered_map<Expr, unsigned> &uses,
+                               ExprVector &post, bool binders) const {
+  struct Frame {
+    Expr e;
+    ExprVector kids;
+    unsigned next;
+  };
+  std::vector<Frame> stack;
+  auto visit = [&](Expr e) {
+    if (isAtom(e) || lookup(e))
+      return;
+    auto res = uses.insert({e, 0});
+    ++res.first->second;
+    if (!res.second)
+      return;
+    stack.push_back({e, ExprVector(), 0});
+    if (binders && isOp<BinderOp>(e))
+      stack.back().kids.push_back(bind::body(e));
+    else
+      forEachKid(e, [&](Expr k) { stack.back().kids.push_back(k); });
+  };
+
+  for (Expr r : roots) {
+    visit(r);
+    while (!stack.empty()) {
+      Frame &top = stack.back();
+      if (top.next < top.kids.size()) {
+        Expr k = top.kids[top.next++];
+        visit(k);
+        continue;
+      }
+      post.push_back(top.e);
+      stack.pop_back();
+    }
+  }
+}
+
+void SmtLibWriter::expandLet(Expr root) {
+  std::unordered_map<Expr, unsigned> uses;
+  ExprVector post;
+  collectUses({root}, uses, post);
+
+  // -- a shared term is bound by the let after the ones of all the shared
+  // -- terms below it. height is the last let needed by a term.
+  std::unordered_map<Expr, unsigned> height;
+  std::vector<ExprVector> layers;
+  for (Expr e : post) {
+    unsigned h = 0;
+    forEachKid(e, [&](Expr k) {
+      auto it = height.find(k);
+      if (it != height.end())
+        h = std::max(h, it->second);
+    });
+    if (e != root && uses[e] > 1) {
+      if (layers.size() <= h)
+        layers.resize(h + 1);
+      layers[h].push_back(e);
+      ++h;
+    }
+    height[e] = h;
+  }
+  height.clear();
+  uses.clear();
+  post.clear();
+
+  // -- names shadowed by the let, restored after the body
+  using Saved = std::vector<std::pair<Expr, Binding>>;
+  auto saved = std::make_shared<Saved>();
+  auto bind = [this, saved](const ExprVector &layer, unsigned id,
+                            unsigned depth) {
+    for (Expr e : layer) {
+      auto res = m_names.insert({e, {id, depth}});
+      saved->push_back({e, res.first->second});
+      if (res.second)
+        saved->back().second.id = kNoName;
+      else
+        res.first->second = {id, depth};
+      ++id;
+    }
+  };
+
+  // -- tokens are pushed last one first
+  m_todo.push_back({Token::ACTION, std::string(), Expr(), [this, saved]() {
+                      for (auto &kv : *saved)
+                        if (kv.second.id == kNoName)
+                          m_names.erase(kv.first);
+                        else
+                          m_names[kv.first] = kv.second;
+                    }});
+  pushText(std::string(layers.size(), ')'));
+  pushTerm(root);
+
+  std::vector<unsigned> ids;
+  for (const ExprVector &layer : layers) {
+    ids.push_back(m_nextName);
+    m_nextName += layer.size();
+  }
+  unsigned depth = m_binders.size();
+  for (unsigned l = layers.size(); l-- > 0;) {
+    unsigned id = ids[l];
+    ExprVector layer = std::move(layers[l]);
+    for (unsigned i = layer.size(); i-- > 0;) {
+      // -- the bindings are pushed after the action that names them
+      if (i + 1 == layer.size()) {
+        m_todo.push_back({Token::ACTION, std::string(), Expr(),
+                          [bind, layer, id, depth]() {
+                            bind(layer, id, depth);
+                          }});
+        pushText(") ");
+      }
+      pushText(")");
+      pushTerm(layer[i]);
+      pushText((i == 0 ? "(let ((e!" : " (e!") + std::to_string(id + i) +
+               " ");
+    }
+  }
+}
+
+void SmtLibWriter::expand(Expr e) {
+  std::vector<Token> toks;
+  auto text = [&](std::string s) {
+    toks.push_back({Token::TEXT, std::move(s), Expr(), nullptr});
+  };
+  auto term = [&](Expr a) {
+    toks.push_back({Token::TERM, std::string(), a, nullptr});
+  };
+  // -- (name args[begin..])
+  auto app = [&](const std::string &name, unsigned begin) {
+    text("(" + name);
+    for (unsigned i = begin, sz = e->arity(); i < sz; ++i) {
+      text(" ");
+      term(e->arg(i));
+    }
+    text(")");
+  };
+  // -- associative operators with one argument are the argument
+  auto nary = [&](const std::string &name, const char *unit) {
+    if (e->arity() == 0)
+      text(unit);
+    else if (e->arity() == 1)
+      term(e->arg(0));
+    else
+      app(name, 0);
+  };
+  // -- (name a0 (name a1 ... an)) for binary operators
+  auto rightNested = [&](const std::string &name) {
+    unsigned sz = e->arity();
+    for (unsigned i = 0; i + 1 < sz; ++i) {
+      text("(" + name + " ");
+      term(e->arg(i));
+      text(" ");
+    }
+    term(e->arg(sz - 1));
+    text(std::string(sz - 1, ')'));
+  };
+  auto unsupported = [&]() {
+    ++m_unsupported;
+    app(e->op().name(), 0);
+  };
+
+  auto &op = e->op();
+  switch (op.getFamilyId()) {
+  case OpFamilyId::BoolOp:
+    switch (llvm::cast<BoolOp>(op).m_kind) {
+    case BoolOpKind::TRUE:
+      text("true");
+      break;
+    case BoolOpKind::FALSE:
+      text("false");
+      break;
+    case BoolOpKind::AND:
+      nary("and", "true");
+      break;
+    case BoolOpKind::OR:
+      nary("or", "false");
+      break;
+    case BoolOpKind::XOR:
+      app("xor", 0);
+      break;
+    case BoolOpKind::NEG:
+      app("not", 0);
+      break;
+    case BoolOpKind::IMPL:
+      app("=>", 0);
+      break;
+    case BoolOpKind::ITE:
+      app("ite", 0);
+      break;
+    case BoolOpKind::IFF:
+      app("=", 0);
+      break;
+    }
+    break;
+  case OpFamilyId::CompareOp:
+    switch (llvm::cast<CompareOp>(op).m_kind) {
+    case CompareOpKind::EQ:
+      app("=", 0);
+      break;
+    case CompareOpKind::NEQ:
+      app("distinct", 0);
+      break;
+    case CompareOpKind::LEQ:
+      app("<=", 0);
+      break;
+    case CompareOpKind::GEQ:
+      app(">=", 0);
+      break;
+    case CompareOpKind::LT:
+      app("<", 0);
+      break;
+    case CompareOpKind::GT:
+      app(">", 0);
+      break;
+    }
+    break;
+  case OpFamilyId::NumericOp:
+    switch (llvm::cast<NumericOp>(op).m_kind) {
+    case NumericOpKind::PLUS:
+      nary("+", "0");
+      break;
+    case NumericOpKind::MINUS:
+      app("-", 0);
+      break;
+    case NumericOpKind::MULT:
+      nary("*", "1");
+      break;
+    case NumericOpKind::DIV: {
+      // -- integer division when the arguments are integers, as in Z3
+      Expr s = sortOf(e->arg(0));
+      app(s && isOpX<INT_TY>(s) ? "div" : "/", 0);
+      break;
+    }
+    case NumericOpKind::IDIV:
+      app("div", 0);
+      break;
+    case NumericOpKind::MOD:
+      app("mod", 0);
+      break;
+    case NumericOpKind::REM:
+      app("rem", 0);
+      break;
+    case NumericOpKind::UN_MINUS:
+      app("-", 0);
+      break;
+    case NumericOpKind::ABS:
+      app("abs", 0);
+      break;
+    default:
+      unsupported();
+    }
+    break;
+  case OpFamilyId::ArrayOp:
+    switch (llvm::cast<ArrayOp>(op).m_kind) {
+    case ArrayOpKind::SELECT:
+      app("select", 0);
+      break;
+    case ArrayOpKind::STORE:
+      app("store", 0);
+      break;
+    case ArrayOpKind::CONST_ARRAY: {
+      Expr val = sortOf(e->arg(1));
+      if (!val) {
+        unsupported();
+        break;
+      }
+      text("((as const " + sortString(sort::arrayTy(e->arg(0), val)) + ") ");
+      term(e->arg(1));
+      text(")");
+      break;
+    }
+    default:
+      unsupported();
+    }
+    break;
+  case OpFamilyId::BindOp:
+    if (isOpX<FAPP>(e) && bind::isFdecl(bind::fname(e))) {
+      text("(");
+      std::string name;
+      llvm::raw_string_ostream os(name);
+      writeQuoted(os, symbolName(bind::fname(bind::fname(e))));
+      text(os.str());
+      for (unsigned i = 1, sz = e->arity(); i < sz; ++i) {
+        text(" ");
+        term(e->arg(i));
+      }
+      text(")");
+    } else if (isOpX<FAPP>(e))
+      // -- application of a lambda, i.e., of an array as in Z3
+      app("select", 0);
+    else
+      unsupported();
+    break;
+  case OpFamilyId::BinderOp: {
+    const char *name = isOpX<FORALL>(e)   ? "forall"
+                       : isOpX<EXISTS>(e) ? "exists"
+                                          : "lambda";
+    std::string decls;
+    for (unsigned i = 0, sz = bind::numBound(e); i < sz; ++i) {
+      llvm::raw_string_ostream os(decls);
+      os << (i == 0 ? "(" : " (");
+      writeQuoted(os, symbolName(bind::boundName(e, i)));
+      os << " " << sortString(bind::boundSort(e, i)) << ")";
+    }
+    text(std::string("(") + name + " (" + decls + ") ");
+    toks.push_back({Token::ACTION, std::string(), Expr(),
+                    [this, e]() { m_binders.push_back(e); }});
+    toks.push_back({Token::LET, std::string(), bind::body(e), nullptr});
+    toks.push_back({Token::ACTION, std::string(), Expr(),
+                    [this]() { m_binders.pop_back(); }});
+    text(")");
+    break;
+  }
+  case OpFamilyId::BvOp: {
+    BvOpKind k = llvm::cast<BvOp>(op).m_kind;
+    if (isOverflowCheck(e)) {
+      unsigned w = bvWidth(e->arg(0));
+      if (w == 0) {
+        unsupported();
+        break;
+      }
+      Expr a = e->arg(0), b = e->arg(1);
+      std::string ws = std::to_string(w);
+      std::string zero = "(_ bv0 " + ws + ")";
+      // -- writes the text in parts, with a or b between them
+      auto seq = [&](std::initializer_list<std::string> parts,
+                     std::initializer_list<Expr> args) {
+        auto arg = args.begin();
+        for (const std::string &p : parts) {
+          text(p);
+          if (arg != args.end())
+            term(*arg++);
+        }
+      };
+      switch (k) {
+      case BvOpKind::UADD_NO_OVERFLOW:
+        seq({"(= ((_ extract " + ws + " " + ws +
+                 ") (bvadd ((_ zero_extend 1) ",
+             ") ((_ zero_extend 1) ", "))) #b0)"},
+            {a, b});
+        break;
+      case BvOpKind::SADD_NO_OVERFLOW:
+        seq({"(=> (and (bvslt " + zero + " ", ") (bvslt " + zero + " ",
+             ")) (bvslt " + zero + " (bvadd ", " ", ")))"},
+            {a, b, a, b});
+        break;
+      case BvOpKind::SADD_NO_UNDERFLOW:
+        seq({"(=> (and (bvslt ", " " + zero + ") (bvslt ",
+             " " + zero + ")) (bvslt (bvadd ", " ", ") " + zero + "))"},
+            {a, b, a, b});
+        break;
+      case BvOpKind::SSUB_NO_OVERFLOW:
+        seq({"(=> (and (bvsle " + zero + " ", ") (bvslt ",
+             " " + zero + ")) (bvsle " + zero + " (bvsub ", " ", ")))"},
+            {a, b, a, b});
+        break;
+      case BvOpKind::SSUB_NO_UNDERFLOW:
+        seq({"(=> (and (bvslt ", " " + zero + ") (bvslt " + zero + " ",
+             ")) (bvslt (bvsub ", " ", ") " + zero + "))"},
+            {a, b, a, b});
+        break;
+      case BvOpKind::USUB_NO_UNDERFLOW:
+        seq({"(bvule ", " ", ")"}, {b, a});
+        break;
+      case BvOpKind::UMUL_NO_OVERFLOW:
+        seq({"(= ((_ extract " + std::to_string(2 * w - 1) + " " + ws +
+                 ") (bvmul ((_ zero_extend " + ws + ") ",
+             ") ((_ zero_extend " + ws + ") ", "))) " + zero + ")"},
+            {a, b});
+        break;
+      case BvOpKind::SMUL_NO_OVERFLOW:
+      case BvOpKind::SMUL_NO_UNDERFLOW: {
+        // -- the product in 2w bits against 2^(w-1) - 1 or -2^(w-1)
+        std::string w2 = std::to_string(2 * w);
+        std::string max = "(bvlshr (bvnot (_ bv0 " + w2 + ")) (_ bv" +
+                          std::to_string(w + 1) + " " + w2 + "))";
+        bool over = k == BvOpKind::SMUL_NO_OVERFLOW;
+        seq({std::string(over ? "(bvsle" : "(bvsge") +
+                 " (bvmul ((_ sign_extend " + ws + ") ",
+             ") ((_ sign_extend " + ws + ") ",
+             ")) " + (over ? max : "(bvnot " + max + ")") + ")"},
+            {a, b});
+        break;
+      }
+      default:
+        unsupported();
+      }
+      break;
+    }
+    switch (k) {
+    case BvOpKind::BEXTRACT:
+      text("((_ extract " + std::to_string(bv::high(e)) + " " +
+           std::to_string(bv::low(e)) + ") ");
+      term(bv::earg(e));
+      text(")");
+      break;
+    case BvOpKind::BSEXT:
+    case BvOpKind::BZEXT: {
+      unsigned in = bvWidth(e->arg(0));
+      unsigned out = bv::width(e->arg(1));
+      if (in == 0 || in > out) {
+        unsupported();
+        break;
+      }
+      if (in == out) {
+        term(e->arg(0));
+        break;
+      }
+      text(std::string(k == BvOpKind::BSEXT ? "((_ sign_extend "
+                                            : "((_ zero_extend ") +
+           std::to_string(out - in) + ") ");
+      term(e->arg(0));
+      text(")");
+      break;
+    }
+    case BvOpKind::BCONCAT:
+      rightNested("concat");
+      break;
+    case BvOpKind::BADD:
+      rightNested("bvadd");
+      break;
+    case BvOpKind::BNOT:
+    case BvOpKind::BREDAND:
+    case BvOpKind::BREDOR:
+    case BvOpKind::BAND:
+    case BvOpKind::BOR:
+    case BvOpKind::BXOR:
+    case BvOpKind::BNAND:
+    case BvOpKind::BNOR:
+    case BvOpKind::BXNOR:
+    case BvOpKind::BNEG:
+    case BvOpKind::BSUB:
+    case BvOpKind::BMUL:
+    case BvOpKind::BUDIV:
+    case BvOpKind::BSDIV:
+    case BvOpKind::BUREM:
+    case BvOpKind::BSREM:
+    case BvOpKind::BSMOD:
+    case BvOpKind::BULT:
+    case BvOpKind::BSLT:
+    case BvOpKind::BULE:
+    case BvOpKind::BSLE:
+    case BvOpKind::BUGE:
+    case BvOpKind::BSGE:
+    case BvOpKind::BUGT:
+    case BvOpKind::BSGT:
+    case BvOpKind::BSHL:
+    case BvOpKind::BLSHR:
+    case BvOpKind::BASHR:
+      // -- the name of the operator is the SMT-LIB one
+      app(op.name(), 0);
+      break;
+    default:
+      unsupported();
+    }
+    break;
+  }
+  default:
+    unsupported();
+  }
+
+  m_todo.insert(m_todo.end(), std::make_move_iterator(toks.rbegin()),
+                std::make_move_iterator(toks.rend()));
+}
+
+void SmtLibWriter::writeTerm(Expr e) {
+  pushTerm(e, Token::LET);
+  run();
+  m_sorts.clear();
+}
+
+void SmtLibWriter::writeSymbol(Expr fdecl) {
+  writeQuoted(m_out, symbolName(bind::fname(fdecl)));
+}
+
+std::string SmtLibWriter::sortString(Expr sort) {
+  if (isOpX<BOOL_TY>(sort))
+    return "Bool";
+  if (isOpX<INT_TY>(sort))
+    return "Int";
+  if (isOpX<REAL_TY>(sort))
+    return "Real";
+  if (isOpX<BVSORT>(sort))
+    return "(_ BitVec " + std::to_string(bv::width(sort)) + ")";
+  if (isOpX<ARRAY_TY>(sort))
+    return "(Array " + sortString(sort::arrayIndexTy(sort)) + " " +
+           sortString(sort::arrayValTy(sort)) + ")";
+  ++m_unsupported;
+  return boost::lexical_cast<std::string>(*sort);
+}
+
+void SmtLibWriter::writeSort(Expr sort) { m_out << sortString(sort); }
+
+void SmtLibWriter::declareFun(Expr fdecl) {
+  m_declared.insert(fdecl);
+  m_out << "(declare-fun ";
+  writeSymbol(fdecl);
+  m_out << " (";
+  for (unsigned i = 0, sz = bind::domainSz(fdecl); i < sz; ++i) {
+    if (i > 0)
+      m_out << " ";
+    writeSort(bind::domainTy(fdecl, i));
+  }
+  m_out << ") ";
+  writeSort(bind::rangeTy(fdecl));
+  m_out << ")\n";
+}
+
+void SmtLibWriter::declare(Expr e) {
+  std::unordered_set<Expr> seen;
+  ExprVector todo{e};
+  while (!todo.empty()) {
+    Expr n = todo.back();
+    todo.pop_back();
+    if (!seen.insert(n).second)
+      continue;
+    if (isOpX<FAPP>(n) && bind::isFdecl(bind::fname(n))) {
+      Expr fdecl = bind::fname(n);
+      if (!m_declared.count(fdecl))
+        declareFun(fdecl);
+      todo.insert(todo.end(), ++n->args_begin(), n->args_end());
+    } else if (isOp<BinderOp>(n))
+      todo.push_back(bind::body(n));
+    else if (!isAtom(n))
+      todo.insert(todo.end(), n->args_begin(), n->args_end());
+  }
+}
+
+void SmtLibWriter::defineShared(const ExprVector &f) {
+  assert(m_binders.empty());
+  std::unordered_map<Expr, unsigned> uses;
+  ExprVector post;
+  collectUses(f, uses, post, true);
+
+  // -- terms under binders are closed unless they have a bound variable
+  std::unordered_set<Expr> open;
+  for (Expr e : post) {
+    bool isOpen = isOp<BinderOp>(e);
+    forEachKid(e, [&](Expr k) {
+      isOpen = isOpen || bind::isBVar(k) || open.count(k);
+    });
+    if (isOpen) {
+      open.insert(e);
+      continue;
+    }
+    if (uses[e] < 2)
+      continue;
+    Expr sort = sortOf(e);
+    if (!sort)
+      continue;
+    unsigned id = m_nextName++;
+    m_out << "(define-fun e!" << id << " () " << sortString(sort) << " ";
+    pushTerm(e, Token::LET);
+    run();
+    m_out << ")\n";
+    m_names[e] = {id, 0};
+  }
+  m_sorts.clear();
+}
+
+void SmtLibWriter::assertAll(const ExprVector &f) {
+  for (Expr e : f)
+    declare(e);
+  defineShared(f);
+  for (Expr e : f) {
+    m_out << "(assert ";
+    writeTerm(e);
+    m_out << ")\n";
+  }
+}
+
+unsigned SmtLibWriter::bvWidth(Expr e) {
+  Expr s = sortOf(e);
+  return s && isOpX<BVSORT>(s) ? bv::width(s) : 0;
+}
+
+Expr SmtLibWriter::sortOf(Expr e) {
+  auto it = m_sorts.find(e);
+  if (it != m_sorts.end())
+    return it->second;
+
+  // -- sub-terms whose sort is needed for the sort of e
+  auto deps = [](Expr n, ExprVector &out) {
+    if (isOpX<ITE>(n))
+      out.push_back(n->arg(1));
+    else if (isOpX<BCONCAT>(n))
+      out.insert(out.end(), n->args_begin(), n->args_end());
+    else if (isOpX<CONST_ARRAY>(n))
+      out.push_back(n->arg(1));
+    else if (isOpX<LAMBDA>(n))
+      out.push_back(bind::body(n));
+    else if (isOpX<FAPP>(n) && !bind::isFdecl(bind::fname(n)))
+      out.push_back(n->arg(0));
+    else if (isOp<NumericOp>(n) || isOpX<SELECT>(n) || isOpX<STORE>(n) ||
+             (isOp<BvOp>(n) && n->arity() > 0 && !isOpX<BEXTRACT>(n) &&
+              !isOpX<BSEXT>(n) && !isOpX<BZEXT>(n)))
+      out.push_back(n->arg(0));
+  };
+
+  auto compute = [this](Expr n) -> Expr {
+    auto get = [this](Expr k) { return m_sorts.at(k); };
+    ExprFactory &efac = n->efac();
+    if (isOp<BoolOp>(n) && !isOpX<ITE>(n))
+      return sort::boolTy(efac);
+    if (isOp<CompareOp>(n) || isOpX<FORALL>(n) || isOpX<EXISTS>(n))
+      return sort::boolTy(efac);
+    if (isOpX<ITE>(n))
+      return get(n->arg(1));
+    if (isOpX<MPZ>(n))
+      return sort::intTy(efac);
+    if (isOpX<MPQ>(n))
+      return sort::realTy(efac);
+    if (bv::is_bvnum(n))
+      return n->arg(1);
+    if (bind::isBVar(n))
+      return bind::type(n);
+    if (isOpX<FAPP>(n)) {
+      if (bind::isFdecl(bind::fname(n)))
+        return bind::rangeTy(bind::fname(n));
+      Expr s = get(n->arg(0));
+      return s && isOpX<ARRAY_TY>(s) && n->arity() == 2 ? sort::arrayValTy(s)
+                                                        : Expr();
+    }
+    if (isOpX<LAMBDA>(n)) {
+      Expr body = get(bind::body(n));
+      return body && bind::numBound(n) == 1
+                 ? sort::arrayTy(bind::boundSort(n, 0), body)
+                 : Expr();
+    }
+    if (isOp<NumericOp>(n))
+      return isOpX<IDIV>(n) ? sort::intTy(efac) : get(n->arg(0));
+    if (isOpX<SELECT>(n)) {
+      Expr s = get(n->arg(0));
+      return s && isOpX<ARRAY_TY>(s) ? sort::arrayValTy(s) : Expr();
+    }
+    if (isOpX<STORE>(n))
+      return get(n->arg(0));
+    if (isOpX<CONST_ARRAY>(n)) {
+      Expr val = get(n->arg(1));
+      return val ? sort::arrayTy(n->arg(0), val) : Expr();
+    }
+    if (isOp<BvOp>(n)) {
+      BvOpKind k = llvm::cast<BvOp>(n->op()).m_kind;
+      if (isBvPredicate(k) || isOverflowCheck(n))
+        return sort::boolTy(efac);
+      switch (k) {
+      case BvOpKind::BEXTRACT:
+        return bv::bvsort(bv::high(n) - bv::low(n) + 1, efac);
+      case BvOpKind::BSEXT:
+      case BvOpKind::BZEXT:
+        return n->arg(1);
+      case BvOpKind::BREDAND:
+      case BvOpKind::BREDOR:
+        return bv::bvsort(1, efac);
+      case BvOpKind::BCONCAT: {
+        unsigned w = 0;
+        for (auto it = n->args_begin(), end = n->args_end(); it != end;
+             ++it) {
+          Expr s = get(*it);
+          if (!s || !isOpX<BVSORT>(s))
+            return Expr();
+          w += bv::width(s);
+        }
+        return bv::bvsort(w, efac);
+      }
+      case BvOpKind::BREPEAT:
+      case BvOpKind::BROTATE_LEFT:
+      case BvOpKind::BROTATE_RIGHT:
+      case BvOpKind::BEXT_ROTATE_LEFT:
+      case BvOpKind::BEXT_ROTATE_RIGHT:
+      case BvOpKind::INT2BV:
+        return Expr();
+      case BvOpKind::BV2INT:
+        return sort::intTy(efac);
+      default:
+        return get(n->arg(0));
+      }
+    }
+    return Expr();
+  };
+
+  ExprVector todo{e};
+  ExprVector kids;
+  while (!todo.empty()) {
+    Expr n = todo.back();
+    if (m_sorts.count(n)) {
+      todo.pop_back();
+      continue;
+    }
+    kids.clear();
+    deps(n, kids);
+    bool ready = true;
+    for (Expr k : kids)
+      if (!m_sorts.count(k)) {
+        todo.push_back(k);
+        ready = false;
+      }
+    if (!ready)
+      continue;
+    m_sorts[n] = compute(n);
+    todo.pop_back();
+  }
+  return m_sorts.at(e);
+}
+} // namespace seahorn
@@ -174,6 +174,11 @@ void yices_solver_impl::to_smt_lib(raw_ostream& o) {
   errs() << "Warning: yices::to_smt_lib is not implemented\n";
 }
 
+/** Stop a running check */
+void yices_solver_impl::interrupt() {
+  yices_stop_search(d_ctx);
+}
+
 }
 }
 #endif
@@ -0,0 +1,28 @@
+#include "seahorn/Expr/Smt/ZCache.hh"
+#include "seahorn/Support/Stats.hh"
+
+#include "llvm/Support/CommandLine.h"
+
+namespace seahorn {
+unsigned ZCacheBudget = 0;
+
+void ZCache::flushStats() {
+  // -- contexts of path workers flush concurrently
+  static Stats::CounterId hits = Stats::counter("zctx.cache.hits");
+  static Stats::CounterId misses = Stats::counter("zctx.cache.misses");
+  static Stats::CounterId evictions = Stats::counter("zctx.cache.evictions");
+  static Stats::CounterId peak = Stats::counter("zctx.cache.peak");
+  Stats::add(hits, m_hits);
+  Stats::add(misses, m_misses);
+  Stats::add(evictions, m_evictions);
+  Stats::max(peak, m_peak);
+  m_hits = m_misses = m_evictions = 0;
+}
+} // namespace seahorn
+
+static llvm::cl::opt<unsigned, true> ZCacheBudgetOpt(
+    "zctx-cache-budget",
+    llvm::cl::desc("Memory budget (in MB) of the Expr/Z3 cache of each Z3 "
+                   "context. 0 is unbounded"),
+    llvm::cl::location(seahorn::ZCacheBudget), llvm::cl::init(0),
+    llvm::cl::value_desc("MB"));
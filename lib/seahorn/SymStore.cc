@@ -14,7 +14,7 @@ void SymStore::swap(SymStore &o) {
 
   std::swap(m_Parent, o.m_Parent);
   std::swap(m_ownedParent, o.m_ownedParent);
-  std::swap(m_Store, o.m_Store);
+  m_Store.swap(o.m_Store);
   std::swap(m_trackUse, o.m_trackUse);
   std::swap(m_uses, o.m_uses);
   std::swap(m_defs, o.m_defs);
@@ -23,7 +23,7 @@ void SymStore::swap(SymStore &o) {
 
 void SymStore::print(llvm::raw_ostream &out) {
   out << "SYMSTORE BEGIN\n";
-  for (auto p : m_Store)
+  for (auto &p : m_Store)
     out << *p.first << ": " << *p.second << "\n";
   out << "SYMSTORE END\n";
 }
@@ -32,7 +32,7 @@ void SymStore::print(llvm::raw_ostream &out) {
 void SymStore::write(Expr key, Expr val) {
   assert(!isValue(key));
 
-  m_Store[key] = val;
+  m_Store.set(key, val);
   if (m_trackUse)
     m_defs.push_back(key);
 }
@@ -135,8 +135,8 @@ const ExprVector &SymStore::defs() {
 
 namespace detail {
 VisitAction seahorn::detail::SymStoreEvalVisitor::operator()(Expr exp) const {
-  if (m_store.isDefined(exp))
-    return VisitAction::changeTo(m_store.at(exp));
+  if (Expr val = m_store.at(exp))
+    return VisitAction::changeTo(val);
 
   else if (expr::op::bind::isFdecl(exp) || isOpX<BIND>(exp))
     return VisitAction::skipKids();
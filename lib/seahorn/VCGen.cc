@@ -170,27 +170,50 @@ struct FwdReachPred : public std::unary_function<const BasicBlock &, bool> {
 };
 } // namespace sem_detail
 
-/// \brief Naive quadratic implementation of at-most-one
-static Expr mkAtMostOne(ExprVector &vec) {
+/// \brief Linear encoding of at-most-one using a sequential counter
+///
+/// For each x_i, a fresh constant s_i is true if one of x_1..x_i is. Then
+/// x_i -> s_i, s_{i-1} -> s_i, and x_i -> !s_{i-1}. The result is
+/// equisatisfiable with at-most-one over \p vec, not equivalent.
+static Expr mkAtMostOne(const ExprVector &vec) {
   assert(!vec.empty());
+  ExprVector xs;
+  DenseSet<const ENode *> seen;
+  for (Expr x : vec)
+    if (seen.insert(&*x).second)
+      xs.push_back(x);
+
+  ExprFactory &efac = xs.front()->efac();
+  if (xs.size() == 1)
+    return mk<TRUE>(efac);
+
+  Expr tag = mkTerm<std::string>("amo", efac);
   ExprVector res;
-  for (unsigned i = 0, e = vec.size(); i < e; ++i) {
-    ExprVector exactly_vi; // exactly  vec[i]
-    exactly_vi.push_back(vec[i]);
-    for (unsigned j = 0; j < e; ++j) {
-      if (vec[i] == vec[j])
-        continue;
-      exactly_vi.push_back(mk<NEG>(vec[j]));
-    }
-    // at this point: exactly_vi is vi && !vj for all j
-    res.push_back(op::boolop::land(exactly_vi));
+  Expr prev;
+  for (unsigned i = 0, e = xs.size(); i < e; ++i) {
+    if (prev)
+      res.push_back(mk<IMPL>(xs[i], mk<NEG>(prev)));
+    // -- no counter is needed after the last element
+    if (i + 1 == e)
+      break;
+    Expr si = bind::boolConst(mk<TUPLE>(tag, xs[i]));
+    res.push_back(mk<IMPL>(xs[i], si));
+    if (prev)
+      res.push_back(mk<IMPL>(prev, si));
+    prev = si;
   }
-  return mknary<OR>(res);
+  return op::boolop::land(res);
+}
+
+/// \brief Linear encoding of exactly-one. See mkAtMostOne
+static Expr mkExactlyOne(const ExprVector &vec) {
+  assert(!vec.empty());
+  return mk<AND>(mknary<OR>(mk<FALSE>(vec.front()->efac()), vec),
+                 mkAtMostOne(vec));
 }
 
 namespace {
 bool hasTrackablePhiNode(const BasicBlock &bb, OperationalSemantics &sem) {
-  bool hasPhi = false;
   for (const Instruction &inst : bb) {
     if (!isa<PHINode>(&inst))
       break;
@@ -208,15 +231,13 @@ void computePhiNodeValues(const BasicBlock &bb,
                           std::vector<ExprVector> &phiVal) {
   phiVal.resize(preds.size());
 
+  static Stats::TimerId cloneTimer = Stats::timer("vcgen.store.clone");
   unsigned idx = 0;
   for (const BasicBlock *pred : preds) {
-    // clone s
-    Stats::resume("vcgen.store.clone");
+    // clone s. O(1), the store shares its content with ctx.values()
+    Stats::resume(cloneTimer);
     SymStore es(ctx.values());
-    Stats::stop("vcgen.store.clone");
-    // XXX: ctx.fork() is very expensive because it copies complete
-    // XXX: content of the symbolic store. Can be fixed with a different
-    // interface
+    Stats::stop(cloneTimer);
     OpSemContextPtr ectx = ctx.fork(es, ctx.side());
     ectx->setPathCond(edges[idx]);
 
@@ -240,6 +261,36 @@ void computePhiNodeValues(const BasicBlock &bb,
   }
 }
 
+/// \brief Groups edges by the value of the \p i-th PHINode on them
+///
+/// \p vals are the distinct values, in the order of their first edge, and
+/// \p conds are the disjunctions of the edges on which each is taken.
+/// Returns the index of the value taken on the most edges.
+unsigned groupPhiValues(const ExprVector &edges,
+                        const std::vector<ExprVector> &phiVal, unsigned i,
+                        ExprVector &vals, ExprVector &conds) {
+  DenseMap<const ENode *, unsigned> valIdx;
+  std::vector<ExprVector> valEdges;
+  for (unsigned j = 0, sz = edges.size(); j < sz; ++j) {
+    Expr v = phiVal[j][i];
+    auto r = valIdx.insert(std::make_pair(&*v, vals.size()));
+    if (r.second) {
+      vals.push_back(v);
+      valEdges.emplace_back();
+    }
+    valEdges[r.first->second].push_back(edges[j]);
+  }
+
+  Expr falseE = mk<FALSE>(edges.front()->efac());
+  unsigned most = 0;
+  for (unsigned k = 0, sz = valEdges.size(); k < sz; ++k) {
+    conds.push_back(mknary<OR>(falseE, valEdges[k]));
+    if (valEdges[k].size() > valEdges[most].size())
+      most = k;
+  }
+  return most;
+}
+
 /// \brief Create definitions for PHINodes using ite expressions
 void defPHINodesIte(const BasicBlock &bb, const ExprVector &edges,
                     const std::vector<ExprVector> &phiVal, OpSemContext &ctx,
@@ -256,20 +307,23 @@ void defPHINodesIte(const BasicBlock &bb, const ExprVector &edges,
   }
 
   assert(edges.size() > 0);
-  // TODO: Optimize ite construction by ensuring that each unique value
-  // appears only ones. For example, ite(c1, ite(c2, v, u), v) --reduces-->
-  // ite (c1 || !c2, v, u) This is easy in this case because conditions are
-  // known to be disjoint. This is basically compiling a known switch
-  // statement into if-then-else block
+  // -- each distinct value appears once, guarded by the disjunction of its
+  // -- edges. For example, ite(c1, v, ite(c2, u, v)) becomes
+  // -- ite(c2, u, v). This is compiling a known switch statement into
+  // -- if-then-else blocks
   for (unsigned i = 0; i < newPhi.size(); ++i) {
     // assume that path-conditions (edges) are disjoint and that
-    // at least one must be true. Using the last edge condition as the
-    // default value. If all other edge conditions are false, the default is
-    // taken
-    Expr val = phiVal[edges.size() - 1][i];
-    for (unsigned j = edges.size() - 1; j > 0; --j) {
-      Expr cond = edges[j - 1];
-      Expr lhs = phiVal[j - 1][i];
+    // at least one must be true. The value taken on the most edges is the
+    // default. If all other conditions are false, the default is taken
+    ExprVector vals, conds;
+    unsigned dflt = groupPhiValues(edges, phiVal, i, vals, conds);
+
+    Expr val = vals[dflt];
+    for (unsigned k = vals.size(); k > 0; --k) {
+      if (k - 1 == dflt)
+        continue;
+      Expr cond = conds[k - 1];
+      Expr lhs = vals[k - 1];
       if (strct::isStructVal(val))
         val = strct::push_ite_struct(cond, lhs, val);
       else
@@ -295,10 +349,14 @@ void defPHINodesEq(const BasicBlock &bb, const ExprVector &edges,
     newPhi.push_back(ctx.havoc(sem.mkSymbReg(inst, ctx)));
   }
 
-  // connect new PHINode register values with constructed PHINode values
-  for (unsigned j = 0, sz = edges.size(); j < sz; ++j)
-    for (unsigned i = 0, phi_sz = newPhi.size(); i < phi_sz; ++i)
-      ctx.addSide(boolop::limp(edges[j], strct::mkEq(newPhi[i], phiVal[j][i])));
+  // connect new PHINode register values with constructed PHINode values,
+  // once for each distinct value
+  for (unsigned i = 0, phi_sz = newPhi.size(); i < phi_sz; ++i) {
+    ExprVector vals, conds;
+    groupPhiValues(edges, phiVal, i, vals, conds);
+    for (unsigned k = 0, sz = vals.size(); k < sz; ++k)
+      ctx.addSide(boolop::limp(conds[k], strct::mkEq(newPhi[i], vals[k])));
+  }
 }
 
 Expr computePathCondForBb(const BasicBlock &bb, const CpEdge &cpEdge,
@@ -339,17 +397,17 @@ Expr computePathCondForBb(const BasicBlock &bb, const CpEdge &cpEdge,
     }
   }
 
-  // bbV ==> at_least_one(edges)
-  // -- encode control flow
-  // -- b_j -> (b1 & e_{1,j} | b2 & e_{2,j} | ...)
-  ctx.addSide(mk<IMPL>(bbV, mknary<OR>(mk<FALSE>(sem.efac()), edges)));
-
-  // bbv ==> at_most_one(edges)
   if (EnforceAtMostOnePredecessor && edges.size() > 1) {
+    // bbV ==> exactly_one(edges)
     // this enforces at-most-one predecessor.
     // if !bbV (i.e., bb is not reachable) then bb won't have
     // predecessors.
-    ctx.addSide(mk<IMPL>(bbV, mkAtMostOne(edges)));
+    ctx.addSide(mk<IMPL>(bbV, mkExactlyOne(edges)));
+  } else {
+    // bbV ==> at_least_one(edges)
+    // -- encode control flow
+    // -- b_j -> (b1 & e_{1,j} | b2 & e_{2,j} | ...)
+    ctx.addSide(mk<IMPL>(bbV, mknary<OR>(mk<FALSE>(sem.efac()), edges)));
   }
 
   // relate predecessors and conditions under which control flows from them
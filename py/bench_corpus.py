@@ -0,0 +1,283 @@
+#!/usr/bin/env python3
+"""Run a pinned benchmark corpus and compare it against a baseline.
+
+Every benchmark of the corpus (see test/bench/corpus.json) is run with
+--horn-stats-json. The report keeps, for each benchmark, the verdict,
+the wall time and peak memory of the whole pipeline, the timers of
+every phase (HornifyModule, BMC path-based: *, Horn, VCGen.smt, ...)
+and the counters (dag sizes, solver calls, ...). Comparing two reports
+flags every phase that got slower, and every size counter that grew,
+by more than the threshold.
+
+  bench_corpus.py run --path=<bin> --out=report.json [--baseline=base.json]
+  bench_corpus.py compare base.json report.json
+"""
+
+import argparse
+import csv
+import json
+import os
+import resource
+import subprocess
+import sys
+import tempfile
+import time
+
+REPO = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# -- counters that measure the size of an encoding: growing is a regression
+SIZE_KEYS = ('dag_sz', 'size', 'num_', 'lemmas', 'clauses')
+
+
+def which(prog, path):
+    for d in path.split(os.pathsep):
+        f = os.path.join(d, prog)
+        if os.path.isfile(f) and os.access(f, os.X_OK):
+            return f
+    return None
+
+
+def flatten_timers(timers, prefix, out):
+    """ Timers are a tree. Name each one by its path from the root """
+    for t in timers:
+        name = prefix + t['name']
+        prev = out.get(name)
+        if prev is None or prev['wall'] < t['wall']:
+            out[name] = {
+                'wall': t['wall'], 'user': t['user'], 'sys': t['sys'],
+                'process_peak_rss_kb': t['process_peak_rss_kb']}
+        flatten_timers(t.get('children', []), name + '/', out)
+
+
+def verdict(output):
+    for line in reversed(output.splitlines()):
+        line = line.strip()
+        if line in ('sat', 'unsat', 'unknown'):
+            return line
+    return 'none'
+
+
+def children_peak_rss_kb():
+    # -- ru_maxrss is in kilobytes on Linux and in bytes on macOS
+    rss = resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss
+    return rss // 1024 if sys.platform == 'darwin' else rss
+
+
+def run_one(bench, path, timeout, work_dir):
+    tool = which(bench['tool'], path)
+    if tool is None:
+        raise IOError('{0} not found in {1}'.format(bench['tool'], path))
+    stats = os.path.join(work_dir, 'stats.json')
+    if os.path.exists(stats):
+        os.remove(stats)
+    fname = os.path.join(REPO, bench['file'])
+    argv = [tool] + [a.format(file=fname, stats=stats) for a in bench['args']]
+
+    env = dict(os.environ)
+    env['PATH'] = path + os.pathsep + env.get('PATH', '')
+    start = time.time()
+    try:
+        p = subprocess.run(argv, stdout=subprocess.PIPE,
+                           stderr=subprocess.STDOUT, cwd=work_dir, env=env,
+                           timeout=timeout, universal_newlines=True)
+        status, output = p.returncode, p.stdout
+    except subprocess.TimeoutExpired:
+        status, output = 'timeout', ''
+    wall = time.time() - start
+
+    res = {'status': status, 'verdict': verdict(output), 'wall': wall,
+           'timers': {}, 'counters': {}, 'strings': {}}
+    if os.path.exists(stats):
+        with open(stats) as f:
+            js = json.load(f)
+        flatten_timers(js.get('timers', []), '', res['timers'])
+        res['counters'] = js.get('counters', {})
+        res['strings'] = js.get('strings', {})
+    return res
+
+
+def median(xs):
+    xs = sorted(xs)
+    n = len(xs)
+    return xs[n // 2] if n % 2 else (xs[n // 2 - 1] + xs[n // 2]) / 2.0
+
+
+def merge_runs(runs):
+    """ Keep the median of every timer, and the peak memory, over
+        repeated runs """
+    res = dict(runs[0])
+    res['wall'] = median([r['wall'] for r in runs])
+    timers = {}
+    for name in runs[0]['timers']:
+        samples = [r['timers'][name] for r in runs if name in r['timers']]
+        timers[name] = {k: (max if k == 'process_peak_rss_kb' else median)(
+            [s[k] for s in samples]) for k in samples[0]}
+    res['timers'] = timers
+    return res
+
+
+def run(args):
+    with open(args.corpus) as f:
+        corpus = json.load(f)['benchmarks']
+    if args.filter:
+        corpus = [b for b in corpus if args.filter in b['name']]
+
+    report = {'benchmarks': {}}
+    for bench in corpus:
+        work_dir = tempfile.mkdtemp(prefix='sea-bench-')
+        runs = []
+        for _ in range(args.repeat):
+            runs.append(run_one(bench, args.path, args.timeout, work_dir))
+        res = merge_runs(runs)
+        report['benchmarks'][bench['name']] = res
+        print('{0:50} {1:8} {2:8.2f}s'.format(bench['name'], res['verdict'],
+                                              res['wall']))
+        sys.stdout.flush()
+    # -- of all the runs: resource usage of children is cumulative
+    report['peak_rss_kb'] = children_peak_rss_kb()
+
+    with open(args.out, 'w') as f:
+        json.dump(report, f, indent=2, sort_keys=True)
+    if args.csv:
+        write_csv(report, args.csv)
+
+    if args.baseline is None:
+        return 0
+    if not os.path.exists(args.baseline):
+        print('WARNING: no baseline at {0}'.format(args.baseline))
+        return 0
+    with open(args.baseline) as f:
+        base = json.load(f)
+    return 1 if compare_reports(base, report, args) and args.fail else 0
+
+
+def write_csv(report, fname):
+    with open(fname, 'w') as f:
+        out = csv.writer(f)
+        out.writerow(['benchmark', 'kind', 'name', 'value', 'wall', 'user',
+                      'sys', 'process_peak_rss_kb'])
+        for bname, res in sorted(report['benchmarks'].items()):
+            out.writerow([bname, 'verdict', '', res['verdict'],
+                          '{0:.3f}'.format(res['wall']), '', '', ''])
+            for name, c in sorted(res['counters'].items()):
+                out.writerow([bname, 'counter', name, c, '', '', '', ''])
+            for name, t in sorted(res['timers'].items()):
+                out.writerow([bname, 'timer', name, '',
+                              '{0:.3f}'.format(t['wall']),
+                              '{0:.3f}'.format(t['user']),
+                              '{0:.3f}'.format(t['sys']),
+                              t['process_peak_rss_kb']])
+
+
+def is_size(name):
+    return any(k in name for k in SIZE_KEYS)
+
+
+def slower(old, new, threshold, min_time):
+    """ True if new is slower than old by more than threshold percent.
+        Differences below min_time seconds are noise """
+    return new - old > min_time and new > old * (1.0 + threshold / 100.0)
+
+
+def compare_reports(base, report, args):
+    regressions = []
+    old_benchs = base['benchmarks']
+    for bname, res in sorted(report['benchmarks'].items()):
+        old = old_benchs.get(bname)
+        if old is None:
+            continue
+        if old['verdict'] != res['verdict']:
+            regressions.append((bname, 'verdict', old['verdict'],
+                                res['verdict']))
+        if slower(old['wall'], res['wall'], args.threshold, args.min_time):
+            regressions.append((bname, 'wall', old['wall'], res['wall']))
+        for name, t in sorted(res['timers'].items()):
+            o = old['timers'].get(name)
+            if o is not None and \
+               slower(o['wall'], t['wall'], args.threshold, args.min_time):
+                regressions.append((bname, name, o['wall'], t['wall']))
+        for name, c in sorted(res['counters'].items()):
+            o = old['counters'].get(name)
+            if o is not None and is_size(name) and \
+               c > o * (1.0 + args.threshold / 100.0):
+                regressions.append((bname, name, o, c))
+
+    missing = sorted(set(old_benchs) - set(report['benchmarks']))
+    for bname in missing:
+        print('WARNING: {0} is in the baseline but was not run'.format(bname))
+
+    old_total = sum(old_benchs[b]['wall'] for b in report['benchmarks']
+                    if b in old_benchs)
+    new_total = sum(r['wall'] for b, r in report['benchmarks'].items()
+                    if b in old_benchs)
+    print('Total wall time: {0:.2f}s -> {1:.2f}s'.format(old_total, new_total))
+
+    if not regressions:
+        print('No regressions (threshold {0}%)'.format(args.threshold))
+        return False
+    print('REGRESSIONS (threshold {0}%):'.format(args.threshold))
+    for bname, what, o, n in regressions:
+        if isinstance(o, float):
+            print('  {0}: {1}: {2:.3f}s -> {3:.3f}s'.format(bname, what, o, n))
+        else:
+            print('  {0}: {1}: {2} -> {3}'.format(bname, what, o, n))
+    return True
+
+
+def compare(args):
+    with open(args.baseline) as f:
+        base = json.load(f)
+    with open(args.report) as f:
+        report = json.load(f)
+    return 1 if compare_reports(base, report, args) and args.fail else 0
+
+
+def add_threshold_args(ap):
+    ap.add_argument('--threshold', type=float, default=20.0,
+                    help='Slowdown (or growth) in percent that is a '
+                    'regression', metavar='PCT')
+    ap.add_argument('--min-time', dest='min_time', type=float, default=0.05,
+                    help='Ignore timer differences below this many seconds',
+                    metavar='SEC')
+    ap.add_argument('--fail', action='store_true', default=False,
+                    help='Exit with an error when there are regressions')
+
+
+def main(argv):
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    sub = ap.add_subparsers(dest='cmd')
+
+    rp = sub.add_parser('run', help='Run the corpus')
+    rp.add_argument('--path', default=os.environ.get('PATH', ''),
+                    help='Where to find sea and seahorn')
+    rp.add_argument('--corpus',
+                    default=os.path.join(REPO, 'test', 'bench', 'corpus.json'))
+    rp.add_argument('--out', default='bench.json', help='JSON report')
+    rp.add_argument('--csv', default=None, help='CSV report')
+    rp.add_argument('--baseline', default=None,
+                    help='Report to compare against')
+    rp.add_argument('--repeat', type=int, default=1,
+                    help='Runs per benchmark, timers are the median')
+    rp.add_argument('--timeout', type=int, default=300,
+                    help='Timeout per run in seconds')
+    rp.add_argument('--filter', default=None,
+                    help='Only run benchmarks whose name contains STR',
+                    metavar='STR')
+    add_threshold_args(rp)
+
+    cp = sub.add_parser('compare', help='Compare two reports')
+    cp.add_argument('baseline')
+    cp.add_argument('report')
+    add_threshold_args(cp)
+
+    args = ap.parse_args(argv)
+    if args.cmd == 'run':
+        return run(args)
+    if args.cmd == 'compare':
+        return compare(args)
+    ap.print_help()
+    return 1
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
@@ -1,7 +1,10 @@
 // RUN: %sea bpf -O0 --bmc=mono --bound=10  --horn-stats --inline "%s" 2>&1 | OutputCheck %s
 // RUN: %sea bpf -O0 --horn-bmc-crab=false  --bmc=path --horn-bmc-muc=assume --bound=10  --horn-stats --inline "%s" 2>&1 | OutputCheck %s
 // RUN: %sea bpf -O0 --horn-bmc-crab=false  --bmc=path --horn-bmc-muc=quickXplain --bound=10  --horn-stats --inline "%s" 2>&1 | OutputCheck %s
+// RUN: %sea bpf -O0 --horn-bmc-crab=false  --bmc=path --horn-bmc-muc=incremental --bound=10  --horn-stats --inline "%s" 2>&1 | OutputCheck %s
 // RUN: %sea bpf -O0 --horn-bmc-crab=true  --bmc=path --bound=10  --horn-stats --inline "%s" 2>&1 | OutputCheck %s
+// RUN: %sea bpf -O0 --horn-bmc-crab=false --bmc=path --horn-bmc-path-workers=4 --bound=10  --horn-stats --inline "%s" 2>&1 | OutputCheck %s
+// RUN: %sea bpf -O0 --horn-bmc-crab=false --bmc=path --horn-bmc-path-workers=4 --horn-bmc-retry-budget=10 --bound=10  --horn-stats --inline "%s" 2>&1 | OutputCheck %s
 // RUN: %sea bpf -O0 --horn-gsa --bmc=mono --bound=10  --horn-stats --inline "%s" 2>&1 | OutputCheck %s
 // CHECK: ^sat$
 
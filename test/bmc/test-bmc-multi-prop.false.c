@@ -0,0 +1,23 @@
+// RUN: %sea bpf -O0 --bmc=mono --horn-bmc-multi-prop --bound=10  --horn-stats --inline  "%s" 2>&1 | OutputCheck %s
+// property 1 is x == y, property 2 is x > 0
+// CHECK: ^property 1 .*: unsat$
+// CHECK: ^property 2 .*: sat$
+// CHECK-NOT: ^property 3
+// CHECK: ^sat$
+
+extern int nd(void);
+extern void __VERIFIER_error(void) __attribute__((noreturn));
+#define assert(X) if(!(X)){__VERIFIER_error();}
+
+int main(){
+  int x,y;
+  x=nd(); y=x;
+  if (nd()) {
+    x++;
+    y++;
+  }
+
+  assert (x==y);
+  assert (x > 0);
+  return 0;
+}
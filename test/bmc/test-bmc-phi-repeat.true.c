@@ -0,0 +1,33 @@
+// RUN: %sea bpf -O0 --bmc=mono --horn-vcgen-use-ite=false --bound=1  --horn-stats --inline "%s" 2>&1 | OutputCheck %s
+// RUN: %sea bpf -O0 --bmc=mono --horn-vcgen-use-ite=true --bound=1  --horn-stats --inline "%s" 2>&1 | OutputCheck %s
+// CHECK: ^unsat$
+
+/**
+ * The PHI nodes after the switch get the same value from many of
+ * their predecessors. Each distinct value is defined once, guarded by
+ * the edges that carry it.
+ **/
+
+extern int nd(void);
+extern void __VERIFIER_error(void) __attribute__((noreturn));
+#define assert(X) if(!(X)){__VERIFIER_error();}
+
+int main(){
+  int x, y;
+
+  switch (nd()) {
+  case 0: x = 5; y = 0; break;
+  case 1: x = 5; y = 1; break;
+  case 2: x = 5; y = 0; break;
+  case 3: x = 7; y = 1; break;
+  case 4: x = 5; y = 0; break;
+  case 5: x = 7; y = 1; break;
+  case 6: x = 5; y = 0; break;
+  case 7: x = 9; y = 1; break;
+  default: x = 5; y = 0;
+  }
+
+  assert ((x == 5 && y == 0) || (x == 5 && y == 1) || (x == 7 && y == 1) ||
+          (x == 9 && y == 1));
+  return 0;
+}
@@ -0,0 +1,34 @@
+// RUN: %sea bpf -O0 --bmc=mono --bound=1  --horn-stats --inline "%s" 2>&1 | OutputCheck %s
+// RUN: %sea bpf -O0 --bmc=mono --horn-at-most-one-predecessor --bound=1  --horn-stats --inline "%s" 2>&1 | OutputCheck %s
+// CHECK: ^unsat$
+
+/**
+ * The block after the switch has one predecessor per case. With
+ * --horn-at-most-one-predecessor exactly one of its incoming edges is
+ * taken.
+ **/
+
+extern int nd(void);
+extern void __VERIFIER_error(void) __attribute__((noreturn));
+#define assert(X) if(!(X)){__VERIFIER_error();}
+
+int main(){
+  int x;
+
+  switch (nd()) {
+  case 0: x = 0; break;
+  case 1: x = 10; break;
+  case 2: x = 20; break;
+  case 3: x = 30; break;
+  case 4: x = 40; break;
+  case 5: x = 50; break;
+  case 6: x = 60; break;
+  case 7: x = 70; break;
+  case 8: x = 80; break;
+  case 9: x = 90; break;
+  default: x = 100;
+  }
+
+  assert (x % 10 == 0 && x <= 100);
+  return 0;
+}
@@ -0,0 +1,23 @@
+// RUN: %sea pf -O0 "%s" 2>&1 | OutputCheck %s
+// RUN: %sea smt -O0 --horn-stream-writer "%s" -o %t.smt2
+// RUN: %z3 %t.smt2 2>&1 | OutputCheck %s
+// RUN: %sea smt -O0 --horn-stream-writer --horn-format=pure-smt2 "%s" -o %t.pure.smt2
+// RUN: %z3 %t.pure.smt2 2>&1 | OutputCheck %s --check-prefix=PURE
+// CHECK: ^unsat$
+// PURE: ^sat$
+
+// The clauses written by --horn-stream-writer are read back by z3 with
+// the verdict of seahorn. In the pure SMT-LIB2 format the clauses are
+// satisfiable exactly when the program is safe.
+
+#include "seahorn/seahorn.h"
+extern int nd();
+
+int main() {
+  int x = 0;
+  int n = nd();
+  while (x < n)
+    x++;
+  sassert(x >= 0);
+  return 0;
+}
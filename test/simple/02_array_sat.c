@@ -1,5 +1,8 @@
 // RUN: %sea pf -O0 "%s"  2>&1 | OutputCheck %s
+// RUN: %sea pf -O0 --horn-portfolio=3 --horn-stats "%s"  2>&1 | tee %t.portfolio | OutputCheck %s
+// RUN: OutputCheck %s --check-prefix=PORTFOLIO < %t.portfolio
 // CHECK: ^sat$
+// PORTFOLIO: ^BRUNCH_STAT horn.portfolio.winner (default|no-weak-abs|iuc-0)$
 
 #include "seahorn/seahorn.h"
 #define N 10
@@ -1,4 +1,5 @@
 // RUN: %sea pf -O0 "%s"  2>&1 | OutputCheck %s
+// RUN: %sea pf -O0 --step=small --horn-inter-proc --horn-threads=4 "%s"  2>&1 | OutputCheck %s
 // CHECK: ^unsat$
 
 #include "seahorn/seahorn.h"
@@ -1,5 +1,15 @@
 // RUN: %sea --mem=-1 -m64 pf --step=large -g --horn-global-constraints=true --track=mem --horn-stats --enable-nondet-init --strip-extern --externalize-addr-taken-functions --horn-singleton-aliases=true --devirt-functions --horn-ignore-calloc=false --enable-indvar --enable-loop-idiom --horn-make-undef-warning-error=false --inline "%s"
+// RUN: %sea --mem=-1 -m64 pf --step=large -g --horn-global-constraints=true --track=mem --horn-stats --enable-nondet-init --strip-extern --externalize-addr-taken-functions --horn-singleton-aliases=true --devirt-functions --horn-ignore-calloc=false --enable-indvar --enable-loop-idiom --horn-make-undef-warning-error=false --inline --horn-portfolio=3 "%s" 2>&1 | tee %t.portfolio | OutputCheck %s
+// RUN: OutputCheck %s --check-prefix=PORTFOLIO < %t.portfolio
+// RUN: %sea --mem=-1 -m64 pf --step=small -g --horn-global-constraints=true --track=mem --horn-stats --enable-nondet-init --strip-extern --externalize-addr-taken-functions --horn-singleton-aliases=true --devirt-functions --horn-ignore-calloc=false --enable-indvar --enable-loop-idiom --horn-make-undef-warning-error=false --inline --horn-houdini --horn-houdini-config=assumptions --horn-houdini-workers=1 "%s" 2>&1 | tee %t.w1 | OutputCheck %s
+// RUN: %sea --mem=-1 -m64 pf --step=small -g --horn-global-constraints=true --track=mem --horn-stats --enable-nondet-init --strip-extern --externalize-addr-taken-functions --horn-singleton-aliases=true --devirt-functions --horn-ignore-calloc=false --enable-indvar --enable-loop-idiom --horn-make-undef-warning-error=false --inline --horn-houdini --horn-houdini-config=assumptions --horn-houdini-workers=4 "%s" 2>&1 | tee %t.w4 | OutputCheck %s
+// RUN: grep "^BRUNCH_STAT Houdini .* candidates" %t.w1 > %t.c1
+// RUN: grep "^BRUNCH_STAT Houdini .* candidates" %t.w4 | diff %t.c1 -
+// RUN: OutputCheck %s --check-prefix=HOUDINI < %t.c1
 // CHECK: ^unsat$
+// PORTFOLIO: ^BRUNCH_STAT horn.portfolio.winner (default|no-weak-abs|iuc-0)$
+// HOUDINI: ^BRUNCH_STAT Houdini dropped candidates [1-9][0-9]*$
+// HOUDINI: ^BRUNCH_STAT Houdini kept candidates [0-9]+$
 
 #include "seahorn/seahorn.h"
 int unknown1();
@@ -125,6 +125,16 @@ static llvm::cl::opt<bool> PrintStats("horn-stats",
                                       llvm::cl::desc("Print statistics"),
                                       llvm::cl::init(false));
 
+static llvm::cl::opt<std::string>
+    StatsJsonFilename("horn-stats-json",
+                      llvm::cl::desc("Write statistics in JSON to a file"),
+                      llvm::cl::init(""), llvm::cl::value_desc("filename"));
+
+static llvm::cl::opt<std::string>
+    StatsCsvFilename("horn-stats-csv",
+                     llvm::cl::desc("Write statistics in CSV to a file"),
+                     llvm::cl::init(""), llvm::cl::value_desc("filename"));
+
 static llvm::cl::opt<bool>
     Cex("horn-cex-pass", llvm::cl::desc("Produce detailed counterexample"),
         llvm::cl::init(false));
@@ -202,6 +212,19 @@ std::string getFileName(const std::string &str) {
   return filename;
 }
 
+// -- writes statistics to a file using one of the printers of Stats
+static void writeStats(const std::string &fname,
+                       void (*print)(llvm::raw_ostream &)) {
+  std::error_code error_code;
+  llvm::raw_fd_ostream out(fname, error_code, llvm::sys::fs::F_Text);
+  if (error_code) {
+    llvm::errs() << "error: Could not open " << fname << ": "
+                 << error_code.message() << "\n";
+    return;
+  }
+  print(out);
+}
+
 int main(int argc, char **argv) {
   seahorn::ScopedStats _st("seahorn_total");
 
@@ -434,5 +457,9 @@ int main(int argc, char **argv) {
     output->keep();
   if (PrintStats)
     seahorn::Stats::PrintBrunch(llvm::outs());
+  if (!StatsJsonFilename.empty())
+    writeStats(StatsJsonFilename, seahorn::Stats::PrintJson);
+  if (!StatsCsvFilename.empty())
+    writeStats(StatsCsvFilename, seahorn::Stats::PrintCsv);
   return 0;
 }
@@ -0,0 +1,51 @@
+#include "seahorn/Expr/Smt/EZ3.hh"
+#include "seahorn/Expr/ExprAig.hh"
+
+#include "doctest.h"
+#include "z3_util.hh"
+
+using namespace seahorn;
+using namespace expr;
+using namespace expr::op;
+using seahorn::units::provedEq;
+
+TEST_CASE("aig.simplify") {
+  ExprFactory efac;
+  EZ3 z3(efac);
+
+  Expr a = bind::boolConst(mkTerm<std::string>("a", efac));
+  Expr b = bind::boolConst(mkTerm<std::string>("b", efac));
+  Expr c = bind::boolConst(mkTerm<std::string>("c", efac));
+  Expr x = bind::intConst(mkTerm<std::string>("x", efac));
+  Expr lt = mk<LT>(x, mkTerm<expr::mpz_class>(0UL, efac));
+
+  // -- structural hashing
+  ExprVector ab = {mk<AND>(a, b), mk<AND>(b, a)}, abOut;
+  boolop::aig(ab, abOut);
+  CHECK(abOut[0] == abOut[1]);
+  CHECK(boolop::aigSize(mk<OR>(mk<AND>(a, b), mk<AND>(b, a))) == 3);
+
+  // -- constant propagation and two-level rules
+  CHECK(isOpX<FALSE>(boolop::aig(mk<AND>(mk<AND>(a, lt), mk<NEG>(lt)))));
+  CHECK(boolop::aig(mk<OR>(mk<AND>(a, b), mk<AND>(a, mk<NEG>(b)))) == a);
+  CHECK(boolop::aig(mk<AND>(mk<OR>(a, b), a)) == a);
+
+  // -- equivalences that only fraiging finds
+  Expr axb = mk<XOR>(mk<XOR>(a, b), b);
+  CHECK(boolop::aig(axb) == a);
+  Expr maj = mk<OR>(mk<OR>(mk<AND>(a, b), mk<AND>(b, c)), mk<AND>(a, c));
+  Expr maj2 = mk<ITE>(a, mk<OR>(b, c), mk<AND>(b, c));
+  CHECK(isOpX<TRUE>(boolop::aig(mk<IFF>(maj, maj2))));
+
+  // -- shared AIG for several formulas
+  ExprVector in = {maj, maj2, mk<IMPL>(lt, maj)}, out;
+  boolop::aig(in, out);
+  REQUIRE(out.size() == 3);
+  CHECK(out[0] == out[1]);
+  CHECK(boolop::aigSize(out) < boolop::aigSize(in));
+  for (unsigned i = 0; i < in.size(); ++i)
+    CHECK(provedEq(z3, in[i], out[i]));
+
+  Expr flat = boolop::flat_aig(mk<IMPL>(lt, maj));
+  CHECK(provedEq(z3, flat, in[2]));
+}
@@ -0,0 +1,46 @@
+#pragma once
+/// Helpers shared by the micro-benchmarks
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include <unistd.h>
+
+namespace seahorn {
+namespace units {
+using bench_clock = std::chrono::steady_clock;
+
+inline double elapsedSec(bench_clock::time_point start) {
+  return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+/// \brief Resident set size of the process in bytes (0 if unknown)
+inline size_t residentBytes() {
+  std::ifstream statm("/proc/self/statm");
+  size_t size = 0, resident = 0;
+  if (statm >> size >> resident)
+    return resident * sysconf(_SC_PAGESIZE);
+  return 0;
+}
+
+/// \brief Prints the throughput of a phase that handles \p nodes nodes
+inline void report(const char *name, size_t nodes, double sec) {
+  std::cout << std::left << std::setw(28) << name << std::right
+            << std::setw(12) << nodes << " nodes " << std::fixed
+            << std::setprecision(3) << std::setw(9) << sec << " s "
+            << std::setprecision(1) << std::setw(9)
+            << (sec > 0 ? nodes / sec / 1e6 : 0) << " Mnodes/s\n";
+}
+
+/// \brief Prints the time and memory of a phase that does \p ops operations
+inline void report(const char *name, size_t ops, double sec, size_t bytes) {
+  std::cout << std::left << std::setw(24) << name << std::right
+            << std::setw(10) << ops << " ops " << std::fixed
+            << std::setprecision(3) << std::setw(9) << sec << " s "
+            << std::setw(9) << bytes / (1024 * 1024) << " MB\n";
+}
+} // namespace units
+} // namespace seahorn
@@ -0,0 +1,102 @@
+/**==-- ControlDependenceAnalysis Tests --==*/
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "doctest.h"
+#include "seahorn/Analysis/ControlDependenceAnalysis.hh"
+
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/Support/SourceMgr.h"
+
+#include <random>
+#include <sstream>
+
+using namespace llvm;
+using namespace seahorn;
+
+namespace {
+/// A function with n blocks. Block i branches to i + 1 and to a random
+/// block, so there are both forward edges and loops of all sizes.
+std::string randomCfg(unsigned n, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::ostringstream out;
+  out << "define void @f(i1 %c) {\n";
+  for (unsigned i = 0; i < n; ++i) {
+    out << "b" << i << ":\n";
+    if (i + 1 == n) {
+      out << "  ret void\n";
+      continue;
+    }
+    // -- the entry block has no predecessors
+    unsigned other = 1 + rng() % (n - 1);
+    // -- mostly forward edges, as in inlined code
+    if (rng() % 4)
+      other = i + 1 + rng() % (n - i - 1);
+    out << "  br i1 %c, label %b" << i + 1 << ", label %b" << other << "\n";
+  }
+  out << "}\n";
+  return out.str();
+}
+
+/// runs the analysis and checks isReachable against a search from each block
+void checkReach(const std::string &ir) {
+  LLVMContext ctx;
+  SMDiagnostic err;
+  std::unique_ptr<Module> M = parseAssemblyString(ir, err, ctx);
+  REQUIRE(M);
+  Function &F = *M->getFunction("f");
+
+  auto *cda = new ControlDependenceAnalysisPass();
+  legacy::PassManager pm;
+  pm.add(cda);
+  pm.run(*M);
+  ControlDependenceAnalysis &CDA = cda->getControlDependenceAnalysis(F);
+
+  unsigned reachable = 0;
+  for (BasicBlock &src : F) {
+    SmallPtrSet<BasicBlock *, 32> seen = {&src};
+    SmallVector<BasicBlock *, 64> stack = {&src};
+    while (!stack.empty())
+      for (BasicBlock *succ : successors(stack.pop_back_val()))
+        if (seen.insert(succ).second)
+          stack.push_back(succ);
+    for (BasicBlock &dst : F) {
+      bool expected = seen.count(&dst);
+      reachable += expected;
+      if (CDA.isReachable(&src, &dst) != expected) {
+        FAIL_CHECK(src.getName().str() << " ~> " << dst.getName().str()
+                                       << " expected " << expected);
+        return;
+      }
+    }
+  }
+  CHECK(reachable > 0);
+}
+} // namespace
+
+TEST_CASE("cda.reach.random") {
+  for (unsigned seed = 0; seed < 20; ++seed) {
+    CAPTURE(seed);
+    checkReach(randomCfg(60, seed));
+  }
+}
+
+TEST_CASE("cda.reach.loops") {
+  // -- a loop nest with an exit from the inner loop
+  checkReach(R"(
+define void @f(i1 %c) {
+entry:
+  br label %outer
+outer:
+  br i1 %c, label %inner, label %exit
+inner:
+  br i1 %c, label %inner, label %latch
+latch:
+  br i1 %c, label %outer, label %exit
+exit:
+  ret void
+}
+)");
+}
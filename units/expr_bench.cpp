@@ -0,0 +1,118 @@
+/**==-- Expr Micro-Benchmarks --==*/
+///
+/// Throughput of ExprFactory node creation. The benchmark uses only the
+/// public Expr API so that it can be compiled against older revisions of the
+/// factory and the numbers compared side by side. The terms are synthetic
+/// and do not have the shape of a VC produced by BmcEngine::encode.
+///
+/// Usage: expr_bench [num_nodes]
+#include "seahorn/Expr/Expr.hh"
+
+#include <boost/functional/hash.hpp>
+
+#include "bench_util.hh"
+
+#include <cstdlib>
+#include <iostream>
+
+using namespace expr;
+using namespace seahorn::units;
+
+namespace {
+/// \brief Depth-first traversal of the DAG below \p roots
+///
+/// Uses an explicit stack and a bitmap indexed by node id, so that the cost
+/// is dominated by reading the nodes themselves.
+size_t traverse(const ExprVector &roots) {
+  std::vector<bool> seen;
+  std::vector<ENode *> stack;
+  size_t visited = 0;
+  for (const Expr &r : roots)
+    stack.push_back(r.get());
+  while (!stack.empty()) {
+    ENode *n = stack.back();
+    stack.pop_back();
+    if (n->getId() >= seen.size())
+      seen.resize(2 * n->getId() + 1, false);
+    if (seen[n->getId()])
+      continue;
+    seen[n->getId()] = true;
+    ++visited;
+    for (auto it = n->args_begin(), end = n->args_end(); it != end; ++it)
+      stack.push_back(*it);
+  }
+  return visited;
+}
+
+/// \brief Builds a DAG with \p n internal nodes over \p leaves
+///
+/// Mixes unary, binary and ternary operators from different families so that
+/// the unique table sees a realistic spread of operators. All nodes are
+/// returned so that they stay alive until the result is released.
+ExprVector buildDag(const ExprVector &leaves, size_t n) {
+  ExprVector nodes(leaves);
+  nodes.reserve(leaves.size() + n);
+  for (size_t i = 0; i < n; ++i) {
+    Expr a = nodes[(i * 7) % nodes.size()];
+    Expr b = nodes[(i * 13 + 1) % nodes.size()];
+    Expr c = nodes[(i * 31 + 2) % nodes.size()];
+    switch (i % 4) {
+    case 0:
+      nodes.push_back(mk<PLUS>(a, b));
+      break;
+    case 1:
+      nodes.push_back(mk<MULT>(a, b));
+      break;
+    case 2:
+      nodes.push_back(mk<ITE>(mk<LT>(a, b), b, c));
+      break;
+    default:
+      nodes.push_back(mk<UN_MINUS>(a));
+    }
+  }
+  return nodes;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+
+  ExprFactory efac;
+  ExprVector leaves;
+  for (unsigned i = 0; i < 1024; ++i)
+    leaves.push_back(mkTerm<unsigned>(i, efac));
+
+  // -- fresh nodes: every mk inserts into the unique table
+  size_t rss = residentBytes();
+  auto start = bench_clock::now();
+  ExprVector dag = buildDag(leaves, n);
+  report("create (miss)", n, elapsedSec(start));
+  std::cout << "memory: " << (residentBytes() - rss) / n
+            << " bytes/node (resident, including the node vector)\n";
+
+  start = bench_clock::now();
+  size_t visited = 0;
+  for (unsigned i = 0; i < 10; ++i)
+    visited += traverse(dag);
+  report("traverse (10x)", visited, elapsedSec(start));
+
+  // -- same DAG again: every mk is a unique table hit
+  start = bench_clock::now();
+  ExprVector dag2 = buildDag(leaves, n);
+  report("create (hit)", n, elapsedSec(start));
+  if (dag != dag2) {
+    std::cerr << "error: hash-consing failed\n";
+    return 1;
+  }
+
+  // -- release everything and build it again through the free list
+  start = bench_clock::now();
+  dag2.clear();
+  dag.clear();
+  report("release", n, elapsedSec(start));
+
+  start = bench_clock::now();
+  dag = buildDag(leaves, n);
+  report("re-create (miss)", n, elapsedSec(start));
+  return 0;
+}
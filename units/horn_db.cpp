@@ -0,0 +1,413 @@
+/**==-- HornClauseDB Tests --==*/
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "doctest.h"
+#include "seahorn/Expr/Expr.hh"
+#include "seahorn/Expr/ExprOpBinder.hh"
+#include "seahorn/Expr/Smt/EZ3.hh"
+#include "seahorn/HornClauseDB.hh"
+#include "seahorn/HornClauseDBTransf.hh"
+
+using namespace expr;
+using namespace seahorn;
+
+static Expr mkFun(const std::string &name, ExprVector sort) {
+  return bind::fdecl(mkTerm(name, sort.at(0)->efac()), sort);
+}
+
+TEST_CASE("horn_db.rules") {
+  ExprFactory efac;
+  HornClauseDB db(efac);
+
+  Expr iTy = sort::intTy(efac);
+  Expr bTy = sort::boolTy(efac);
+  Expr p = mkFun("p", {iTy, bTy});
+  Expr q = mkFun("q", {iTy, bTy});
+  db.registerRelation(p);
+  db.registerRelation(q);
+
+  Expr x = bind::intConst(mkTerm<std::string>("x", efac));
+  Expr zero = mkTerm<expr::mpz_class>(0UL, efac);
+  ExprVector vars = {x};
+
+  // p(x) <- x = 0.  q(x) <- p(x).
+  db.addRule(vars, mk<IMPL>(mk<EQ>(x, zero), bind::fapp(p, x)));
+  db.addRule(vars, mk<IMPL>(bind::fapp(p, x), bind::fapp(q, x)));
+  REQUIRE(db.getRules().size() == 2);
+
+  const HornRule &r1 = db.getRules().front();
+  const HornRule &r2 = db.getRules().back();
+  CHECK(r1.id() != 0);
+  CHECK(r1.id() < r2.id());
+  CHECK(db.getRule(r2.id()) == &r2);
+
+  // -- equality is structural and ignores ids
+  HornRule copy(vars, r2.head(), r2.body());
+  CHECK(copy.id() == 0);
+  CHECK(copy == r2);
+  CHECK(!(copy == r1));
+
+  // -- indexes are up to date without buildIndexes
+  CHECK(db.def(p).size() == 1);
+  CHECK(db.def(q).size() == 1);
+  CHECK(db.use(p).size() == 1);
+  CHECK(*db.use(p).begin() == &r2);
+
+  unsigned id1 = r1.id();
+  db.removeRule(copy);
+  CHECK(db.getRules().size() == 1);
+  CHECK(db.use(p).empty());
+  CHECK(db.def(q).empty());
+  // -- the other rule keeps its id and address
+  CHECK(db.getRule(id1) == &db.getRules().front());
+}
+
+TEST_CASE("horn_db.scale") {
+  ExprFactory efac;
+  HornClauseDB db(efac);
+
+  Expr iTy = sort::intTy(efac);
+  Expr bTy = sort::boolTy(efac);
+  Expr p = mkFun("p", {iTy, bTy});
+  Expr q = mkFun("q", {iTy, bTy});
+  db.registerRelation(p);
+  db.registerRelation(q);
+
+  Expr x = bind::intConst(mkTerm<std::string>("x", efac));
+  ExprVector vars = {x};
+
+  // q(x) <- p(x) && x = i, for i in [0, N)
+  const unsigned N = 100000;
+  for (unsigned i = 0; i < N; ++i) {
+    Expr body = mk<AND>(bind::fapp(p, x),
+                        mk<EQ>(x, mkTerm<expr::mpz_class>(i, efac)));
+    db.addRule(vars, mk<IMPL>(body, bind::fapp(q, x)));
+  }
+  CHECK(db.getRules().size() == N);
+  CHECK(db.use(p).size() == N);
+  CHECK(db.def(q).size() == N);
+
+  // -- remove through copies, as HornClauseDBTransf does
+  std::vector<HornRule> worklist(db.getRules().begin(), db.getRules().end());
+  for (const HornRule &r : worklist)
+    db.removeRule(r);
+  CHECK(db.getRules().empty());
+  CHECK(db.use(p).empty());
+  CHECK(db.def(q).empty());
+}
+
+TEST_CASE("horn_db.append") {
+  ExprFactory efac;
+  HornClauseDB db(efac), other(efac);
+
+  Expr iTy = sort::intTy(efac);
+  Expr bTy = sort::boolTy(efac);
+  Expr p = mkFun("p", {iTy, bTy});
+  Expr q = mkFun("q", {iTy, bTy});
+  Expr err = mkFun("err", {bTy});
+  db.registerRelation(p);
+  other.registerRelation(p);
+  other.registerRelation(q);
+  other.registerRelation(err);
+
+  Expr x = bind::intConst(mkTerm<std::string>("x", efac));
+  Expr zero = mkTerm<expr::mpz_class>(0UL, efac);
+  ExprVector vars = {x};
+
+  // db: p(x) <- x = 0.  other: q(x) <- p(x).  err <- q(x), x < 0.
+  db.addRule(vars, mk<IMPL>(mk<EQ>(x, zero), bind::fapp(p, x)));
+  other.addRule(vars, mk<IMPL>(bind::fapp(p, x), bind::fapp(q, x)));
+  other.addRule(vars, mk<IMPL>(mk<AND>(bind::fapp(q, x), mk<LT>(x, zero)),
+                               bind::fapp(err)));
+  other.addQuery(bind::fapp(err));
+  Expr v0 = bind::intConst(variant::variant(0, mkTerm<std::string>("V", efac)));
+  other.addConstraint(bind::fapp(q, v0), mk<GEQ>(v0, zero));
+
+  db.append(other);
+  CHECK(db.getRules().size() == 3);
+  CHECK(db.getRelations().size() == 3);
+  CHECK(db.getQueries().size() == 1);
+  CHECK(db.hasConstraints(q));
+  CHECK(!other.getRules().empty());
+
+  // -- appended rules get ids of db and are indexed
+  const HornRule &first = db.getRules().front();
+  for (const HornRule &r : db.getRules()) {
+    CHECK(db.getRule(r.id()) == &r);
+    if (&r != &first)
+      CHECK(first.id() < r.id());
+  }
+  CHECK(db.def(p).size() == 1);
+  CHECK(db.use(p).size() == 1);
+  CHECK(db.def(q).size() == 1);
+  CHECK(db.use(q).size() == 1);
+  CHECK(db.def(err).size() == 1);
+  CHECK(bind::fname((*db.use(p).begin())->head()) == q);
+}
+
+TEST_CASE("horn_db.preprocess") {
+  ExprFactory efac;
+  EZ3 z3(efac);
+  HornClauseDB db(efac);
+
+  Expr iTy = sort::intTy(efac);
+  Expr bTy = sort::boolTy(efac);
+  Expr p = mkFun("p", {iTy, bTy});
+  Expr q = mkFun("q", {iTy, bTy});
+  Expr r = mkFun("r", {iTy, iTy, bTy});
+  Expr s = mkFun("s", {iTy, bTy});
+  Expr t = mkFun("t", {iTy, bTy});
+  Expr u = mkFun("u", {iTy, bTy});
+  Expr err = mkFun("err", {bTy});
+  for (Expr rel : {p, q, r, s, t, u, err})
+    db.registerRelation(rel);
+
+  Expr x = bind::intConst(mkTerm<std::string>("x", efac));
+  Expr y = bind::intConst(mkTerm<std::string>("y", efac));
+  Expr z = bind::intConst(mkTerm<std::string>("z", efac));
+  Expr w = bind::intConst(mkTerm<std::string>("w", efac));
+  Expr zero = mkTerm<expr::mpz_class>(0UL, efac);
+  Expr one = mkTerm<expr::mpz_class>(1UL, efac);
+  ExprVector vars = {x, y, z, w};
+
+  // p(x) <- x = 0.  q(y) <- p(x), y = x + 1.  r(y, z) <- q(y), z = 0.
+  // r(x, w) <- r(y, z), x = y + 1.  err <- r(y, z), y < 0.
+  // s(x) <- x = 1.  t(x) <- u(x).  u(x) <- t(x).  err <- t(x).
+  db.addRule(vars, mk<IMPL>(mk<EQ>(x, zero), bind::fapp(p, x)));
+  const HornRule &pFact = db.getRules().back();
+  db.addRule(vars, mk<IMPL>(mk<AND>(bind::fapp(p, x),
+                                    mk<EQ>(y, mk<PLUS>(x, one))),
+                            bind::fapp(q, y)));
+  db.addRule(vars, mk<IMPL>(mk<AND>(bind::fapp(q, y), mk<EQ>(z, zero)),
+                            bind::fapp(r, y, z)));
+  db.addRule(vars, mk<IMPL>(mk<AND>(bind::fapp(r, y, z),
+                                    mk<EQ>(x, mk<PLUS>(y, one))),
+                            bind::fapp(r, x, w)));
+  db.addRule(vars, mk<IMPL>(mk<AND>(bind::fapp(r, y, z), mk<LT>(y, zero)),
+                            bind::fapp(err)));
+  db.addRule(vars, mk<IMPL>(mk<EQ>(x, one), bind::fapp(s, x)));
+  db.addRule(vars, mk<IMPL>(bind::fapp(u, x), bind::fapp(t, x)));
+  db.addRule(vars, mk<IMPL>(bind::fapp(t, x), bind::fapp(u, x)));
+  db.addRule(vars, mk<IMPL>(bind::fapp(t, x), bind::fapp(err)));
+  db.addQuery(bind::fapp(err));
+
+  HornClauseDB tdb(efac);
+  HornPreprocessConverter conv(z3);
+  preprocessHornClauses(db, tdb, conv);
+
+  // -- s is sliced, t and u are dead, p and q are inlined and the
+  // -- second argument of r is never used
+  CHECK(tdb.getRules().size() == 3);
+  CHECK(tdb.getRelations().size() == 2);
+  CHECK(db.getRules().size() == 9);
+  Expr tr;
+  for (Expr rel : tdb.getRelations())
+    if (rel != err)
+      tr = rel;
+  REQUIRE(tr);
+  CHECK(bind::domainSz(tr) == 1);
+  CHECK(tdb.use(tr).size() == 2);
+  CHECK(tdb.def(tr).size() == 2);
+
+  // -- a cex of tdb, from the query back to the fact. Its rules are
+  // -- named by their id in tdb
+  ExprVector cex, ocex;
+  std::vector<std::string> names;
+  auto addCex = [&](const HornRule *rule) {
+    cex.push_back(rule->get());
+    names.push_back(std::to_string(rule->id()));
+  };
+  addCex(*tdb.def(err).begin());
+  for (HornRule *rule : tdb.use(tr))
+    if (bind::fname(rule->head()) == tr)
+      addCex(rule);
+  for (HornRule *rule : tdb.def(tr))
+    if (tdb.use(tr).count(rule) == 0)
+      addCex(rule);
+  REQUIRE(cex.size() == 3);
+  REQUIRE(conv.convertCex(cex, names, ocex));
+  CHECK(ocex.size() == 5);
+  CHECK(ocex.back() == pFact.get());
+
+  // -- rules that are not in tdb cannot be mapped back
+  names.back() = "1000";
+  ocex.clear();
+  CHECK_FALSE(conv.convertCex(cex, names, ocex));
+
+  // -- a model of tdb: tr(V_0) := V_0 >= 1, err := false
+  Expr v0 = bind::intConst(variant::variant(0, mkTerm<std::string>("V", efac)));
+  Expr v1 = bind::intConst(variant::variant(1, mkTerm<std::string>("V", efac)));
+  HornDbModel in, out;
+  in.addDef(bind::fapp(tr, v0), mk<GEQ>(v0, one));
+  in.addDef(bind::fapp(err), mk<FALSE>(efac));
+  REQUIRE(conv.convert(in, out));
+
+  CHECK(isOpX<TRUE>(out.getDef(bind::fapp(s, v0))));
+  CHECK(isOpX<FALSE>(out.getDef(bind::fapp(t, v0))));
+  CHECK(out.getDef(bind::fapp(r, v0, v1)) == mk<GEQ>(v0, one));
+  // -- p and q are the images of their rules
+  Expr pDef = out.getDef(bind::fapp(p, v0));
+  Expr qDef = out.getDef(bind::fapp(q, v0));
+  CHECK(bool(!z3_is_sat(z3, mk<AND>(pDef, mk<NEQ>(v0, zero)))));
+  CHECK(bool(!z3_is_sat(z3, mk<AND>(qDef, mk<NEQ>(v0, one)))));
+  CHECK(bool(z3_is_sat(z3, qDef)));
+}
+
+TEST_CASE("horn_db.preprocess.inline_top_level") {
+  ExprFactory efac;
+  EZ3 z3(efac);
+  HornClauseDB db(efac);
+
+  Expr iTy = sort::intTy(efac);
+  Expr bTy = sort::boolTy(efac);
+  Expr p = mkFun("p", {iTy, bTy});
+  Expr q = mkFun("q", {iTy, bTy});
+  Expr s = mkFun("s", {iTy, bTy});
+  Expr u = mkFun("u", {iTy, bTy});
+  Expr err = mkFun("err", {bTy});
+  for (Expr rel : {p, q, s, u, err})
+    db.registerRelation(rel);
+
+  Expr x = bind::intConst(mkTerm<std::string>("x", efac));
+  Expr zero = mkTerm<expr::mpz_class>(0UL, efac);
+  Expr one = mkTerm<expr::mpz_class>(1UL, efac);
+  Expr two = mkTerm<expr::mpz_class>(2UL, efac);
+  ExprVector vars = {x};
+
+  // p(x) <- x = 0.  q(x) <- p(x) || x = 1.  s(x) <- x = 2.
+  // u(x) <- !s(x).  err <- q(x), u(x).
+  // -- p and s have one defining and one using rule, but they are not
+  // -- applied as top-level conjuncts so they must not be inlined
+  db.addRule(vars, mk<IMPL>(mk<EQ>(x, zero), bind::fapp(p, x)));
+  db.addRule(vars, mk<IMPL>(mk<OR>(bind::fapp(p, x), mk<EQ>(x, one)),
+                            bind::fapp(q, x)));
+  db.addRule(vars, mk<IMPL>(mk<EQ>(x, two), bind::fapp(s, x)));
+  db.addRule(vars, mk<IMPL>(mk<NEG>(bind::fapp(s, x)), bind::fapp(u, x)));
+  db.addRule(vars, mk<IMPL>(mk<AND>(bind::fapp(q, x), bind::fapp(u, x)),
+                            bind::fapp(err)));
+  db.addQuery(bind::fapp(err));
+
+  HornClauseDB tdb(efac);
+  HornPreprocessConverter conv(z3);
+  preprocessHornClauses(db, tdb, conv);
+
+  CHECK(tdb.getRules().size() == 5);
+  CHECK(tdb.getRelations().size() == 5);
+  for (Expr rel : {p, q, s, u}) {
+    CHECK(tdb.def(rel).size() == 1);
+    CHECK(tdb.use(rel).size() == 1);
+  }
+}
+
+TEST_CASE("horn_db.preprocess.cex_diamond") {
+  ExprFactory efac;
+  EZ3 z3(efac);
+  HornClauseDB db(efac);
+
+  Expr iTy = sort::intTy(efac);
+  Expr bTy = sort::boolTy(efac);
+  Expr a = mkFun("a", {iTy, bTy});
+  Expr b = mkFun("b", {iTy, bTy});
+  Expr c = mkFun("c", {iTy, bTy});
+  Expr err = mkFun("err", {bTy});
+  for (Expr rel : {a, b, c, err})
+    db.registerRelation(rel);
+
+  Expr x = bind::intConst(mkTerm<std::string>("x", efac));
+  Expr zero = mkTerm<expr::mpz_class>(0UL, efac);
+  Expr one = mkTerm<expr::mpz_class>(1UL, efac);
+  ExprVector vars = {x};
+
+  // -- the CFG of if (x == 1) { ... }: a -> b -> c and a -> c.
+  // a(x) <- x = 0.  b(x) <- a(x), x = 1.  c(x) <- b(x).  c(x) <- a(x).
+  // err <- c(x), x = 0.
+  // -- b is inlined, so both rules of c in tdb go from a to c. Only the
+  // -- direct edge reaches err.
+  db.addRule(vars, mk<IMPL>(mk<EQ>(x, zero), bind::fapp(a, x)));
+  db.addRule(vars, mk<IMPL>(mk<AND>(bind::fapp(a, x), mk<EQ>(x, one)),
+                            bind::fapp(b, x)));
+  db.addRule(vars, mk<IMPL>(bind::fapp(b, x), bind::fapp(c, x)));
+  db.addRule(vars, mk<IMPL>(bind::fapp(a, x), bind::fapp(c, x)));
+  const HornRule &direct = db.getRules().back();
+  db.addRule(vars, mk<IMPL>(mk<AND>(bind::fapp(c, x), mk<EQ>(x, zero)),
+                            bind::fapp(err)));
+  db.addQuery(bind::fapp(err));
+
+  HornClauseDB tdb(efac);
+  HornPreprocessConverter conv(z3);
+  preprocessHornClauses(db, tdb, conv);
+  REQUIRE(tdb.def(c).size() == 2);
+
+  ZFixedPoint<EZ3> fp(z3);
+  ZParams<EZ3> params(z3);
+  params.set(":engine", "spacer");
+  params.set(":xform.slice", false);
+  params.set(":xform.inline-linear", false);
+  params.set(":xform.inline-eager", false);
+  fp.set(params);
+  tdb.loadZFixedPoint(fp, false, false, true);
+  REQUIRE(static_cast<bool>(fp.query()));
+
+  ExprVector cex, ocex;
+  std::vector<std::string> names;
+  fp.getCexRules(cex);
+  fp.getCexRuleNames(names);
+  REQUIRE(conv.convertCex(cex, names, ocex));
+
+  // -- the cex takes the direct edge and never goes through b
+  ExprSet orules(ocex.begin(), ocex.end());
+  CHECK(orules.count(direct.get()) == 1);
+  for (HornRule *rule : db.def(b))
+    CHECK(orules.count(rule->get()) == 0);
+  for (HornRule *rule : db.use(b))
+    CHECK(orules.count(rule->get()) == 0);
+
+  // -- the direct edge of tdb maps to exactly that rule of db
+  for (HornRule *rule : tdb.def(c)) {
+    ExprVector one_rule;
+    REQUIRE(conv.convertCex({rule->get()}, {std::to_string(rule->id())},
+                            one_rule));
+    if (one_rule.size() == 1)
+      CHECK(one_rule[0] == direct.get());
+    else
+      CHECK(one_rule.size() == 2);
+  }
+}
+
+TEST_CASE("horn_db.register_after_rules") {
+  ExprFactory efac;
+  HornClauseDB db(efac);
+
+  Expr iTy = sort::intTy(efac);
+  Expr bTy = sort::boolTy(efac);
+  Expr p = mkFun("p", {iTy, bTy});
+  Expr q = mkFun("q", {iTy, bTy});
+
+  Expr x = bind::intConst(mkTerm<std::string>("x", efac));
+  Expr zero = mkTerm<expr::mpz_class>(0UL, efac);
+  ExprVector vars = {x};
+
+  // q(x) <- p(x) is added before p and q are registered
+  db.addRule(vars, mk<IMPL>(bind::fapp(p, x), bind::fapp(q, x)));
+  const HornRule &r = db.getRules().back();
+  CHECK(db.use(p).empty());
+  CHECK(db.def(q).size() == 1);
+
+  db.registerRelation(q);
+  db.registerRelation(p);
+  REQUIRE(db.use(p).size() == 1);
+  CHECK(*db.use(p).begin() == &r);
+  CHECK(db.use(q).empty());
+
+  // -- later rules are indexed as usual
+  db.addRule(vars, mk<IMPL>(mk<AND>(bind::fapp(p, x), mk<EQ>(x, zero)),
+                            bind::fapp(q, x)));
+  CHECK(db.use(p).size() == 2);
+  db.registerRelation(p);
+  CHECK(db.use(p).size() == 2);
+
+  HornRule copy(vars, r.head(), r.body());
+  db.removeRule(copy);
+  CHECK(db.use(p).size() == 1);
+  CHECK(db.def(q).size() == 1);
+}
@@ -0,0 +1,268 @@
+/**==-- LiveSymbols Tests --==*/
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "doctest.h"
+#include "seahorn/Expr/ExprLlvm.hh"
+#include "seahorn/LiveSymbols.hh"
+#include "seahorn/UfoOpSem.hh"
+
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/SourceMgr.h"
+
+#include <set>
+
+using namespace expr;
+using namespace seahorn;
+
+namespace {
+/// Integer registers only. A block is executed by reading all operands
+/// of an instruction and havocing its register.
+class TestOpSem : public OperationalSemantics {
+public:
+  TestOpSem(ExprFactory &efac) : OperationalSemantics(efac) {}
+
+  bool isTracked(const Value &v) const override {
+    return v.getType()->isIntegerTy();
+  }
+
+  Expr mkSymbReg(const Value &v, OpSemContext &ctx) override {
+    return getSymbReg(v, ctx);
+  }
+  Expr getSymbReg(const Value &v, const OpSemContext &ctx) const override {
+    if (const ConstantInt *c = dyn_cast<ConstantInt>(&v))
+      return mkTerm<expr::mpz_class>(c->getZExtValue(), m_efac);
+    if (!isTracked(v) || isa<Constant>(v))
+      return Expr();
+    return bind::intConst(mkTerm<const Value *>(&v, m_efac));
+  }
+  const Value &conc(Expr v) const override {
+    return *getTerm<const Value *>(bind::fname(bind::fname(v)));
+  }
+  Expr lookup(SymStore &s, const Value &v) override {
+    OpSemContext ctx(s, m_side);
+    Expr r = mkSymbReg(v, ctx);
+    return r && bind::isFapp(r) ? s.read(r) : r;
+  }
+
+  void exec(const BasicBlock &bb, OpSemContext &ctx) override {
+    ++m_execs;
+    ctx.values().read(errorFlag(bb));
+    for (const Instruction &I : bb) {
+      if (isa<PHINode>(I))
+        continue;
+      for (const Value *op : I.operand_values())
+        lookup(ctx.values(), *op);
+      if (isTracked(I))
+        ctx.values().havoc(mkSymbReg(I, ctx));
+    }
+  }
+  void execPhi(const BasicBlock &bb, const BasicBlock &from,
+               OpSemContext &ctx) override {
+    for (const Instruction &I : bb)
+      if (const PHINode *phi = dyn_cast<PHINode>(&I)) {
+        lookup(ctx.values(), *phi->getIncomingValueForBlock(&from));
+        ctx.values().havoc(mkSymbReg(*phi, ctx));
+      }
+  }
+  void execEdg(const BasicBlock &src, const BasicBlock &dst,
+               OpSemContext &ctx) override {}
+  void execBr(const BasicBlock &src, const BasicBlock &dst,
+              OpSemContext &ctx) override {}
+
+  unsigned m_execs = 0;
+
+private:
+  ExprVector m_side;
+};
+
+const char *kLoop = R"(
+declare void @g(i32)
+
+define i32 @f(i32 %n, i32 %a, i32 %b) {
+entry:
+  br label %loop
+loop:
+  %i = phi i32 [0, %entry], [%i1, %body]
+  %s = phi i32 [0, %entry], [%s1, %body]
+  %c = icmp slt i32 %i, %n
+  br i1 %c, label %body, label %exit
+body:
+  %t = mul i32 %i, %a
+  %s1 = add i32 %s, %t
+  %i1 = add i32 %i, 1
+  br label %loop
+exit:
+  %d = add i32 %b, 1
+  call void @g(i32 %d)
+  ret i32 %s
+}
+)";
+
+/// names of the values of the live registers of bb
+std::set<std::string> liveNames(const LiveSymbols &ls, const Function &F,
+                                StringRef bb) {
+  std::set<std::string> res;
+  for (const BasicBlock &BB : F)
+    if (BB.getName() == bb)
+      for (Expr v : ls.live(&BB)) {
+        Expr u = bind::fname(bind::fname(v));
+        res.insert(isOpX<VALUE>(u) ? getTerm<const Value *>(u)->getName().str()
+                                   : "error.flag");
+      }
+  return res;
+}
+
+/// checks that the live sets of ls contain those of ref at every block,
+/// and returns the number of blocks where they are equal
+unsigned checkSuperset(const LiveSymbols &ls, const LiveSymbols &ref,
+                       const Function &F) {
+  unsigned equal = 0;
+  for (const BasicBlock &BB : F) {
+    ExprSet live(ls.live(&BB).begin(), ls.live(&BB).end());
+    bool contained = true;
+    for (Expr v : ref.live(&BB))
+      contained &= live.count(v) > 0;
+    std::string where = F.getName().str() + ":" + BB.getName().str();
+    INFO(where);
+    CHECK(contained);
+    equal += live.size() == ref.live(&BB).size();
+  }
+  return equal;
+}
+
+/// Compares the live sets read off the IR with those computed by
+/// executing every block under UfoOpSem. UfoOpSem needs a pass to ask
+/// for its analyses.
+class CompareLiveSymbols : public ModulePass {
+public:
+  static char ID;
+  unsigned m_blocks = 0;
+  unsigned m_equal = 0;
+
+  CompareLiveSymbols() : ModulePass(ID) {}
+
+  bool runOnModule(Module &M) override {
+    ExprFactory efac;
+    UfoOpSem sem(efac, *this, M.getDataLayout(), MEM);
+    for (const Function &F : M) {
+      if (F.isDeclaration())
+        continue;
+      LiveSymbols ls(F, efac, sem);
+      ls.run();
+      LiveSymbols ref(F, efac, sem, true);
+      ref.run();
+      m_blocks += F.size();
+      m_equal += checkSuperset(ls, ref, F);
+    }
+    return false;
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesAll();
+  }
+};
+char CompareLiveSymbols::ID = 0;
+
+/// a loop over an array, and a main with assumptions, an error block
+/// and a call to a defined function
+const char *kProgram = R"(
+declare i32 @nd()
+declare void @verifier.assume(i1)
+declare void @verifier.error()
+
+define i32 @sum(i32* %a, i32 %n) {
+entry:
+  %pos = icmp sgt i32 %n, 0
+  br i1 %pos, label %loop, label %exit
+loop:
+  %i = phi i32 [0, %entry], [%i1, %loop]
+  %s = phi i32 [0, %entry], [%s1, %loop]
+  %p = getelementptr inbounds i32, i32* %a, i32 %i
+  %v = load i32, i32* %p
+  %s1 = add nsw i32 %s, %v
+  store i32 %s1, i32* %p
+  %i1 = add nsw i32 %i, 1
+  %c = icmp slt i32 %i1, %n
+  br i1 %c, label %loop, label %exit
+exit:
+  %r = phi i32 [0, %entry], [%s1, %loop]
+  ret i32 %r
+}
+
+define i32 @main() {
+entry:
+  %x = call i32 @nd()
+  %y = call i32 @nd()
+  %c0 = icmp sgt i32 %x, 0
+  call void @verifier.assume(i1 %c0)
+  %big = icmp sgt i32 %y, 10
+  br i1 %big, label %then, label %else
+then:
+  %x1 = add nsw i32 %x, %y
+  br label %join
+else:
+  %x2 = sub nsw i32 %x, %y
+  %sel = select i1 %c0, i32 %x2, i32 0
+  br label %join
+join:
+  %z = phi i32 [%x1, %then], [%sel, %else]
+  %w = phi i32 [%y, %then], [%y, %else]
+  %arr = alloca i32, i32 4
+  %t = call i32 @sum(i32* %arr, i32 %w)
+  %ok = icmp sge i32 %z, %t
+  br i1 %ok, label %done, label %err
+err:
+  call void @verifier.error()
+  unreachable
+done:
+  ret i32 0
+}
+)";
+} // namespace
+
+TEST_CASE("live_symbols.loop") {
+  LLVMContext llvmCtx;
+  SMDiagnostic err;
+  std::unique_ptr<Module> M = parseAssemblyString(kLoop, err, llvmCtx);
+  REQUIRE(M);
+  const Function &F = *M->getFunction("f");
+
+  ExprFactory efac;
+  TestOpSem sem(efac);
+  LiveSymbols ls(F, efac, sem);
+  ls.run();
+
+  // -- only the block with a call is executed
+  CHECK(sem.m_execs == 1);
+
+  // -- arguments live at entry are live everywhere
+  using S = std::set<std::string>;
+  S entry = {"error.flag", "n", "a", "b"};
+  CHECK(liveNames(ls, F, "entry") == entry);
+  CHECK(liveNames(ls, F, "loop") == S{"error.flag", "n", "a", "b", "i", "s"});
+  CHECK(liveNames(ls, F, "body") == S{"error.flag", "n", "a", "b", "i", "s"});
+  CHECK(liveNames(ls, F, "exit") == S{"error.flag", "n", "a", "b", "s"});
+
+  // -- same sets as executing every block
+  LiveSymbols ref(F, efac, sem, true);
+  ref.run();
+  CHECK(checkSuperset(ls, ref, F) == F.size());
+}
+
+TEST_CASE("live_symbols.ufo") {
+  LLVMContext llvmCtx;
+  SMDiagnostic err;
+  std::unique_ptr<Module> M = parseAssemblyString(kProgram, err, llvmCtx);
+  REQUIRE(M);
+
+  CompareLiveSymbols *cmp = new CompareLiveSymbols();
+  legacy::PassManager pm;
+  pm.add(cmp);
+  pm.run(*M);
+  CHECK(cmp->m_blocks == 9);
+  MESSAGE(cmp->m_equal << " of " << cmp->m_blocks
+                       << " blocks have the same live sets");
+}
@@ -0,0 +1,27 @@
+#include "seahorn/Expr/Smt/EZ3.hh"
+#include "seahorn/Expr/ExprOpBinder.hh"
+#include "doctest.h"
+
+TEST_CASE("z3.deep_marshal") {
+  using namespace seahorn;
+  using namespace expr;
+  using namespace expr::op;
+
+  ExprFactory efac;
+  z3::context ctx;
+  ZCache cache;
+
+  // -- far deeper than the call stack allows to recurse on
+  Expr x = bind::intConst(mkTerm<std::string>("x", efac));
+  Expr e = x;
+  for (unsigned i = 0; i < 200000; ++i)
+    e = mk<PLUS>(e, mkTerm<expr::mpz_class>(i % 16, efac));
+  e = mk<EQ>(e, mk<ITE>(mk<GT>(x, e), x, e));
+
+  expr_ast_map seen;
+  z3::ast z(ExprToZ::marshal(e, ctx, cache.left, seen));
+  CHECK(z.kind() == Z3_APP_AST);
+
+  ast_expr_map zseen;
+  CHECK(ZToExpr::unmarshal(z, efac, cache.right, zseen) == e);
+}
@@ -0,0 +1,149 @@
+/**==-- Path Bmc MUC Tests --==*/
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "doctest.h"
+
+#include "seahorn/Expr/Expr.hh"
+#include "seahorn/Expr/ExprOpBinder.hh"
+#include "seahorn/Expr/Smt/Z3SolverImpl.hh"
+#include "seahorn/PathBmcMuc.hh"
+#include "seahorn/PathBmcUtil.hh"
+
+#include <stdexcept>
+
+using namespace seahorn;
+using namespace expr;
+using namespace expr::op;
+
+TEST_CASE("path_bmc.incremental_muc.last_needed") {
+  ExprFactory efac;
+
+  Expr x = bv::bvConst(mkTerm<std::string>("x", efac), 32);
+  Expr y = bv::bvConst(mkTerm<std::string>("y", efac), 32);
+  Expr z = bv::bvConst(mkTerm<std::string>("z", efac), 32);
+  Expr five = bv::bvnum(5UL, 32, efac);
+  Expr ten = bv::bvnum(10UL, 32, efac);
+
+  // -- the last conjunct is needed, and it is the last literal of the
+  // -- core while the core is minimized
+  Expr c0 = mk<BULT>(x, five);
+  Expr c1 = mk<EQ>(y, five);
+  Expr c2 = mk<EQ>(z, ten);
+  Expr c3 = mk<BULT>(ten, x);
+  ExprVector f = {c0, c1, c2, c3};
+
+  std::unique_ptr<solver::Solver> solver(new solver::z3_solver_impl(efac));
+  path_bmc::incremental_muc muc(std::move(solver), 10);
+
+  ExprVector core;
+  REQUIRE(muc.solve(f, 10, core) == solver::SolverResult::UNSAT);
+  ExprSet cs(core.begin(), core.end());
+  CHECK(core.size() == 2);
+  CHECK(cs.count(c0) == 1);
+  CHECK(cs.count(c3) == 1);
+
+  // -- a second path with the same core is answered from the cache
+  unsigned calls = muc.solver_calls();
+  ExprVector g = {c2, c3, c0};
+  core.clear();
+  CHECK(muc.solve(g, 10, core) == solver::SolverResult::UNSAT);
+  CHECK(core.size() == 2);
+  CHECK(muc.solver_calls() == calls);
+
+  // -- sat formulas have no core
+  ExprVector h = {c1, c2, c3};
+  core.clear();
+  CHECK(muc.solve(h, 10, core) == solver::SolverResult::SAT);
+  CHECK(core.empty());
+}
+
+namespace {
+/* Enumerate the paths of a Boolean abstraction with two paths, b1 and
+   b2, as the path-based engine does. Solving the path b1 throws, and
+   b2 is solved with path2. Returns the result of the engine, and the
+   number of enumerated paths in num_paths. */
+solver::SolverResult enumerate_paths(ExprFactory &efac, Expr path2,
+                                     unsigned &num_paths) {
+  Expr e1 = mkTerm<std::string>("e1", efac);
+  Expr e2 = mkTerm<std::string>("e2", efac);
+  Expr b1 = bind::boolConst(mkTerm<std::string>("b1", efac));
+  Expr b2 = bind::boolConst(mkTerm<std::string>("b2", efac));
+
+  solver::z3_solver_impl boolean_solver(efac);
+  boolean_solver.add(mk<OR>(b1, b2));
+  boolean_solver.add(mk<NEG>(mk<AND>(b1, b2)));
+
+  solver::z3_solver_impl smt_solver(efac);
+  ExprVector unknown_paths;
+  num_paths = 0;
+  // -- the failing path is enumerated first
+  ExprVector first = {b1};
+  while ((num_paths == 0 ? boolean_solver.check_with_assumptions(
+                               llvm::make_range(first.cbegin(), first.cend()))
+                         : boolean_solver.check()) ==
+         solver::SolverResult::SAT) {
+    REQUIRE(num_paths < 2);
+    ++num_paths;
+    auto model = boolean_solver.get_model();
+    Expr b = isOpX<TRUE>(model->eval(b1, true)) ? b1 : b2;
+    ExprMap bool_map;
+    bool_map[b == b1 ? e1 : e2] = b;
+
+    ExprVector path_cond;
+    unsigned calls = 0;
+    auto res = path_bmc::solve_path_guarded(
+        [&](ExprVector &path_cond, unsigned &calls) {
+          if (b == b1) {
+            throw std::runtime_error("worker failed");
+          }
+          ++calls;
+          smt_solver.reset();
+          smt_solver.add(path2);
+          auto res = smt_solver.check();
+          if (res == solver::SolverResult::UNSAT) {
+            path_cond.push_back(b);
+          }
+          return res;
+        },
+        bool_map, path_cond, calls);
+
+    if (b == b1) {
+      // -- the failed path is unknown and blocked by its whole path
+      CHECK(res == solver::SolverResult::UNKNOWN);
+      CHECK(calls == 0);
+      REQUIRE(path_cond.size() == 1);
+      CHECK(path_cond[0] == b1);
+    }
+    if (res == solver::SolverResult::SAT) {
+      return res;
+    }
+    if (res == solver::SolverResult::UNKNOWN) {
+      unknown_paths.push_back(b);
+    }
+    REQUIRE(!path_cond.empty());
+    boolean_solver.add(op::boolop::lneg(op::boolop::land(path_cond)));
+  }
+  return unknown_paths.empty() ? solver::SolverResult::UNSAT
+                               : solver::SolverResult::UNKNOWN;
+}
+} // namespace
+
+TEST_CASE("path_bmc.worker_failure") {
+  ExprFactory efac;
+  Expr x = bv::bvConst(mkTerm<std::string>("x", efac), 32);
+  Expr five = bv::bvnum(5UL, 32, efac);
+
+  unsigned num_paths = 0;
+  SUBCASE("other path is sat") {
+    // -- blocking the failed path does not block the sat path
+    CHECK(enumerate_paths(efac, mk<BULT>(x, five), num_paths) ==
+          solver::SolverResult::SAT);
+    CHECK(num_paths == 2);
+  }
+  SUBCASE("other path is unsat") {
+    // -- the failed path is not reported as unsat
+    CHECK(enumerate_paths(efac, mk<BULT>(x, x), num_paths) ==
+          solver::SolverResult::UNKNOWN);
+    CHECK(num_paths == 2);
+  }
+}
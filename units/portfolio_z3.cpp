@@ -0,0 +1,85 @@
+#include "seahorn/Expr/Smt/PortfolioSolverImpl.hh"
+#include "seahorn/Expr/Smt/Z3SolverImpl.hh"
+
+#include "doctest.h"
+
+using namespace seahorn;
+using namespace expr;
+using namespace expr::op;
+
+TEST_CASE("portfolio.z3") {
+  // -- solvers of a portfolio marshal expressions concurrently
+  ExprFactory efac(true);
+
+  std::vector<std::unique_ptr<solver::Solver>> solvers;
+  for (unsigned i = 0; i < 3; ++i)
+    solvers.emplace_back(new solver::z3_solver_impl(efac));
+  solver::portfolio_solver_impl portfolio(efac, std::move(solvers));
+  CHECK(portfolio.get_kind() == solver::SolverKind::PORTFOLIO);
+
+  Expr x = bv::bvConst(mkTerm<std::string>("x", efac), 32);
+  Expr y = bv::bvConst(mkTerm<std::string>("y", efac), 32);
+  Expr a = bind::boolConst(mkTerm<std::string>("a", efac));
+  Expr b = bind::boolConst(mkTerm<std::string>("b", efac));
+  Expr ten = bv::bvnum(10UL, 32, efac);
+
+  portfolio.add(mk<BULT>(x, y));
+  portfolio.add(mk<IMPL>(a, mk<EQ>(y, ten)));
+  portfolio.add(mk<IMPL>(b, mk<BULT>(ten, x)));
+
+  REQUIRE(portfolio.check() == solver::SolverResult::SAT);
+  REQUIRE(portfolio.winner() != nullptr);
+  auto model = portfolio.get_model();
+  CHECK(isOpX<TRUE>(model->eval(mk<BULT>(x, y), true)));
+
+  // -- unsat core comes from the solver that answered
+  ExprVector lits = {a, b};
+  REQUIRE(portfolio.check_with_assumptions(llvm::make_range(
+              lits.cbegin(), lits.cend())) == solver::SolverResult::UNSAT);
+  ExprVector core;
+  portfolio.unsat_core(core);
+  CHECK(core.size() == 2);
+
+  // -- assertions and scopes reach every solver
+  portfolio.push();
+  portfolio.add(a);
+  portfolio.add(b);
+  CHECK(portfolio.check() == solver::SolverResult::UNSAT);
+  portfolio.pop();
+  CHECK(portfolio.check() == solver::SolverResult::SAT);
+}
+
+TEST_CASE("portfolio.timeout") {
+  ExprFactory efac(true);
+
+  std::vector<std::unique_ptr<solver::Solver>> solvers;
+  for (unsigned i = 0; i < 2; ++i)
+    solvers.emplace_back(new solver::z3_solver_impl(efac));
+  solver::portfolio_solver_impl portfolio(efac, std::move(solvers));
+
+  // -- x^3 + y^3 + z^3 = 33 is out of reach of the solvers
+  Expr x = bind::intConst(mkTerm<std::string>("x", efac));
+  Expr y = bind::intConst(mkTerm<std::string>("y", efac));
+  Expr z = bind::intConst(mkTerm<std::string>("z", efac));
+  Expr a = bind::boolConst(mkTerm<std::string>("a", efac));
+  auto cube = [](Expr v) { return mk<MULT>(v, mk<MULT>(v, v)); };
+  Expr sum = mk<PLUS>(cube(x), mk<PLUS>(cube(y), cube(z)));
+  portfolio.add(
+      mk<IMPL>(a, mk<EQ>(sum, mkTerm<expr::mpz_class>(33UL, efac))));
+
+  // -- all solvers are interrupted when the time is up
+  portfolio.set_timeout(1);
+  ExprVector lits = {a};
+  CHECK(portfolio.check_with_assumptions(llvm::make_range(
+            lits.cbegin(), lits.cend())) == solver::SolverResult::UNKNOWN);
+  CHECK(portfolio.winner() == nullptr);
+
+  // -- and remain usable. The timeout is lifted, and the query is easy,
+  // -- so that the result does not depend on the load of the machine
+  portfolio.set_timeout(0);
+  lits = {mk<NEG>(a)};
+  CHECK(portfolio.check_with_assumptions(llvm::make_range(
+            lits.cbegin(), lits.cend())) == solver::SolverResult::SAT);
+  portfolio.push();
+  portfolio.pop();
+}
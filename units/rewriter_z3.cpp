@@ -0,0 +1,133 @@
+#include "seahorn/Expr/Smt/EZ3.hh"
+#include "seahorn/Expr/ExprOpBinder.hh"
+#include "seahorn/Expr/ExprRewriter.hh"
+
+#include "doctest.h"
+#include "z3_util.hh"
+
+using namespace seahorn;
+using namespace expr;
+using namespace expr::op;
+using seahorn::units::provedEq;
+
+TEST_CASE("rewriter.bv") {
+  ExprFactory efac;
+  ExprRewriter rw(efac);
+  EZ3 z3(efac);
+
+  Expr x = bv::bvConst(mkTerm<std::string>("x", efac), 32);
+  Expr y = bv::bvConst(mkTerm<std::string>("y", efac), 32);
+  auto num = [&](long v, unsigned w) {
+    return bv::bvnum(expr::mpz_class(v), w, efac);
+  };
+
+  // -- constant folding, including wrap-around and signed operators
+  CHECK(rw.simplify(mk<BADD>(num(0xFFFFFFFF, 32), num(2, 32))) == num(1, 32));
+  CHECK(rw.simplify(mk<BSUB>(num(1, 32), num(2, 32))) ==
+        num(0xFFFFFFFF, 32));
+  CHECK(rw.simplify(mk<BSDIV>(num(-7, 8), num(2, 8))) == num(0xFD, 8));
+  CHECK(rw.simplify(mk<BSMOD>(num(-7, 8), num(2, 8))) == num(1, 8));
+  CHECK(rw.simplify(mk<BASHR>(num(0x80, 8), num(9, 8))) == num(0xFF, 8));
+  CHECK(rw.simplify(mk<BSLT>(num(0xFF, 8), num(0, 8))) == mk<TRUE>(efac));
+  CHECK(rw.simplify(mk<BULT>(num(0xFF, 8), num(0, 8))) == mk<FALSE>(efac));
+  CHECK(rw.simplify(bv::sext(num(0x80, 8), 16)) == num(0xFF80, 16));
+  CHECK(rw.simplify(mk<BCONCAT>(num(0xAB, 8), num(0xCD, 8))) ==
+        num(0xABCD, 16));
+
+  // -- neutral elements and offsets
+  CHECK(rw.simplify(mk<BMUL>(num(1, 32), mk<BADD>(x, num(0, 32)))) == x);
+  CHECK(rw.simplify(mk<BXOR>(x, x)) == num(0, 32));
+  Expr xp4 = rw.simplify(mk<BADD>(mk<BADD>(x, num(1, 32)), num(3, 32)));
+  CHECK(xp4 == mk<BADD>(x, num(4, 32)));
+  CHECK(rw.simplify(mk<EQ>(xp4, mk<BSUB>(x, num(-4, 32)))) ==
+        mk<TRUE>(efac));
+  CHECK(rw.simplify(mk<EQ>(xp4, x)) == mk<FALSE>(efac));
+
+  // -- extract/concat fusion
+  Expr hi = bv::extract(31, 16, x), lo = bv::extract(15, 0, x);
+  CHECK(rw.simplify(bv::concat(hi, lo)) == x);
+  Expr xy = bv::concat(x, y);
+  CHECK(rw.simplify(bv::extract(39, 32, xy)) == bv::extract(7, 0, x));
+  CHECK(rw.simplify(bv::extract(7, 0, bv::extract(15, 8, xy))) ==
+        bv::extract(15, 8, y));
+  CHECK(rw.simplify(bv::extract(40, 33, bv::zext(x, 64))) == num(0, 8));
+
+  // -- ITE lifting over constant branches
+  Expr c = mk<BULT>(x, y);
+  Expr ite = mk<ITE>(c, num(1, 32), num(2, 32));
+  CHECK(rw.simplify(mk<EQ>(ite, num(1, 32))) == c);
+  CHECK(rw.simplify(mk<EQ>(ite, num(3, 32))) == mk<FALSE>(efac));
+  CHECK(rw.simplify(mk<ITE>(mk<NEG>(c), x, y)) == mk<ITE>(c, y, x));
+
+  // -- every rewrite is sound
+  ExprVector terms = {mk<BADD>(mk<BSUB>(x, num(3, 32)), num(5, 32)),
+                      bv::concat(bv::extract(31, 8, xy), bv::extract(7, 0, y)),
+                      mk<BAND>(mk<BOR>(ite, x), num(0xFF, 32)),
+                      mk<BSREM>(num(-7, 32), ite)};
+  for (Expr t : terms)
+    CHECK(provedEq(z3, t, rw.simplify(t)));
+}
+
+TEST_CASE("rewriter.memory") {
+  ExprFactory efac;
+  ExprRewriter rw(efac);
+
+  Expr bv32Ty = bv::bvsort(32, efac);
+  Expr arrTy = sort::arrayTy(bv32Ty, bv32Ty);
+  Expr p = bv::bvConst(mkTerm<std::string>("p", efac), 32);
+  Expr q = bv::bvConst(mkTerm<std::string>("q", efac), 32);
+  auto num = [&](unsigned long v) { return bv::bvnum(v, 32, efac); };
+  auto at = [&](unsigned long off) { return mk<BADD>(p, num(off)); };
+
+  // -- read-over-write on arrays
+  Expr arr = bind::mkConst(mkTerm<std::string>("arr", efac), arrTy);
+  Expr st = arr;
+  for (unsigned long i = 0; i < 8; ++i)
+    st = op::array::store(st, at(4 * i), num(i));
+  CHECK(rw.simplify(op::array::select(st, at(8))) == num(2));
+  CHECK(rw.simplify(op::array::select(st, at(64))) ==
+        op::array::select(arr, at(64)));
+  // -- unknown address stops at the last store
+  CHECK(rw.simplify(op::array::select(st, q)) ==
+        op::array::select(rw.simplify(st), q));
+
+  // -- read-over-write on lambda memories
+  Expr mem = bind::mkConst(mkTerm<std::string>("mem", efac), arrTy);
+  Expr addr = bind::mkConst(mkTerm<std::string>("addr", efac), bv32Ty);
+  Expr b0 = bind::bvar(0, bv32Ty);
+  Expr lmem = mem;
+  for (unsigned long i = 0; i < 1000; ++i) {
+    Expr ite = mk<ITE>(mk<EQ>(b0, at(4 * i)), num(i), bind::fapp(lmem, b0));
+    lmem = mk<LAMBDA>(bind::fname(addr), ite);
+  }
+  CHECK(rw.simplify(bind::fapp(lmem, at(400))) == num(100));
+  CHECK(rw.simplify(bind::fapp(lmem, at(2))) == bind::fapp(mem, at(2)));
+  // -- a read at an unknown address is not unfolded
+  CHECK(rw.simplify(bind::fapp(lmem, q)) ==
+        bind::fapp(rw.simplify(lmem), q));
+}
+
+TEST_CASE("rewriter.capacity") {
+  ExprFactory efac;
+  ExprRewriter rw(efac, 16);
+  CHECK(rw.capacity() == 16);
+
+  Expr x = bv::bvConst(mkTerm<std::string>("x", efac), 32);
+  auto num = [&](unsigned long v) { return bv::bvnum(v, 32, efac); };
+
+  // -- every call memoizes a few new nodes, the memo is flushed once full
+  size_t peak = 0;
+  for (unsigned long i = 0; i < 100; ++i) {
+    Expr e = mk<BADD>(mk<BADD>(x, num(i)), num(1));
+    CHECK(rw.simplify(e) == rw.simplify(mk<BADD>(x, num(i + 1))));
+    peak = std::max(peak, rw.size());
+  }
+  CHECK(peak <= 16 + 8);
+
+  // -- within one call the memo grows past the capacity
+  Expr big = x;
+  for (unsigned long i = 0; i < 32; ++i)
+    big = mk<BMUL>(big, mk<BADD>(x, num(i)));
+  rw.simplify(big);
+  CHECK(rw.size() > 16);
+}
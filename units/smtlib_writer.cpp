@@ -0,0 +1,134 @@
+/**==-- SmtLibWriter Tests --==*/
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "doctest.h"
+#include "seahorn/Expr/Expr.hh"
+#include "seahorn/Expr/ExprOpBinder.hh"
+#include "seahorn/Expr/Smt/SmtLibWriter.hh"
+
+#include "llvm/Support/raw_ostream.h"
+
+#include <z3++.h>
+
+using namespace expr;
+using namespace seahorn;
+
+static std::string write(const ExprVector &f) {
+  std::string res;
+  llvm::raw_string_ostream out(res);
+  SmtLibWriter w(out);
+  w.assertAll(f);
+  CHECK(w.unsupported() == 0);
+  return out.str();
+}
+
+static unsigned count(const std::string &s, const std::string &sub) {
+  unsigned n = 0;
+  for (size_t pos = s.find(sub); pos != std::string::npos;
+       pos = s.find(sub, pos + 1))
+    ++n;
+  return n;
+}
+
+/// the assertions of the output, as read by z3
+static z3::expr parse(z3::context &ctx, const std::string &out) {
+  z3::solver s(ctx);
+  s.from_string(out.c_str());
+  return z3::mk_and(s.assertions());
+}
+
+/// e is valid iff the output for its negation is unsat
+static bool isValid(Expr e) {
+  z3::context ctx;
+  z3::solver s(ctx);
+  s.add(parse(ctx, write({mk<NEG>(e)})));
+  return s.check() == z3::unsat;
+}
+
+/// a and b are equivalent as read by z3
+static bool equiv(z3::context &ctx, z3::expr a, z3::expr b) {
+  z3::solver s(ctx);
+  s.add(a != b);
+  return s.check() == z3::unsat;
+}
+
+TEST_CASE("smtlib_writer.sharing") {
+  ExprFactory efac;
+  Expr x = bind::intConst(mkTerm<std::string>("x", efac));
+  Expr y = bind::intConst(mkTerm<std::string>("y", efac));
+
+  // -- a chain of n terms, each used twice, is exponential as a tree
+  Expr t = x;
+  for (unsigned i = 0; i < 64; ++i)
+    t = mk<PLUS>(t, mk<MULT>(t, y));
+  Expr f = mk<GT>(t, mkTerm<expr::mpz_class>(0UL, efac));
+
+  std::string out = write({f});
+  CHECK(count(out, "(declare-fun ") == 2);
+  CHECK(count(out, "(define-fun ") == 63);
+  CHECK(out.size() < 64 * 64);
+
+  z3::context ctx;
+  z3::solver s(ctx);
+  s.add(parse(ctx, out));
+  CHECK(s.check() == z3::sat);
+}
+
+TEST_CASE("smtlib_writer.binders") {
+  ExprFactory efac;
+  Expr x = bind::intConst(mkTerm<std::string>("x", efac));
+  Expr y = bind::intConst(mkTerm<std::string>("y", efac));
+  Expr one = mkTerm<expr::mpz_class>(1UL, efac);
+
+  // -- forall x. (x + y) + (x + y) = x + x + y + y, shared under the binder
+  Expr sum = mk<PLUS>(x, y);
+  Expr body = mk<EQ>(mk<PLUS>(sum, sum), mk<PLUS>(mk<PLUS>(x, x), mk<PLUS>(y, y)));
+  Expr q = bind::abs<FORALL>(x, body);
+  std::string out = write({q});
+  CHECK(count(out, "(let ") == 1);
+  CHECK(count(out, "(define-fun ") == 0);
+  CHECK(isValid(q));
+
+  // -- closed terms shared across the binder and outside of it
+  Expr yy = mk<PLUS>(y, one);
+  Expr g = mk<AND>(mk<GT>(yy, one),
+                   bind::abs<EXISTS>(x, mk<EQ>(x, mk<PLUS>(yy, yy))));
+  out = write({g});
+  CHECK(count(out, "(define-fun ") == 1);
+  CHECK(isValid(mk<IMPL>(mk<GT>(y, one), g)));
+}
+
+TEST_CASE("smtlib_writer.bv") {
+  ExprFactory efac;
+  Expr a = bv::bvConst(mkTerm<std::string>("a", efac), 8);
+  Expr b = bv::bvConst(mkTerm<std::string>("b", efac), 8);
+  z3::context ctx;
+  z3::expr za = ctx.bv_const("a", 8), zb = ctx.bv_const("b", 8);
+
+  // -- the expansions of the overflow checks agree with z3
+  std::vector<std::pair<Expr, z3::expr>> checks = {
+      {mk<SADD_NO_OVERFLOW>(a, b), z3::bvadd_no_overflow(za, zb, true)},
+      {mk<UADD_NO_OVERFLOW>(a, b), z3::bvadd_no_overflow(za, zb, false)},
+      {mk<SADD_NO_UNDERFLOW>(a, b), z3::bvadd_no_underflow(za, zb)},
+      {mk<SSUB_NO_OVERFLOW>(a, b), z3::bvsub_no_overflow(za, zb)},
+      {mk<SSUB_NO_UNDERFLOW>(a, b), z3::bvsub_no_underflow(za, zb, true)},
+      {mk<USUB_NO_UNDERFLOW>(a, b), z3::bvsub_no_underflow(za, zb, false)},
+      {mk<SMUL_NO_OVERFLOW>(a, b), z3::bvmul_no_overflow(za, zb, true)},
+      {mk<UMUL_NO_OVERFLOW>(a, b), z3::bvmul_no_overflow(za, zb, false)},
+      {mk<SMUL_NO_UNDERFLOW>(a, b), z3::bvmul_no_underflow(za, zb)}};
+  for (auto &c : checks) {
+    CAPTURE(*c.first);
+    CHECK(equiv(ctx, parse(ctx, write({c.first})), c.second));
+  }
+
+  // -- extract(11, 4, a ++ b) + zext(a[3:0]) + 255 == sext(b[7:0])
+  Expr e = bv::extract(11, 4, bv::concat(a, b));
+  Expr z = bv::zext(bv::extract(3, 0, a), 8);
+  Expr n = bv::bvnum(mpz_class(-1), 8, efac);
+  Expr f = mk<EQ>(mk<BADD>(e, z, n), bv::sext(bv::extract(7, 0, b), 8));
+  std::string out = write({f});
+  CHECK(out.find("(_ bv255 8)") != std::string::npos);
+  z3::expr ze = z3::concat(za, zb).extract(11, 4);
+  z3::expr zz = z3::zext(za.extract(3, 0), 4);
+  CHECK(equiv(ctx, parse(ctx, out), ze + zz + ctx.bv_val(255, 8) == zb));
+}
@@ -0,0 +1,143 @@
+/**==-- Stats Tests --==*/
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "doctest.h"
+#include "seahorn/Support/Stats.hh"
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace seahorn;
+
+TEST_CASE("stats.counters") {
+  Stats::CounterId c = Stats::counter("units.stats.count");
+  CHECK(Stats::counter("units.stats.count") == c);
+
+  const unsigned N = 8;
+  const unsigned M = 10000;
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < N; ++i)
+    threads.emplace_back([c, i]() {
+      for (unsigned j = 0; j < M; ++j) {
+        if (i % 2)
+          Stats::count(c);
+        else
+          Stats::count("units.stats.count");
+      }
+    });
+  for (auto &t : threads)
+    t.join();
+  CHECK(Stats::get("units.stats.count") == N * M);
+
+  Stats::uset(c, 5);
+  CHECK(Stats::add("units.stats.count", 3) == 8);
+  CHECK(Stats::get(c) == 8);
+}
+
+TEST_CASE("stats.handles") {
+  // -- counting and timing through handles stays exact while other
+  // -- threads intern new names and print the statistics
+  Stats::CounterId c = Stats::counter("units.stats.handle");
+  Stats::TimerId t = Stats::timer("units.stats.handle_timer");
+
+  const unsigned N = 8;
+  const unsigned M = 10000;
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < N; ++i)
+    threads.emplace_back([c, t, i]() {
+      for (unsigned j = 0; j < M; ++j) {
+        if (i == 0) {
+          Stats::count("units.stats.fresh." + std::to_string(j));
+        } else if (i == 1 && j % 100 == 0) {
+          std::string out;
+          llvm::raw_string_ostream os(out);
+          Stats::PrintBrunch(os);
+        }
+        Stats::count(c);
+        Stats::resume(t);
+        Stats::add(c, 2);
+        Stats::stop(t);
+      }
+    });
+  for (auto &th : threads)
+    th.join();
+  CHECK(Stats::get(c) == 3 * N * M);
+  CHECK(Stats::get("units.stats.fresh.0") == 1);
+  CHECK(Stats::get("units.stats.fresh." + std::to_string(M - 1)) == 1);
+}
+
+TEST_CASE("stats.max") {
+  // -- concurrent peaks, as flushed by several Z3 contexts
+  const unsigned N = 8;
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < N; ++i)
+    threads.emplace_back([i]() {
+      for (unsigned j = 0; j < 1000; ++j)
+        Stats::max("units.stats.peak", i * 1000 + j);
+    });
+  for (auto &t : threads)
+    t.join();
+  CHECK(Stats::get("units.stats.peak") == N * 1000 - 1);
+  CHECK(Stats::max("units.stats.peak", 5) == N * 1000 - 1);
+}
+
+TEST_CASE("stats.strings") {
+  // -- sget returns a copy, so readers do not race with writers
+  const unsigned N = 8;
+  std::vector<char> ok(N, 1);
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < N; ++i)
+    threads.emplace_back([i, &ok]() {
+      for (unsigned j = 0; j < 1000; ++j) {
+        if (i % 2)
+          Stats::sset("units.stats.str", std::string(j % 64, 'a'));
+        else if (Stats::sget("units.stats.str").find_first_not_of('a') !=
+                 std::string::npos)
+          ok[i] = 0;
+      }
+    });
+  for (auto &t : threads)
+    t.join();
+  CHECK(std::count(ok.begin(), ok.end(), 1) == N);
+  Stats::sset("units.stats.str", "done");
+  CHECK(Stats::sget("units.stats.str") == "done");
+}
+
+TEST_CASE("stats.timers") {
+  {
+    ScopedStats outer("units.stats.outer");
+    {
+      ScopedStats inner("units.stats.inner");
+      // -- recursion into the same timer is not measured twice
+      ScopedStats again("units.stats.outer");
+    }
+  }
+
+  std::string json;
+  llvm::raw_string_ostream os(json);
+  Stats::PrintJson(os);
+  os.flush();
+  // -- inner is nested in outer
+  auto outer = json.find("\"name\": \"units.stats.outer\"");
+  auto inner = json.find("\"name\": \"units.stats.inner\"");
+  REQUIRE(outer != std::string::npos);
+  REQUIRE(inner != std::string::npos);
+  CHECK(outer < inner);
+  CHECK(json.find("\"children\"", outer) < inner);
+  CHECK(json.find("\"process_peak_rss_kb\"") != std::string::npos);
+
+  std::string csv;
+  llvm::raw_string_ostream cs(csv);
+  Stats::PrintCsv(cs);
+  cs.flush();
+  CHECK(csv.find("timer,units.stats.inner,units.stats.outer,") !=
+        std::string::npos);
+  CHECK(csv.find("counter,units.stats.count,,8,") != std::string::npos);
+
+  Stopwatch sw;
+  sw.stop();
+  CHECK(sw.getWallTimeElapsed() >= 0);
+  CHECK(sw.getProcessPeakRss() > 0);
+}
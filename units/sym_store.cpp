@@ -0,0 +1,86 @@
+/**==-- SymStore Tests --==*/
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "doctest.h"
+#include "seahorn/Support/PersistentHashMap.hh"
+#include "seahorn/SymStore.hh"
+
+#include <map>
+
+using namespace expr;
+using namespace seahorn;
+
+namespace {
+/// a poor hash: many keys share a hash, and all share the low bits
+struct PoorHash {
+  size_t operator()(unsigned k) const { return (k % 97) << 20; }
+};
+} // namespace
+
+TEST_CASE("persistent_map.ops") {
+  using Map = PersistentHashMap<unsigned, unsigned, PoorHash>;
+  Map m;
+  std::map<unsigned, unsigned> ref;
+  for (unsigned i = 0; i < 5000; ++i) {
+    m.set(i * 31 % 2000, i);
+    ref[i * 31 % 2000] = i;
+  }
+  CHECK(m.size() == ref.size());
+  for (auto &kv : ref) {
+    REQUIRE(m.lookup(kv.first));
+    CHECK(*m.lookup(kv.first) == kv.second);
+  }
+  CHECK(!m.lookup(2000));
+
+  std::map<unsigned, unsigned> seen(m.begin(), m.end());
+  CHECK(seen == ref);
+
+  // -- copies do not see each other's writes
+  Map c(m);
+  c.set(7, 100);
+  c.set(3000, 1);
+  m.set(7, 200);
+  CHECK(*c.lookup(7) == 100);
+  CHECK(*m.lookup(7) == 200);
+  CHECK(c.lookup(3000));
+  CHECK(!m.lookup(3000));
+  CHECK(c.size() == m.size() + 1);
+  CHECK(*c.lookup(8) == *m.lookup(8));
+
+  c.clear();
+  CHECK(c.empty());
+  CHECK(c.begin() == c.end());
+  CHECK(m.size() == ref.size());
+}
+
+TEST_CASE("sym_store.copy") {
+  ExprFactory efac;
+  Expr x = bind::intConst(mkTerm<std::string>("x", efac));
+  Expr y = bind::intConst(mkTerm<std::string>("y", efac));
+  Expr one = mkTerm<expr::mpz_class>(1UL, efac);
+
+  SymStore s(efac);
+  Expr x0 = s.read(x);
+  Expr y0 = s.read(y);
+
+  // -- a fork, as done for each incoming edge of a join
+  SymStore es(s);
+  es.write(x, one);
+  Expr y1 = es.havoc(y);
+  CHECK(es.at(x) == one);
+  CHECK(y1 != y0);
+  CHECK(s.at(x) == x0);
+  CHECK(s.at(y) == y0);
+
+  // -- snapshots keep the values at the time they were taken
+  std::vector<SymStore> states;
+  for (unsigned i = 0; i < 10; ++i) {
+    states.push_back(s);
+    s.havoc(x);
+  }
+  CHECK(states[0].at(x) == x0);
+  for (unsigned i = 1; i < 10; ++i)
+    CHECK(states[i].at(x) != states[i - 1].at(x));
+  CHECK(states[9].at(y) == y0);
+  CHECK(s.eval(mk<PLUS>(x, y)) == mk<PLUS>(s.at(x), y0));
+}
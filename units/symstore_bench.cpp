@@ -0,0 +1,72 @@
+/**==-- SymStore Micro-Benchmarks --==*/
+///
+/// Cost of the store copies made by VCGen and BMC on functions with many
+/// joins: a copy per incoming edge of a join, to compute the values of its
+/// PHI nodes, and a copy per cut-point, kept as a snapshot. The benchmark
+/// uses only the public SymStore API so that it can be compiled against
+/// older revisions of the store and the numbers compared side by side.
+///
+/// Usage: symstore_bench [num_registers] [num_joins] [preds_per_join]
+#include "seahorn/SymStore.hh"
+
+#include "bench_util.hh"
+
+#include <cstdlib>
+#include <iostream>
+
+using namespace expr;
+using namespace seahorn;
+using namespace seahorn::units;
+
+int main(int argc, char **argv) {
+  unsigned regs = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+  unsigned joins = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000;
+  unsigned preds = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 4;
+
+  ExprFactory efac;
+  ExprVector keys;
+  for (unsigned i = 0; i < regs; ++i)
+    keys.push_back(
+        bind::intConst(mkTerm<std::string>("r" + std::to_string(i), efac)));
+
+  SymStore store(efac);
+  for (Expr k : keys)
+    store.read(k);
+
+  // -- a join per block: fork the store for each incoming edge, write the
+  // -- PHI nodes in the fork, and define them in the store
+  size_t rss = residentBytes();
+  auto start = bench_clock::now();
+  for (unsigned j = 0; j < joins; ++j) {
+    for (unsigned p = 0; p < preds; ++p) {
+      SymStore es(store);
+      Expr phi = keys[(j * 7 + p) % regs];
+      es.write(phi, es.read(keys[(j * 13 + p) % regs]));
+      es.read(phi);
+    }
+    store.havoc(keys[(j * 7) % regs]);
+  }
+  report("fork per edge", size_t(joins) * preds, elapsedSec(start),
+         residentBytes() - rss);
+
+  // -- a cut-point per block: keep a snapshot of the store after each
+  std::vector<SymStore> states;
+  rss = residentBytes();
+  start = bench_clock::now();
+  for (unsigned j = 0; j < joins; ++j) {
+    store.havoc(keys[(j * 11) % regs]);
+    store.havoc(keys[(j * 17 + 3) % regs]);
+    states.push_back(store);
+  }
+  report("snapshot per block", joins, elapsedSec(start),
+         residentBytes() - rss);
+
+  // -- reads of the snapshots must see the values at their cut-point
+  Expr first = states.front().at(keys[0]);
+  Expr last = states.back().at(keys[0]);
+  if (!first || !last) {
+    std::cerr << "error: lost a value\n";
+    return 1;
+  }
+  return 0;
+}
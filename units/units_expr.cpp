@@ -1,9 +1,11 @@
 #include "seahorn/Expr/Expr.hh"
 #include "seahorn/Expr/ExprGmp.hh"
 #include "seahorn/Expr/ExprLlvm.hh"
+#include "seahorn/Expr/ExprVisitor.hh"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/ADT/APInt.h"
 #include "boost/lexical_cast.hpp"
+#include <thread>
 #include "doctest.h"
 
 inline expr::mpz_class toMpzE(const llvm::APInt &v) {
@@ -49,3 +51,120 @@ TEST_CASE("expr.APInt.large") {
 
   CHECK(numA2.toString(10, false) == numZ2.to_string());
 }
+
+TEST_CASE("expr.hashcons") {
+  using namespace expr;
+
+  ExprFactory efac;
+  Expr x = mkTerm<std::string>("x", efac);
+  Expr y = mkTerm<std::string>("y", efac);
+
+  CHECK(mk<PLUS>(x, y) == mk<PLUS>(x, y));
+  CHECK(mk<PLUS>(x, y) != mk<PLUS>(y, x));
+  CHECK(mk<PLUS>(x, y) != mk<MINUS>(x, y));
+  CHECK(mkTerm<std::string>("x", efac) == x);
+
+  // -- enough nodes to force the unique table to grow several times
+  ExprVector nodes;
+  for (unsigned i = 0; i < 10000; ++i)
+    nodes.push_back(mk<PLUS>(x, mkTerm<unsigned>(i, efac)));
+  for (unsigned i = 0; i < 10000; ++i)
+    CHECK(nodes[i] == mk<PLUS>(x, mkTerm<unsigned>(i, efac)));
+
+  // -- release every other node and check that the rest is still found
+  ExprVector kept;
+  for (unsigned i = 0; i < nodes.size(); i += 2)
+    kept.push_back(nodes[i]);
+  nodes.clear();
+  for (unsigned i = 0; i < kept.size(); ++i)
+    CHECK(kept[i] == mk<PLUS>(x, mkTerm<unsigned>(2 * i, efac)));
+
+  Expr fresh = mk<PLUS>(x, mkTerm<unsigned>(1, efac));
+  CHECK(fresh == mk<PLUS>(x, mkTerm<unsigned>(1, efac)));
+}
+
+TEST_CASE("expr.concurrent_factory") {
+  using namespace expr;
+
+  ExprFactory efac(true);
+  CHECK(efac.isConcurrent());
+  Expr x = mkTerm<std::string>("x", efac);
+
+  // -- every thread builds (and releases) the same terms
+  const unsigned numThreads = 4;
+  std::vector<ExprVector> results(numThreads);
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < numThreads; ++t)
+    threads.emplace_back([&, t]() {
+      for (unsigned round = 0; round < 3; ++round) {
+        ExprVector nodes;
+        for (unsigned i = 0; i < 2000; ++i)
+          nodes.push_back(mk<PLUS>(x, mkTerm<unsigned>(i, efac)));
+        if (round == 2)
+          results[t] = nodes;
+      }
+    });
+  for (auto &th : threads)
+    th.join();
+
+  for (unsigned t = 1; t < numThreads; ++t)
+    CHECK(results[t] == results[0]);
+  CHECK(results[0][7] == mk<PLUS>(x, mkTerm<unsigned>(7, efac)));
+}
+
+TEST_CASE("expr.concurrent_factory.release") {
+  using namespace expr;
+
+  // -- operators outlive their nodes in a concurrent factory, and are
+  // -- destroyed with it. Names are long so that a leak of the operators
+  // -- also leaks heap memory and shows up under LeakSanitizer
+  for (unsigned f = 0; f < 3; ++f) {
+    ExprFactory efac(true);
+    std::string prefix(64, 'v');
+    for (unsigned i = 0; i < 100; ++i) {
+      Expr v = mkTerm<std::string>(prefix + std::to_string(i), efac);
+      CHECK(getTerm<std::string>(v) == prefix + std::to_string(i));
+    }
+  }
+}
+
+TEST_CASE("expr.deep_visit") {
+  using namespace expr;
+
+  ExprFactory efac;
+  Expr x = mkTerm<std::string>("x", efac);
+  Expr y = mkTerm<std::string>("y", efac);
+
+  // -- a chain that is far deeper than the call stack allows to recurse on.
+  // -- Every node is used twice by its parent
+  const unsigned depth = 500000;
+  Expr e = x;
+  for (unsigned i = 0; i < depth; ++i)
+    e = mk<PLUS>(e, e);
+
+  struct CountVisitor {
+    unsigned count = 0;
+    VisitAction operator()(Expr e) {
+      ++count;
+      return VisitAction::doKids();
+    }
+  };
+  CountVisitor cv;
+  CHECK(dagVisit(cv, e) == e);
+  CHECK(cv.count == depth + 1);
+
+  ExprMap m;
+  m[x] = y;
+  Expr r = replace(e, m);
+  bool shape = true;
+  for (unsigned i = 0; shape && i < depth; ++i) {
+    shape = isOpX<PLUS>(r) && r->left() == r->right();
+    r = r->left();
+  }
+  CHECK(shape);
+  CHECK(r == y);
+
+  // -- releasing the chain must not recurse either
+  e.reset();
+  CHECK(mkTerm<std::string>("x", efac) == x);
+}
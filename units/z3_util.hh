@@ -0,0 +1,18 @@
+#pragma once
+/// Helpers shared by the unit tests that call Z3
+
+#include "seahorn/Expr/Smt/EZ3.hh"
+
+namespace seahorn {
+namespace units {
+/// \brief true if Z3 proves that \p e1 and \p e2 are equal
+///
+/// For Boolean expressions, this is equivalence
+inline bool provedEq(EZ3 &z3, expr::Expr e1, expr::Expr e2) {
+  ZSolver<EZ3> solver(z3);
+  solver.assertExpr(expr::mk<expr::NEQ>(e1, e2));
+  boost::tribool res = solver.solve();
+  return static_cast<bool>(!res);
+}
+} // namespace units
+} // namespace seahorn
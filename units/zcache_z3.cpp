@@ -0,0 +1,37 @@
+#include "seahorn/Expr/Smt/EZ3.hh"
+#include "seahorn/Expr/ExprOpBinder.hh"
+#include "doctest.h"
+
+TEST_CASE("z3.cache_eviction") {
+  using namespace seahorn;
+  using namespace expr;
+  using namespace expr::op;
+
+  ExprFactory efac;
+  EZ3 z3(efac);
+  ZCache &cache = z3.getCache();
+  cache.setCapacity(16);
+
+  // -- the name of x is not a string, so converting x back from Z3 relies
+  // -- on the cache
+  Expr x = bind::intConst(mkTerm<unsigned>(42, efac));
+  CHECK(z3_lite_simplify(z3, x) == x);
+
+  for (unsigned i = 0; i < 1000; ++i) {
+    Expr v = bind::intConst(mkTerm<unsigned>(1000 + i, efac));
+    z3_to_smtlib(z3, mk<PLUS>(v, x));
+  }
+
+  CHECK(cache.evictions() > 0);
+  CHECK(cache.size() <= 2 * cache.capacity());
+  CHECK(cache.peak() >= cache.size());
+  // -- x is still in use and was not evicted
+  CHECK(z3_lite_simplify(z3, x) == x);
+
+  // -- unbounded cache keeps everything
+  cache.setCapacity(0);
+  size_t sz = cache.size();
+  Expr y = bind::intConst(mkTerm<unsigned>(7, efac));
+  z3_to_smtlib(z3, y);
+  CHECK(cache.size() > sz);
+}
@@ -0,0 +1,104 @@
+/**==-- Expr/Z3 Marshalling Micro-Benchmarks --==*/
+///
+/// Throughput of converting a BMC-like formula from Expr to Z3 and back.
+///
+/// Usage: zmarshal_bench [num_nodes]
+#include "seahorn/Expr/Smt/EZ3.hh"
+#include "seahorn/Expr/ExprOpBinder.hh"
+
+#include "bench_util.hh"
+
+#include <cstdlib>
+#include <iostream>
+
+using namespace expr;
+using namespace expr::op;
+using namespace seahorn;
+using namespace seahorn::units;
+
+namespace {
+/// \brief Number of distinct nodes in the DAG below \p e
+size_t numNodes(Expr e) {
+  std::vector<bool> seen;
+  std::vector<ENode *> stack{e.get()};
+  size_t sz = 0;
+  while (!stack.empty()) {
+    ENode *n = stack.back();
+    stack.pop_back();
+    if (n->getId() >= seen.size())
+      seen.resize(2 * n->getId() + 1, false);
+    if (seen[n->getId()])
+      continue;
+    seen[n->getId()] = true;
+    ++sz;
+    for (auto it = n->args_begin(), end = n->args_end(); it != end; ++it)
+      stack.push_back(*it);
+  }
+  return sz;
+}
+
+/// \brief Unrolls a small transition system for \p steps steps
+///
+/// Every step constrains the next SSA copy of two integer and one bit-vector
+/// variable in terms of the current ones, as a BMC encoding does.
+Expr bmcFormula(ExprFactory &efac, unsigned steps) {
+  auto ivar = [&](const char *n, unsigned i) {
+    return bind::intConst(mkTerm<std::string>(n + std::to_string(i), efac));
+  };
+  auto bvar = [&](unsigned i) {
+    return bv::bvConst(mkTerm<std::string>("b" + std::to_string(i), efac), 32);
+  };
+
+  ExprVector conj;
+  Expr zero = mkTerm<expr::mpz_class>(0UL, efac);
+  Expr one = mkTerm<expr::mpz_class>(1UL, efac);
+  for (unsigned i = 0; i < steps; ++i) {
+    Expr x = ivar("x", i), y = ivar("y", i), b = bvar(i);
+    Expr x1 = ivar("x", i + 1), y1 = ivar("y", i + 1), b1 = bvar(i + 1);
+    Expr k = mkTerm<expr::mpz_class>((unsigned long)(i % 97), efac);
+
+    Expr c = mk<LT>(mk<PLUS>(x, k), y);
+    conj.push_back(mk<EQ>(x1, mk<ITE>(c, mk<PLUS>(x, one), mk<MINUS>(x, y))));
+    conj.push_back(mk<EQ>(y1, mk<ITE>(mk<GEQ>(y, zero), mk<MULT>(y, k), y)));
+    conj.push_back(mk<EQ>(
+        b1, mk<ITE>(c, mk<BADD>(b, bv::bvnum(i % 13, 32, efac)),
+                    mk<BXOR>(b, bv::extract(31, 0, mk<BSHL>(b, b))))));
+  }
+  return mknary<AND>(mk<TRUE>(efac), conj);
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+
+  ExprFactory efac;
+  z3::context ctx;
+  ZCache cache;
+
+  // -- about 25 new nodes per step
+  Expr vc = bmcFormula(efac, n / 25);
+  size_t sz = numNodes(vc);
+  std::cout << "formula: " << sz << " nodes\n";
+
+  auto start = bench_clock::now();
+  expr_ast_map seen;
+  z3::ast z(ExprToZ::marshal(vc, ctx, cache.left, seen));
+  report("marshal", sz, elapsedSec(start));
+
+  // -- terminals are in the global cache now
+  start = bench_clock::now();
+  expr_ast_map seen2;
+  z3::ast z2(ExprToZ::marshal(vc, ctx, cache.left, seen2));
+  report("marshal (warm cache)", sz, elapsedSec(start));
+
+  start = bench_clock::now();
+  ast_expr_map zseen;
+  Expr vc2 = ZToExpr::unmarshal(z, efac, cache.right, zseen);
+  report("unmarshal", sz, elapsedSec(start));
+
+  if (vc2 != vc || static_cast<Z3_ast>(z) != static_cast<Z3_ast>(z2)) {
+    std::cerr << "error: round trip failed\n";
+    return 1;
+  }
+  return 0;
+}